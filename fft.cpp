@@ -1,10 +1,36 @@
+#include <stdio.h>
 #include <math.h>
 #include <memory.h>
+#include <string.h>
 #include <vector>
 #include <complex>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <map>
 #include "fft.h"
+#include "stat.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FFT_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// Functions using instruction sets above the compiler's baseline are compiled
+// for that instruction set only and are called after a runtime CPU check
+#if defined(FFT_X86) && defined(__GNUC__)
+#define FFT_TARGET(isa) __attribute__((target(isa)))
+#else
+#define FFT_TARGET(isa)
+#endif
 
 const double const_PI = (double) 3.141592653589793238462643383279502884;
+// Smallest transform split between threads (SetThreads())
+const size_t const_ParallelMinSize = 65536;
 
 // Radix-2 Cooley-Tukey Algorithm, 1965 (complex input, complex output)
 // *x - Real, *y - Imaginary
@@ -85,10 +111,11 @@ static short do_fft(short int dir, long m, double *x, double *y)
 	return 0;
 }
 
-static void do_bit_reverse2(int n, double *a)
+template <class T>
+static void do_bit_reverse2(int n, T *a)
 {
 	int j, j1, k, k1, l, m, m2, n2;
-	double xr, xi;
+	T xr, xi;
 
 	m = n >> 2;
 	m2 = m << 1;
@@ -134,11 +161,166 @@ static void do_bit_reverse2(int n, double *a)
 }
 
 
+// Largest transform of the unrolled codelets
+const size_t const_CodeletMaxSize = 64;
+
+// cos(2*pi*j/64), j = 0..16. Twiddles of the codelets are taken from it at compile time,
+// exp(-+2*pi*i*k/N) = cos(2*pi*j/64) -+ i*sin(2*pi*j/64), j = k*64/N
+static const double const_CodeletCos[17] = {
+	1.,
+	0.995184726672196886244836953109,
+	0.980785280403230449126182236134,
+	0.956940335732208864935797886980,
+	0.923879532511286756128183189397,
+	0.881921264348355029712756863660,
+	0.831469612302545237078788377618,
+	0.773010453362736960810906609758,
+	0.707106781186547524400844362105,
+	0.634393284163645498215171613225,
+	0.555570233019602224742830813949,
+	0.471396736825997648556387625905,
+	0.382683432365089771728459984030,
+	0.290284677254462367636192375817,
+	0.195090322016128267848284868477,
+	0.098017140329560601994195563889,
+	0.
+};
+
+// (xr, xi) *= exp(-+2*pi*i*J/64), J < 32. eKind: 0 - J = 0, 1 - J = 16 (-+i), 2 - any other J
+template <class T, size_t J, bool bInverse, int eKind = (J == 0) ? 0 : (J == 16) ? 1 : 2>
+struct CCodeletTwiddle
+{
+	static void Mul(T &xr, T &xi)
+	{
+		enum { C = (J <= 16) ? J : 32 - J, S = (J <= 16) ? 16 - J : J - 16 };
+		const T c = T(J <= 16 ? const_CodeletCos[C] : -const_CodeletCos[C]);
+		const T s = T(bInverse ? const_CodeletCos[S] : -const_CodeletCos[S]);
+		T t = xr * c - xi * s;
+		xi = xr * s + xi * c;
+		xr = t;
+	}
+};
+
+template <class T, size_t J, bool bInverse>
+struct CCodeletTwiddle<T, J, bInverse, 0>
+{
+	static void Mul(T &, T &) {}
+};
+
+template <class T, size_t J, bool bInverse>
+struct CCodeletTwiddle<T, J, bInverse, 1>
+{
+	static void Mul(T &xr, T &xi)
+	{
+		T t = xr;
+		xr = bInverse ? -xi : xi;
+		xi = bInverse ? t : -t;
+	}
+};
+
+// Butterflies K..N/2-1 of the last radix-2 stage of an N-point codelet. out holds
+// the transforms of even and odd samples (N/2 points each)
+template <class T, size_t N, size_t K, bool bInverse, bool bEnd = (2 * K == N)>
+struct CCodeletStage
+{
+	static void Run(T *out)
+	{
+		T *e = out + 2 * K;
+		T *o = out + N + 2 * K;
+		T tr = o[0];
+		T ti = o[1];
+		CCodeletTwiddle<T, K * (const_CodeletMaxSize / N), bInverse>::Mul(tr, ti);
+		o[0] = e[0] - tr;
+		o[1] = e[1] - ti;
+		e[0] += tr;
+		e[1] += ti;
+		CCodeletStage<T, N, K + 1, bInverse>::Run(out);
+	}
+};
+
+template <class T, size_t N, size_t K, bool bInverse>
+struct CCodeletStage<T, N, K, bInverse, true>
+{
+	static void Run(T *) {}
+};
+
+// Fully unrolled N-point transform, N = 2^m <= 64 (complex input, complex output).
+// Recursive decimation in time: the input is read with a stride of s complex elements
+// in the order of the sub-transforms, so no bit reversal pass is needed.
+// Loop bounds and twiddles are compile time constants. Out of place, not normalized.
+template <class T, size_t N, bool bInverse>
+struct CCodelet
+{
+	static void Run(const T *in, size_t s, T *out)
+	{
+		CCodelet<T, N / 2, bInverse>::Run(in, 2 * s, out);
+		CCodelet<T, N / 2, bInverse>::Run(in + 2 * s, 2 * s, out + N);
+		CCodeletStage<T, N, 0, bInverse>::Run(out);
+	}
+};
+
+template <class T, bool bInverse>
+struct CCodelet<T, 2, bInverse>
+{
+	static void Run(const T *in, size_t s, T *out)
+	{
+		T xr = in[0], xi = in[1];
+		T yr = in[2 * s], yi = in[2 * s + 1];
+		out[0] = xr + yr;
+		out[1] = xi + yi;
+		out[2] = xr - yr;
+		out[3] = xi - yi;
+	}
+};
+
+template <class T, bool bInverse>
+struct CCodelet<T, 1, bInverse>
+{
+	static void Run(const T *in, size_t, T *out)
+	{
+		out[0] = in[0];
+		out[1] = in[1];
+	}
+};
+
+template <class T, bool bInverse>
+static void do_fft_codelet(size_t n, const T *in, T *out)
+{
+	switch (n)
+	{
+	case 1: CCodelet<T, 1, bInverse>::Run(in, 1, out); break;
+	case 2: CCodelet<T, 2, bInverse>::Run(in, 1, out); break;
+	case 4: CCodelet<T, 4, bInverse>::Run(in, 1, out); break;
+	case 8: CCodelet<T, 8, bInverse>::Run(in, 1, out); break;
+	case 16: CCodelet<T, 16, bInverse>::Run(in, 1, out); break;
+	case 32: CCodelet<T, 32, bInverse>::Run(in, 1, out); break;
+	case 64: CCodelet<T, 64, bInverse>::Run(in, 1, out); break;
+	}
+}
+
+// Transform of n = 2^m <= const_CodeletMaxSize points by the unrolled codelets
+// (complex input, complex output). in and out may be equal. Not normalized.
+template <class T>
+static void do_fft_codelet(size_t n, const T *in, T *out, bool bInverse)
+{
+	T buf[2 * const_CodeletMaxSize];
+	if (in == out)
+	{
+		memcpy(buf, in, 2 * n * sizeof(T));
+		in = buf;
+	}
+	if (bInverse)
+		do_fft_codelet<T, true>(n, in, out);
+	else
+		do_fft_codelet<T, false>(n, in, out);
+}
+
 // Radix-2 Cooley-Tukey Algorithm, 1965 (complex input, complex output)
 // a[2*i] - Real, a[2*i+1] - Imaginary
 // This algorithm does not evaluate square root on each cycle, but is less presice than do_fft
 // Compute values in place
-static void do_complex_dft(int n, double wr, double wi, double *a)
+template <class T>
+static void do_complex_dft_loop(int n, double wr, double wi, T *a)
 {
 	int i, j, k, l, m;
 	double wkr, wki, wdr, wdi, ss, xr, xi;
@@ -213,8 +395,20 @@ static void do_complex_dft(int n, double wr, double wi, double *a)
 	}
 }
 
+// Same as do_complex_dft_loop(), (wr, wi) = exp(-+i*pi/(n/2)).
+// Up to const_CodeletMaxSize points the unrolled codelets are run instead.
+template <class T>
+static void do_complex_dft(int n, double wr, double wi, T *a)
+{
+	if (n <= int(2 * const_CodeletMaxSize))
+		do_fft_codelet(size_t(n / 2), a, a, wi > 0);
+	else
+		do_complex_dft_loop(n, wr, wi, a);
+}
+
 // Radix-2 Cooley-Tukey Algorithm, 1965 (real input, complex output)
-static void do_real_rdft(int n, double wr, double wi, double *a)
+template <class T>
+static void do_real_rdft(int n, double wr, double wi, T *a)
 {
 	int j, k;
 	double wkr, wki, wdr, wdi, ss, xr, xi, yr, yi;
@@ -301,7 +495,8 @@ static void do_real_rdft(int n, double wr, double wi, double *a)
 }
 
 // Fast Discrete Cosine Transform based on FFT (real input, real input)
-static void do_real_dct(int n, double wr, double wi, double *a)
+template <class T>
+static void do_real_dct(int n, double wr, double wi, T *a)
 {
 	int j, k, m;
 	double wkr, wki, wdr, wdi, ss, xr;
@@ -380,7 +575,8 @@ static void do_real_dct(int n, double wr, double wi, double *a)
 }
 
 // Fast Discrete Sine Transform based on FFT (real input, real input)
-static void ro_real_dst(int n, double wr, double wi, double *a)
+template <class T>
+static void ro_real_dst(int n, double wr, double wi, T *a)
 {
 	int j, k, m;
 	double wkr, wki, wdr, wdi, ss, xr;
@@ -498,118 +694,272 @@ static int do_real_dct_slow(bool bInverse, int n, double *in, double *out)
 	}
 }
 
-// Fast Fourier transform (real input). Output is always multiple of 2
-int FFT(size_t nInCnt, double *pInVal, std::vector<std::complex<double> > &arOutput, bool bInverse, bool bOrthNorm/* = true*/)
+// Discrete Fourier Transform (slow) (complex input, complex output). Not normalized
+static int do_complex_dft_slow(bool bInverse, size_t n, const std::complex<double> *in, std::complex<double> *out)
 {
-	if (nInCnt < 2) return -1;
+	if (n < 1) return -1;
 
-	size_t N = 1;
-	int pw = 0;
-	while (N < nInCnt)
+	size_t i, k;
+	double sgn = bInverse ? 1. : -1.;
+	for (k = 0; k < n; k++)
 	{
-		N <<= 1;
-		pw++;
+		std::complex<double> v = 0.;
+		for (i = 0; i < n; i++)
+		{
+			double phi = 2. * const_PI * double((i * k) % n) / double(n);
+			v += in[i] * std::complex<double>(cos(phi), sgn * sin(phi));
+		}
+		out[k] = v;
 	}
+	return 0;
+}
 
-	std::vector<double> arTmpOutput;
-	arTmpOutput.resize(2 * N);
-	arOutput.resize(N);
-	size_t i;
-	for (i = 0; i < nInCnt; i++)
-		arTmpOutput[2 * i] = pInVal[i];
+// Real to real transforms of CFFTPlanT (slow), FFTW definitions, not normalized.
+// MDCT: 2n -> n, no window.
+static int do_real_r2r_slow(CFFTPlanBase::TTransform eType, size_t n, const double *in, double *out)
+{
+	if (n < 2) return -1;
 
-	double w1 = cos(const_PI / double(N) );
-	double w2 = bInverse ? sin(const_PI / double(N) ) : -sin(const_PI / double(N) );
+	size_t j, k;
+	double N = double(n);
+	for (k = 0; k < n; k++)
+	{
+		double v = 0.;
+		double K = double(k);
+		switch (eType)
+		{
+		case CFFTPlanBase::DCT1:
+			for (j = 1; j + 1 < n; j++)
+				v += 2. * in[j] * cos(const_PI * double(j) * K / (N - 1.));
+			v += in[0] + ((k & 1) ? -in[n - 1] : in[n - 1]);
+			break;
+		case CFFTPlanBase::DCT4:
+			for (j = 0; j < n; j++)
+				v += 2. * in[j] * cos(const_PI * (2. * double(j) + 1.) * (2. * K + 1.) / (4. * N));
+			break;
+		case CFFTPlanBase::DST1:
+			for (j = 0; j < n; j++)
+				v += 2. * in[j] * sin(const_PI * (double(j) + 1.) * (K + 1.) / (N + 1.));
+			break;
+		case CFFTPlanBase::DST2:
+			for (j = 0; j < n; j++)
+				v += 2. * in[j] * sin(const_PI * (2. * double(j) + 1.) * (K + 1.) / (2. * N));
+			break;
+		case CFFTPlanBase::DST4:
+			for (j = 0; j < n; j++)
+				v += 2. * in[j] * sin(const_PI * (2. * double(j) + 1.) * (2. * K + 1.) / (4. * N));
+			break;
+		case CFFTPlanBase::MDCT:
+			for (j = 0; j < 2 * n; j++)
+				v += in[j] * cos(const_PI / N * (double(j) + 0.5 + N / 2.) * (K + 0.5));
+			break;
+		default:
+			return -3;
+		}
+		out[k] = v;
+	}
+	return 0;
+}
 
-	do_complex_dft( int(2 * N), w1, w2, &arTmpOutput[0]);
+// Twiddle factors of FDCT() and FDST() (SetAccurateTwiddles())
+static bool bAccurateTwiddles = false;
 
-	double norm = 1.;
-	if (bOrthNorm)
-		norm = ::sqrt(1. / N);
-	else if (!bInverse)
-		norm = 1. / N;
-	for (i = 0; i < N; i++)
-		arOutput[i] = std::complex<double>(arTmpOutput[2 * i] * norm, arTmpOutput[2 * i + 1] * norm);
+void SetAccurateTwiddles(bool bAccurate)
+{
+	bAccurateTwiddles = bAccurate;
+}
 
-	return 0;
+bool GetAccurateTwiddles()
+{
+	return bAccurateTwiddles;
 }
 
-// Fast Fourier transform (complex input). Output is always multiple of 2
-int FFT(size_t nInCnt, const std::complex<double> *pInVal, std::vector<std::complex<double> > &arOutput, bool bInverse, bool bOrthNorm/* = true*/)
+// Largest transform kept by the plan cache of the free functions
+static const size_t const_PlanCacheMaxSize = 65536;
+
+// Plans of the free functions, one per type, size, direction and normalization. Every thread
+// has its own cache (the functions stay reentrant), a plan lives until the thread ends or
+// ForgetFFTPlans(), so its tables are computed by the first call of a kind only. Plans above
+// const_PlanCacheMaxSize points aren't kept: they are created in tmp, a plan of the caller
+// freed when it returns, so a call holds no memory afterwards.
+template <class T>
+class CFFTPlanCacheT
 {
-	if (nInCnt < 2) return -1;
+public:
+	~CFFTPlanCacheT()
+	{
+		Clear();
+	}
 
-	size_t N = 1;
-	int pw = 0;
-	while (N < nInCnt)
+	void Clear()
 	{
-		N <<= 1;
-		pw++;
+		typename std::map<std::pair<size_t, int>, CFFTPlanT<T> *>::iterator it;
+		for (it = m_mapPlans.begin(); it != m_mapPlans.end(); ++it)
+			delete it->second;
+		m_mapPlans.clear();
 	}
 
-	std::vector<double> arTmpOutput;
-	arTmpOutput.resize(2 * N);
-	arOutput.resize(N);
-	size_t i;
-	for (i = 0; i < nInCnt; i++)
+	int Get(CFFTPlanBase::TTransform eType, size_t N, bool bInverse, bool bOrthNorm, CFFTPlanT<T> &tmp, CFFTPlanT<T> *&pPlan)
 	{
-		arTmpOutput[2 * i] = pInVal[i].real();
-		arTmpOutput[2 * i + 1] = pInVal[i].imag();
+		if (N > const_PlanCacheMaxSize)
+		{
+			int nRes = tmp.Create(eType, N, bInverse, bOrthNorm);
+			pPlan = (nRes == 0) ? &tmp : NULL;
+			return nRes;
+		}
+
+		std::pair<size_t, int> key(N, 4 * int(eType) + (bInverse ? 2 : 0) + (bOrthNorm ? 1 : 0));
+		typename std::map<std::pair<size_t, int>, CFFTPlanT<T> *>::iterator it = m_mapPlans.find(key);
+		if (it != m_mapPlans.end())
+		{
+			pPlan = it->second;
+			return 0;
+		}
+
+		pPlan = new CFFTPlanT<T>;
+		int nRes = pPlan->Create(eType, N, bInverse, bOrthNorm);
+		if (nRes != 0)
+		{
+			delete pPlan;
+			pPlan = NULL;
+			return nRes;
+		}
+		m_mapPlans[key] = pPlan;
+		return 0;
 	}
 
-	double w1 = cos(const_PI / double(N) );
-	double w2 = bInverse ? sin(const_PI / double(N) ) : -sin(const_PI / double(N) );
+private:
+	std::map<std::pair<size_t, int>, CFFTPlanT<T> *> m_mapPlans;
+};
 
-	do_complex_dft(int(2 * N), w1, w2, &arTmpOutput[0]);
+template <class T>
+static CFFTPlanCacheT<T> &do_plan_cache()
+{
+	static thread_local CFFTPlanCacheT<T> cache;
+	return cache;
+}
 
-	double norm = 1.;
-	if (bOrthNorm)
-		norm = ::sqrt(1. / N);
-	else if (!bInverse)
-		norm = 1. / N;
-	for (i = 0; i < N; i++)
-		arOutput[i] = std::complex<double>(arTmpOutput[2 * i] * norm, arTmpOutput[2 * i + 1] * norm);
+template <class T>
+static int do_cached_plan(CFFTPlanBase::TTransform eType, size_t N, bool bInverse, bool bOrthNorm, CFFTPlanT<T> &tmp, CFFTPlanT<T> *&pPlan)
+{
+	return do_plan_cache<T>().Get(eType, N, bInverse, bOrthNorm, tmp, pPlan);
+}
 
-	return 0;
+void ForgetFFTPlans()
+{
+	do_plan_cache<double>().Clear();
+	do_plan_cache<float>().Clear();
+}
+
+// Transform by a cached plan, its tables are computed directly
+template <class T, class TIn, class TOut>
+static int do_cached_execute(CFFTPlanBase::TTransform eType, size_t N, bool bInverse, bool bOrthNorm,
+	size_t nInCnt, const TIn *pInVal, std::vector<TOut> &arOutput)
+{
+	CFFTPlanT<T> tmp, *pPlan;
+	int nRes = do_cached_plan<T>(eType, N, bInverse, bOrthNorm, tmp, pPlan);
+	if (nRes != 0) return nRes;
+	return pPlan->Execute(nInCnt, pInVal, arOutput);
+}
+
+// Fast Fourier transform (real input) by the cached plan of the padded size. Output is always multiple of 2
+template <class T>
+static int do_FFT(size_t nInCnt, const T *pInVal, std::vector<std::complex<T> > &arOutput, bool bInverse, bool bOrthNorm)
+{
+	if (nInCnt < 2) return -1;
+
+	size_t N = 1;
+	while (N < nInCnt)
+		N <<= 1;
+
+	return do_cached_execute<T>(CFFTPlanBase::COMPLEX, N, bInverse, bOrthNorm, nInCnt, pInVal, arOutput);
+}
+
+int FFT(size_t nInCnt, double *pInVal, std::vector<std::complex<double> > &arOutput, bool bInverse, bool bOrthNorm/* = true*/)
+{
+	return do_FFT(nInCnt, (const double *) pInVal, arOutput, bInverse, bOrthNorm);
+}
+
+int FFT(size_t nInCnt, const float *pInVal, std::vector<std::complex<float> > &arOutput, bool bInverse, bool bOrthNorm/* = true*/)
+{
+	return do_FFT(nInCnt, pInVal, arOutput, bInverse, bOrthNorm);
+}
+
+// Fast Fourier transform (complex input) by the cached plan of the padded size. Output is always multiple of 2
+template <class T>
+static int do_FFT(size_t nInCnt, const std::complex<T> *pInVal, std::vector<std::complex<T> > &arOutput, bool bInverse, bool bOrthNorm)
+{
+	if (nInCnt < 2) return -1;
+
+	size_t N = 1;
+	while (N < nInCnt)
+		N <<= 1;
+
+	return do_cached_execute<T>(CFFTPlanBase::COMPLEX, N, bInverse, bOrthNorm, nInCnt, pInVal, arOutput);
+}
+
+int FFT(size_t nInCnt, const std::complex<double> *pInVal, std::vector<std::complex<double> > &arOutput, bool bInverse, bool bOrthNorm/* = true*/)
+{
+	return do_FFT(nInCnt, pInVal, arOutput, bInverse, bOrthNorm);
+}
+
+int FFT(size_t nInCnt, const std::complex<float> *pInVal, std::vector<std::complex<float> > &arOutput, bool bInverse, bool bOrthNorm/* = true*/)
+{
+	return do_FFT(nInCnt, pInVal, arOutput, bInverse, bOrthNorm);
+}
+
+// Fast Fourier transform (complex input, caller provided output) by the cached plan.
+// In place when pIn == pOut
+template <class T>
+static int do_FFT(size_t nCnt, const std::complex<T> *pIn, std::complex<T> *pOut, bool bInverse, bool bOrthNorm)
+{
+	if (nCnt < 2) return -1;
+
+	CFFTPlanT<T> tmp, *pPlan;
+	int nRes = do_cached_plan<T>(CFFTPlanBase::COMPLEX, nCnt, bInverse, bOrthNorm, tmp, pPlan);
+	if (nRes != 0) return nRes;
+	return pPlan->Execute(pIn, pOut);
+}
+
+int FFT(size_t nCnt, const std::complex<double> *pIn, std::complex<double> *pOut, bool bInverse, bool bOrthNorm/* = true*/)
+{
+	return do_FFT(nCnt, pIn, pOut, bInverse, bOrthNorm);
+}
+
+int FFT(size_t nCnt, const std::complex<float> *pIn, std::complex<float> *pOut, bool bInverse, bool bOrthNorm/* = true*/)
+{
+	return do_FFT(nCnt, pIn, pOut, bInverse, bOrthNorm);
 }
 
 // Forward Transform: 2 * n -> n + 1 elements (i.e. complex conjurgate half is ignored)
 // Inverse Transform: n + 1 -> 2 * n elements
-int RFFT(const v_double &f, v_complex &F, bool bOrthNorm /*= true*/)
+// Runs the cached REAL plan (an n-point complex transform on the packed input), not 2 * n
+template <class T>
+static int do_RFFT(const std::vector<T> &f, std::vector<std::complex<T> > &F, bool bOrthNorm)
 {
-	size_t n = F.size();
+	size_t n = f.size();
 	if (n < 4) return -1;
 
 	size_t N = 1;
-	int pw = 0;
 	while (N < n)
-	{
 		N <<= 1;
-		pw++;
-	}
 
-	std::vector<double> arTmpOutput;
-	arTmpOutput.resize(2 * N);
-	F.resize(N/2+1);
-	size_t i;
-	for (i = 0; i < n; i++)
-		arTmpOutput[2 * i] = f[i];
-
-	double w1 =  cos(const_PI / double(N));
-	double w2 = -sin(const_PI / double(N));
-
-	do_complex_dft(int(2 * N), w1, w2, &arTmpOutput[0]);
+	return do_cached_execute<T>(CFFTPlanBase::REAL, N, false, bOrthNorm, n, &f[0], F);
+}
 
-	double norm = bOrthNorm ? ::sqrt(1. / N) : 1. / N;;
-		
-	for (i = 0; i < N/2+1; i++)
-		F[i] = std::complex<double>(arTmpOutput[2 * i] * norm, arTmpOutput[2 * i + 1] * norm);
+int RFFT(const v_double &f, v_complex &F, bool bOrthNorm /*= true*/)
+{
+	return do_RFFT(f, F, bOrthNorm);
+}
 
-	return 0;
+int RFFT(const v_float &f, v_complex_f &F, bool bOrthNorm /*= true*/)
+{
+	return do_RFFT(f, F, bOrthNorm);
 }
 
-// Inverse Transform: n + 1 -> 2 * n elements
-int IRFFT(const v_complex &F, v_double &f, bool bOrthNorm/* = true*/)
+// Inverse Transform: n + 1 -> 2 * n elements (cached REAL plan)
+template <class T>
+static int do_IRFFT(const std::vector<std::complex<T> > &F, std::vector<T> &f, bool bOrthNorm)
 {
 	size_t n = F.size();
 	if (n < 3) return -1;
@@ -618,33 +968,20 @@ int IRFFT(const v_complex &F, v_double &f, bool bOrthNorm/* = true*/)
 	if ( (N & (N-1)) !=0 ) return -2;  // Must be 2^m+1 elements	
 	N <<= 1;
 
-	std::vector<double> arTmpOutput;
-	arTmpOutput.resize(2 * N);
-	f.resize(N);
-	size_t i;
-	for (i = 0; i < n; i++)
-	{
-		arTmpOutput[2 * i]     = F[i].real();
-		arTmpOutput[2 * i + 1] = F[i].imag();
-	}
-	for (i = 1; i < n; i++)
-	{
-		arTmpOutput[2 * N - 2 * i]     =  F[i].real();
-		arTmpOutput[2 * N - 2 * i + 1] = -F[i].imag();		
-	}
-
-	double w1 = cos(const_PI / double(N));
-	double w2 = sin(const_PI / double(N));
-
-	do_complex_dft(int(2 * N), w1, w2, &arTmpOutput[0]);
-
-	double norm = bOrthNorm ? ::sqrt(1. / N) : 1.;
+	CFFTPlanT<T> tmp, *pPlan;
+	int nRes = do_cached_plan<T>(CFFTPlanBase::REAL, N, true, bOrthNorm, tmp, pPlan);
+	if (nRes != 0) return nRes;
+	return pPlan->Execute(F, f);
+}
 
-	if (bOrthNorm) norm = ::sqrt(1. / N);
-	for (i = 0; i < N; i++)
-		f[i] = arTmpOutput[2 * i] * norm;
+int IRFFT(const v_complex &F, v_double &f, bool bOrthNorm/* = true*/)
+{
+	return do_IRFFT(F, f, bOrthNorm);
+}
 
-	return 0;
+int IRFFT(const v_complex_f &F, v_float &f, bool bOrthNorm/* = true*/)
+{
+	return do_IRFFT(F, f, bOrthNorm);
 }
 
 // Forward Transform: 2 * n -> n + 1 elements (i.e. complex conjurgate half is ignored)
@@ -729,7 +1066,8 @@ int IRFFT2(const v_complex &F, v_double &f)
 
 
 // Fast discrete cosine transform based on FFT (interface)
-int FDCT(size_t nInCnt, const double *pInVal, std::vector<double> &arOutput, bool bInverse, bool bOrthNorm/*=true*/)
+template <class T>
+static int do_FDCT(size_t nInCnt, const T *pInVal, std::vector<T> &arOutput, bool bInverse, bool bOrthNorm)
 {
 	if (nInCnt < 2) return -1;
 
@@ -741,6 +1079,9 @@ int FDCT(size_t nInCnt, const double *pInVal, std::vector<double> &arOutput, boo
 		pw++;
 	}
 
+	if (bAccurateTwiddles)
+		return do_cached_execute<T>(CFFTPlanBase::DCT, N, bInverse, bOrthNorm, nInCnt, pInVal, arOutput);
+
 	arOutput.resize(N);
 	size_t i;
 	for (i = 0; i < nInCnt; i++)
@@ -788,70 +1129,45 @@ int FDCT(size_t nInCnt, const double *pInVal, std::vector<double> &arOutput, boo
 	return 0;
 }
 
-// Fast discrete cosine transform based on 4N FFT method (interface)
+int FDCT(size_t nInCnt, const double *pInVal, std::vector<double> &arOutput, bool bInverse, bool bOrthNorm/*=true*/)
+{
+	return do_FDCT(nInCnt, pInVal, arOutput, bInverse, bOrthNorm);
+}
+
+int FDCT(size_t nInCnt, const float *pInVal, std::vector<float> &arOutput, bool bInverse, bool bOrthNorm/*=true*/)
+{
+	return do_FDCT(nInCnt, pInVal, arOutput, bInverse, bOrthNorm);
+}
+
+// Fast discrete cosine transform (interface). FDCT() of the input zero padded
+// to a power of 2 by the cached plan, first n values of the output.
 int FDCT2(bool bInverse, int n, double *in, double *out)
 {
 	if (n < 2) return -1;
 
 	int i;
 	int N = 1;
-	int pw = 0;
 	while (N < n)
-	{
 		N <<= 1;
-		pw++;
-	}
-
-	int N_fft = N * 4;
 
-	std::vector<double> fft_re(N_fft), fft_im(N_fft);
-
-	if (bInverse)
-	{
-		for (i = 0; i < n; i++)
-		{
-			fft_re[i] = in[i];
-			fft_re[2*N - i] = -in[i];
-		}
-		for (i = 1; i < n; i++)
-		{
-			fft_re[2*N + i] = - in[i];
-			fft_re[4*N - i] = in[i];
-		}
-	}
-	else
-	{
-		for (i = 0; i < n; i++)
-		{
-			fft_re[i * 2 + 1] = in[i];
-			fft_re[N_fft - (i * 2) - 1] = in[i];
-		}
-	}
+	CFFTPlan tmp, *pPlan;
+	int nRes = do_cached_plan<double>(CFFTPlanBase::DCT, N, bInverse, true, tmp, pPlan);
+	if (nRes != 0) return nRes;
 
-	if (bInverse)
-		do_fft(-1, pw + 2, &fft_re[0], &fft_im[0]);
-	else
-		do_fft(1, pw + 2, &fft_re[0], &fft_im[0]);
+	std::vector<double> arData(N, 0.);
+	for (i = 0; i < n; i++)
+		arData[i] = in[i];
+	nRes = pPlan->Execute(&arData[0]);
+	if (nRes != 0) return nRes;
 
-	if (bInverse)
-	{
-		for (i = 0; i < n; i++)
-		{
-			out[i] = fft_re[i*2+1];
-		}
-	}
-	else
-	{
-		for (i = 0; i < n; i++)
-		{
-			out[i] = fft_re[i];
-		}
-	}
+	for (i = 0; i < n; i++)
+		out[i] = arData[i];
 	return 0;
 }
 
 // Fast discrete sine transform (interface)
-int FDST(size_t nInCnt, const double *pInVal, std::vector<double> &arOutput, bool bInverse, bool bOrthNorm/*=true*/)
+template <class T>
+static int do_FDST(size_t nInCnt, const T *pInVal, std::vector<T> &arOutput, bool bInverse, bool bOrthNorm)
 {
 	if (nInCnt < 2) return -1;
 
@@ -863,6 +1179,9 @@ int FDST(size_t nInCnt, const double *pInVal, std::vector<double> &arOutput, boo
 		pw++;
 	}
 
+	if (bAccurateTwiddles)
+		return do_cached_execute<T>(CFFTPlanBase::DST, N, bInverse, bOrthNorm, nInCnt, pInVal, arOutput);
+
 	arOutput.resize(N);
 	size_t i;
 	for (i = 0; i < nInCnt; i++)
@@ -902,141 +1221,8682 @@ int FDST(size_t nInCnt, const double *pInVal, std::vector<double> &arOutput, boo
 	return 0;
 }
 
-static int nTestNum = 0;
-static int nTestErrNum = 0;
-
-#define TEST(a) { nTestNum ++; \
-	if (!(a)) {printf("Test %d FAILED! (%s)\n", nTestNum, #a); nTestErrNum++; } }
-#define EXPECT(a,b) { nTestNum ++; \
-	if (!(fabs(double(a)-double(b))<0.0001)) {printf("Test %d FAILED! (%s==%g, expexted %g)\n", nTestNum, #a, double(a), double(b)); nTestErrNum++; } }
-#define FAIL(a) { nTestNum ++; \
-	if (!(a)) {printf("Test %d FAILED! (%s)\n", nTestNum, #a); return nTestNum; } }
-#define EXPECT_FAIL(a,b) { nTestNum ++; \
-	if (!(fabs(double(a)-double(b))<0.0001)) {printf("Test %d FAILED! (%s==%g, expexted %g)\n", nTestNum, #a, double(a), double(b)); return nTestNum; } }
-
-#define USE_N 8
+int FDST(size_t nInCnt, const double *pInVal, std::vector<double> &arOutput, bool bInverse, bool bOrthNorm/*=true*/)
+{
+	return do_FDST(nInCnt, pInVal, arOutput, bInverse, bOrthNorm);
+}
 
-int run_FFT_selftest()
+int FDST(size_t nInCnt, const float *pInVal, std::vector<float> &arOutput, bool bInverse, bool bOrthNorm/*=true*/)
+{
+	return do_FDST(nInCnt, pInVal, arOutput, bInverse, bOrthNorm);
+}
+
+// Angle of the twiddle factor exp(2*pi*i*k/N) reduced to the first octant by integer
+// arithmetic: pi * a / 4N, 0 <= a <= N. nFlags tells do_unfold_twiddle() how to get back.
+static size_t do_fold_twiddle(size_t k, size_t N, int &nFlags)
+{
+	size_t r = (k < N) ? k : k % N;
+	nFlags = 0;
+	if (2 * r > N)                  // angle in (pi, 2*pi): conjugate of 2*pi - angle
+	{
+		r = N - r;
+		nFlags |= 1;
+	}
+	size_t a = 8 * r;               // angle = pi * a / 4N, a <= 4N
+	if (a > 2 * N)                  // pi/2 + angle of a - 2N
+	{
+		a -= 2 * N;
+		nFlags |= 2;
+	}
+	if (a > N)                      // pi/2 - angle of 2N - a
+	{
+		a = 2 * N - a;
+		nFlags |= 4;
+	}
+	return a;
+}
+
+// Twiddle factor (c, s) from the cosine x and the sine y of the folded angle
+template <class T>
+static void do_unfold_twiddle(T x, T y, int nFlags, T &c, T &s)
+{
+	if ((nFlags & 4) != 0)
+		std::swap(x, y);
+	if ((nFlags & 2) != 0)
+	{
+		T t = x;
+		x = -y;
+		y = t;
+	}
+	c = x;
+	s = ((nFlags & 1) != 0) ? -y : y;
+}
+
+// Twiddle factor exp(2*pi*i*k/N) = (c, s) of plan tables. The angle is reduced to the
+// first octant by integer arithmetic, so the cosine and sine of a small angle are
+// evaluated (in long double) and symmetric twiddles are equal to the last bit.
+static void do_twiddle(size_t k, size_t N, long double &c, long double &s)
+{
+	const long double pi = 3.141592653589793238462643383279502884L;
+	int nFlags;
+	size_t a = do_fold_twiddle(k, N, nFlags);
+	long double phi = pi * (long double) a / (long double) (4 * N);
+	do_unfold_twiddle(cosl(phi), sinl(phi), nFlags, c, s);
+}
+
+static void do_twiddle(size_t k, size_t N, double &c, double &s)
+{
+	long double x, y;
+	do_twiddle(k, N, x, y);
+	c = double(x);
+	s = double(y);
+}
+
+// do_twiddle() of every size n dividing N by a table of the first octant of N, evaluated
+// once: a large plan computes about N/8 cosines and sines instead of one per entry. The
+// angle pi * a / 4n is pi * (a * N/n) / 4N, and unfolding only swaps and negates, so the
+// factors are the same to the last bit.
+class CTwiddleTable
+{
+public:
+	explicit CTwiddleTable(size_t N)
+		: m_nSize(N)
+		, m_nShift((N % 4 == 0) ? 3 : ((N % 2 == 0) ? 2 : 1))  // folded angles are multiples of 2^m_nShift
+	{
+		const long double pi = 3.141592653589793238462643383279502884L;
+		size_t i;
+		m_arOctant.resize(2 * ((N >> m_nShift) + 1));
+		for (i = 0; 2 * i < m_arOctant.size(); i++)
+		{
+			long double phi = pi * (long double) (i << m_nShift) / (long double) (4 * N);
+			m_arOctant[2 * i] = double(cosl(phi));
+			m_arOctant[2 * i + 1] = double(sinl(phi));
+		}
+	}
+
+	void Get(size_t k, size_t n, double &c, double &s) const
+	{
+		int nFlags;
+		size_t a = do_fold_twiddle(k * (m_nSize / n), m_nSize, nFlags) >> m_nShift;
+		do_unfold_twiddle(m_arOctant[2 * a], m_arOctant[2 * a + 1], nFlags, c, s);
+	}
+
+private:
+	size_t m_nSize;
+	int m_nShift;
+	std::vector<double> m_arOctant;       // cosine and sine of pi * (a << m_nShift) / 4N
+};
+
+// Bit reversal permutation by a precomputed table (in place)
+template <class T>
+static void do_bit_reverse_table(size_t n, const unsigned int *rev, T *a)
+{
+	size_t i, j;
+	T xr, xi;
+
+	for (i = 0; i < n; i++)
+	{
+		j = rev[i];
+		if (i < j)
+		{
+			xr = a[2 * i];
+			xi = a[2 * i + 1];
+			a[2 * i] = a[2 * j];
+			a[2 * i + 1] = a[2 * j + 1];
+			a[2 * j] = xr;
+			a[2 * j + 1] = xi;
+		}
+	}
+}
+
+// Bit reversal permutation by a precomputed table (out of place)
+template <class T>
+static void do_bit_reverse_copy(size_t n, const unsigned int *rev, const T *in, T *out)
+{
+	size_t i, j;
+
+	for (i = 0; i < n; i++)
+	{
+		j = rev[i];
+		out[2 * j] = in[2 * i];
+		out[2 * j + 1] = in[2 * i + 1];
+	}
+}
+
+// First radix-2 pass of the decimation in time algorithm. All twiddles are 1.
+// Combines blocks of L complex numbers (L > 1 for interleaved signals)
+template <class T>
+static void do_radix2_pass(size_t n, size_t L, T *a)
+{
+	size_t j, k;
+	T xr, xi;
+
+	for (j = 0; j < 2 * n; j += 4 * L)
+	{
+		T *p0 = a + j;
+		T *p1 = p0 + 2 * L;
+		for (k = 0; k < 2 * L; k += 2)
+		{
+			xr = p0[k] - p1[k];
+			xi = p0[k + 1] - p1[k + 1];
+			p0[k] += p1[k];
+			p0[k + 1] += p1[k + 1];
+			p1[k] = xr;
+			p1[k + 1] = xi;
+		}
+	}
+}
+
+// Radix-4 pass of the decimation in time algorithm (two radix-2 stages at once).
+// Combines sub-transforms of L points into transforms of 4*L points.
+// w1[k] = exp(-+2*pi*i*k/2L), w2[k] = exp(-+2*pi*i*k/4L), k = 0..L-1 (interleaved)
+template <class T>
+static void do_radix4_pass(size_t n, size_t L, const T *w1, const T *w2, T *a, bool bInverse)
+{
+	size_t j, k;
+	T t1r, t1i, t3r, t3i, b0r, b0i, b1r, b1i, b2r, b2i, b3r, b3i, u2r, u2i, u3r, u3i;
+	T s = bInverse ? 1. : -1.;
+
+	for (j = 0; j < n; j += 4 * L)
+	{
+		T *p0 = a + 2 * j;
+		T *p1 = p0 + 2 * L;
+		T *p2 = p1 + 2 * L;
+		T *p3 = p2 + 2 * L;
+		for (k = 0; k < 2 * L; k += 2)
+		{
+			t1r = p1[k] * w1[k] - p1[k + 1] * w1[k + 1];
+			t1i = p1[k] * w1[k + 1] + p1[k + 1] * w1[k];
+			t3r = p3[k] * w1[k] - p3[k + 1] * w1[k + 1];
+			t3i = p3[k] * w1[k + 1] + p3[k + 1] * w1[k];
+			b0r = p0[k] + t1r;
+			b0i = p0[k + 1] + t1i;
+			b1r = p0[k] - t1r;
+			b1i = p0[k + 1] - t1i;
+			b2r = p2[k] + t3r;
+			b2i = p2[k + 1] + t3i;
+			b3r = p2[k] - t3r;
+			b3i = p2[k + 1] - t3i;
+			u2r = b2r * w2[k] - b2i * w2[k + 1];
+			u2i = b2r * w2[k + 1] + b2i * w2[k];
+			// u3 = b3 * w2 * (-+i)
+			u3r = -s * (b3r * w2[k + 1] + b3i * w2[k]);
+			u3i = s * (b3r * w2[k] - b3i * w2[k + 1]);
+			p0[k] = b0r + u2r;
+			p0[k + 1] = b0i + u2i;
+			p2[k] = b0r - u2r;
+			p2[k + 1] = b0i - u2i;
+			p1[k] = b1r + u3r;
+			p1[k + 1] = b1i + u3i;
+			p3[k] = b1r - u3r;
+			p3[k + 1] = b1i - u3i;
+		}
+	}
+}
+
+// Bit reversal permutation of a split complex array part (in place when in == out)
+template <class T>
+static void do_bit_reverse_split(size_t n, const unsigned int *rev, const T *in, T *out)
+{
+	size_t i, j;
+
+	if (in == out)
+	{
+		for (i = 0; i < n; i++)
+		{
+			j = rev[i];
+			if (i < j)
+				std::swap(out[i], out[j]);
+		}
+	}
+	else
+	{
+		for (i = 0; i < n; i++)
+			out[rev[i]] = in[i];
+	}
+}
+
+// do_radix2_pass() on split arrays (real and imaginary parts), L = 1
+template <class T>
+static void do_radix2_pass_split(size_t n, T *re, T *im)
+{
+	size_t j;
+	T xr, xi;
+
+	for (j = 0; j < n; j += 2)
+	{
+		xr = re[j] - re[j + 1];
+		xi = im[j] - im[j + 1];
+		re[j] += re[j + 1];
+		im[j] += im[j + 1];
+		re[j + 1] = xr;
+		im[j + 1] = xi;
+	}
+}
+
+// do_radix4_pass() on split arrays. tw holds real parts of w1[], imaginary parts of w1[],
+// then the same of w2[] (L values each)
+template <class T>
+static void do_radix4_pass_split(size_t n, size_t L, const T *tw, T *re, T *im, bool bInverse)
+{
+	size_t j, k;
+	T t1r, t1i, t3r, t3i, b0r, b0i, b1r, b1i, b2r, b2i, b3r, b3i, u2r, u2i, u3r, u3i;
+	T s = bInverse ? 1. : -1.;
+	const T *w1r = tw;
+	const T *w1i = w1r + L;
+	const T *w2r = w1i + L;
+	const T *w2i = w2r + L;
+
+	for (j = 0; j < n; j += 4 * L)
+	{
+		T *r0 = re + j, *r1 = r0 + L, *r2 = r1 + L, *r3 = r2 + L;
+		T *i0 = im + j, *i1 = i0 + L, *i2 = i1 + L, *i3 = i2 + L;
+		for (k = 0; k < L; k++)
+		{
+			t1r = r1[k] * w1r[k] - i1[k] * w1i[k];
+			t1i = r1[k] * w1i[k] + i1[k] * w1r[k];
+			t3r = r3[k] * w1r[k] - i3[k] * w1i[k];
+			t3i = r3[k] * w1i[k] + i3[k] * w1r[k];
+			b0r = r0[k] + t1r;
+			b0i = i0[k] + t1i;
+			b1r = r0[k] - t1r;
+			b1i = i0[k] - t1i;
+			b2r = r2[k] + t3r;
+			b2i = i2[k] + t3i;
+			b3r = r2[k] - t3r;
+			b3i = i2[k] - t3i;
+			u2r = b2r * w2r[k] - b2i * w2i[k];
+			u2i = b2r * w2i[k] + b2i * w2r[k];
+			// u3 = b3 * w2 * (-+i)
+			u3r = -s * (b3r * w2i[k] + b3i * w2r[k]);
+			u3i = s * (b3r * w2r[k] - b3i * w2i[k]);
+			r0[k] = b0r + u2r;
+			i0[k] = b0i + u2i;
+			r2[k] = b0r - u2r;
+			i2[k] = b0i - u2i;
+			r1[k] = b1r + u3r;
+			i1[k] = b1i + u3i;
+			r3[k] = b1r - u3r;
+			i3[k] = b1i - u3i;
+		}
+	}
+}
+
+#ifdef FFT_X86
+
+// Same as do_radix4_pass(), one complex number per SSE2 register
+FFT_TARGET("sse2") static inline __m128d cmul_sse2(__m128d a, __m128d w)
+{
+	__m128d wr = _mm_unpacklo_pd(w, w);
+	__m128d wi = _mm_unpackhi_pd(w, w);
+	__m128d as = _mm_shuffle_pd(a, a, 1);
+	__m128d t = _mm_xor_pd(_mm_mul_pd(as, wi), _mm_set_pd(0., -0.));
+	return _mm_add_pd(_mm_mul_pd(a, wr), t);
+}
+
+FFT_TARGET("sse2") static void do_radix4_pass_sse2(size_t n, size_t L, const double *w1, const double *w2, double *a, bool bInverse)
+{
+	size_t j, k;
+	// Multiplication by -i (forward) or +i (inverse) is a swap and a sign change
+	__m128d sgn = bInverse ? _mm_set_pd(0., -0.) : _mm_set_pd(-0., 0.);
+
+	for (j = 0; j < n; j += 4 * L)
+	{
+		double *p0 = a + 2 * j;
+		double *p1 = p0 + 2 * L;
+		double *p2 = p1 + 2 * L;
+		double *p3 = p2 + 2 * L;
+		for (k = 0; k < 2 * L; k += 2)
+		{
+			__m128d v1 = _mm_loadu_pd(w1 + k);
+			__m128d v2 = _mm_loadu_pd(w2 + k);
+			__m128d x0 = _mm_loadu_pd(p0 + k);
+			__m128d t1 = cmul_sse2(_mm_loadu_pd(p1 + k), v1);
+			__m128d x2 = _mm_loadu_pd(p2 + k);
+			__m128d t3 = cmul_sse2(_mm_loadu_pd(p3 + k), v1);
+			__m128d b0 = _mm_add_pd(x0, t1);
+			__m128d b1 = _mm_sub_pd(x0, t1);
+			__m128d u2 = cmul_sse2(_mm_add_pd(x2, t3), v2);
+			__m128d u3 = cmul_sse2(_mm_sub_pd(x2, t3), v2);
+			u3 = _mm_xor_pd(_mm_shuffle_pd(u3, u3, 1), sgn);
+			_mm_storeu_pd(p0 + k, _mm_add_pd(b0, u2));
+			_mm_storeu_pd(p2 + k, _mm_sub_pd(b0, u2));
+			_mm_storeu_pd(p1 + k, _mm_add_pd(b1, u3));
+			_mm_storeu_pd(p3 + k, _mm_sub_pd(b1, u3));
+		}
+	}
+}
+
+// Same as do_radix4_pass(), two complex numbers per AVX register. L >= 2
+FFT_TARGET("avx2,fma") static inline __m256d cmul_avx2(__m256d a, __m256d w)
+{
+	__m256d wr = _mm256_movedup_pd(w);
+	__m256d wi = _mm256_permute_pd(w, 0xF);
+	__m256d as = _mm256_permute_pd(a, 0x5);
+	return _mm256_fmaddsub_pd(a, wr, _mm256_mul_pd(as, wi));
+}
+
+FFT_TARGET("avx2,fma") static void do_radix4_pass_avx2(size_t n, size_t L, const double *w1, const double *w2, double *a, bool bInverse)
+{
+	size_t j, k;
+	__m256d sgn = bInverse ? _mm256_set_pd(0., -0., 0., -0.) : _mm256_set_pd(-0., 0., -0., 0.);
+
+	for (j = 0; j < n; j += 4 * L)
+	{
+		double *p0 = a + 2 * j;
+		double *p1 = p0 + 2 * L;
+		double *p2 = p1 + 2 * L;
+		double *p3 = p2 + 2 * L;
+		for (k = 0; k < 2 * L; k += 4)
+		{
+			__m256d v1 = _mm256_loadu_pd(w1 + k);
+			__m256d v2 = _mm256_loadu_pd(w2 + k);
+			__m256d x0 = _mm256_loadu_pd(p0 + k);
+			__m256d t1 = cmul_avx2(_mm256_loadu_pd(p1 + k), v1);
+			__m256d x2 = _mm256_loadu_pd(p2 + k);
+			__m256d t3 = cmul_avx2(_mm256_loadu_pd(p3 + k), v1);
+			__m256d b0 = _mm256_add_pd(x0, t1);
+			__m256d b1 = _mm256_sub_pd(x0, t1);
+			__m256d u2 = cmul_avx2(_mm256_add_pd(x2, t3), v2);
+			__m256d u3 = cmul_avx2(_mm256_sub_pd(x2, t3), v2);
+			u3 = _mm256_xor_pd(_mm256_permute_pd(u3, 0x5), sgn);
+			_mm256_storeu_pd(p0 + k, _mm256_add_pd(b0, u2));
+			_mm256_storeu_pd(p2 + k, _mm256_sub_pd(b0, u2));
+			_mm256_storeu_pd(p1 + k, _mm256_add_pd(b1, u3));
+			_mm256_storeu_pd(p3 + k, _mm256_sub_pd(b1, u3));
+		}
+	}
+}
+
+// Same as do_radix4_pass(), four complex numbers per AVX-512 register. L >= 4
+FFT_TARGET("avx512f") static inline __m512d cmul_avx512(__m512d a, __m512d w)
+{
+	__m512d wr = _mm512_movedup_pd(w);
+	__m512d wi = _mm512_permute_pd(w, 0xFF);
+	__m512d as = _mm512_permute_pd(a, 0x55);
+	return _mm512_fmaddsub_pd(a, wr, _mm512_mul_pd(as, wi));
+}
+
+FFT_TARGET("avx512f") static void do_radix4_pass_avx512(size_t n, size_t L, const double *w1, const double *w2, double *a, bool bInverse)
+{
+	size_t j, k;
+	// Negates imaginary (forward) or real (inverse) parts
+	__mmask8 neg = bInverse ? 0x55 : 0xAA;
+	__m512d zero = _mm512_setzero_pd();
+
+	for (j = 0; j < n; j += 4 * L)
+	{
+		double *p0 = a + 2 * j;
+		double *p1 = p0 + 2 * L;
+		double *p2 = p1 + 2 * L;
+		double *p3 = p2 + 2 * L;
+		for (k = 0; k < 2 * L; k += 8)
+		{
+			__m512d v1 = _mm512_loadu_pd(w1 + k);
+			__m512d v2 = _mm512_loadu_pd(w2 + k);
+			__m512d x0 = _mm512_loadu_pd(p0 + k);
+			__m512d t1 = cmul_avx512(_mm512_loadu_pd(p1 + k), v1);
+			__m512d x2 = _mm512_loadu_pd(p2 + k);
+			__m512d t3 = cmul_avx512(_mm512_loadu_pd(p3 + k), v1);
+			__m512d b0 = _mm512_add_pd(x0, t1);
+			__m512d b1 = _mm512_sub_pd(x0, t1);
+			__m512d u2 = cmul_avx512(_mm512_add_pd(x2, t3), v2);
+			__m512d u3 = cmul_avx512(_mm512_sub_pd(x2, t3), v2);
+			u3 = _mm512_permute_pd(u3, 0x55);
+			u3 = _mm512_mask_sub_pd(u3, neg, zero, u3);
+			_mm512_storeu_pd(p0 + k, _mm512_add_pd(b0, u2));
+			_mm512_storeu_pd(p2 + k, _mm512_sub_pd(b0, u2));
+			_mm512_storeu_pd(p1 + k, _mm512_add_pd(b1, u3));
+			_mm512_storeu_pd(p3 + k, _mm512_sub_pd(b1, u3));
+		}
+	}
+}
+
+// Single precision versions of the passes above. Twice as many complex numbers
+// per register: SSE2 L >= 2, AVX2 L >= 4, AVX-512 L >= 8
+FFT_TARGET("sse2") static inline __m128 cmul_sse2(__m128 a, __m128 w)
+{
+	__m128 wr = _mm_shuffle_ps(w, w, _MM_SHUFFLE(2, 2, 0, 0));
+	__m128 wi = _mm_shuffle_ps(w, w, _MM_SHUFFLE(3, 3, 1, 1));
+	__m128 as = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+	__m128 t = _mm_xor_ps(_mm_mul_ps(as, wi), _mm_set_ps(0.f, -0.f, 0.f, -0.f));
+	return _mm_add_ps(_mm_mul_ps(a, wr), t);
+}
+
+FFT_TARGET("sse2") static void do_radix4_pass_sse2(size_t n, size_t L, const float *w1, const float *w2, float *a, bool bInverse)
+{
+	size_t j, k;
+	__m128 sgn = bInverse ? _mm_set_ps(0.f, -0.f, 0.f, -0.f) : _mm_set_ps(-0.f, 0.f, -0.f, 0.f);
+
+	for (j = 0; j < n; j += 4 * L)
+	{
+		float *p0 = a + 2 * j;
+		float *p1 = p0 + 2 * L;
+		float *p2 = p1 + 2 * L;
+		float *p3 = p2 + 2 * L;
+		for (k = 0; k < 2 * L; k += 4)
+		{
+			__m128 v1 = _mm_loadu_ps(w1 + k);
+			__m128 v2 = _mm_loadu_ps(w2 + k);
+			__m128 x0 = _mm_loadu_ps(p0 + k);
+			__m128 t1 = cmul_sse2(_mm_loadu_ps(p1 + k), v1);
+			__m128 x2 = _mm_loadu_ps(p2 + k);
+			__m128 t3 = cmul_sse2(_mm_loadu_ps(p3 + k), v1);
+			__m128 b0 = _mm_add_ps(x0, t1);
+			__m128 b1 = _mm_sub_ps(x0, t1);
+			__m128 u2 = cmul_sse2(_mm_add_ps(x2, t3), v2);
+			__m128 u3 = cmul_sse2(_mm_sub_ps(x2, t3), v2);
+			u3 = _mm_xor_ps(_mm_shuffle_ps(u3, u3, _MM_SHUFFLE(2, 3, 0, 1)), sgn);
+			_mm_storeu_ps(p0 + k, _mm_add_ps(b0, u2));
+			_mm_storeu_ps(p2 + k, _mm_sub_ps(b0, u2));
+			_mm_storeu_ps(p1 + k, _mm_add_ps(b1, u3));
+			_mm_storeu_ps(p3 + k, _mm_sub_ps(b1, u3));
+		}
+	}
+}
+
+FFT_TARGET("avx2,fma") static inline __m256 cmul_avx2(__m256 a, __m256 w)
+{
+	__m256 wr = _mm256_moveldup_ps(w);
+	__m256 wi = _mm256_movehdup_ps(w);
+	__m256 as = _mm256_permute_ps(a, 0xB1);
+	return _mm256_fmaddsub_ps(a, wr, _mm256_mul_ps(as, wi));
+}
+
+FFT_TARGET("avx2,fma") static void do_radix4_pass_avx2(size_t n, size_t L, const float *w1, const float *w2, float *a, bool bInverse)
+{
+	size_t j, k;
+	__m256 sgn = bInverse ? _mm256_set_ps(0.f, -0.f, 0.f, -0.f, 0.f, -0.f, 0.f, -0.f) : _mm256_set_ps(-0.f, 0.f, -0.f, 0.f, -0.f, 0.f, -0.f, 0.f);
+
+	for (j = 0; j < n; j += 4 * L)
+	{
+		float *p0 = a + 2 * j;
+		float *p1 = p0 + 2 * L;
+		float *p2 = p1 + 2 * L;
+		float *p3 = p2 + 2 * L;
+		for (k = 0; k < 2 * L; k += 8)
+		{
+			__m256 v1 = _mm256_loadu_ps(w1 + k);
+			__m256 v2 = _mm256_loadu_ps(w2 + k);
+			__m256 x0 = _mm256_loadu_ps(p0 + k);
+			__m256 t1 = cmul_avx2(_mm256_loadu_ps(p1 + k), v1);
+			__m256 x2 = _mm256_loadu_ps(p2 + k);
+			__m256 t3 = cmul_avx2(_mm256_loadu_ps(p3 + k), v1);
+			__m256 b0 = _mm256_add_ps(x0, t1);
+			__m256 b1 = _mm256_sub_ps(x0, t1);
+			__m256 u2 = cmul_avx2(_mm256_add_ps(x2, t3), v2);
+			__m256 u3 = cmul_avx2(_mm256_sub_ps(x2, t3), v2);
+			u3 = _mm256_xor_ps(_mm256_permute_ps(u3, 0xB1), sgn);
+			_mm256_storeu_ps(p0 + k, _mm256_add_ps(b0, u2));
+			_mm256_storeu_ps(p2 + k, _mm256_sub_ps(b0, u2));
+			_mm256_storeu_ps(p1 + k, _mm256_add_ps(b1, u3));
+			_mm256_storeu_ps(p3 + k, _mm256_sub_ps(b1, u3));
+		}
+	}
+}
+
+FFT_TARGET("avx512f") static inline __m512 cmul_avx512(__m512 a, __m512 w)
+{
+	__m512 wr = _mm512_moveldup_ps(w);
+	__m512 wi = _mm512_movehdup_ps(w);
+	__m512 as = _mm512_permute_ps(a, 0xB1);
+	return _mm512_fmaddsub_ps(a, wr, _mm512_mul_ps(as, wi));
+}
+
+FFT_TARGET("avx512f") static void do_radix4_pass_avx512(size_t n, size_t L, const float *w1, const float *w2, float *a, bool bInverse)
+{
+	size_t j, k;
+	__mmask16 neg = bInverse ? 0x5555 : 0xAAAA;
+	__m512 zero = _mm512_setzero_ps();
+
+	for (j = 0; j < n; j += 4 * L)
+	{
+		float *p0 = a + 2 * j;
+		float *p1 = p0 + 2 * L;
+		float *p2 = p1 + 2 * L;
+		float *p3 = p2 + 2 * L;
+		for (k = 0; k < 2 * L; k += 16)
+		{
+			__m512 v1 = _mm512_loadu_ps(w1 + k);
+			__m512 v2 = _mm512_loadu_ps(w2 + k);
+			__m512 x0 = _mm512_loadu_ps(p0 + k);
+			__m512 t1 = cmul_avx512(_mm512_loadu_ps(p1 + k), v1);
+			__m512 x2 = _mm512_loadu_ps(p2 + k);
+			__m512 t3 = cmul_avx512(_mm512_loadu_ps(p3 + k), v1);
+			__m512 b0 = _mm512_add_ps(x0, t1);
+			__m512 b1 = _mm512_sub_ps(x0, t1);
+			__m512 u2 = cmul_avx512(_mm512_add_ps(x2, t3), v2);
+			__m512 u3 = cmul_avx512(_mm512_sub_ps(x2, t3), v2);
+			u3 = _mm512_permute_ps(u3, 0xB1);
+			u3 = _mm512_mask_sub_ps(u3, neg, zero, u3);
+			_mm512_storeu_ps(p0 + k, _mm512_add_ps(b0, u2));
+			_mm512_storeu_ps(p2 + k, _mm512_sub_ps(b0, u2));
+			_mm512_storeu_ps(p1 + k, _mm512_add_ps(b1, u3));
+			_mm512_storeu_ps(p3 + k, _mm512_sub_ps(b1, u3));
+		}
+	}
+}
+
+// Same as do_radix4_pass_split(), 2 doubles per register. Split arrays need no shuffles:
+// the inverse only swaps the outputs of -i*v and +i*v.
+FFT_TARGET("sse2") static void do_radix4_pass_split_sse2(size_t n, size_t L, const double *tw, double *re, double *im, bool bInverse)
+{
+	size_t j, k;
+	const double *w1r = tw;
+	const double *w1i = w1r + L;
+	const double *w2r = w1i + L;
+	const double *w2i = w2r + L;
+
+	for (j = 0; j < n; j += 4 * L)
+	{
+		double *r0 = re + j, *r1 = r0 + L, *r2 = r1 + L, *r3 = r2 + L;
+		double *i0 = im + j, *i1 = i0 + L, *i2 = i1 + L, *i3 = i2 + L;
+		double *q1r = bInverse ? r3 : r1, *q1i = bInverse ? i3 : i1;
+		double *q3r = bInverse ? r1 : r3, *q3i = bInverse ? i1 : i3;
+		for (k = 0; k < L; k += 2)
+		{
+			__m128d ar = _mm_loadu_pd(w1r + k), ai = _mm_loadu_pd(w1i + k);
+			__m128d br = _mm_loadu_pd(w2r + k), bi = _mm_loadu_pd(w2i + k);
+			__m128d x1r = _mm_loadu_pd(r1 + k), x1i = _mm_loadu_pd(i1 + k);
+			__m128d x3r = _mm_loadu_pd(r3 + k), x3i = _mm_loadu_pd(i3 + k);
+			__m128d t1r = _mm_sub_pd(_mm_mul_pd(x1r, ar), _mm_mul_pd(x1i, ai));
+			__m128d t1i = _mm_add_pd(_mm_mul_pd(x1r, ai), _mm_mul_pd(x1i, ar));
+			__m128d t3r = _mm_sub_pd(_mm_mul_pd(x3r, ar), _mm_mul_pd(x3i, ai));
+			__m128d t3i = _mm_add_pd(_mm_mul_pd(x3r, ai), _mm_mul_pd(x3i, ar));
+			__m128d x0r = _mm_loadu_pd(r0 + k), x0i = _mm_loadu_pd(i0 + k);
+			__m128d x2r = _mm_loadu_pd(r2 + k), x2i = _mm_loadu_pd(i2 + k);
+			__m128d b0r = _mm_add_pd(x0r, t1r), b0i = _mm_add_pd(x0i, t1i);
+			__m128d b1r = _mm_sub_pd(x0r, t1r), b1i = _mm_sub_pd(x0i, t1i);
+			__m128d b2r = _mm_add_pd(x2r, t3r), b2i = _mm_add_pd(x2i, t3i);
+			__m128d b3r = _mm_sub_pd(x2r, t3r), b3i = _mm_sub_pd(x2i, t3i);
+			__m128d u2r = _mm_sub_pd(_mm_mul_pd(b2r, br), _mm_mul_pd(b2i, bi));
+			__m128d u2i = _mm_add_pd(_mm_mul_pd(b2r, bi), _mm_mul_pd(b2i, br));
+			__m128d vr = _mm_sub_pd(_mm_mul_pd(b3r, br), _mm_mul_pd(b3i, bi));
+			__m128d vi = _mm_add_pd(_mm_mul_pd(b3r, bi), _mm_mul_pd(b3i, br));
+			_mm_storeu_pd(r0 + k, _mm_add_pd(b0r, u2r));
+			_mm_storeu_pd(i0 + k, _mm_add_pd(b0i, u2i));
+			_mm_storeu_pd(r2 + k, _mm_sub_pd(b0r, u2r));
+			_mm_storeu_pd(i2 + k, _mm_sub_pd(b0i, u2i));
+			_mm_storeu_pd(q1r + k, _mm_add_pd(b1r, vi));
+			_mm_storeu_pd(q1i + k, _mm_sub_pd(b1i, vr));
+			_mm_storeu_pd(q3r + k, _mm_sub_pd(b1r, vi));
+			_mm_storeu_pd(q3i + k, _mm_add_pd(b1i, vr));
+		}
+	}
+}
+
+// Same as do_radix4_pass_split(), 4 doubles per register
+FFT_TARGET("avx2,fma") static void do_radix4_pass_split_avx2(size_t n, size_t L, const double *tw, double *re, double *im, bool bInverse)
+{
+	size_t j, k;
+	const double *w1r = tw;
+	const double *w1i = w1r + L;
+	const double *w2r = w1i + L;
+	const double *w2i = w2r + L;
+
+	for (j = 0; j < n; j += 4 * L)
+	{
+		double *r0 = re + j, *r1 = r0 + L, *r2 = r1 + L, *r3 = r2 + L;
+		double *i0 = im + j, *i1 = i0 + L, *i2 = i1 + L, *i3 = i2 + L;
+		double *q1r = bInverse ? r3 : r1, *q1i = bInverse ? i3 : i1;
+		double *q3r = bInverse ? r1 : r3, *q3i = bInverse ? i1 : i3;
+		for (k = 0; k < L; k += 4)
+		{
+			__m256d ar = _mm256_loadu_pd(w1r + k), ai = _mm256_loadu_pd(w1i + k);
+			__m256d br = _mm256_loadu_pd(w2r + k), bi = _mm256_loadu_pd(w2i + k);
+			__m256d x1r = _mm256_loadu_pd(r1 + k), x1i = _mm256_loadu_pd(i1 + k);
+			__m256d x3r = _mm256_loadu_pd(r3 + k), x3i = _mm256_loadu_pd(i3 + k);
+			__m256d t1r = _mm256_fmsub_pd(x1r, ar, _mm256_mul_pd(x1i, ai));
+			__m256d t1i = _mm256_fmadd_pd(x1r, ai, _mm256_mul_pd(x1i, ar));
+			__m256d t3r = _mm256_fmsub_pd(x3r, ar, _mm256_mul_pd(x3i, ai));
+			__m256d t3i = _mm256_fmadd_pd(x3r, ai, _mm256_mul_pd(x3i, ar));
+			__m256d x0r = _mm256_loadu_pd(r0 + k), x0i = _mm256_loadu_pd(i0 + k);
+			__m256d x2r = _mm256_loadu_pd(r2 + k), x2i = _mm256_loadu_pd(i2 + k);
+			__m256d b0r = _mm256_add_pd(x0r, t1r), b0i = _mm256_add_pd(x0i, t1i);
+			__m256d b1r = _mm256_sub_pd(x0r, t1r), b1i = _mm256_sub_pd(x0i, t1i);
+			__m256d b2r = _mm256_add_pd(x2r, t3r), b2i = _mm256_add_pd(x2i, t3i);
+			__m256d b3r = _mm256_sub_pd(x2r, t3r), b3i = _mm256_sub_pd(x2i, t3i);
+			__m256d u2r = _mm256_fmsub_pd(b2r, br, _mm256_mul_pd(b2i, bi));
+			__m256d u2i = _mm256_fmadd_pd(b2r, bi, _mm256_mul_pd(b2i, br));
+			__m256d vr = _mm256_fmsub_pd(b3r, br, _mm256_mul_pd(b3i, bi));
+			__m256d vi = _mm256_fmadd_pd(b3r, bi, _mm256_mul_pd(b3i, br));
+			_mm256_storeu_pd(r0 + k, _mm256_add_pd(b0r, u2r));
+			_mm256_storeu_pd(i0 + k, _mm256_add_pd(b0i, u2i));
+			_mm256_storeu_pd(r2 + k, _mm256_sub_pd(b0r, u2r));
+			_mm256_storeu_pd(i2 + k, _mm256_sub_pd(b0i, u2i));
+			_mm256_storeu_pd(q1r + k, _mm256_add_pd(b1r, vi));
+			_mm256_storeu_pd(q1i + k, _mm256_sub_pd(b1i, vr));
+			_mm256_storeu_pd(q3r + k, _mm256_sub_pd(b1r, vi));
+			_mm256_storeu_pd(q3i + k, _mm256_add_pd(b1i, vr));
+		}
+	}
+}
+
+// Same as do_radix4_pass_split(), 8 doubles per register
+FFT_TARGET("avx512f") static void do_radix4_pass_split_avx512(size_t n, size_t L, const double *tw, double *re, double *im, bool bInverse)
+{
+	size_t j, k;
+	const double *w1r = tw;
+	const double *w1i = w1r + L;
+	const double *w2r = w1i + L;
+	const double *w2i = w2r + L;
+
+	for (j = 0; j < n; j += 4 * L)
+	{
+		double *r0 = re + j, *r1 = r0 + L, *r2 = r1 + L, *r3 = r2 + L;
+		double *i0 = im + j, *i1 = i0 + L, *i2 = i1 + L, *i3 = i2 + L;
+		double *q1r = bInverse ? r3 : r1, *q1i = bInverse ? i3 : i1;
+		double *q3r = bInverse ? r1 : r3, *q3i = bInverse ? i1 : i3;
+		for (k = 0; k < L; k += 8)
+		{
+			__m512d ar = _mm512_loadu_pd(w1r + k), ai = _mm512_loadu_pd(w1i + k);
+			__m512d br = _mm512_loadu_pd(w2r + k), bi = _mm512_loadu_pd(w2i + k);
+			__m512d x1r = _mm512_loadu_pd(r1 + k), x1i = _mm512_loadu_pd(i1 + k);
+			__m512d x3r = _mm512_loadu_pd(r3 + k), x3i = _mm512_loadu_pd(i3 + k);
+			__m512d t1r = _mm512_fmsub_pd(x1r, ar, _mm512_mul_pd(x1i, ai));
+			__m512d t1i = _mm512_fmadd_pd(x1r, ai, _mm512_mul_pd(x1i, ar));
+			__m512d t3r = _mm512_fmsub_pd(x3r, ar, _mm512_mul_pd(x3i, ai));
+			__m512d t3i = _mm512_fmadd_pd(x3r, ai, _mm512_mul_pd(x3i, ar));
+			__m512d x0r = _mm512_loadu_pd(r0 + k), x0i = _mm512_loadu_pd(i0 + k);
+			__m512d x2r = _mm512_loadu_pd(r2 + k), x2i = _mm512_loadu_pd(i2 + k);
+			__m512d b0r = _mm512_add_pd(x0r, t1r), b0i = _mm512_add_pd(x0i, t1i);
+			__m512d b1r = _mm512_sub_pd(x0r, t1r), b1i = _mm512_sub_pd(x0i, t1i);
+			__m512d b2r = _mm512_add_pd(x2r, t3r), b2i = _mm512_add_pd(x2i, t3i);
+			__m512d b3r = _mm512_sub_pd(x2r, t3r), b3i = _mm512_sub_pd(x2i, t3i);
+			__m512d u2r = _mm512_fmsub_pd(b2r, br, _mm512_mul_pd(b2i, bi));
+			__m512d u2i = _mm512_fmadd_pd(b2r, bi, _mm512_mul_pd(b2i, br));
+			__m512d vr = _mm512_fmsub_pd(b3r, br, _mm512_mul_pd(b3i, bi));
+			__m512d vi = _mm512_fmadd_pd(b3r, bi, _mm512_mul_pd(b3i, br));
+			_mm512_storeu_pd(r0 + k, _mm512_add_pd(b0r, u2r));
+			_mm512_storeu_pd(i0 + k, _mm512_add_pd(b0i, u2i));
+			_mm512_storeu_pd(r2 + k, _mm512_sub_pd(b0r, u2r));
+			_mm512_storeu_pd(i2 + k, _mm512_sub_pd(b0i, u2i));
+			_mm512_storeu_pd(q1r + k, _mm512_add_pd(b1r, vi));
+			_mm512_storeu_pd(q1i + k, _mm512_sub_pd(b1i, vr));
+			_mm512_storeu_pd(q3r + k, _mm512_sub_pd(b1r, vi));
+			_mm512_storeu_pd(q3i + k, _mm512_add_pd(b1i, vr));
+		}
+	}
+}
+
+// Same as do_radix4_pass_split(), 4 floats per register
+FFT_TARGET("sse2") static void do_radix4_pass_split_sse2(size_t n, size_t L, const float *tw, float *re, float *im, bool bInverse)
+{
+	size_t j, k;
+	const float *w1r = tw;
+	const float *w1i = w1r + L;
+	const float *w2r = w1i + L;
+	const float *w2i = w2r + L;
+
+	for (j = 0; j < n; j += 4 * L)
+	{
+		float *r0 = re + j, *r1 = r0 + L, *r2 = r1 + L, *r3 = r2 + L;
+		float *i0 = im + j, *i1 = i0 + L, *i2 = i1 + L, *i3 = i2 + L;
+		float *q1r = bInverse ? r3 : r1, *q1i = bInverse ? i3 : i1;
+		float *q3r = bInverse ? r1 : r3, *q3i = bInverse ? i1 : i3;
+		for (k = 0; k < L; k += 4)
+		{
+			__m128 ar = _mm_loadu_ps(w1r + k), ai = _mm_loadu_ps(w1i + k);
+			__m128 br = _mm_loadu_ps(w2r + k), bi = _mm_loadu_ps(w2i + k);
+			__m128 x1r = _mm_loadu_ps(r1 + k), x1i = _mm_loadu_ps(i1 + k);
+			__m128 x3r = _mm_loadu_ps(r3 + k), x3i = _mm_loadu_ps(i3 + k);
+			__m128 t1r = _mm_sub_ps(_mm_mul_ps(x1r, ar), _mm_mul_ps(x1i, ai));
+			__m128 t1i = _mm_add_ps(_mm_mul_ps(x1r, ai), _mm_mul_ps(x1i, ar));
+			__m128 t3r = _mm_sub_ps(_mm_mul_ps(x3r, ar), _mm_mul_ps(x3i, ai));
+			__m128 t3i = _mm_add_ps(_mm_mul_ps(x3r, ai), _mm_mul_ps(x3i, ar));
+			__m128 x0r = _mm_loadu_ps(r0 + k), x0i = _mm_loadu_ps(i0 + k);
+			__m128 x2r = _mm_loadu_ps(r2 + k), x2i = _mm_loadu_ps(i2 + k);
+			__m128 b0r = _mm_add_ps(x0r, t1r), b0i = _mm_add_ps(x0i, t1i);
+			__m128 b1r = _mm_sub_ps(x0r, t1r), b1i = _mm_sub_ps(x0i, t1i);
+			__m128 b2r = _mm_add_ps(x2r, t3r), b2i = _mm_add_ps(x2i, t3i);
+			__m128 b3r = _mm_sub_ps(x2r, t3r), b3i = _mm_sub_ps(x2i, t3i);
+			__m128 u2r = _mm_sub_ps(_mm_mul_ps(b2r, br), _mm_mul_ps(b2i, bi));
+			__m128 u2i = _mm_add_ps(_mm_mul_ps(b2r, bi), _mm_mul_ps(b2i, br));
+			__m128 vr = _mm_sub_ps(_mm_mul_ps(b3r, br), _mm_mul_ps(b3i, bi));
+			__m128 vi = _mm_add_ps(_mm_mul_ps(b3r, bi), _mm_mul_ps(b3i, br));
+			_mm_storeu_ps(r0 + k, _mm_add_ps(b0r, u2r));
+			_mm_storeu_ps(i0 + k, _mm_add_ps(b0i, u2i));
+			_mm_storeu_ps(r2 + k, _mm_sub_ps(b0r, u2r));
+			_mm_storeu_ps(i2 + k, _mm_sub_ps(b0i, u2i));
+			_mm_storeu_ps(q1r + k, _mm_add_ps(b1r, vi));
+			_mm_storeu_ps(q1i + k, _mm_sub_ps(b1i, vr));
+			_mm_storeu_ps(q3r + k, _mm_sub_ps(b1r, vi));
+			_mm_storeu_ps(q3i + k, _mm_add_ps(b1i, vr));
+		}
+	}
+}
+
+// Same as do_radix4_pass_split(), 8 floats per register
+FFT_TARGET("avx2,fma") static void do_radix4_pass_split_avx2(size_t n, size_t L, const float *tw, float *re, float *im, bool bInverse)
+{
+	size_t j, k;
+	const float *w1r = tw;
+	const float *w1i = w1r + L;
+	const float *w2r = w1i + L;
+	const float *w2i = w2r + L;
+
+	for (j = 0; j < n; j += 4 * L)
+	{
+		float *r0 = re + j, *r1 = r0 + L, *r2 = r1 + L, *r3 = r2 + L;
+		float *i0 = im + j, *i1 = i0 + L, *i2 = i1 + L, *i3 = i2 + L;
+		float *q1r = bInverse ? r3 : r1, *q1i = bInverse ? i3 : i1;
+		float *q3r = bInverse ? r1 : r3, *q3i = bInverse ? i1 : i3;
+		for (k = 0; k < L; k += 8)
+		{
+			__m256 ar = _mm256_loadu_ps(w1r + k), ai = _mm256_loadu_ps(w1i + k);
+			__m256 br = _mm256_loadu_ps(w2r + k), bi = _mm256_loadu_ps(w2i + k);
+			__m256 x1r = _mm256_loadu_ps(r1 + k), x1i = _mm256_loadu_ps(i1 + k);
+			__m256 x3r = _mm256_loadu_ps(r3 + k), x3i = _mm256_loadu_ps(i3 + k);
+			__m256 t1r = _mm256_fmsub_ps(x1r, ar, _mm256_mul_ps(x1i, ai));
+			__m256 t1i = _mm256_fmadd_ps(x1r, ai, _mm256_mul_ps(x1i, ar));
+			__m256 t3r = _mm256_fmsub_ps(x3r, ar, _mm256_mul_ps(x3i, ai));
+			__m256 t3i = _mm256_fmadd_ps(x3r, ai, _mm256_mul_ps(x3i, ar));
+			__m256 x0r = _mm256_loadu_ps(r0 + k), x0i = _mm256_loadu_ps(i0 + k);
+			__m256 x2r = _mm256_loadu_ps(r2 + k), x2i = _mm256_loadu_ps(i2 + k);
+			__m256 b0r = _mm256_add_ps(x0r, t1r), b0i = _mm256_add_ps(x0i, t1i);
+			__m256 b1r = _mm256_sub_ps(x0r, t1r), b1i = _mm256_sub_ps(x0i, t1i);
+			__m256 b2r = _mm256_add_ps(x2r, t3r), b2i = _mm256_add_ps(x2i, t3i);
+			__m256 b3r = _mm256_sub_ps(x2r, t3r), b3i = _mm256_sub_ps(x2i, t3i);
+			__m256 u2r = _mm256_fmsub_ps(b2r, br, _mm256_mul_ps(b2i, bi));
+			__m256 u2i = _mm256_fmadd_ps(b2r, bi, _mm256_mul_ps(b2i, br));
+			__m256 vr = _mm256_fmsub_ps(b3r, br, _mm256_mul_ps(b3i, bi));
+			__m256 vi = _mm256_fmadd_ps(b3r, bi, _mm256_mul_ps(b3i, br));
+			_mm256_storeu_ps(r0 + k, _mm256_add_ps(b0r, u2r));
+			_mm256_storeu_ps(i0 + k, _mm256_add_ps(b0i, u2i));
+			_mm256_storeu_ps(r2 + k, _mm256_sub_ps(b0r, u2r));
+			_mm256_storeu_ps(i2 + k, _mm256_sub_ps(b0i, u2i));
+			_mm256_storeu_ps(q1r + k, _mm256_add_ps(b1r, vi));
+			_mm256_storeu_ps(q1i + k, _mm256_sub_ps(b1i, vr));
+			_mm256_storeu_ps(q3r + k, _mm256_sub_ps(b1r, vi));
+			_mm256_storeu_ps(q3i + k, _mm256_add_ps(b1i, vr));
+		}
+	}
+}
+
+// Same as do_radix4_pass_split(), 16 floats per register
+FFT_TARGET("avx512f") static void do_radix4_pass_split_avx512(size_t n, size_t L, const float *tw, float *re, float *im, bool bInverse)
+{
+	size_t j, k;
+	const float *w1r = tw;
+	const float *w1i = w1r + L;
+	const float *w2r = w1i + L;
+	const float *w2i = w2r + L;
+
+	for (j = 0; j < n; j += 4 * L)
+	{
+		float *r0 = re + j, *r1 = r0 + L, *r2 = r1 + L, *r3 = r2 + L;
+		float *i0 = im + j, *i1 = i0 + L, *i2 = i1 + L, *i3 = i2 + L;
+		float *q1r = bInverse ? r3 : r1, *q1i = bInverse ? i3 : i1;
+		float *q3r = bInverse ? r1 : r3, *q3i = bInverse ? i1 : i3;
+		for (k = 0; k < L; k += 16)
+		{
+			__m512 ar = _mm512_loadu_ps(w1r + k), ai = _mm512_loadu_ps(w1i + k);
+			__m512 br = _mm512_loadu_ps(w2r + k), bi = _mm512_loadu_ps(w2i + k);
+			__m512 x1r = _mm512_loadu_ps(r1 + k), x1i = _mm512_loadu_ps(i1 + k);
+			__m512 x3r = _mm512_loadu_ps(r3 + k), x3i = _mm512_loadu_ps(i3 + k);
+			__m512 t1r = _mm512_fmsub_ps(x1r, ar, _mm512_mul_ps(x1i, ai));
+			__m512 t1i = _mm512_fmadd_ps(x1r, ai, _mm512_mul_ps(x1i, ar));
+			__m512 t3r = _mm512_fmsub_ps(x3r, ar, _mm512_mul_ps(x3i, ai));
+			__m512 t3i = _mm512_fmadd_ps(x3r, ai, _mm512_mul_ps(x3i, ar));
+			__m512 x0r = _mm512_loadu_ps(r0 + k), x0i = _mm512_loadu_ps(i0 + k);
+			__m512 x2r = _mm512_loadu_ps(r2 + k), x2i = _mm512_loadu_ps(i2 + k);
+			__m512 b0r = _mm512_add_ps(x0r, t1r), b0i = _mm512_add_ps(x0i, t1i);
+			__m512 b1r = _mm512_sub_ps(x0r, t1r), b1i = _mm512_sub_ps(x0i, t1i);
+			__m512 b2r = _mm512_add_ps(x2r, t3r), b2i = _mm512_add_ps(x2i, t3i);
+			__m512 b3r = _mm512_sub_ps(x2r, t3r), b3i = _mm512_sub_ps(x2i, t3i);
+			__m512 u2r = _mm512_fmsub_ps(b2r, br, _mm512_mul_ps(b2i, bi));
+			__m512 u2i = _mm512_fmadd_ps(b2r, bi, _mm512_mul_ps(b2i, br));
+			__m512 vr = _mm512_fmsub_ps(b3r, br, _mm512_mul_ps(b3i, bi));
+			__m512 vi = _mm512_fmadd_ps(b3r, bi, _mm512_mul_ps(b3i, br));
+			_mm512_storeu_ps(r0 + k, _mm512_add_ps(b0r, u2r));
+			_mm512_storeu_ps(i0 + k, _mm512_add_ps(b0i, u2i));
+			_mm512_storeu_ps(r2 + k, _mm512_sub_ps(b0r, u2r));
+			_mm512_storeu_ps(i2 + k, _mm512_sub_ps(b0i, u2i));
+			_mm512_storeu_ps(q1r + k, _mm512_add_ps(b1r, vi));
+			_mm512_storeu_ps(q1i + k, _mm512_sub_ps(b1i, vr));
+			_mm512_storeu_ps(q3r + k, _mm512_sub_ps(b1r, vi));
+			_mm512_storeu_ps(q3i + k, _mm512_add_ps(b1i, vr));
+		}
+	}
+}
+
+// Same as do_stockham4_pass(). The twiddles are the same for the whole inner loop, so they
+// are broadcast and the loop runs on whole registers of s*2 values:
+// SSE2 s >= 1 (double), s >= 2 (float), AVX2 s >= 2, 4, AVX-512 s >= 4, 8
+FFT_TARGET("sse2") static inline __m128d cmul_sse2(__m128d a, __m128d wr, __m128d wi)
+{
+	__m128d as = _mm_shuffle_pd(a, a, 1);
+	__m128d t = _mm_xor_pd(_mm_mul_pd(as, wi), _mm_set_pd(0., -0.));
+	return _mm_add_pd(_mm_mul_pd(a, wr), t);
+}
+
+FFT_TARGET("sse2") static void do_stockham4_pass_sse2(size_t n, size_t s, const double *w, const double *x, double *y, bool bInverse)
+{
+	const size_t m = n / 4;
+	size_t p, q;
+	__m128d sgn = bInverse ? _mm_set_pd(0., -0.) : _mm_set_pd(-0., 0.);
+
+	for (p = 0; p < m; p++, w += 6)
+	{
+		__m128d w1r = _mm_set1_pd(w[0]), w1i = _mm_set1_pd(w[1]);
+		__m128d w2r = _mm_set1_pd(w[2]), w2i = _mm_set1_pd(w[3]);
+		__m128d w3r = _mm_set1_pd(w[4]), w3i = _mm_set1_pd(w[5]);
+		const double *x0 = x + 2 * s * p;
+		const double *x1 = x0 + 2 * s * m;
+		const double *x2 = x1 + 2 * s * m;
+		const double *x3 = x2 + 2 * s * m;
+		double *y0 = y + 8 * s * p;
+		double *y1 = y0 + 2 * s;
+		double *y2 = y1 + 2 * s;
+		double *y3 = y2 + 2 * s;
+		for (q = 0; q < 2 * s; q += 2)
+		{
+			__m128d a = _mm_loadu_pd(x0 + q), b = _mm_loadu_pd(x1 + q);
+			__m128d c = _mm_loadu_pd(x2 + q), d = _mm_loadu_pd(x3 + q);
+			__m128d apc = _mm_add_pd(a, c), amc = _mm_sub_pd(a, c);
+			__m128d bpd = _mm_add_pd(b, d), bmd = _mm_sub_pd(b, d);
+			__m128d j = _mm_xor_pd(_mm_shuffle_pd(bmd, bmd, 1), sgn);
+			_mm_storeu_pd(y0 + q, _mm_add_pd(apc, bpd));
+			_mm_storeu_pd(y1 + q, cmul_sse2(_mm_add_pd(amc, j), w1r, w1i));
+			_mm_storeu_pd(y2 + q, cmul_sse2(_mm_sub_pd(apc, bpd), w2r, w2i));
+			_mm_storeu_pd(y3 + q, cmul_sse2(_mm_sub_pd(amc, j), w3r, w3i));
+		}
+	}
+}
+
+FFT_TARGET("avx2,fma") static inline __m256d cmul_avx2(__m256d a, __m256d wr, __m256d wi)
+{
+	__m256d as = _mm256_permute_pd(a, 0x5);
+	return _mm256_fmaddsub_pd(a, wr, _mm256_mul_pd(as, wi));
+}
+
+FFT_TARGET("avx2,fma") static void do_stockham4_pass_avx2(size_t n, size_t s, const double *w, const double *x, double *y, bool bInverse)
+{
+	const size_t m = n / 4;
+	size_t p, q;
+	__m256d sgn = bInverse ? _mm256_set_pd(0., -0., 0., -0.) : _mm256_set_pd(-0., 0., -0., 0.);
+
+	for (p = 0; p < m; p++, w += 6)
+	{
+		__m256d w1r = _mm256_set1_pd(w[0]), w1i = _mm256_set1_pd(w[1]);
+		__m256d w2r = _mm256_set1_pd(w[2]), w2i = _mm256_set1_pd(w[3]);
+		__m256d w3r = _mm256_set1_pd(w[4]), w3i = _mm256_set1_pd(w[5]);
+		const double *x0 = x + 2 * s * p;
+		const double *x1 = x0 + 2 * s * m;
+		const double *x2 = x1 + 2 * s * m;
+		const double *x3 = x2 + 2 * s * m;
+		double *y0 = y + 8 * s * p;
+		double *y1 = y0 + 2 * s;
+		double *y2 = y1 + 2 * s;
+		double *y3 = y2 + 2 * s;
+		for (q = 0; q < 2 * s; q += 4)
+		{
+			__m256d a = _mm256_loadu_pd(x0 + q), b = _mm256_loadu_pd(x1 + q);
+			__m256d c = _mm256_loadu_pd(x2 + q), d = _mm256_loadu_pd(x3 + q);
+			__m256d apc = _mm256_add_pd(a, c), amc = _mm256_sub_pd(a, c);
+			__m256d bpd = _mm256_add_pd(b, d), bmd = _mm256_sub_pd(b, d);
+			__m256d j = _mm256_xor_pd(_mm256_permute_pd(bmd, 0x5), sgn);
+			_mm256_storeu_pd(y0 + q, _mm256_add_pd(apc, bpd));
+			_mm256_storeu_pd(y1 + q, cmul_avx2(_mm256_add_pd(amc, j), w1r, w1i));
+			_mm256_storeu_pd(y2 + q, cmul_avx2(_mm256_sub_pd(apc, bpd), w2r, w2i));
+			_mm256_storeu_pd(y3 + q, cmul_avx2(_mm256_sub_pd(amc, j), w3r, w3i));
+		}
+	}
+}
+
+FFT_TARGET("avx512f") static inline __m512d cmul_avx512(__m512d a, __m512d wr, __m512d wi)
+{
+	__m512d as = _mm512_permute_pd(a, 0x55);
+	return _mm512_fmaddsub_pd(a, wr, _mm512_mul_pd(as, wi));
+}
+
+FFT_TARGET("avx512f") static void do_stockham4_pass_avx512(size_t n, size_t s, const double *w, const double *x, double *y, bool bInverse)
+{
+	const size_t m = n / 4;
+	size_t p, q;
+	__mmask8 neg = bInverse ? 0x55 : 0xAA;
+	__m512d zero = _mm512_setzero_pd();
+
+	for (p = 0; p < m; p++, w += 6)
+	{
+		__m512d w1r = _mm512_set1_pd(w[0]), w1i = _mm512_set1_pd(w[1]);
+		__m512d w2r = _mm512_set1_pd(w[2]), w2i = _mm512_set1_pd(w[3]);
+		__m512d w3r = _mm512_set1_pd(w[4]), w3i = _mm512_set1_pd(w[5]);
+		const double *x0 = x + 2 * s * p;
+		const double *x1 = x0 + 2 * s * m;
+		const double *x2 = x1 + 2 * s * m;
+		const double *x3 = x2 + 2 * s * m;
+		double *y0 = y + 8 * s * p;
+		double *y1 = y0 + 2 * s;
+		double *y2 = y1 + 2 * s;
+		double *y3 = y2 + 2 * s;
+		for (q = 0; q < 2 * s; q += 8)
+		{
+			__m512d a = _mm512_loadu_pd(x0 + q), b = _mm512_loadu_pd(x1 + q);
+			__m512d c = _mm512_loadu_pd(x2 + q), d = _mm512_loadu_pd(x3 + q);
+			__m512d apc = _mm512_add_pd(a, c), amc = _mm512_sub_pd(a, c);
+			__m512d bpd = _mm512_add_pd(b, d), bmd = _mm512_sub_pd(b, d);
+			__m512d j = _mm512_permute_pd(bmd, 0x55);
+			j = _mm512_mask_sub_pd(j, neg, zero, j);
+			_mm512_storeu_pd(y0 + q, _mm512_add_pd(apc, bpd));
+			_mm512_storeu_pd(y1 + q, cmul_avx512(_mm512_add_pd(amc, j), w1r, w1i));
+			_mm512_storeu_pd(y2 + q, cmul_avx512(_mm512_sub_pd(apc, bpd), w2r, w2i));
+			_mm512_storeu_pd(y3 + q, cmul_avx512(_mm512_sub_pd(amc, j), w3r, w3i));
+		}
+	}
+}
+
+FFT_TARGET("sse2") static inline __m128 cmul_sse2(__m128 a, __m128 wr, __m128 wi)
+{
+	__m128 as = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+	__m128 t = _mm_xor_ps(_mm_mul_ps(as, wi), _mm_set_ps(0.f, -0.f, 0.f, -0.f));
+	return _mm_add_ps(_mm_mul_ps(a, wr), t);
+}
+
+FFT_TARGET("sse2") static void do_stockham4_pass_sse2(size_t n, size_t s, const float *w, const float *x, float *y, bool bInverse)
+{
+	const size_t m = n / 4;
+	size_t p, q;
+	__m128 sgn = bInverse ? _mm_set_ps(0.f, -0.f, 0.f, -0.f) : _mm_set_ps(-0.f, 0.f, -0.f, 0.f);
+
+	for (p = 0; p < m; p++, w += 6)
+	{
+		__m128 w1r = _mm_set1_ps(w[0]), w1i = _mm_set1_ps(w[1]);
+		__m128 w2r = _mm_set1_ps(w[2]), w2i = _mm_set1_ps(w[3]);
+		__m128 w3r = _mm_set1_ps(w[4]), w3i = _mm_set1_ps(w[5]);
+		const float *x0 = x + 2 * s * p;
+		const float *x1 = x0 + 2 * s * m;
+		const float *x2 = x1 + 2 * s * m;
+		const float *x3 = x2 + 2 * s * m;
+		float *y0 = y + 8 * s * p;
+		float *y1 = y0 + 2 * s;
+		float *y2 = y1 + 2 * s;
+		float *y3 = y2 + 2 * s;
+		for (q = 0; q < 2 * s; q += 4)
+		{
+			__m128 a = _mm_loadu_ps(x0 + q), b = _mm_loadu_ps(x1 + q);
+			__m128 c = _mm_loadu_ps(x2 + q), d = _mm_loadu_ps(x3 + q);
+			__m128 apc = _mm_add_ps(a, c), amc = _mm_sub_ps(a, c);
+			__m128 bpd = _mm_add_ps(b, d), bmd = _mm_sub_ps(b, d);
+			__m128 j = _mm_xor_ps(_mm_shuffle_ps(bmd, bmd, _MM_SHUFFLE(2, 3, 0, 1)), sgn);
+			_mm_storeu_ps(y0 + q, _mm_add_ps(apc, bpd));
+			_mm_storeu_ps(y1 + q, cmul_sse2(_mm_add_ps(amc, j), w1r, w1i));
+			_mm_storeu_ps(y2 + q, cmul_sse2(_mm_sub_ps(apc, bpd), w2r, w2i));
+			_mm_storeu_ps(y3 + q, cmul_sse2(_mm_sub_ps(amc, j), w3r, w3i));
+		}
+	}
+}
+
+FFT_TARGET("avx2,fma") static inline __m256 cmul_avx2(__m256 a, __m256 wr, __m256 wi)
+{
+	__m256 as = _mm256_permute_ps(a, 0xB1);
+	return _mm256_fmaddsub_ps(a, wr, _mm256_mul_ps(as, wi));
+}
+
+FFT_TARGET("avx2,fma") static void do_stockham4_pass_avx2(size_t n, size_t s, const float *w, const float *x, float *y, bool bInverse)
+{
+	const size_t m = n / 4;
+	size_t p, q;
+	__m256 sgn = bInverse ? _mm256_set_ps(0.f, -0.f, 0.f, -0.f, 0.f, -0.f, 0.f, -0.f) :
+		_mm256_set_ps(-0.f, 0.f, -0.f, 0.f, -0.f, 0.f, -0.f, 0.f);
+
+	for (p = 0; p < m; p++, w += 6)
+	{
+		__m256 w1r = _mm256_set1_ps(w[0]), w1i = _mm256_set1_ps(w[1]);
+		__m256 w2r = _mm256_set1_ps(w[2]), w2i = _mm256_set1_ps(w[3]);
+		__m256 w3r = _mm256_set1_ps(w[4]), w3i = _mm256_set1_ps(w[5]);
+		const float *x0 = x + 2 * s * p;
+		const float *x1 = x0 + 2 * s * m;
+		const float *x2 = x1 + 2 * s * m;
+		const float *x3 = x2 + 2 * s * m;
+		float *y0 = y + 8 * s * p;
+		float *y1 = y0 + 2 * s;
+		float *y2 = y1 + 2 * s;
+		float *y3 = y2 + 2 * s;
+		for (q = 0; q < 2 * s; q += 8)
+		{
+			__m256 a = _mm256_loadu_ps(x0 + q), b = _mm256_loadu_ps(x1 + q);
+			__m256 c = _mm256_loadu_ps(x2 + q), d = _mm256_loadu_ps(x3 + q);
+			__m256 apc = _mm256_add_ps(a, c), amc = _mm256_sub_ps(a, c);
+			__m256 bpd = _mm256_add_ps(b, d), bmd = _mm256_sub_ps(b, d);
+			__m256 j = _mm256_xor_ps(_mm256_permute_ps(bmd, 0xB1), sgn);
+			_mm256_storeu_ps(y0 + q, _mm256_add_ps(apc, bpd));
+			_mm256_storeu_ps(y1 + q, cmul_avx2(_mm256_add_ps(amc, j), w1r, w1i));
+			_mm256_storeu_ps(y2 + q, cmul_avx2(_mm256_sub_ps(apc, bpd), w2r, w2i));
+			_mm256_storeu_ps(y3 + q, cmul_avx2(_mm256_sub_ps(amc, j), w3r, w3i));
+		}
+	}
+}
+
+FFT_TARGET("avx512f") static inline __m512 cmul_avx512(__m512 a, __m512 wr, __m512 wi)
+{
+	__m512 as = _mm512_permute_ps(a, 0xB1);
+	return _mm512_fmaddsub_ps(a, wr, _mm512_mul_ps(as, wi));
+}
+
+FFT_TARGET("avx512f") static void do_stockham4_pass_avx512(size_t n, size_t s, const float *w, const float *x, float *y, bool bInverse)
+{
+	const size_t m = n / 4;
+	size_t p, q;
+	__mmask16 neg = bInverse ? 0x5555 : 0xAAAA;
+	__m512 zero = _mm512_setzero_ps();
+
+	for (p = 0; p < m; p++, w += 6)
+	{
+		__m512 w1r = _mm512_set1_ps(w[0]), w1i = _mm512_set1_ps(w[1]);
+		__m512 w2r = _mm512_set1_ps(w[2]), w2i = _mm512_set1_ps(w[3]);
+		__m512 w3r = _mm512_set1_ps(w[4]), w3i = _mm512_set1_ps(w[5]);
+		const float *x0 = x + 2 * s * p;
+		const float *x1 = x0 + 2 * s * m;
+		const float *x2 = x1 + 2 * s * m;
+		const float *x3 = x2 + 2 * s * m;
+		float *y0 = y + 8 * s * p;
+		float *y1 = y0 + 2 * s;
+		float *y2 = y1 + 2 * s;
+		float *y3 = y2 + 2 * s;
+		for (q = 0; q < 2 * s; q += 16)
+		{
+			__m512 a = _mm512_loadu_ps(x0 + q), b = _mm512_loadu_ps(x1 + q);
+			__m512 c = _mm512_loadu_ps(x2 + q), d = _mm512_loadu_ps(x3 + q);
+			__m512 apc = _mm512_add_ps(a, c), amc = _mm512_sub_ps(a, c);
+			__m512 bpd = _mm512_add_ps(b, d), bmd = _mm512_sub_ps(b, d);
+			__m512 j = _mm512_permute_ps(bmd, 0xB1);
+			j = _mm512_mask_sub_ps(j, neg, zero, j);
+			_mm512_storeu_ps(y0 + q, _mm512_add_ps(apc, bpd));
+			_mm512_storeu_ps(y1 + q, cmul_avx512(_mm512_add_ps(amc, j), w1r, w1i));
+			_mm512_storeu_ps(y2 + q, cmul_avx512(_mm512_sub_ps(apc, bpd), w2r, w2i));
+			_mm512_storeu_ps(y3 + q, cmul_avx512(_mm512_sub_ps(amc, j), w3r, w3i));
+		}
+	}
+}
+
+#endif // FFT_X86
+
+// Complex numbers of nCplxBytes bytes per register of the instruction set
+static size_t get_simd_lanes(int nSimd, size_t nCplxBytes)
+{
+	static const size_t arRegBytes[] = {0, 16, 32, 64};
+	size_t nLanes = arRegBytes[nSimd] / nCplxBytes;
+	return (nLanes > 1) ? nLanes : 1;
+}
+
+// Best instruction set supported by the CPU and the OS
+static int detect_simd()
+{
+#if defined(FFT_X86) && defined(__GNUC__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+		return CFFTPlanBase::SIMD_AVX512;
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		return CFFTPlanBase::SIMD_AVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return CFFTPlanBase::SIMD_SSE2;
+#elif defined(FFT_X86) && defined(_MSC_VER)
+	int r[4];
+	__cpuid(r, 0);
+	int nMaxLeaf = r[0];
+	__cpuid(r, 1);
+	bool bSSE2 = (r[3] & (1 << 26)) != 0;
+	bool bFMA = (r[2] & (1 << 12)) != 0;
+	bool bOSXSAVE = (r[2] & (1 << 27)) != 0;
+	bool bAVX = (r[2] & (1 << 28)) != 0;
+	unsigned long long xcr0 = bOSXSAVE ? _xgetbv(0) : 0;
+	if (nMaxLeaf >= 7 && bAVX && (xcr0 & 0x6) == 0x6)
+	{
+		__cpuidex(r, 7, 0);
+		if ((r[1] & (1 << 16)) != 0 && (xcr0 & 0xE6) == 0xE6)
+			return CFFTPlanBase::SIMD_AVX512;
+		if ((r[1] & (1 << 5)) != 0 && bFMA)
+			return CFFTPlanBase::SIMD_AVX2;
+	}
+	if (bSSE2)
+		return CFFTPlanBase::SIMD_SSE2;
+#endif
+	return CFFTPlanBase::SIMD_SCALAR;
+}
+
+// Radix-2 Cooley-Tukey Algorithm with radix-4 passes (complex input, complex output)
+// a[2*i] - Real, a[2*i+1] - Imaginary
+// Input must be in bit reversed order. tw holds w1[], w2[] of every radix-4 pass,
+// so no trigonometry or recurrences are evaluated here. Not normalized.
+// Each pass runs on the widest instruction set allowed by nSimd that fits the pass,
+// i.e. a register holds no more than L complex numbers (16/32/64 bytes).
+// nLanes signals may be interleaved element by element (n = size * nLanes). Then every
+// twiddle is repeated nLanes times in tw and all passes work on whole registers.
+// Compute values in place
+template <class T>
+static void do_fft_radix4(size_t n, const T *tw, T *a, bool bInverse, int nSimd, size_t nLanes)
+{
+	const size_t nCplx = 2 * sizeof(T);
+	size_t L = nLanes;
+	size_t m = 0;
+	while ((nLanes << m) < n)
+		m++;
+
+	if ((m & 1) != 0)
+	{
+		do_radix2_pass(n, L, a);
+		L *= 2;
+	}
+
+	for (; 4 * L <= n; L *= 4)
+	{
+		const T *w1 = tw;
+		const T *w2 = tw + 2 * L;
+#ifdef FFT_X86
+		if (nSimd >= CFFTPlanBase::SIMD_AVX512 && L * nCplx >= 64)
+			do_radix4_pass_avx512(n, L, w1, w2, a, bInverse);
+		else if (nSimd >= CFFTPlanBase::SIMD_AVX2 && L * nCplx >= 32)
+			do_radix4_pass_avx2(n, L, w1, w2, a, bInverse);
+		else if (nSimd >= CFFTPlanBase::SIMD_SSE2 && L * nCplx >= 16)
+			do_radix4_pass_sse2(n, L, w1, w2, a, bInverse);
+		else
+#endif
+			do_radix4_pass(n, L, w1, w2, a, bInverse);
+		tw += 4 * L;
+	}
+}
+
+// do_fft_radix4() on split arrays, tw is the split twiddle table (see do_radix4_pass_split())
+template <class T>
+static void do_fft_radix4_split(size_t n, const T *tw, T *re, T *im, bool bInverse, int nSimd)
+{
+	size_t L = 1;
+	size_t m = 0;
+	while ((size_t(1) << m) < n)
+		m++;
+
+	if ((m & 1) != 0)
+	{
+		do_radix2_pass_split(n, re, im);
+		L = 2;
+	}
+
+	for (; 4 * L <= n; L *= 4)
+	{
+#ifdef FFT_X86
+		if (nSimd >= CFFTPlanBase::SIMD_AVX512 && L * sizeof(T) >= 64)
+			do_radix4_pass_split_avx512(n, L, tw, re, im, bInverse);
+		else if (nSimd >= CFFTPlanBase::SIMD_AVX2 && L * sizeof(T) >= 32)
+			do_radix4_pass_split_avx2(n, L, tw, re, im, bInverse);
+		else if (nSimd >= CFFTPlanBase::SIMD_SSE2 && L * sizeof(T) >= 16)
+			do_radix4_pass_split_sse2(n, L, tw, re, im, bInverse);
+		else
+#endif
+			do_radix4_pass_split(n, L, tw, re, im, bInverse);
+		tw += 4 * L;
+	}
+}
+
+// Radix-4 pass of the Stockham autosort algorithm (decimation in frequency, out of place).
+// x holds s interleaved sequences of n points (point p of sequence q is x[q + s*p]),
+// y gets 4*s interleaved sequences of n/4 points. w holds W^p, W^2p, W^3p, p < n/4,
+// W = exp(-+2*pi*i/n) (interleaved). Every read and write is sequential, the output
+// order needs no permutation.
+template <class T>
+static void do_stockham4_pass(size_t n, size_t s, const T *w, const T *x, T *y, bool bInverse)
+{
+	const size_t m = n / 4;
+	size_t p, q;
+	for (p = 0; p < m; p++, w += 6)
+	{
+		const T w1r = w[0], w1i = w[1], w2r = w[2], w2i = w[3], w3r = w[4], w3i = w[5];
+		const T *x0 = x + 2 * s * p;
+		const T *x1 = x0 + 2 * s * m;
+		const T *x2 = x1 + 2 * s * m;
+		const T *x3 = x2 + 2 * s * m;
+		T *y0 = y + 8 * s * p;
+		T *y1 = y0 + 2 * s;
+		T *y2 = y1 + 2 * s;
+		T *y3 = y2 + 2 * s;
+		for (q = 0; q < 2 * s; q += 2)
+		{
+			T apcr = x0[q] + x2[q], apci = x0[q + 1] + x2[q + 1];
+			T amcr = x0[q] - x2[q], amci = x0[q + 1] - x2[q + 1];
+			T bpdr = x1[q] + x3[q], bpdi = x1[q + 1] + x3[q + 1];
+			T bmdr = x1[q] - x3[q], bmdi = x1[q + 1] - x3[q + 1];
+			// -+i * (b - d)
+			T jr = bInverse ? -bmdi : bmdi;
+			T ji = bInverse ? bmdr : -bmdr;
+			T t1r = amcr + jr, t1i = amci + ji;
+			T t2r = apcr - bpdr, t2i = apci - bpdi;
+			T t3r = amcr - jr, t3i = amci - ji;
+			y0[q] = apcr + bpdr;
+			y0[q + 1] = apci + bpdi;
+			y1[q] = t1r * w1r - t1i * w1i;
+			y1[q + 1] = t1r * w1i + t1i * w1r;
+			y2[q] = t2r * w2r - t2i * w2i;
+			y2[q + 1] = t2r * w2i + t2i * w2r;
+			y3[q] = t3r * w3r - t3i * w3i;
+			y3[q + 1] = t3r * w3i + t3i * w3r;
+		}
+	}
+}
+
+// Radix-4 Stockham pass at the widest instruction set the interleaved length 2*s fills
+template <class T>
+static void do_stockham4(size_t n, size_t s, const T *w, const T *x, T *y, bool bInverse, int nSimd)
+{
+#ifdef FFT_X86
+	const size_t nCplx = 2 * sizeof(T);
+	if (nSimd >= CFFTPlanBase::SIMD_AVX512 && s * nCplx >= 64)
+		do_stockham4_pass_avx512(n, s, w, x, y, bInverse);
+	else if (nSimd >= CFFTPlanBase::SIMD_AVX2 && s * nCplx >= 32)
+		do_stockham4_pass_avx2(n, s, w, x, y, bInverse);
+	else if (nSimd >= CFFTPlanBase::SIMD_SSE2 && s * nCplx >= 16)
+		do_stockham4_pass_sse2(n, s, w, x, y, bInverse);
+	else
+#endif
+		do_stockham4_pass(n, s, w, x, y, bInverse);
+}
+
+// Last radix-2 pass of the Stockham algorithm (odd powers of 2), n = 2, twiddles are 1
+template <class T>
+static void do_stockham2_pass(size_t s, const T *x, T *y)
+{
+	size_t q;
+	const T *x1 = x + 2 * s;
+	T *y1 = y + 2 * s;
+	for (q = 0; q < 2 * s; q++)
+	{
+		y[q] = x[q] + x1[q];
+		y1[q] = x[q] - x1[q];
+	}
+}
+
+// Mixed-radix butterflies (complex input, complex output)
+// F holds p consecutive sub-transforms of m points each, tw is the N-point
+// twiddle table and s is the twiddle stride (N / (p*m)). Compute values in place
+template <class T>
+static void do_bfly2(T *F, size_t s, size_t m, const T *tw)
+{
+	size_t k;
+	T xr, xi, wr, wi;
+	T *F1 = F + 2 * m;
+
+	for (k = 0; k < m; k++)
+	{
+		wr = tw[2 * k * s];
+		wi = tw[2 * k * s + 1];
+		xr = F1[2 * k] * wr - F1[2 * k + 1] * wi;
+		xi = F1[2 * k] * wi + F1[2 * k + 1] * wr;
+		F1[2 * k] = F[2 * k] - xr;
+		F1[2 * k + 1] = F[2 * k + 1] - xi;
+		F[2 * k] += xr;
+		F[2 * k + 1] += xi;
+	}
+}
+
+template <class T>
+static void do_bfly4(T *F, size_t s, size_t m, const T *tw, bool bInverse)
+{
+	size_t k, q;
+	T xr[4], xi[4], t0r, t0i, t1r, t1i, t2r, t2i, t3r, t3i;
+
+	for (k = 0; k < m; k++)
+	{
+		xr[0] = F[2 * k];
+		xi[0] = F[2 * k + 1];
+		for (q = 1; q < 4; q++)
+		{
+			T wr = tw[2 * q * k * s];
+			T wi = tw[2 * q * k * s + 1];
+			T yr = F[2 * (k + q * m)];
+			T yi = F[2 * (k + q * m) + 1];
+			xr[q] = yr * wr - yi * wi;
+			xi[q] = yr * wi + yi * wr;
+		}
+		t0r = xr[0] + xr[2];
+		t0i = xi[0] + xi[2];
+		t1r = xr[0] - xr[2];
+		t1i = xi[0] - xi[2];
+		t2r = xr[1] + xr[3];
+		t2i = xi[1] + xi[3];
+		// t3 = -i * (x1 - x3) forward, +i * (x1 - x3) inverse
+		if (bInverse)
+		{
+			t3r = xi[3] - xi[1];
+			t3i = xr[1] - xr[3];
+		}
+		else
+		{
+			t3r = xi[1] - xi[3];
+			t3i = xr[3] - xr[1];
+		}
+		F[2 * k] = t0r + t2r;
+		F[2 * k + 1] = t0i + t2i;
+		F[2 * (k + m)] = t1r + t3r;
+		F[2 * (k + m) + 1] = t1i + t3i;
+		F[2 * (k + 2 * m)] = t0r - t2r;
+		F[2 * (k + 2 * m) + 1] = t0i - t2i;
+		F[2 * (k + 3 * m)] = t1r - t3r;
+		F[2 * (k + 3 * m) + 1] = t1i - t3i;
+	}
+}
+
+// Odd radix butterfly (p = 3, 5, 7). Inputs x[j] and x[p-j] are combined in
+// pairs, so outputs q and p-q share all multiplications.
+template <class T>
+static void do_bfly_odd(T *F, size_t s, size_t m, size_t p, const T *tw)
+{
+	size_t k, j, q, r;
+	T xr[7], xi[7], ar[4], ai[4], br[4], bi[4], cr[7], ci[7];
+	T yr, yi, zr, zi;
+	size_t h = p >> 1;
+
+	// p-th roots of unity
+	for (r = 0; r < p; r++)
+	{
+		cr[r] = tw[2 * r * s * m];
+		ci[r] = tw[2 * r * s * m + 1];
+	}
+
+	for (k = 0; k < m; k++)
+	{
+		xr[0] = F[2 * k];
+		xi[0] = F[2 * k + 1];
+		for (j = 1; j < p; j++)
+		{
+			T wr = tw[2 * j * k * s];
+			T wi = tw[2 * j * k * s + 1];
+			T vr = F[2 * (k + j * m)];
+			T vi = F[2 * (k + j * m) + 1];
+			xr[j] = vr * wr - vi * wi;
+			xi[j] = vr * wi + vi * wr;
+		}
+		yr = xr[0];
+		yi = xi[0];
+		for (j = 1; j <= h; j++)
+		{
+			ar[j] = xr[j] + xr[p - j];
+			ai[j] = xi[j] + xi[p - j];
+			br[j] = xr[j] - xr[p - j];
+			bi[j] = xi[j] - xi[p - j];
+			yr += ar[j];
+			yi += ai[j];
+		}
+		F[2 * k] = yr;
+		F[2 * k + 1] = yi;
+		for (q = 1; q <= h; q++)
+		{
+			yr = xr[0];
+			yi = xi[0];
+			zr = 0.;
+			zi = 0.;
+			for (j = 1, r = q; j <= h; j++)
+			{
+				yr += ar[j] * cr[r];
+				yi += ai[j] * cr[r];
+				zr -= bi[j] * ci[r];
+				zi += br[j] * ci[r];
+				r += q;
+				if (r >= p) r -= p;
+			}
+			F[2 * (k + q * m)] = yr + zr;
+			F[2 * (k + q * m) + 1] = yi + zi;
+			F[2 * (k + (p - q) * m)] = yr - zr;
+			F[2 * (k + (p - q) * m) + 1] = yi - zi;
+		}
+	}
+}
+
+// Mixed-radix decimation in time Cooley-Tukey Algorithm (complex input, complex output)
+// factors[] holds pairs (p, m) where p is the radix and m is the remaining length.
+// Input is read with a stride of fstride*istride complex elements. Out of place
+template <class T>
+static void do_mixed_radix(T *out, const T *in, size_t fstride, size_t istride,
+	const size_t *factors, const T *tw, bool bInverse)
+{
+	size_t p = factors[0];
+	size_t m = factors[1];
+	size_t j;
+
+	if (m == 1)
+	{
+		for (j = 0; j < p; j++)
+		{
+			out[2 * j] = in[2 * j * fstride * istride];
+			out[2 * j + 1] = in[2 * j * fstride * istride + 1];
+		}
+	}
+	else
+	{
+		for (j = 0; j < p; j++)
+			do_mixed_radix(out + 2 * j * m, in + 2 * j * fstride * istride, fstride * p, istride, factors + 2, tw, bInverse);
+	}
+
+	switch (p)
+	{
+	case 2:
+		do_bfly2(out, fstride, m, tw);
+		break;
+	case 4:
+		do_bfly4(out, fstride, m, tw, bInverse);
+		break;
+	default:
+		do_bfly_odd(out, fstride, m, p, tw);
+		break;
+	}
+}
+
+// Blocked transpose of rows nRow0..nRow1-1 of an nRows x nCols matrix.
+// E is a real or complex element.
+template <class E>
+static void do_transpose(size_t nRows, size_t nCols, size_t nRow0, size_t nRow1, const E *in, E *out)
+{
+	const size_t B = 32;
+	size_t i0, j0, i1, j1, i, j;
+
+	for (i0 = nRow0; i0 < nRow1; i0 += B)
+	{
+		i1 = (i0 + B < nRow1) ? i0 + B : nRow1;
+		for (j0 = 0; j0 < nCols; j0 += B)
+		{
+			j1 = (j0 + B < nCols) ? j0 + B : nCols;
+			for (i = i0; i < i1; i++)
+			{
+				for (j = j0; j < j1; j++)
+				{
+					out[j * nRows + i] = in[i * nCols + j];
+				}
+			}
+		}
+	}
+}
+
+// Blocked transpose of rows nBegin..nEnd-1 of a stack of nRows x nCols matrices
+// (row i of matrix m is row m*nRows+i)
+template <class E>
+static void do_transpose_stack(size_t nRows, size_t nCols, size_t nBegin, size_t nEnd, const E *in, E *out)
+{
+	while (nBegin < nEnd)
+	{
+		size_t m = nBegin / nRows;
+		size_t nRow1 = ((m + 1) * nRows < nEnd) ? (m + 1) * nRows : nEnd;
+		do_transpose(nRows, nCols, nBegin - m * nRows, nRow1 - m * nRows,
+			in + m * nRows * nCols, out + m * nRows * nCols);
+		nBegin = nRow1;
+	}
+}
+
+// Worker threads of a plan that runs in parallel (SetThreads()). Create() starts them, they
+// wait between the phases of Execute(), so a phase only hands out its parts.
+class CFFTThreadPool
+{
+public:
+	explicit CFFTThreadPool(int nThreads)
+		: m_nThreads(nThreads)
+		, m_pTask(NULL)
+		, m_pCall(NULL)
+		, m_nCount(0)
+		, m_nGeneration(0)
+		, m_nPending(0)
+		, m_bStop(false)
+	{
+		int t;
+		for (t = 1; t < nThreads; t++)
+			m_arThreads.push_back(std::thread(&CFFTThreadPool::Worker, this, t));
+	}
+
+	~CFFTThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mtx);
+			m_bStop = true;
+		}
+		m_cvStart.notify_all();
+		size_t t;
+		for (t = 0; t < m_arThreads.size(); t++)
+			m_arThreads[t].join();
+	}
+
+	int GetThreads() const { return m_nThreads; };
+
+	// Runs fn(nBegin, nEnd, nThread) on every thread, each one gets its part of 0..nCount-1.
+	// The calling thread does part 0 and returns when all parts are done.
+	template <class F>
+	void Run(size_t nCount, const F &fn)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mtx);
+			m_pTask = &fn;
+			m_pCall = &Call<F>;
+			m_nCount = nCount;
+			m_nPending = m_nThreads - 1;
+			m_nGeneration++;
+		}
+		m_cvStart.notify_all();
+		fn(size_t(0), nCount / m_nThreads, 0);
+
+		std::unique_lock<std::mutex> lock(m_mtx);
+		while (m_nPending != 0)
+			m_cvDone.wait(lock);
+	}
+
+private:
+	CFFTThreadPool(const CFFTThreadPool &);
+	CFFTThreadPool &operator=(const CFFTThreadPool &);
+
+	template <class F>
+	static void Call(const void *pTask, size_t nBegin, size_t nEnd, int nThread)
+	{
+		(*static_cast<const F *>(pTask))(nBegin, nEnd, nThread);
+	}
+
+	void Worker(int nThread)
+	{
+		unsigned long long nDone = 0;
+		std::unique_lock<std::mutex> lock(m_mtx);
+		for (;;)
+		{
+			while (!m_bStop && m_nGeneration == nDone)
+				m_cvStart.wait(lock);
+			if (m_bStop)
+				return;
+			nDone = m_nGeneration;
+			const size_t nCount = m_nCount;
+			lock.unlock();
+			m_pCall(m_pTask, nCount * nThread / m_nThreads, nCount * (nThread + 1) / m_nThreads, nThread);
+			lock.lock();
+			if (--m_nPending == 0)
+				m_cvDone.notify_one();
+		}
+	}
+
+	const int m_nThreads;
+	std::vector<std::thread> m_arThreads;
+	std::mutex m_mtx;
+	std::condition_variable m_cvStart;
+	std::condition_variable m_cvDone;
+	const void *m_pTask;                  // F of Run()
+	void (*m_pCall)(const void *, size_t, size_t, int);
+	size_t m_nCount;
+	unsigned long long m_nGeneration;     // number of Run() calls
+	int m_nPending;                       // workers still running the current one
+	bool m_bStop;
+};
+
+// Runs fn(nBegin, nEnd, nThread) on the threads of pPool, NULL - on the calling thread only
+template <class F>
+static void do_parallel(CFFTThreadPool *pPool, size_t nCount, F fn)
+{
+	if (pPool == NULL)
+		fn(size_t(0), nCount, 0);
+	else
+		pPool->Run(nCount, fn);
+}
+
+// Pool of nThreads threads in pPool, no pool for a single thread
+static void do_update_pool(int nThreads, CFFTThreadPool *&pPool)
+{
+	if (pPool != NULL && pPool->GetThreads() == nThreads)
+		return;
+	delete pPool;
+	pPool = (nThreads > 1) ? new CFFTThreadPool(nThreads) : NULL;
+}
+
+template <class T>
+CFFTPlanT<T>::CFFTPlanT()
+	: m_eType(COMPLEX)
+	, m_eAlgorithm(RADIX2)
+	, m_nPow2Algorithm(-1)
+	, m_nTuneAlgorithm(-1)
+	, m_eSimd(GetSupportedSimd())
+	, m_nSize(0)
+	, m_nCplxSize(0)
+	, m_nLanes(0)
+	, m_nThreads(1)
+	, m_bInverse(false)
+	, m_bBackward(false)
+	, m_bOrthNorm(true)
+	, m_fNorm(1.)
+	, m_pSubPlan(NULL)
+	, m_pPool(NULL)
+{
+}
+
+template <class T>
+CFFTPlanT<T>::~CFFTPlanT()
+{
+	Reset();
+}
+
+template <class T>
+void CFFTPlanT<T>::Reset()
+{
+	m_eType = COMPLEX;
+	m_eAlgorithm = RADIX2;
+	m_nSize = 0;
+	m_nCplxSize = 0;
+	m_nLanes = 0;
+	m_bInverse = false;
+	m_bBackward = false;
+	m_bOrthNorm = true;
+	m_fNorm = 1.;
+	m_arTwiddle.clear();
+	m_arBitRev.clear();
+	m_arFactors.clear();
+	m_arChirp.clear();
+	m_arChirpSpectrum.clear();
+	m_arShift.clear();
+	m_arRealTwiddle.clear();
+	m_arDctTwiddle.clear();
+	m_arWindow.clear();
+	m_arWork.clear();
+	m_arAlgWork.clear();
+	m_arLaneTwiddle.clear();
+	m_arBatch.clear();
+	m_arSplitTwiddle.clear();
+	m_arSplit.clear();
+	if (m_pSubPlan != NULL)
+	{
+		delete m_pSubPlan;
+		m_pSubPlan = NULL;
+	}
+	size_t i;
+	for (i = 0; i < m_arStepPlans.size(); i++)
+		delete m_arStepPlans[i];
+	m_arStepPlans.clear();
+	do_update_pool(1, m_pPool);
+}
+
+template <class T>
+int CFFTPlanT<T>::Create(TTransform eType, size_t nSize, bool bInverse, bool bOrthNorm/* = true*/)
+{
+	Reset();
+
+	if (nSize < 2) return -1;
+	if (nSize > 0x7FFFFFFF) return -2;
+	if (eType == MDCT && (nSize & 1) != 0) return -1;
+
+	m_eType = eType;
+	m_nSize = nSize;
+	m_bInverse = bInverse;
+	m_bOrthNorm = bOrthNorm;
+
+	size_t N = nSize;
+	size_t k;
+	double fNorm = 1.;
+
+	// Real transform of even size runs on N/2 complex points (see PackedForward()).
+	// DCT-I and DST-I are real transforms of 2(N-1) and 2(N+1) points.
+	size_t nReal = 0;
+	if (eType == REAL && (N & 1) == 0)
+		nReal = N;
+	else if (eType == DCT1)
+		nReal = 2 * (N - 1);
+	else if (eType == DST1)
+		nReal = 2 * (N + 1);
+
+	// DCT-IV of even size runs on N/2 complex points, of odd size on top of DCT-II
+	bool bDCT4 = (eType == DCT4 || eType == DST4 || eType == MDCT);
+	bool bHalf = bDCT4 && (N & 1) == 0 && N >= 4;
+
+	// Direction of the underlying complex transform. DST is built on top
+	// of DCT-III (forward) and DCT-II (inverse), so its direction is flipped.
+	// DCT-I, DST-I and DCT-IV are always computed forward.
+	if (nReal != 0)
+		CreateTransform(nReal / 2, eType == REAL && bInverse);
+	else if (bHalf)
+		CreateTransform(N / 2, false);
+	else if (bDCT4)
+		CreateTransform(N, false);
+	else
+		CreateTransform(N, (eType == DST) ? !bInverse : bInverse);
+
+	if (nReal != 0)
+	{
+		double sgn = (eType == REAL && bInverse) ? 1. : -1.;
+		CTwiddleTable table(nReal);
+		m_arRealTwiddle.resize(nReal);
+		for (k = 0; k < nReal / 2; k++)
+		{
+			double c, s;
+			table.Get(k, nReal, c, s);
+			m_arRealTwiddle[2 * k] = T(c);
+			m_arRealTwiddle[2 * k + 1] = T(sgn * s);
+		}
+	}
+
+	if (eType == DCT || eType == DST || eType == DST2 || (bDCT4 && !bHalf))
+	{
+		m_arShift.resize(2 * N);
+		for (k = 0; k < N; k++)
+		{
+			double c, s;
+			do_twiddle(k, 4 * N, c, s);
+			m_arShift[2 * k] = T(c);
+			m_arShift[2 * k + 1] = T(s);
+		}
+	}
+
+	if (bHalf)
+	{
+		// exp(-i*pi*n/N), n < N/2, then exp(-i*pi*(4k+1)/4N), k < N/2
+		m_arDctTwiddle.resize(2 * N);
+		for (k = 0; k < N / 2; k++)
+		{
+			double c, s;
+			do_twiddle(k, 2 * N, c, s);
+			m_arDctTwiddle[2 * k] = T(c);
+			m_arDctTwiddle[2 * k + 1] = T(-s);
+			do_twiddle(4 * k + 1, 8 * N, c, s);
+			m_arDctTwiddle[N + 2 * k] = T(c);
+			m_arDctTwiddle[N + 2 * k + 1] = T(-s);
+		}
+	}
+	else if (bDCT4)
+	{
+		// 2*cos(pi*(2n+1)/4N)
+		m_arDctTwiddle.resize(N);
+		for (k = 0; k < N; k++)
+		{
+			double c, s;
+			do_twiddle(2 * k + 1, 8 * N, c, s);
+			m_arDctTwiddle[k] = T(2. * c);
+		}
+	}
+
+	if (eType == MDCT)
+		m_arWork.resize(3 * N);
+	else if (eType == DST1)
+		m_arWork.resize(2 * N + 4);
+	else if (eType != COMPLEX && !(eType == REAL && nReal != 0))
+		m_arWork.resize(2 * N);
+
+	switch (eType)
+	{
+	case COMPLEX:
+	case REAL:
+		if (bOrthNorm)
+			fNorm = ::sqrt(1. / double(N));
+		else
+			fNorm = bInverse ? 1. : 1. / double(N);
+		break;
+	case DCT:
+		if (bOrthNorm)
+			fNorm = ::sqrt(1. / double(N));
+		else
+			fNorm = bInverse ? 0.5 / double(N) : 2.;
+		break;
+	case DST:
+		if (bOrthNorm)
+			fNorm = ::sqrt(2. / double(N));
+		else
+			fNorm = bInverse ? 2. / double(N) : 1.;
+		break;
+	case DCT1:
+		if (bOrthNorm)
+			fNorm = ::sqrt(0.5 / double(N - 1));
+		else
+			fNorm = bInverse ? 0.5 / double(N - 1) : 1.;
+		break;
+	case DST1:
+		if (bOrthNorm)
+			fNorm = ::sqrt(0.5 / double(N + 1));
+		else
+			fNorm = bInverse ? 0.5 / double(N + 1) : 1.;
+		break;
+	case DST2:
+		if (bOrthNorm)
+			fNorm = ::sqrt((bInverse ? 0.5 : 2.) / double(N));
+		else
+			fNorm = bInverse ? 0.5 / double(N) : 2.;
+		break;
+	case DCT4:
+	case DST4:
+		if (bOrthNorm)
+			fNorm = ::sqrt(2. / double(N));
+		else
+			fNorm = bInverse ? 1. / double(N) : 2.;
+		break;
+	case MDCT:
+		if (bOrthNorm)
+			fNorm = ::sqrt(2. / double(N));
+		else
+			fNorm = bInverse ? 2. / double(N) : 1.;
+		break;
+	}
+	m_fNorm = T(fNorm);
+
+	return 0;
+}
+
+// Choose the algorithm for an N-point complex transform and precompute its tables.
+// N1*N2, N large     - four-step over N1 and N2-point transforms, if more than one thread
+// 2^m                - radix-2 (or Stockham, SetAlgorithm()), unrolled codelets up to
+//                      const_CodeletMaxSize points
+// 2^a*3^b*5^c*7^d    - mixed radix 4, 2, 3, 5, 7
+// anything else      - Bluestein's chirp z-transform over a 2^m-point radix-2 transform
+template <class T>
+void CFFTPlanT<T>::CreateTransform(size_t N, bool bBackward)
+{
+	size_t i, j, k;
+	double sgn = bBackward ? 1. : -1.;
+
+	m_bBackward = bBackward;
+	m_nCplxSize = N;
+
+	size_t n = N;
+	std::vector<size_t> arRadix;
+	while ((n % 4) == 0)
+	{
+		arRadix.push_back(4);
+		n /= 4;
+	}
+	while ((n % 2) == 0)
+	{
+		arRadix.push_back(2);
+		n /= 2;
+	}
+	for (k = 3; k <= 7; k += 2)
+	{
+		while ((n % k) == 0)
+		{
+			arRadix.push_back(k);
+			n /= k;
+		}
+	}
+
+	// N1 is the largest divisor not above sqrt(N)
+	size_t N1 = 1;
+	if (m_nThreads > 1 && N >= const_ParallelMinSize)
+	{
+		for (N1 = size_t(::sqrt(double(N))) + 1; N1 * N1 > N || (N % N1) != 0; N1--);
+	}
+
+	if (N1 >= 16)
+		m_eAlgorithm = FOUR_STEP;
+	else
+		m_eAlgorithm = SelectAlgorithm(N, n == 1);
+
+	if (m_eAlgorithm == FOUR_STEP)
+	{
+		size_t N2 = N / N1;
+		m_arFactors.push_back(N1);
+		m_arFactors.push_back(N2);
+
+		// W_N^e = lo[e % N1] * hi[e / N1], lo[k] = W_N^k, hi[k] = W_N^(N1*k)
+		m_arTwiddle.resize(2 * (N1 + N2));
+		double c, s;
+		for (k = 0; k < N1; k++)
+		{
+			do_twiddle(k, N, c, s);
+			m_arTwiddle[2 * k] = T(c);
+			m_arTwiddle[2 * k + 1] = T(sgn * s);
+		}
+		for (k = 0; k < N2; k++)
+		{
+			do_twiddle(k, N2, c, s);
+			m_arTwiddle[2 * (N1 + k)] = T(c);
+			m_arTwiddle[2 * (N1 + k) + 1] = T(sgn * s);
+		}
+
+		// N1 and N2-point transforms of every thread. Only FOUR_STEP starts worker threads,
+		// once per Create().
+		do_update_pool(m_nThreads, m_pPool);
+		for (i = 0; i < 2 * size_t(m_nThreads); i++)
+		{
+			CFFTPlanT *pPlan = new CFFTPlanT;
+			pPlan->m_eSimd = m_eSimd;
+			pPlan->m_nPow2Algorithm = m_nPow2Algorithm;
+			pPlan->CreateTransform((i & 1) ? N2 : N1, bBackward);
+			m_arStepPlans.push_back(pPlan);
+		}
+
+		m_arAlgWork.resize(2 * N);
+		return;
+	}
+
+	if (m_eAlgorithm == BLUESTEIN)
+	{
+		// Chirp w[n] = exp(-+i*pi*n^2/N). n^2 is reduced modulo 2N to keep the angle small
+		size_t M = 1;
+		while (M < 2 * N - 1)
+			M <<= 1;
+
+		m_arChirp.resize(2 * N);
+		for (k = 0; k < N; k++)
+		{
+			unsigned long long kk = ((unsigned long long) k * k) % (2 * N);
+			double c, s;
+			do_twiddle(size_t(kk), 2 * N, c, s);
+			m_arChirp[2 * k] = T(c);
+			m_arChirp[2 * k + 1] = T(sgn * s);
+		}
+
+		m_pSubPlan = new CFFTPlanT;
+		m_pSubPlan->m_eSimd = m_eSimd;
+		m_pSubPlan->m_nThreads = m_nThreads;
+		m_pSubPlan->m_nPow2Algorithm = m_nPow2Algorithm;
+		m_pSubPlan->CreateTransform(M, false);
+
+		// Spectrum of the convolution kernel conj(w[n]), n = -(N-1)..N-1
+		m_arChirpSpectrum.assign(2 * M, 0.);
+		m_arChirpSpectrum[0] = m_arChirp[0];
+		m_arChirpSpectrum[1] = -m_arChirp[1];
+		for (k = 1; k < N; k++)
+		{
+			m_arChirpSpectrum[2 * k] = m_arChirpSpectrum[2 * (M - k)] = m_arChirp[2 * k];
+			m_arChirpSpectrum[2 * k + 1] = m_arChirpSpectrum[2 * (M - k) + 1] = -m_arChirp[2 * k + 1];
+		}
+		m_pSubPlan->Transform(&m_arChirpSpectrum[0]);
+		for (k = 0; k < 2 * M; k++)
+			m_arChirpSpectrum[k] /= T(M);
+
+		m_arAlgWork.resize(2 * M);
+		return;
+	}
+
+	if (m_eAlgorithm == STOCKHAM)
+	{
+		// W^p, W^2p, W^3p of every radix-4 pass, W = exp(-+2*pi*i/n) (see do_stockham4_pass())
+		CTwiddleTable table(N);
+		m_arTwiddle.reserve(2 * N);
+		for (n = N; n >= 4; n /= 4)
+		{
+			for (k = 0; k < n / 4; k++)
+			{
+				for (j = 1; j <= 3; j++)
+				{
+					double c, s;
+					table.Get(j * k, n, c, s);
+					m_arTwiddle.push_back(T(c));
+					m_arTwiddle.push_back(T(sgn * s));
+				}
+			}
+		}
+		m_arAlgWork.resize(2 * N);
+	}
+	else if (m_eAlgorithm == RADIX2)
+	{
+		// w1[], w2[] of every radix-4 pass (see do_fft_radix4())
+		CTwiddleTable table(N);
+		m_arTwiddle.reserve(2 * N);
+		size_t L = 1;
+		for (i = 0; (size_t(1) << i) < N; i++);
+		if ((i & 1) != 0)
+			L = 2;
+		for (; 4 * L <= N; L *= 4)
+		{
+			for (j = 0; j < 2; j++)
+			{
+				for (k = 0; k < L; k++)
+				{
+					double c, s;
+					table.Get(k, 2 * L * (j + 1), c, s);
+					m_arTwiddle.push_back(T(c));
+					m_arTwiddle.push_back(T(sgn * s));
+				}
+			}
+		}
+
+		m_arBitRev.resize(N);
+		for (i = 0, j = 0; i < N; i++)
+		{
+			m_arBitRev[i] = (unsigned int) j;
+			k = N >> 1;
+			while (k >= 1 && (j & k) != 0)
+			{
+				j ^= k;
+				k >>= 1;
+			}
+			j |= k;
+		}
+	}
+	else
+	{
+		CTwiddleTable table(N);
+		m_arTwiddle.resize(2 * N);
+		for (k = 0; k < N; k++)
+		{
+			double c, s;
+			table.Get(k, N, c, s);
+			m_arTwiddle[2 * k] = T(c);
+			m_arTwiddle[2 * k + 1] = T(sgn * s);
+		}
+
+		n = N;
+		for (k = 0; k < arRadix.size(); k++)
+		{
+			n /= arRadix[k];
+			m_arFactors.push_back(arRadix[k]);
+			m_arFactors.push_back(n);
+		}
+		m_arAlgWork.resize(2 * N);
+	}
+}
+
+CFFTPlanBase::TSimd CFFTPlanBase::GetSupportedSimd()
+{
+	// Initialized once, thread-safe: plans are constructed on many threads
+	static const TSimd eSimd = TSimd(detect_simd());
+	return eSimd;
+}
+
+// Planner of all plans and its wisdom: (sizeof(T), complex size) -> fastest algorithm
+static CFFTPlanBase::TPlanner ePlanner = CFFTPlanBase::ESTIMATE;
+static std::map<std::pair<size_t, size_t>, int> mapWisdom;
+static std::recursive_mutex mtxWisdom;
+
+static const char *const arAlgorithmNames[] = {"RADIX2", "MIXED_RADIX", "BLUESTEIN", "FOUR_STEP", "STOCKHAM"};
+static const char *const arSimdNames[] = {"scalar", "sse2", "avx2", "avx512"};
+
+void CFFTPlanBase::SetPlanner(TPlanner eNewPlanner)
+{
+	std::lock_guard<std::recursive_mutex> lock(mtxWisdom);
+	ePlanner = eNewPlanner;
+}
+
+CFFTPlanBase::TPlanner CFFTPlanBase::GetPlanner()
+{
+	std::lock_guard<std::recursive_mutex> lock(mtxWisdom);
+	return ePlanner;
+}
+
+// "fft_wisdom <version> <instruction set>", then "<sizeof(T)> <size> <algorithm>" lines
+int CFFTPlanBase::SaveWisdom(const char *pFileName)
+{
+	std::lock_guard<std::recursive_mutex> lock(mtxWisdom);
+	FILE *f = fopen(pFileName, "w");
+	if (f == NULL) return -1;
+
+	fprintf(f, "fft_wisdom 1 %s\n", arSimdNames[GetSupportedSimd()]);
+	std::map<std::pair<size_t, size_t>, int>::const_iterator it;
+	for (it = mapWisdom.begin(); it != mapWisdom.end(); ++it)
+	{
+		fprintf(f, "%d %llu %s\n", int(it->first.first), (unsigned long long) it->first.second,
+			arAlgorithmNames[it->second]);
+	}
+	bool bOk = ferror(f) == 0;
+	if (fclose(f) != 0)
+		bOk = false;
+	return bOk ? 0 : -1;
+}
+
+int CFFTPlanBase::LoadWisdom(const char *pFileName)
+{
+	FILE *f = fopen(pFileName, "r");
+	if (f == NULL) return -1;
+
+	std::map<std::pair<size_t, size_t>, int> mapLoaded;
+	char szName[16];
+	int nVersion = 0;
+	int nRes = 0;
+	if (fscanf(f, " fft_wisdom %d %15s", &nVersion, szName) != 2 || nVersion != 1)
+		nRes = -2;
+	else if (strcmp(szName, arSimdNames[GetSupportedSimd()]) != 0)
+		nRes = -3;
+	while (nRes == 0)
+	{
+		int nBytes = 0;
+		unsigned long long nSize = 0;
+		int nFields = fscanf(f, "%d %llu %15s", &nBytes, &nSize, szName);
+		if (nFields == EOF)
+			break;
+		int nAlg = -1;
+		for (int i = 0; i < int(sizeof(arAlgorithmNames) / sizeof(arAlgorithmNames[0])); i++)
+		{
+			if (nFields == 3 && strcmp(szName, arAlgorithmNames[i]) == 0)
+				nAlg = i;
+		}
+		if (nAlg < 0 || nAlg == FOUR_STEP || (nBytes != sizeof(float) && nBytes != sizeof(double)) ||
+			nSize < 2 || nSize > 0x7FFFFFFF)
+			nRes = -2;
+		else
+			mapLoaded[std::make_pair(size_t(nBytes), size_t(nSize))] = nAlg;
+	}
+	fclose(f);
+	if (nRes != 0) return nRes;
+
+	std::lock_guard<std::recursive_mutex> lock(mtxWisdom);
+	std::map<std::pair<size_t, size_t>, int>::const_iterator it;
+	for (it = mapLoaded.begin(); it != mapLoaded.end(); ++it)
+		mapWisdom[it->first] = it->second;
+	return 0;
+}
+
+void CFFTPlanBase::ForgetWisdom()
+{
+	std::lock_guard<std::recursive_mutex> lock(mtxWisdom);
+	mapWisdom.clear();
+}
+
+// Algorithms able to run a complex transform of N points, the first one is chosen without
+// measurements. bSmooth - N is a product of 2, 3, 5 and 7.
+static size_t get_candidates(size_t N, bool bSmooth, CFFTPlanBase::TAlgorithm *pAlg)
+{
+	size_t n = 0;
+	if ((N & (N - 1)) == 0)
+	{
+		pAlg[n++] = CFFTPlanBase::RADIX2;
+		if (N > const_CodeletMaxSize)
+		{
+			pAlg[n++] = CFFTPlanBase::STOCKHAM;
+			pAlg[n++] = CFFTPlanBase::MIXED_RADIX;
+		}
+	}
+	else if (bSmooth)
+	{
+		pAlg[n++] = CFFTPlanBase::MIXED_RADIX;
+		pAlg[n++] = CFFTPlanBase::BLUESTEIN;
+	}
+	else
+		pAlg[n++] = CFFTPlanBase::BLUESTEIN;
+	return n;
+}
+
+// Kernel of planner measurements: in place orthonormal transforms (the signal keeps its
+// energy). Small sizes are repeated, so that a sample is long enough for the timer.
+// Per thread: several threads may measure at the same time.
+template <class T>
+struct CPlannerBench
+{
+	static thread_local CFFTPlanT<T> *pPlan;
+	static thread_local std::complex<T> *pData;
+	static thread_local size_t nRepeat;
+
+	static void Run()
+	{
+		for (size_t i = 0; i < nRepeat; i++)
+			pPlan->Execute(pData);
+	}
+};
+
+template <class T> thread_local CFFTPlanT<T> *CPlannerBench<T>::pPlan = NULL;
+template <class T> thread_local std::complex<T> *CPlannerBench<T>::pData = NULL;
+template <class T> thread_local size_t CPlannerBench<T>::nRepeat = 1;
+
+// Algorithm of a complex transform of N points (FOUR_STEP aside). In order of precedence:
+// the one timed by the planner, SetAlgorithm() for powers of 2, wisdom, measurements
+// with MEASURE planner, the default one. Wisdom is kept per precision and size only, so
+// plans restricted by SetSimd() or SetThreads() neither use nor store it. The lock is
+// not held while measuring.
+template <class T>
+CFFTPlanBase::TAlgorithm CFFTPlanT<T>::SelectAlgorithm(size_t N, bool bSmooth)
+{
+	TAlgorithm arAlg[3];
+	size_t nAlg = get_candidates(N, bSmooth, arAlg);
+	size_t i;
+
+	if (m_nTuneAlgorithm >= 0)
+		return TAlgorithm(m_nTuneAlgorithm);
+	if (nAlg == 1)
+		return arAlg[0];
+	if (arAlg[0] == RADIX2 && m_nPow2Algorithm >= 0)
+		return TAlgorithm(m_nPow2Algorithm);
+
+	const bool bWisdom = m_eSimd >= GetSupportedSimd() && m_nThreads == 1;
+	std::pair<size_t, size_t> key(sizeof(T), N);
+	{
+		std::lock_guard<std::recursive_mutex> lock(mtxWisdom);
+		std::map<std::pair<size_t, size_t>, int>::const_iterator it = mapWisdom.find(key);
+		if (bWisdom && it != mapWisdom.end())
+		{
+			for (i = 0; i < nAlg; i++)
+			{
+				if (arAlg[i] == it->second)
+					return arAlg[i];
+			}
+		}
+		if (ePlanner != MEASURE)
+			return arAlg[0];
+	}
+
+	// Candidates are created first: their sub-plans may be measured as well
+	std::vector<std::complex<T> > arData(N);
+	for (i = 0; i < N; i++)
+		arData[i] = std::complex<T>(T(int(i % 7) - 3), T(int(i % 5) - 2));
+	size_t nBest = 0;
+	double fBestTime = 0.;
+	for (i = 0; i < nAlg; i++)
+	{
+		CFFTPlanT plan;
+		plan.m_eSimd = m_eSimd;
+		plan.m_nThreads = m_nThreads;
+		plan.m_nPow2Algorithm = m_nPow2Algorithm;
+		plan.m_nTuneAlgorithm = arAlg[i];
+		plan.Create(COMPLEX, N, false);
+
+		CPlannerBench<T>::pPlan = &plan;
+		CPlannerBench<T>::pData = &arData[0];
+		CPlannerBench<T>::nRepeat = (N < 65536) ? 65536 / N : 1;
+		CStatistics stat;
+		stat.RunMicrobenchmark(CPlannerBench<T>::Run, 7, 0.01);
+		double fTime = stat.GetMinValue();
+		if (i == 0 || fTime < fBestTime)
+		{
+			fBestTime = fTime;
+			nBest = i;
+		}
+	}
+	CPlannerBench<T>::pPlan = NULL;
+
+	if (bWisdom)
+	{
+		std::lock_guard<std::recursive_mutex> lock(mtxWisdom);
+		mapWisdom[key] = arAlg[nBest];
+	}
+	return arAlg[nBest];
+}
+
+// Restrict the instruction set used by the plan. Returns -1 if the CPU doesn't support it
+template <class T>
+int CFFTPlanT<T>::SetSimd(TSimd eSimd)
+{
+	if (eSimd > GetSupportedSimd()) return -1;
+
+	m_eSimd = eSimd;
+	if (m_pSubPlan != NULL)
+		m_pSubPlan->SetSimd(eSimd);
+	size_t i;
+	for (i = 0; i < m_arStepPlans.size(); i++)
+		m_arStepPlans[i]->SetSimd(eSimd);
+	return 0;
+}
+
+// Algorithm of power of 2 transforms, RADIX2 or STOCKHAM. A created plan is created again.
+template <class T>
+int CFFTPlanT<T>::SetAlgorithm(TAlgorithm eAlgorithm)
+{
+	if (eAlgorithm != RADIX2 && eAlgorithm != STOCKHAM) return -1;
+
+	m_nPow2Algorithm = eAlgorithm;
+	return Recreate();
+}
+
+// Number of threads for transforms of 65536 points and more (four-step algorithm).
+// 1 by default. A created plan is created again.
+template <class T>
+int CFFTPlanT<T>::SetThreads(int nThreads)
+{
+	if (nThreads < 1) return -1;
+
+	m_nThreads = nThreads;
+	return Recreate();
+}
+
+// Create() a created plan again with its parameters, the MDCT window (SetWindow()) is kept
+template <class T>
+int CFFTPlanT<T>::Recreate()
+{
+	if (m_nSize == 0) return 0;
+
+	std::vector<T> arWindow;
+	arWindow.swap(m_arWindow);
+	int nRes = Create(m_eType, m_nSize, m_bInverse, m_bOrthNorm);
+	if (nRes == 0)
+		m_arWindow.swap(arWindow);
+	return nRes;
+}
+
+// Unnormalized in place complex transform of m_nCplxSize points
+template <class T>
+void CFFTPlanT<T>::Transform(T *a)
+{
+	Transform(a, a);
+}
+
+// Unnormalized out of place complex transform of m_nCplxSize points. in and out may be equal.
+// For radix-2 the permutation doubles as the copy, so the input is read only once.
+template <class T>
+void CFFTPlanT<T>::Transform(const T *in, T *out)
+{
+	switch (m_eAlgorithm)
+	{
+	case RADIX2:
+		if (m_nCplxSize <= const_CodeletMaxSize)
+		{
+			do_fft_codelet(m_nCplxSize, in, out, m_bBackward);
+			break;
+		}
+		if (in == out)
+			do_bit_reverse_table(m_nCplxSize, &m_arBitRev[0], out);
+		else
+			do_bit_reverse_copy(m_nCplxSize, &m_arBitRev[0], in, out);
+		do_fft_radix4(m_nCplxSize, m_arTwiddle.data(), out, m_bBackward, m_eSimd, 1);
+		break;
+	case MIXED_RADIX:
+		if (in == out)
+		{
+			memcpy(&m_arAlgWork[0], in, 2 * m_nCplxSize * sizeof(T));
+			in = &m_arAlgWork[0];
+		}
+		do_mixed_radix(out, in, 1, 1, &m_arFactors[0], &m_arTwiddle[0], m_bBackward);
+		break;
+	case BLUESTEIN:
+		Bluestein(in, out);
+		break;
+	case FOUR_STEP:
+		FourStep(in, out);
+		break;
+	case STOCKHAM:
+		Stockham(in, out);
+		break;
+	}
+}
+
+// Stockham autosort algorithm (Cooley, Lewis, Welch, 1969). Radix-4 passes (and a last
+// radix-2 one for odd powers of 2) go back and forth between out and m_arAlgWork,
+// the first one reads in. The number of passes decides where to start, so that
+// the last one writes to out.
+template <class T>
+void CFFTPlanT<T>::Stockham(const T *in, T *out)
+{
+	const size_t N = m_nCplxSize;
+	size_t n, nPasses = 0;
+	for (n = N; n >= 4; n /= 4)
+		nPasses++;
+	if (n == 2)
+		nPasses++;
+
+	T *work = &m_arAlgWork[0];
+	T *dst = ((nPasses & 1) != 0) ? out : work;
+	if (in == dst)
+	{
+		memcpy(work, in, 2 * N * sizeof(T));
+		in = work;
+	}
+
+	const T *src = in;
+	const T *w = &m_arTwiddle[0];
+	size_t s = 1;
+	for (n = N; n >= 4; n /= 4, s *= 4)
+	{
+		do_stockham4(n, s, w, src, dst, m_bBackward, m_eSimd);
+		w += 6 * (n / 4);
+		src = dst;
+		dst = (dst == out) ? work : out;
+	}
+	if (n == 2)
+		do_stockham2_pass(s, src, dst);
+}
+
+// Four-step algorithm (Bailey, 1990). N = N1 * N2, n = N2*n1 + n2, k = k1 + N1*k2:
+// N2 transforms of N1 points, twiddles W_N^(n2*k1), N1 transforms of N2 points.
+// Blocked transposes make every transform contiguous, so it runs in cache.
+// Rows are split between threads, each thread has its own pair of sub-plans.
+template <class T>
+void CFFTPlanT<T>::FourStep(const T *in, T *out)
+{
+	const size_t N = m_nCplxSize;
+	const size_t N1 = m_arFactors[0];
+	const size_t N2 = m_arFactors[1];
+	const T *lo = &m_arTwiddle[0];
+	const T *hi = lo + 2 * N1;
+	CFFTPlanT * const *pPlans = &m_arStepPlans[0];
+	T *w = &m_arAlgWork[0];
+	const std::complex<T> *cx = reinterpret_cast<const std::complex<T> *>(in);
+	std::complex<T> *cw = reinterpret_cast<std::complex<T> *>(w);
+	std::complex<T> *cy = reinterpret_cast<std::complex<T> *>(out);
+
+	// x[n1][n2] -> w[n2][n1]
+	do_parallel(m_pPool, N1, [=](size_t nBegin, size_t nEnd, int) {
+		do_transpose(N1, N2, nBegin, nEnd, cx, cw);
+	});
+
+	// w[n2][k1] = W_N^(n2*k1) * (transform of row n2)[k1]
+	do_parallel(m_pPool, N2, [=](size_t nBegin, size_t nEnd, int nThread) {
+		size_t n2, k1, elo, ehi;
+		T wr, wi, xr, xi;
+		for (n2 = nBegin; n2 < nEnd; n2++)
+		{
+			T *r = w + 2 * n2 * N1;
+			pPlans[2 * nThread]->Transform(r);
+			for (k1 = 1, elo = 0, ehi = 0; k1 < N1; k1++)
+			{
+				elo += n2 % N1;
+				ehi += n2 / N1;
+				if (elo >= N1)
+				{
+					elo -= N1;
+					ehi++;
+				}
+				if (ehi >= N2)
+					ehi -= N2;
+				wr = lo[2 * elo] * hi[2 * ehi] - lo[2 * elo + 1] * hi[2 * ehi + 1];
+				wi = lo[2 * elo] * hi[2 * ehi + 1] + lo[2 * elo + 1] * hi[2 * ehi];
+				xr = r[2 * k1];
+				xi = r[2 * k1 + 1];
+				r[2 * k1] = xr * wr - xi * wi;
+				r[2 * k1 + 1] = xr * wi + xi * wr;
+			}
+		}
+	});
+
+	// w[n2][k1] -> out[k1][n2]
+	do_parallel(m_pPool, N2, [=](size_t nBegin, size_t nEnd, int) {
+		do_transpose(N2, N1, nBegin, nEnd, cw, cy);
+	});
+
+	// out[k1][k2] = transform of row k1
+	do_parallel(m_pPool, N1, [=](size_t nBegin, size_t nEnd, int nThread) {
+		size_t k1;
+		for (k1 = nBegin; k1 < nEnd; k1++)
+			pPlans[2 * nThread + 1]->Transform(out + 2 * k1 * N2);
+	});
+
+	// out[k1][k2] -> w[k2][k1] -> out
+	do_parallel(m_pPool, N1, [=](size_t nBegin, size_t nEnd, int) {
+		do_transpose(N1, N2, nBegin, nEnd, cy, cw);
+	});
+	do_parallel(m_pPool, N, [=](size_t nBegin, size_t nEnd, int) {
+		memcpy(out + 2 * nBegin, w + 2 * nBegin, 2 * (nEnd - nBegin) * sizeof(T));
+	});
+}
+
+// Bluestein's algorithm, 1968 (chirp z-transform)
+// X[k] = w[k] * sum (x[n] * w[n]) * conj(w[k-n]), w[n] = exp(-+i*pi*n^2/N)
+// The convolution is done by 2^m-point transforms with a precomputed kernel spectrum.
+template <class T>
+void CFFTPlanT<T>::Bluestein(const T *in, T *out)
+{
+	size_t N = m_nCplxSize;
+	size_t M = m_pSubPlan->m_nCplxSize;
+	size_t k;
+	T *a = &m_arAlgWork[0];
+	const T *w = &m_arChirp[0];
+	const T *b = &m_arChirpSpectrum[0];
+	T xr, xi;
+
+	for (k = 0; k < N; k++)
+	{
+		a[2 * k] = in[2 * k] * w[2 * k] - in[2 * k + 1] * w[2 * k + 1];
+		a[2 * k + 1] = in[2 * k] * w[2 * k + 1] + in[2 * k + 1] * w[2 * k];
+	}
+	for (k = 2 * N; k < 2 * M; k++)
+		a[k] = 0.;
+
+	m_pSubPlan->Transform(a);
+
+	// Multiply by the kernel spectrum and conjugate, so the forward
+	// transform below works as the inverse one
+	for (k = 0; k < M; k++)
+	{
+		xr = a[2 * k] * b[2 * k] - a[2 * k + 1] * b[2 * k + 1];
+		xi = a[2 * k] * b[2 * k + 1] + a[2 * k + 1] * b[2 * k];
+		a[2 * k] = xr;
+		a[2 * k + 1] = -xi;
+	}
+
+	m_pSubPlan->Transform(a);
+
+	for (k = 0; k < N; k++)
+	{
+		xr = a[2 * k];
+		xi = -a[2 * k + 1];
+		out[2 * k] = xr * w[2 * k] - xi * w[2 * k + 1];
+		out[2 * k + 1] = xr * w[2 * k + 1] + xi * w[2 * k];
+	}
+}
+
+// Fast discrete cosine transform (Makhoul, 1980). Runs an N-point complex
+// transform on the reordered input with a precomputed post-twiddle. Not normalized.
+// DCT-II: X[k] = sum x[n] * cos(pi * k * (2n + 1) / 2N)
+template <class T>
+void CFFTPlanT<T>::DCT2(T *a)
+{
+	size_t N = m_nSize;
+	size_t n, k;
+	T *w = &m_arWork[0];
+	const T *s = &m_arShift[0];
+
+	// v[n] = x[2n], v[N-1-n] = x[2n+1]
+	for (n = 0; 2 * n < N; n++)
+	{
+		w[2 * n] = a[2 * n];
+		w[2 * n + 1] = 0.;
+	}
+	for (n = 0; 2 * n + 1 < N; n++)
+	{
+		w[2 * (N - 1 - n)] = a[2 * n + 1];
+		w[2 * (N - 1 - n) + 1] = 0.;
+	}
+	Transform(w);
+	// X[k] = Re(exp(-i*pi*k/2N) * V[k])
+	for (k = 0; k < N; k++)
+		a[k] = w[2 * k] * s[2 * k] + w[2 * k + 1] * s[2 * k + 1];
+}
+
+// Inverse of DCT2() multiplied by N (Makhoul, 1980). Not normalized.
+// DCT-III: x[n] = X[0] + 2 * sum X[k] * cos(pi * k * (2n + 1) / 2N), k > 0
+template <class T>
+void CFFTPlanT<T>::DCT3(T *a)
+{
+	size_t N = m_nSize;
+	size_t n, k;
+	T *w = &m_arWork[0];
+	const T *s = &m_arShift[0];
+
+	// V[k] = exp(i*pi*k/2N) * (X[k] - i*X[N-k]), X[N] = 0
+	w[0] = a[0];
+	w[1] = 0.;
+	for (k = 1; k < N; k++)
+	{
+		w[2 * k] = s[2 * k] * a[k] + s[2 * k + 1] * a[N - k];
+		w[2 * k + 1] = s[2 * k + 1] * a[k] - s[2 * k] * a[N - k];
+	}
+	Transform(w);
+	for (n = 0; 2 * n < N; n++)
+		a[2 * n] = w[2 * n];
+	for (n = 0; 2 * n + 1 < N; n++)
+		a[2 * n + 1] = w[2 * (N - 1 - n)];
+}
+
+// Same as do_real_dct() + FDCT() normalization
+template <class T>
+void CFFTPlanT<T>::ExecuteDCT(T *a)
+{
+	size_t k;
+
+	if (m_bInverse)
+		DCT3(a);
+	else
+		DCT2(a);
+
+	for (k = 0; k < m_nSize; k++)
+		a[k] *= m_fNorm;
+}
+
+// Same as ro_real_dst() + FDST() normalization.
+// Forward: out[k] = sum a[j] * sin(pi * j * (2k + 1) / 2N), j = 1..N, a[N] is taken from a[0]
+// Inverse: DST-II, S[k] = sum a[j] * sin(pi * k * (2j + 1) / 2N), k = 1..N, S[N]/2 is put to a[0]
+// Both are reduced to DCT by reversing the order of sines and alternating signs.
+template <class T>
+void CFFTPlanT<T>::ExecuteDST(T *a)
+{
+	size_t N = m_nSize;
+	size_t j, k;
+	T x;
+
+	if (!m_bInverse)
+	{
+		for (j = 1; 2 * j < N; j++)
+		{
+			x = a[j];
+			a[j] = a[N - j];
+			a[N - j] = x;
+		}
+		for (j = 1; j < N; j++)
+			a[j] *= 0.5;
+		DCT3(a);
+		for (k = 0; k < N; k++)
+			a[k] *= (k & 1) ? -m_fNorm : m_fNorm;
+	}
+	else
+	{
+		for (j = 1; j < N; j += 2)
+			a[j] = -a[j];
+		DCT2(a);
+		for (k = 1; 2 * k < N; k++)
+		{
+			x = a[k];
+			a[k] = a[N - k];
+			a[N - k] = x;
+		}
+		a[0] *= 0.5;
+		for (k = 0; k < N; k++)
+			a[k] *= m_fNorm;
+	}
+}
+
+// DCT-IV, not normalized: X[k] = sum x[n] * cos(pi * (2n + 1) * (2k + 1) / 4N).
+// Even N: z[n] = (x[2n] + i*x[N-1-2n]) * exp(-i*pi*n/N) goes through an N/2-point transform,
+// Z[k] * exp(-i*pi*(4k+1)/4N) = X[2k] - i*X[N-1-2k].
+// Odd N: DCT-II of x[n] * 2cos(pi*(2n+1)/4N) is X[k] + X[k-1] (X[-1] = X[0]).
+template <class T>
+void CFFTPlanT<T>::DCTIV(T *a)
+{
+	size_t N = m_nSize;
+	size_t n, k;
+	const T *c = &m_arDctTwiddle[0];
+
+	if (2 * m_nCplxSize == N)
+	{
+		size_t H = N / 2;
+		T *z = &m_arWork[0];
+		T xr, xi;
+		for (n = 0; n < H; n++)
+		{
+			xr = a[2 * n];
+			xi = a[N - 1 - 2 * n];
+			z[2 * n] = xr * c[2 * n] - xi * c[2 * n + 1];
+			z[2 * n + 1] = xr * c[2 * n + 1] + xi * c[2 * n];
+		}
+		Transform(z);
+		c += N;
+		for (k = 0; k < H; k++)
+		{
+			xr = z[2 * k] * c[2 * k] - z[2 * k + 1] * c[2 * k + 1];
+			xi = z[2 * k] * c[2 * k + 1] + z[2 * k + 1] * c[2 * k];
+			a[2 * k] = xr;
+			a[N - 1 - 2 * k] = -xi;
+		}
+	}
+	else
+	{
+		for (n = 0; n < N; n++)
+			a[n] *= c[n];
+		DCT2(a);
+		a[0] *= 0.5;
+		for (k = 1; k < N; k++)
+			a[k] -= a[k - 1];
+	}
+}
+
+// DCT-I (REDFT00): X[k] = x[0] + (-1)^k x[N-1] + 2 * sum x[n] * cos(pi * n * k / (N-1)), 0 < n < N-1.
+// Real transform of the even extension x[0..N-1], x[N-2..1] (2(N-1) points).
+// Orthonormal: x[0], x[N-1], X[0] and X[N-1] are weighted by sqrt(2) (1/sqrt(2) for X).
+template <class T>
+void CFFTPlanT<T>::ExecuteDCT1(T *a)
+{
+	size_t M = m_nSize - 1;
+	size_t n, k;
+	T *z = &m_arWork[0];
+	const T r2 = T(::sqrt(2.));
+
+	for (n = 0; n <= M; n++)
+		z[n] = a[n];
+	for (n = 1; n < M; n++)
+		z[2 * M - n] = a[n];
+	if (m_bOrthNorm)
+	{
+		z[0] *= r2;
+		z[M] *= r2;
+	}
+	Transform(z);
+	PackedSpectrum(z, m_fNorm);
+	for (k = 0; k <= M; k++)
+		a[k] = z[2 * k];
+	if (m_bOrthNorm)
+	{
+		a[0] /= r2;
+		a[M] /= r2;
+	}
+}
+
+// DST-I (RODFT00): X[k] = 2 * sum x[n] * sin(pi * (n + 1) * (k + 1) / (N + 1)).
+// Real transform of the odd extension 0, x[0..N-1], 0, -x[N-1..0] (2(N+1) points).
+template <class T>
+void CFFTPlanT<T>::ExecuteDST1(T *a)
+{
+	size_t N = m_nSize;
+	size_t M = N + 1;
+	size_t n;
+	T *z = &m_arWork[0];
+
+	z[0] = 0.;
+	z[M] = 0.;
+	for (n = 1; n <= N; n++)
+	{
+		z[n] = a[n - 1];
+		z[2 * M - n] = -a[n - 1];
+	}
+	Transform(z);
+	PackedSpectrum(z, m_fNorm);
+	for (n = 0; n < N; n++)
+		a[n] = -z[2 * n + 3];
+}
+
+// DST-II (RODFT10): X[k] = 2 * sum x[n] * sin(pi * (2n + 1) * (k + 1) / 2N), it is DCT-II of
+// (-1)^n x[n] in reverse order.
+// Inverse DST-III (RODFT01): x[n] = (-1)^n X[N-1] + 2 * sum X[k] * sin(pi * (k + 1) * (2n + 1) / 2N),
+// k < N-1, it is (-1)^n times DCT-III of X in reverse order.
+// Orthonormal: X[N-1] is weighted by 1/sqrt(2) (sqrt(2) for the inverse).
+template <class T>
+void CFFTPlanT<T>::ExecuteDST2(T *a)
+{
+	size_t N = m_nSize;
+	size_t n, k;
+	const T r2 = T(::sqrt(2.));
+
+	if (!m_bInverse)
+	{
+		for (n = 1; n < N; n += 2)
+			a[n] = -a[n];
+		DCT2(a);
+		std::reverse(a, a + N);
+		for (k = 0; k < N; k++)
+			a[k] *= m_fNorm;
+		if (m_bOrthNorm)
+			a[N - 1] /= r2;
+	}
+	else
+	{
+		if (m_bOrthNorm)
+			a[N - 1] *= r2;
+		std::reverse(a, a + N);
+		DCT3(a);
+		for (n = 0; n < N; n++)
+			a[n] *= (n & 1) ? -m_fNorm : m_fNorm;
+	}
+}
+
+// DCT-IV (REDFT11) and DST-IV (RODFT11): X[k] = 2 * sum x[n] * sin(pi * (2n + 1) * (2k + 1) / 4N),
+// DST-IV is (-1)^k times DCT-IV of x in reverse order
+template <class T>
+void CFFTPlanT<T>::ExecuteDCT4(T *a)
+{
+	size_t N = m_nSize;
+	size_t k;
+
+	if (m_eType == DST4)
+		std::reverse(a, a + N);
+	DCTIV(a);
+	for (k = 0; k < N; k++)
+		a[k] *= (m_eType == DST4 && (k & 1)) ? -m_fNorm : m_fNorm;
+}
+
+// MDCT: X[k] = sum x[n] * w[n] * cos(pi/N * (n + 1/2 + N/2) * (k + 1/2)), n < 2N, k < N.
+// Blocks (a, b, c, d) of N/2 windowed samples are folded into (-c_r - d, a - b_r)
+// (_r is reversed order), which goes through DCT-IV.
+// IMDCT is the transpose: DCT-IV of X = (v1, v2) is unfolded into (v2, -v2_r, -v1_r, -v1)
+// and windowed. pIn and pOut may be equal.
+template <class T>
+void CFFTPlanT<T>::ExecuteMDCT(const T *pIn, T *pOut)
+{
+	size_t N = m_nSize;
+	size_t h = N / 2;
+	size_t n;
+	T *u = &m_arWork[2 * N];
+	const T *w = m_arWindow.empty() ? NULL : &m_arWindow[0];
+
+	if (!m_bInverse)
+	{
+		for (n = 0; n < h; n++)
+		{
+			size_t i0 = N + h - 1 - n, i1 = N + h + n, i2 = n, i3 = N - 1 - n;
+			if (w != NULL)
+			{
+				u[n] = -w[i0] * pIn[i0] - w[i1] * pIn[i1];
+				u[h + n] = w[i2] * pIn[i2] - w[i3] * pIn[i3];
+			}
+			else
+			{
+				u[n] = -pIn[i0] - pIn[i1];
+				u[h + n] = pIn[i2] - pIn[i3];
+			}
+		}
+		DCTIV(u);
+		for (n = 0; n < N; n++)
+			pOut[n] = u[n] * m_fNorm;
+	}
+	else
+	{
+		memcpy(u, pIn, N * sizeof(T));
+		DCTIV(u);
+		for (n = 0; n < h; n++)
+		{
+			pOut[n] = u[h + n];
+			pOut[N - 1 - n] = -u[h + n];
+			pOut[N + h - 1 - n] = -u[n];
+			pOut[N + h + n] = -u[n];
+		}
+		for (n = 0; n < 2 * N; n++)
+			pOut[n] *= (w != NULL) ? w[n] * m_fNorm : m_fNorm;
+	}
+}
+
+// MDCT window of 2*GetSize() samples, NULL - no window (the default)
+template <class T>
+int CFFTPlanT<T>::SetWindow(const T *pWindow)
+{
+	if (m_nSize == 0) return -1;
+	if (m_eType != MDCT) return -3;
+
+	if (pWindow == NULL)
+		m_arWindow.clear();
+	else
+		m_arWindow.assign(pWindow, pWindow + 2 * m_nSize);
+	return 0;
+}
+
+// In place complex transform of GetSize() points
+template <class T>
+int CFFTPlanT<T>::Execute(std::complex<T> *pData)
+{
+	return Execute(pData, pData);
+}
+
+// Out of place complex transform of GetSize() points. pIn and pOut may be equal.
+template <class T>
+int CFFTPlanT<T>::Execute(const std::complex<T> *pIn, std::complex<T> *pOut)
+{
+	if (m_nSize == 0) return -1;
+	if (m_eType != COMPLEX) return -3;
+
+	T *a = reinterpret_cast<T *>(pOut);
+	Transform(reinterpret_cast<const T *>(pIn), a);
+
+	if (m_fNorm != 1.)
+	{
+		size_t i;
+		for (i = 0; i < 2 * m_nSize; i++)
+			a[i] *= m_fNorm;
+	}
+
+	return 0;
+}
+
+// COMPLEX: GetSize() real -> GetSize() complex
+// REAL: GetSize() real -> GetSize()/2+1 complex
+template <class T>
+int CFFTPlanT<T>::Execute(const T *pIn, std::complex<T> *pOut)
+{
+	if (m_nSize == 0) return -1;
+	if (m_eType != COMPLEX && !(m_eType == REAL && !m_bInverse)) return -3;
+
+	ForwardReal(m_nSize, pIn, pOut);
+	return 0;
+}
+
+// Real input goes straight to the bit reversed positions, zero padded after nInCnt
+template <class T>
+void CFFTPlanT<T>::ForwardReal(size_t nInCnt, const T *pIn, std::complex<T> *pOut)
+{
+	if (m_eType == REAL && m_nCplxSize != m_nSize)
+	{
+		PackedForward(nInCnt, pIn, pOut);
+		return;
+	}
+
+	size_t N = m_nSize;
+	size_t i, j;
+	T *a = (m_eType == COMPLEX) ? reinterpret_cast<T *>(pOut) : &m_arWork[0];
+
+	if (m_eAlgorithm == RADIX2 && N > const_CodeletMaxSize)
+	{
+		const unsigned int *rev = &m_arBitRev[0];
+		for (i = 0; i < N; i++)
+		{
+			j = rev[i];
+			a[2 * j] = (i < nInCnt) ? pIn[i] : 0.;
+			a[2 * j + 1] = 0.;
+		}
+		do_fft_radix4(N, m_arTwiddle.data(), a, m_bBackward, m_eSimd, 1);
+	}
+	else
+	{
+		for (i = 0; i < N; i++)
+		{
+			a[2 * i] = (i < nInCnt) ? pIn[i] : 0.;
+			a[2 * i + 1] = 0.;
+		}
+		Transform(a);
+	}
+
+	size_t nOutCnt = (m_eType == COMPLEX) ? N : N / 2 + 1;
+	for (i = 0; i < nOutCnt; i++)
+		pOut[i] = std::complex<T>(a[2 * i] * m_fNorm, a[2 * i + 1] * m_fNorm);
+}
+
+// Forward real transform of even size N. Even and odd samples are the real and
+// imaginary parts of an N/2-point complex sequence z, Z is its transform and
+// X[k] = (Z[k] + conj(Z[N/2-k])) / 2 - i * w[k] * (Z[k] - conj(Z[N/2-k])) / 2
+// Works in place in pOut (N/2+1 elements), zero padded after nInCnt
+template <class T>
+void CFFTPlanT<T>::PackedForward(size_t nInCnt, const T *pIn, std::complex<T> *pOut)
+{
+	size_t k;
+	T *z = reinterpret_cast<T *>(pOut);
+
+	if (nInCnt == m_nSize)
+		Transform(pIn, z);
+	else
+	{
+		for (k = 0; k < m_nSize; k++)
+			z[k] = (k < nInCnt) ? pIn[k] : 0.;
+		Transform(z);
+	}
+	PackedSpectrum(z, m_fNorm);
+}
+
+// Second half of PackedForward(): transform of the packed sequence z -> X[0..H] multiplied
+// by fNorm, in place (z has H+1 complex elements)
+template <class T>
+void CFFTPlanT<T>::PackedSpectrum(T *z, T fNorm)
+{
+	size_t H = m_nCplxSize;
+	size_t k, j;
+	const T *w = &m_arRealTwiddle[0];
+	T er, ei, dr, di, tr, ti;
+
+	// Z[0] holds X[0] and X[N/2]
+	er = z[0];
+	ei = z[1];
+	z[0] = (er + ei) * fNorm;
+	z[1] = 0.;
+	z[2 * H] = (er - ei) * fNorm;
+	z[2 * H + 1] = 0.;
+
+	// X[k] = E + T, X[N/2-k] = conj(E - T)
+	for (k = 1; 2 * k <= H; k++)
+	{
+		j = H - k;
+		er = T(0.5) * (z[2 * k] + z[2 * j]);
+		ei = T(0.5) * (z[2 * k + 1] - z[2 * j + 1]);
+		dr = T(0.5) * (z[2 * k] - z[2 * j]);
+		di = T(0.5) * (z[2 * k + 1] + z[2 * j + 1]);
+		tr = w[2 * k] * di + w[2 * k + 1] * dr;
+		ti = w[2 * k + 1] * di - w[2 * k] * dr;
+		z[2 * k] = (er + tr) * fNorm;
+		z[2 * k + 1] = (ei + ti) * fNorm;
+		z[2 * j] = (er - tr) * fNorm;
+		z[2 * j + 1] = (ti - ei) * fNorm;
+	}
+}
+
+// Inverse of PackedForward(): Z[k] = E + i * w[k] * D, E = X[k] + conj(X[N/2-k]),
+// D = X[k] - conj(X[N/2-k]). The N/2-point transform of Z holds even samples in
+// real parts and odd samples in imaginary parts, which is the layout of pOut.
+template <class T>
+void CFFTPlanT<T>::PackedInverse(const std::complex<T> *pIn, T *pOut)
+{
+	size_t H = m_nCplxSize;
+	size_t k, j;
+	T *z = pOut;
+	const T *w = &m_arRealTwiddle[0];
+	T er, ei, dr, di, tr, ti;
+
+	z[0] = pIn[0].real() + pIn[H].real();
+	z[1] = pIn[0].real() - pIn[H].real();
+
+	// Z[k] = E + T, Z[N/2-k] = conj(E - T)
+	for (k = 1; 2 * k <= H; k++)
+	{
+		j = H - k;
+		er = pIn[k].real() + pIn[j].real();
+		ei = pIn[k].imag() - pIn[j].imag();
+		dr = pIn[k].real() - pIn[j].real();
+		di = pIn[k].imag() + pIn[j].imag();
+		tr = -(w[2 * k] * di + w[2 * k + 1] * dr);
+		ti = w[2 * k] * dr - w[2 * k + 1] * di;
+		z[2 * k] = er + tr;
+		z[2 * k + 1] = ei + ti;
+		z[2 * j] = er - tr;
+		z[2 * j + 1] = ti - ei;
+	}
+
+	Transform(z);
+
+	for (k = 0; k < m_nSize; k++)
+		pOut[k] *= m_fNorm;
+}
+
+// REAL inverse: GetSize()/2+1 complex -> GetSize() real
+template <class T>
+int CFFTPlanT<T>::Execute(const std::complex<T> *pIn, T *pOut)
+{
+	if (m_nSize == 0) return -1;
+	if (m_eType != REAL || !m_bInverse) return -3;
+
+	if (m_nCplxSize != m_nSize)
+	{
+		PackedInverse(pIn, pOut);
+		return 0;
+	}
+
+	size_t N = m_nSize;
+	size_t i;
+	T *a = &m_arWork[0];
+
+	// Restore the complex conjugate half of the spectrum
+	for (i = 0; i <= N / 2; i++)
+	{
+		a[2 * i] = pIn[i].real();
+		a[2 * i + 1] = pIn[i].imag();
+	}
+	for (i = 1; 2 * i < N; i++)
+	{
+		a[2 * (N - i)] = pIn[i].real();
+		a[2 * (N - i) + 1] = -pIn[i].imag();
+	}
+
+	Transform(a);
+
+	for (i = 0; i < N; i++)
+		pOut[i] = a[2 * i] * m_fNorm;
+
+	return 0;
+}
+
+// Split complex transforms run the radix-4 passes on the split arrays for power of 2
+// COMPLEX plans above 64 points and for REAL plans on top of them
+template <class T>
+bool CFFTPlanT<T>::IsSplitNative() const
+{
+	return m_eAlgorithm == RADIX2 && m_nCplxSize > const_CodeletMaxSize &&
+		(m_eType == COMPLEX || (m_eType == REAL && m_nCplxSize != m_nSize));
+}
+
+// Split twiddles and buffers, allocated by the first ExecuteSplit()
+template <class T>
+void CFFTPlanT<T>::PrepareSplit()
+{
+	if (!IsSplitNative())
+	{
+		if (m_arSplit.empty())
+			m_arSplit.resize(2 * m_nCplxSize + 2);
+		return;
+	}
+
+	if (m_eType == REAL && m_bInverse && m_arSplit.empty())
+		m_arSplit.resize(2 * m_nCplxSize);
+	if (!m_arSplitTwiddle.empty())
+		return;
+
+	// Every block of L complex twiddles (w1[] and w2[] of every radix-4 pass) becomes
+	// L real parts followed by L imaginary parts
+	const size_t N = m_nCplxSize;
+	size_t L = 1, i, j;
+	for (i = 0; (size_t(1) << i) < N; i++);
+	if ((i & 1) != 0)
+		L = 2;
+	m_arSplitTwiddle.resize(m_arTwiddle.size());
+	const T *w = &m_arTwiddle[0];
+	T *s = &m_arSplitTwiddle[0];
+	for (; 4 * L <= N; L *= 4)
+	{
+		for (j = 0; j < 2; j++, w += 2 * L, s += 2 * L)
+		{
+			for (i = 0; i < L; i++)
+			{
+				s[i] = w[2 * i];
+				s[L + i] = w[2 * i + 1];
+			}
+		}
+	}
+}
+
+// PackedSpectrum() on split arrays of H+1 elements
+template <class T>
+void CFFTPlanT<T>::PackedSpectrumSplit(T *zr, T *zi, T fNorm)
+{
+	size_t H = m_nCplxSize;
+	size_t k, j;
+	const T *w = &m_arRealTwiddle[0];
+	T er, ei, dr, di, tr, ti;
+
+	er = zr[0];
+	ei = zi[0];
+	zr[0] = (er + ei) * fNorm;
+	zi[0] = 0.;
+	zr[H] = (er - ei) * fNorm;
+	zi[H] = 0.;
+
+	for (k = 1; 2 * k <= H; k++)
+	{
+		j = H - k;
+		er = T(0.5) * (zr[k] + zr[j]);
+		ei = T(0.5) * (zi[k] - zi[j]);
+		dr = T(0.5) * (zr[k] - zr[j]);
+		di = T(0.5) * (zi[k] + zi[j]);
+		tr = w[2 * k] * di + w[2 * k + 1] * dr;
+		ti = w[2 * k + 1] * di - w[2 * k] * dr;
+		zr[k] = (er + tr) * fNorm;
+		zi[k] = (ei + ti) * fNorm;
+		zr[j] = (er - tr) * fNorm;
+		zi[j] = (ti - ei) * fNorm;
+	}
+}
+
+// COMPLEX on split arrays: GetSize() values each
+template <class T>
+int CFFTPlanT<T>::ExecuteSplit(const T *pInRe, const T *pInIm, T *pOutRe, T *pOutIm)
+{
+	if (m_nSize == 0) return -1;
+	if (m_eType != COMPLEX) return -3;
+
+	PrepareSplit();
+	size_t N = m_nSize;
+	size_t i;
+
+	if (IsSplitNative())
+	{
+		do_bit_reverse_split(N, &m_arBitRev[0], pInRe, pOutRe);
+		do_bit_reverse_split(N, &m_arBitRev[0], pInIm, pOutIm);
+		do_fft_radix4_split(N, &m_arSplitTwiddle[0], pOutRe, pOutIm, m_bBackward, m_eSimd);
+		if (m_fNorm != 1.)
+		{
+			for (i = 0; i < N; i++)
+			{
+				pOutRe[i] *= m_fNorm;
+				pOutIm[i] *= m_fNorm;
+			}
+		}
+		return 0;
+	}
+
+	T *a = &m_arSplit[0];
+	for (i = 0; i < N; i++)
+	{
+		a[2 * i] = pInRe[i];
+		a[2 * i + 1] = pInIm[i];
+	}
+	Transform(a);
+	for (i = 0; i < N; i++)
+	{
+		pOutRe[i] = a[2 * i] * m_fNorm;
+		pOutIm[i] = a[2 * i + 1] * m_fNorm;
+	}
+	return 0;
+}
+
+// COMPLEX: GetSize() real -> GetSize() split complex
+// REAL: GetSize() real -> GetSize()/2+1 split complex. Even and odd samples of the packed
+// sequence (see PackedForward()) go straight to the bit reversed positions of pOutRe, pOutIm.
+template <class T>
+int CFFTPlanT<T>::ExecuteSplit(const T *pIn, T *pOutRe, T *pOutIm)
+{
+	if (m_nSize == 0) return -1;
+	if (m_eType != COMPLEX && !(m_eType == REAL && !m_bInverse)) return -3;
+
+	PrepareSplit();
+	size_t N = m_nCplxSize;
+	size_t i, j;
+
+	if (!IsSplitNative())
+	{
+		std::complex<T> *c = reinterpret_cast<std::complex<T> *>(&m_arSplit[0]);
+		ForwardReal(m_nSize, pIn, c);
+		size_t nOutCnt = (m_eType == COMPLEX) ? m_nSize : m_nSize / 2 + 1;
+		for (i = 0; i < nOutCnt; i++)
+		{
+			pOutRe[i] = c[i].real();
+			pOutIm[i] = c[i].imag();
+		}
+		return 0;
+	}
+
+	const unsigned int *rev = &m_arBitRev[0];
+	bool bPacked = m_eType == REAL;
+	for (i = 0; i < N; i++)
+	{
+		j = rev[i];
+		pOutRe[j] = bPacked ? pIn[2 * i] : pIn[i];
+		pOutIm[j] = bPacked ? pIn[2 * i + 1] : 0.;
+	}
+	do_fft_radix4_split(N, &m_arSplitTwiddle[0], pOutRe, pOutIm, m_bBackward, m_eSimd);
+
+	if (bPacked)
+		PackedSpectrumSplit(pOutRe, pOutIm, m_fNorm);
+	else if (m_fNorm != 1.)
+	{
+		for (i = 0; i < N; i++)
+		{
+			pOutRe[i] *= m_fNorm;
+			pOutIm[i] *= m_fNorm;
+		}
+	}
+	return 0;
+}
+
+// REAL inverse: GetSize()/2+1 split complex -> GetSize() real (see PackedInverse())
+template <class T>
+int CFFTPlanT<T>::ExecuteSplitToReal(const T *pInRe, const T *pInIm, T *pOut)
+{
+	if (m_nSize == 0) return -1;
+	if (m_eType != REAL || !m_bInverse) return -3;
+
+	PrepareSplit();
+	size_t H = m_nCplxSize;
+	size_t k, j;
+
+	if (!IsSplitNative())
+	{
+		std::complex<T> *c = reinterpret_cast<std::complex<T> *>(&m_arSplit[0]);
+		for (k = 0; k <= m_nSize / 2; k++)
+			c[k] = std::complex<T>(pInRe[k], pInIm[k]);
+		return Execute(c, pOut);
+	}
+
+	T *zr = &m_arSplit[0];
+	T *zi = zr + H;
+	const T *w = &m_arRealTwiddle[0];
+	T er, ei, dr, di, tr, ti;
+
+	zr[0] = pInRe[0] + pInRe[H];
+	zi[0] = pInRe[0] - pInRe[H];
+	for (k = 1; 2 * k <= H; k++)
+	{
+		j = H - k;
+		er = pInRe[k] + pInRe[j];
+		ei = pInIm[k] - pInIm[j];
+		dr = pInRe[k] - pInRe[j];
+		di = pInIm[k] + pInIm[j];
+		tr = -(w[2 * k] * di + w[2 * k + 1] * dr);
+		ti = w[2 * k] * dr - w[2 * k + 1] * di;
+		zr[k] = er + tr;
+		zi[k] = ei + ti;
+		zr[j] = er - tr;
+		zi[j] = ti - ei;
+	}
+
+	do_bit_reverse_split(H, &m_arBitRev[0], zr, zr);
+	do_bit_reverse_split(H, &m_arBitRev[0], zi, zi);
+	do_fft_radix4_split(H, &m_arSplitTwiddle[0], zr, zi, m_bBackward, m_eSimd);
+
+	for (k = 0; k < H; k++)
+	{
+		pOut[2 * k] = zr[k] * m_fNorm;
+		pOut[2 * k + 1] = zi[k] * m_fNorm;
+	}
+	return 0;
+}
+
+// DCT, DST, DCT1, DCT4, DST1, DST2, DST4: GetSize() real -> GetSize() real.
+// MDCT: 2*GetSize() real -> GetSize() real (the other way round when inverse).
+// pIn and pOut may be equal.
+template <class T>
+int CFFTPlanT<T>::Execute(const T *pIn, T *pOut)
+{
+	if (m_nSize == 0) return -1;
+	if (m_eType == COMPLEX || m_eType == REAL) return -3;
+
+	if (m_eType == MDCT)
+	{
+		ExecuteMDCT(pIn, pOut);
+		return 0;
+	}
+
+	if (pIn != pOut)
+		memcpy(pOut, pIn, m_nSize * sizeof(T));
+
+	switch (m_eType)
+	{
+	case DCT:
+		ExecuteDCT(pOut);
+		break;
+	case DST:
+		ExecuteDST(pOut);
+		break;
+	case DCT1:
+		ExecuteDCT1(pOut);
+		break;
+	case DST1:
+		ExecuteDST1(pOut);
+		break;
+	case DST2:
+		ExecuteDST2(pOut);
+		break;
+	default:
+		ExecuteDCT4(pOut);
+		break;
+	}
+
+	return 0;
+}
+
+// DCT, DST in place
+template <class T>
+int CFFTPlanT<T>::Execute(T *pData)
+{
+	return Execute(pData, pData);
+}
+
+template <class T>
+int CFFTPlanT<T>::Execute(size_t nInCnt, const T *pInVal, std::vector<std::complex<T> > &arOutput)
+{
+	if (m_nSize == 0) return -1;
+	if (m_eType != COMPLEX && !(m_eType == REAL && !m_bInverse)) return -3;
+	if (nInCnt > m_nSize) return -2;
+
+	arOutput.resize(m_eType == COMPLEX ? m_nSize : m_nSize / 2 + 1);
+	ForwardReal(nInCnt, pInVal, &arOutput[0]);
+	return 0;
+}
+
+template <class T>
+int CFFTPlanT<T>::Execute(size_t nInCnt, const std::complex<T> *pInVal, std::vector<std::complex<T> > &arOutput)
+{
+	if (m_nSize == 0) return -1;
+	if (m_eType != COMPLEX) return -3;
+	if (nInCnt > m_nSize) return -2;
+
+	arOutput.resize(m_nSize);
+	if (nInCnt == m_nSize)
+		return Execute(pInVal, &arOutput[0]);
+
+	size_t i;
+	for (i = 0; i < nInCnt; i++)
+		arOutput[i] = pInVal[i];
+	for (i = nInCnt; i < m_nSize; i++)
+		arOutput[i] = 0.;
+	return Execute(&arOutput[0]);
+}
+
+template <class T>
+int CFFTPlanT<T>::Execute(size_t nInCnt, const T *pInVal, std::vector<T> &arOutput)
+{
+	if (m_nSize == 0) return -1;
+	if (m_eType != DCT && m_eType != DST) return -3;
+	if (nInCnt > m_nSize) return -2;
+
+	size_t i;
+
+	arOutput.resize(m_nSize);
+	for (i = 0; i < nInCnt; i++)
+		arOutput[i] = pInVal[i];
+	for (i = nInCnt; i < m_nSize; i++)
+		arOutput[i] = 0.;
+
+	return Execute(&arOutput[0]);
+}
+
+template <class T>
+int CFFTPlanT<T>::Execute(const std::vector<std::complex<T> > &arInput, std::vector<T> &arOutput)
+{
+	if (m_nSize == 0) return -1;
+	if (m_eType != REAL || !m_bInverse) return -3;
+	if (arInput.size() != m_nSize / 2 + 1) return -2;
+
+	arOutput.resize(m_nSize);
+	return Execute(&arInput[0], &arOutput[0]);
+}
+
+// Batch of nHowMany COMPLEX transforms. Small radix-2 plans transform as many
+// signals at once as a SIMD register holds complex numbers.
+template <class T>
+int CFFTPlanT<T>::ExecuteMany(size_t nHowMany, const std::complex<T> *pIn, size_t nInStride, size_t nInDist,
+	std::complex<T> *pOut, size_t nOutStride, size_t nOutDist)
+{
+	if (m_nSize == 0) return -1;
+	if (m_eType != COMPLEX) return -3;
+
+	size_t nLanes = get_simd_lanes(m_eSimd, 2 * sizeof(T));
+	if (m_eAlgorithm != RADIX2 || nLanes < 2 || nHowMany < 2 || m_nSize > 4096)
+		return ExecuteEach(nHowMany, pIn, nInStride, nInDist, m_nSize, pOut, nOutStride, nOutDist, m_nSize);
+
+	size_t m;
+	for (m = 0; m < nHowMany; m += nLanes)
+	{
+		ExecuteLanes(nLanes, (nHowMany - m < nLanes) ? nHowMany - m : nLanes,
+			pIn + m * nInDist, nInStride, nInDist, pOut + m * nOutDist, nOutStride, nOutDist);
+	}
+	return 0;
+}
+
+// Batch of COMPLEX transforms of real input or REAL forward transforms
+template <class T>
+int CFFTPlanT<T>::ExecuteMany(size_t nHowMany, const T *pIn, size_t nInStride, size_t nInDist,
+	std::complex<T> *pOut, size_t nOutStride, size_t nOutDist)
+{
+	if (m_nSize == 0) return -1;
+	if (m_eType != COMPLEX && !(m_eType == REAL && !m_bInverse)) return -3;
+
+	return ExecuteEach(nHowMany, pIn, nInStride, nInDist, m_nSize,
+		pOut, nOutStride, nOutDist, (m_eType == COMPLEX) ? m_nSize : m_nSize / 2 + 1);
+}
+
+// Batch of REAL inverse transforms
+template <class T>
+int CFFTPlanT<T>::ExecuteMany(size_t nHowMany, const std::complex<T> *pIn, size_t nInStride, size_t nInDist,
+	T *pOut, size_t nOutStride, size_t nOutDist)
+{
+	if (m_nSize == 0) return -1;
+	if (m_eType != REAL || !m_bInverse) return -3;
+
+	return ExecuteEach(nHowMany, pIn, nInStride, nInDist, m_nSize / 2 + 1, pOut, nOutStride, nOutDist, m_nSize);
+}
+
+// Batch of real to real transforms (DCT, DST, ..., MDCT)
+template <class T>
+int CFFTPlanT<T>::ExecuteMany(size_t nHowMany, const T *pIn, size_t nInStride, size_t nInDist,
+	T *pOut, size_t nOutStride, size_t nOutDist)
+{
+	if (m_nSize == 0) return -1;
+	if (m_eType == COMPLEX || m_eType == REAL) return -3;
+
+	size_t nInCnt = m_nSize, nOutCnt = m_nSize;
+	if (m_eType == MDCT)
+	{
+		if (m_bInverse)
+			nOutCnt *= 2;
+		else
+			nInCnt *= 2;
+	}
+	return ExecuteEach(nHowMany, pIn, nInStride, nInDist, nInCnt, pOut, nOutStride, nOutDist, nOutCnt);
+}
+
+// One transform after another. Strided signals are gathered into (scattered from)
+// the batch buffer, contiguous ones are passed to Execute() as they are.
+template <class T>
+template <class TIn, class TOut>
+int CFFTPlanT<T>::ExecuteEach(size_t nHowMany, const TIn *pIn, size_t nInStride, size_t nInDist, size_t nInCnt,
+	TOut *pOut, size_t nOutStride, size_t nOutDist, size_t nOutCnt)
+{
+	size_t m, k;
+	size_t nInSize = nInCnt * (sizeof(TIn) / sizeof(T));
+	size_t nOutSize = nOutCnt * (sizeof(TOut) / sizeof(T));
+
+	if (m_arBatch.size() < nInSize + nOutSize)
+		m_arBatch.resize(nInSize + nOutSize);
+	TIn *pInBuf = reinterpret_cast<TIn *>(&m_arBatch[0]);
+	TOut *pOutBuf = reinterpret_cast<TOut *>(&m_arBatch[nInSize]);
+
+	for (m = 0; m < nHowMany; m++)
+	{
+		const TIn *pSrc = pIn + m * nInDist;
+		TOut *pDst = pOut + m * nOutDist;
+		if (nInStride != 1)
+		{
+			for (k = 0; k < nInCnt; k++)
+				pInBuf[k] = pSrc[k * nInStride];
+			pSrc = pInBuf;
+		}
+
+		int nRes = Execute(pSrc, (nOutStride != 1) ? pOutBuf : pDst);
+		if (nRes != 0) return nRes;
+
+		if (nOutStride != 1)
+		{
+			for (k = 0; k < nOutCnt; k++)
+				pDst[k * nOutStride] = pOutBuf[k];
+		}
+	}
+	return 0;
+}
+
+// nCnt <= nLanes signals are interleaved element by element (in bit reversed order),
+// so a register holds the same element of several signals and every pass of
+// do_fft_radix4() runs at full SIMD width, the first ones included.
+template <class T>
+void CFFTPlanT<T>::ExecuteLanes(size_t nLanes, size_t nCnt, const std::complex<T> *pIn, size_t nInStride, size_t nInDist,
+	std::complex<T> *pOut, size_t nOutStride, size_t nOutDist)
+{
+	size_t N = m_nSize;
+	size_t i, l;
+
+	if (m_nLanes != nLanes)
+	{
+		m_nLanes = nLanes;
+		m_arLaneTwiddle.resize(m_arTwiddle.size() * nLanes);
+		for (i = 0; 2 * i < m_arTwiddle.size(); i++)
+		{
+			for (l = 0; l < nLanes; l++)
+			{
+				m_arLaneTwiddle[2 * (i * nLanes + l)] = m_arTwiddle[2 * i];
+				m_arLaneTwiddle[2 * (i * nLanes + l) + 1] = m_arTwiddle[2 * i + 1];
+			}
+		}
+	}
+	if (m_arBatch.size() < 2 * N * nLanes)
+		m_arBatch.resize(2 * N * nLanes);
+
+	T *a = &m_arBatch[0];
+	const unsigned int *rev = &m_arBitRev[0];
+
+	for (i = 0; i < N; i++)
+	{
+		T *p = a + 2 * nLanes * rev[i];
+		for (l = 0; l < nCnt; l++)
+		{
+			const std::complex<T> &x = pIn[l * nInDist + i * nInStride];
+			p[2 * l] = x.real();
+			p[2 * l + 1] = x.imag();
+		}
+		for (; l < nLanes; l++)
+			p[2 * l] = p[2 * l + 1] = 0.;
+	}
+
+	do_fft_radix4(N * nLanes, m_arLaneTwiddle.data(), a, m_bBackward, m_eSimd, nLanes);
+
+	for (i = 0; i < N; i++)
+	{
+		const T *p = a + 2 * nLanes * i;
+		for (l = 0; l < nCnt; l++)
+			pOut[l * nOutDist + i * nOutStride] = std::complex<T>(p[2 * l] * m_fNorm, p[2 * l + 1] * m_fNorm);
+	}
+}
+
+template class CFFTPlanT<double>;
+template class CFFTPlanT<float>;
+
+// Twiddles W^j = exp(-+2*pi*i*j/N) of any j by two tables of about sqrt(N) entries:
+// W^j = W^(j - j mod B) * W^(j mod B), B = 2^m >= sqrt(N). One product per twiddle.
+struct CTwoLevelTwiddles
+{
+	CTwoLevelTwiddles(size_t N, bool bBackward)
+		: nMask(N - 1)
+		, nBits(0)
+	{
+		size_t j;
+		double c, s;
+		while ((size_t(1) << (2 * nBits)) < N)
+			nBits++;
+		const size_t B = size_t(1) << nBits;
+		arLow.resize(2 * B);
+		arHigh.resize(2 * ((N + B - 1) / B));
+		for (j = 0; j < B; j++)
+		{
+			do_twiddle(j, N, c, s);
+			arLow[2 * j] = c;
+			arLow[2 * j + 1] = bBackward ? s : -s;
+		}
+		for (j = 0; 2 * j < arHigh.size(); j++)
+		{
+			do_twiddle(j * B, N, c, s);
+			arHigh[2 * j] = c;
+			arHigh[2 * j + 1] = bBackward ? s : -s;
+		}
+	}
+
+	void Get(size_t j, double &c, double &s) const
+	{
+		j &= nMask;
+		const double *h = &arHigh[2 * (j >> nBits)];
+		const double *l = &arLow[2 * (j & ((size_t(1) << nBits) - 1))];
+		c = h[0] * l[0] - h[1] * l[1];
+		s = h[0] * l[1] + h[1] * l[0];
+	}
+
+	size_t nMask;
+	int nBits;
+	std::vector<double> arLow;            // W^j, j < B (interleaved)
+	std::vector<double> arHigh;           // W^(j*B)
+};
+
+// Work of an N-point transform in units of a term of the direct sums (a term takes
+// about the time of two points of a radix-2 stage)
+static double do_pruned_fft_cost(size_t N)
+{
+	return 0.5 * double(N) * log2(double(N));
+}
+
+// out[n] = in[n] * W^(n*k), n < nCnt (interleaved complex values)
+template <class T, class U>
+static void do_pruned_modulate(size_t nCnt, const T *in, U *out, const CTwoLevelTwiddles &W, size_t k)
+{
+	size_t n;
+	double c, s;
+	for (n = 0; n < nCnt; n++)
+	{
+		double xr = in[2 * n], xi = in[2 * n + 1];
+		if (k == 0)
+			c = 1., s = 0.;
+		else
+			W.Get(n * k, c, s);
+		out[2 * n] = U(xr * c - xi * s);
+		out[2 * n + 1] = U(xr * s + xi * c);
+	}
+}
+
+// Pruned FFT: bins k0 .. k0+M-1 of the N-point transform of nIn values. After y[n] = x[n] * W^(n*k0)
+// they are bins 0 .. M-1 of the transform of y. P >= nIn, S >= M are powers of 2, Q = N/P, R = N/S.
+// Inputs pruned:  X[k1*Q + k2] = sum_{n<P} (y[n] * W^(n*k2)) * W_P^(n*k1), a P-point transform
+//                 for every class k2 < min(Q, M).
+// Outputs pruned: X[m] = sum_{a<R} W^(a*m) * Z_a[m], Z_a is the S-point transform of y[b*R + a],
+//                 only sequences a < min(R, nIn) aren't zero.
+template <class T, class TIn>
+static int do_pruned_FFT(size_t nInCnt, const TIn *pIn, size_t nSize, size_t nFirstBin, size_t nOutCnt,
+	std::complex<T> *pOut, bool bInverse, bool bOrthNorm)
+{
+	if (nInCnt < 1) return -1;
+
+	size_t N = nSize, P, S;
+	if (N == 0)
+		for (N = 2; N < nInCnt; N <<= 1);
+	if (N < 2 || (N & (N - 1)) != 0 || N < nInCnt) return -2;  // Must be 2^m elements
+	if (nFirstBin > N || nOutCnt > N - nFirstBin) return -3;
+	if (nOutCnt == 0) return 0;
+
+	const size_t M = nOutCnt, k0 = nFirstBin;
+	for (P = 2; P < nInCnt; P <<= 1);
+	for (S = 2; S < M; S <<= 1);
+	const size_t Q = N / P, R = N / S;
+	const double fDirect = double(M) * double(nInCnt);
+	const double fInputs = double(std::min(Q, M)) * (double(nInCnt) + do_pruned_fft_cost(P));
+	const double fOutputs = double(std::min(R, nInCnt)) * (do_pruned_fft_cost(S) + double(M));
+
+	double fNorm = 1.;
+	if (bOrthNorm)
+		fNorm = ::sqrt(1. / double(N));
+	else if (!bInverse)
+		fNorm = 1. / double(N);
+
+	CTwoLevelTwiddles W(N, bInverse);
+	std::vector<std::complex<T> > arY(nInCnt);
+	T *y = reinterpret_cast<T *>(&arY[0]);
+	T *out = reinterpret_cast<T *>(pOut);
+	size_t n, m;
+	double c, s;
+	for (n = 0; n < nInCnt; n++)
+		arY[n] = pIn[n];
+	do_pruned_modulate(nInCnt, y, y, W, k0);
+
+	if (fDirect <= fInputs && fDirect <= fOutputs)
+	{
+		for (m = 0; m < M; m++)
+		{
+			double vr = 0., vi = 0.;
+			for (n = 0; n < nInCnt; n++)
+			{
+				W.Get(n * m, c, s);
+				vr += y[2 * n] * c - y[2 * n + 1] * s;
+				vi += y[2 * n] * s + y[2 * n + 1] * c;
+			}
+			out[2 * m] = T(vr * fNorm);
+			out[2 * m + 1] = T(vi * fNorm);
+		}
+		return 0;
+	}
+
+	// Sub-transforms run as FFT() does, by a cached plan. It isn't normalized, but forward
+	// plans divide by their size.
+	CFFTPlanT<T> tmp, *pPlan;
+	const size_t L = (fInputs <= fOutputs) ? P : S;
+	int nRes = do_cached_plan<T>(CFFTPlanBase::COMPLEX, L, bInverse, false, tmp, pPlan);
+	if (nRes != 0) return nRes;
+	const T fScale = T(fNorm * (bInverse ? 1. : double(L)));
+	std::vector<std::complex<T> > arU(L);
+	T *u = reinterpret_cast<T *>(&arU[0]);
+
+	if (fInputs <= fOutputs)
+	{
+		for (size_t k2 = 0; k2 < std::min(Q, M); k2++)
+		{
+			do_pruned_modulate(nInCnt, y, u, W, k2);
+			std::fill(arU.begin() + nInCnt, arU.end(), std::complex<T>(0., 0.));
+			pPlan->Execute(&arU[0]);
+			for (m = k2; m < M; m += Q)
+			{
+				out[2 * m] = u[2 * (m / Q)] * fScale;
+				out[2 * m + 1] = u[2 * (m / Q) + 1] * fScale;
+			}
+		}
+		return 0;
+	}
+
+	std::vector<double> arSum(2 * M, 0.);
+	for (size_t a = 0; a < std::min(R, nInCnt); a++)
+	{
+		std::fill(arU.begin(), arU.end(), std::complex<T>(0., 0.));
+		for (n = a; n < nInCnt; n += R)
+			arU[n / R] = arY[n];
+		pPlan->Execute(&arU[0]);
+		for (m = 0; m < M; m++)
+		{
+			W.Get(a * m, c, s);
+			arSum[2 * m] += u[2 * m] * c - u[2 * m + 1] * s;
+			arSum[2 * m + 1] += u[2 * m] * s + u[2 * m + 1] * c;
+		}
+	}
+	for (m = 0; m < 2 * M; m++)
+		out[m] = T(arSum[m] * fScale);
+	return 0;
+}
+
+int FFT(size_t nInCnt, const double *pIn, size_t nSize, size_t nFirstBin, size_t nOutCnt, std::complex<double> *pOut, bool bInverse, bool bOrthNorm/* = true*/)
+{
+	return do_pruned_FFT(nInCnt, pIn, nSize, nFirstBin, nOutCnt, pOut, bInverse, bOrthNorm);
+}
+
+int FFT(size_t nInCnt, const std::complex<double> *pIn, size_t nSize, size_t nFirstBin, size_t nOutCnt, std::complex<double> *pOut, bool bInverse, bool bOrthNorm/* = true*/)
+{
+	return do_pruned_FFT(nInCnt, pIn, nSize, nFirstBin, nOutCnt, pOut, bInverse, bOrthNorm);
+}
+
+int FFT(size_t nInCnt, const float *pIn, size_t nSize, size_t nFirstBin, size_t nOutCnt, std::complex<float> *pOut, bool bInverse, bool bOrthNorm/* = true*/)
+{
+	return do_pruned_FFT(nInCnt, pIn, nSize, nFirstBin, nOutCnt, pOut, bInverse, bOrthNorm);
+}
+
+int FFT(size_t nInCnt, const std::complex<float> *pIn, size_t nSize, size_t nFirstBin, size_t nOutCnt, std::complex<float> *pOut, bool bInverse, bool bOrthNorm/* = true*/)
+{
+	return do_pruned_FFT(nInCnt, pIn, nSize, nFirstBin, nOutCnt, pOut, bInverse, bOrthNorm);
+}
+
+template <class T>
+CFFTPlanNDT<T>::CFFTPlanNDT()
+	: m_eType(COMPLEX)
+	, m_nDims(0)
+	, m_nTotal(0)
+	, m_bInverse(false)
+	, m_bOrthNorm(false)
+	, m_nThreads(1)
+	, m_pPool(NULL)
+{
+	m_arSize[0] = m_arSize[1] = m_arSize[2] = 0;
+}
+
+template <class T>
+CFFTPlanNDT<T>::~CFFTPlanNDT()
+{
+	Reset();
+}
+
+template <class T>
+void CFFTPlanNDT<T>::Reset()
+{
+	m_eType = COMPLEX;
+	m_nDims = 0;
+	m_nTotal = 0;
+	m_bInverse = false;
+	m_bOrthNorm = false;
+	m_arSize[0] = m_arSize[1] = m_arSize[2] = 0;
+	size_t i;
+	for (i = 0; i < m_arPlans.size(); i++)
+		delete m_arPlans[i];
+	m_arPlans.clear();
+	m_arWork.clear();
+	do_update_pool(1, m_pPool);
+}
+
+template <class T>
+int CFFTPlanNDT<T>::Create2D(TTransform eType, size_t nSize0, size_t nSize1, bool bInverse, bool bOrthNorm/* = true*/)
+{
+	size_t arSize[2] = {nSize0, nSize1};
+	return Create(eType, 2, arSize, bInverse, bOrthNorm);
+}
+
+template <class T>
+int CFFTPlanNDT<T>::Create3D(TTransform eType, size_t nSize0, size_t nSize1, size_t nSize2, bool bInverse, bool bOrthNorm/* = true*/)
+{
+	size_t arSize[3] = {nSize0, nSize1, nSize2};
+	return Create(eType, 3, arSize, bInverse, bOrthNorm);
+}
+
+// Every size must be at least 2. One 1-D plan per dimension and thread.
+template <class T>
+int CFFTPlanNDT<T>::Create(TTransform eType, size_t nDims, const size_t *pSize, bool bInverse, bool bOrthNorm)
+{
+	Reset();
+
+	if (eType == REAL || eType == MDCT) return -3;
+
+	size_t d, nTotal = 1;
+	for (d = 0; d < nDims; d++)
+	{
+		if (pSize[d] < 2) return -1;
+		if (pSize[d] > 0x7FFFFFFF) return -2;
+		m_arSize[d] = pSize[d];
+		nTotal *= pSize[d];
+	}
+
+	int t;
+	for (d = 0; d < nDims; d++)
+	{
+		for (t = 0; t < m_nThreads; t++)
+		{
+			CFFTPlanT<T> *pPlan = new CFFTPlanT<T>;
+			m_arPlans.push_back(pPlan);
+			int nRes = pPlan->Create(eType, pSize[d], bInverse, bOrthNorm);
+			if (nRes != 0)
+			{
+				Reset();
+				return nRes;
+			}
+		}
+	}
+
+	m_eType = eType;
+	m_nDims = nDims;
+	m_nTotal = nTotal;
+	m_bInverse = bInverse;
+	m_bOrthNorm = bOrthNorm;
+	m_arWork.resize((eType == COMPLEX) ? 2 * nTotal : nTotal);
+	if (nTotal >= const_ParallelMinSize)
+		do_update_pool(m_nThreads, m_pPool);
+	return 0;
+}
+
+// Rows are split between nThreads threads for arrays of 65536 elements and more.
+// A created plan is created again.
+template <class T>
+int CFFTPlanNDT<T>::SetThreads(int nThreads)
+{
+	if (nThreads < 1) return -1;
+
+	m_nThreads = nThreads;
+	if (m_nDims != 0)
+	{
+		size_t arSize[3] = {m_arSize[0], m_arSize[1], m_arSize[2]};
+		return Create(m_eType, m_nDims, arSize, m_bInverse, m_bOrthNorm);
+	}
+	return 0;
+}
+
+// Contiguous rows of the last dimension are transformed from pIn to pOut. Then for every
+// other dimension the array is a stack of n x nInner matrices: each one is transposed
+// into pWork, its nInner rows of n points are transformed, and it is transposed back.
+template <class T>
+template <class E>
+void CFFTPlanNDT<T>::ExecuteAxes(const E *pIn, E *pOut, E *pWork)
+{
+	int nPlanThreads = m_nThreads;
+	CFFTPlanT<T> * const *pPlans = &m_arPlans[0];
+	size_t nDim = m_nDims - 1;
+	size_t n = m_arSize[nDim];
+
+	do_parallel(m_pPool, m_nTotal / n, [=](size_t nBegin, size_t nEnd, int nThread) {
+		CFFTPlanT<T> *pPlan = pPlans[nDim * nPlanThreads + nThread];
+		size_t i;
+		for (i = nBegin; i < nEnd; i++)
+			pPlan->Execute(pIn + i * n, pOut + i * n);
+	});
+
+	size_t nInner = n;
+	while (nDim-- > 0)
+	{
+		n = m_arSize[nDim];
+		size_t nOuter = m_nTotal / (n * nInner);
+
+		// pOut[o][i][j] -> pWork[o][j][i]
+		do_parallel(m_pPool, nOuter * n, [=](size_t nBegin, size_t nEnd, int) {
+			do_transpose_stack(n, nInner, nBegin, nEnd, pOut, pWork);
+		});
+		do_parallel(m_pPool, nOuter * nInner, [=](size_t nBegin, size_t nEnd, int nThread) {
+			CFFTPlanT<T> *pPlan = pPlans[nDim * nPlanThreads + nThread];
+			size_t i;
+			for (i = nBegin; i < nEnd; i++)
+				pPlan->Execute(pWork + i * n);
+		});
+		// pWork[o][j][i] -> pOut[o][i][j]
+		do_parallel(m_pPool, nOuter * nInner, [=](size_t nBegin, size_t nEnd, int) {
+			do_transpose_stack(nInner, n, nBegin, nEnd, pWork, pOut);
+		});
+		nInner *= n;
+	}
+}
+
+template <class T>
+int CFFTPlanNDT<T>::Execute(std::complex<T> *pData)
+{
+	return Execute(pData, pData);
+}
+
+template <class T>
+int CFFTPlanNDT<T>::Execute(const std::complex<T> *pIn, std::complex<T> *pOut)
+{
+	if (m_nDims == 0) return -1;
+	if (m_eType != COMPLEX) return -3;
+
+	ExecuteAxes(pIn, pOut, reinterpret_cast<std::complex<T> *>(&m_arWork[0]));
+	return 0;
+}
+
+template <class T>
+int CFFTPlanNDT<T>::Execute(T *pData)
+{
+	return Execute(pData, pData);
+}
+
+template <class T>
+int CFFTPlanNDT<T>::Execute(const T *pIn, T *pOut)
+{
+	if (m_nDims == 0) return -1;
+	if (m_eType == COMPLEX) return -3;
+
+	ExecuteAxes(pIn, pOut, &m_arWork[0]);
+	return 0;
+}
+
+template class CFFTPlanNDT<double>;
+template class CFFTPlanNDT<float>;
+
+template <class T>
+CFFTConvolverT<T>::CFFTConvolverT()
+	: m_nKernel(0)
+	, m_nBlock(0)
+	, m_nParts(0)
+	, m_nPos(0)
+	, m_nSlot(0)
+{
+}
+
+template <class T>
+void CFFTConvolverT<T>::Reset()
+{
+	m_nKernel = 0;
+	m_nBlock = 0;
+	m_nParts = 0;
+	m_nPos = 0;
+	m_nSlot = 0;
+	m_Forward.Reset();
+	m_Inverse.Reset();
+	m_arKernelSpectra.clear();
+	m_arDelayLine.clear();
+	m_arSum.clear();
+	m_arInput.clear();
+	m_arBlockOut.clear();
+	m_arOutput.clear();
+}
+
+template <class T>
+int CFFTConvolverT<T>::Create(size_t nKernelLen, const T *pKernel, size_t nBlockSize)
+{
+	Reset();
+
+	if (nKernelLen < 1 || nBlockSize < 1) return -1;
+
+	size_t B = nBlockSize;
+	size_t P = (nKernelLen + B - 1) / B;
+	size_t p;
+	int nRes = m_Forward.Create(CFFTPlanBase::REAL, 2 * B, false, false);
+	if (nRes == 0)
+		nRes = m_Inverse.Create(CFFTPlanBase::REAL, 2 * B, true, false);
+	if (nRes != 0)
+	{
+		Reset();
+		return nRes;
+	}
+
+	m_nKernel = nKernelLen;
+	m_nBlock = B;
+	m_nParts = P;
+	m_arKernelSpectra.resize(P * (B + 1));
+	m_arDelayLine.resize(P * (B + 1));
+	m_arSum.resize(B + 1);
+	m_arInput.resize(2 * B);
+	m_arBlockOut.resize(2 * B);
+	m_arOutput.resize(B);
+
+	// Partition p zero padded to 2*B points. The forward transform divides by 2*B,
+	// the inverse one does not, so the partition spectra are multiplied by 2*B.
+	for (p = 0; p < P; p++)
+	{
+		size_t n = (p + 1 < P) ? B : nKernelLen - p * B;
+		std::fill(m_arInput.begin(), m_arInput.end(), T(0));
+		memcpy(&m_arInput[0], pKernel + p * B, n * sizeof(T));
+		std::complex<T> *pSpectrum = &m_arKernelSpectra[p * (B + 1)];
+		m_Forward.Execute(&m_arInput[0], pSpectrum);
+		for (n = 0; n <= B; n++)
+			pSpectrum[n] *= T(2 * B);
+	}
+
+	Clear();
+	return 0;
+}
+
+template <class T>
+void CFFTConvolverT<T>::Clear()
+{
+	std::fill(m_arDelayLine.begin(), m_arDelayLine.end(), std::complex<T>(0));
+	std::fill(m_arInput.begin(), m_arInput.end(), T(0));
+	std::fill(m_arOutput.begin(), m_arOutput.end(), T(0));
+	m_nPos = 0;
+	m_nSlot = 0;
+}
+
+template <class T>
+int CFFTConvolverT<T>::Process(size_t nCnt, const T *pIn, T *pOut)
+{
+	if (m_nBlock == 0) return -1;
+
+	const size_t B = m_nBlock;
+	while (nCnt > 0)
+	{
+		size_t n = (B - m_nPos < nCnt) ? B - m_nPos : nCnt;
+		memcpy(&m_arInput[B + m_nPos], pIn, n * sizeof(T));
+		memcpy(pOut, &m_arOutput[m_nPos], n * sizeof(T));
+		pIn += n;
+		pOut += n;
+		nCnt -= n;
+		m_nPos += n;
+		if (m_nPos == B)
+		{
+			ProcessBlock();
+			m_nPos = 0;
+		}
+	}
+	return 0;
+}
+
+// Spectrum of the last 2*B input samples goes to the delay line. Block j of the line
+// (j blocks old) is multiplied by partition j of the kernel. The last B samples of the
+// circular convolution are the linear convolution (overlap-save).
+template <class T>
+void CFFTConvolverT<T>::ProcessBlock()
+{
+	const size_t B = m_nBlock;
+	const size_t P = m_nParts;
+	size_t p, k;
+
+	m_nSlot = (m_nSlot == 0) ? P - 1 : m_nSlot - 1;
+	m_Forward.Execute(&m_arInput[0], &m_arDelayLine[m_nSlot * (B + 1)]);
+	memcpy(&m_arInput[0], &m_arInput[B], B * sizeof(T));
+
+	T *y = reinterpret_cast<T *>(&m_arSum[0]);
+	std::fill(y, y + 2 * (B + 1), T(0));
+	for (p = 0; p < P; p++)
+	{
+		size_t nSlot = (m_nSlot + p < P) ? m_nSlot + p : m_nSlot + p - P;
+		const T *h = reinterpret_cast<const T *>(&m_arKernelSpectra[p * (B + 1)]);
+		const T *x = reinterpret_cast<const T *>(&m_arDelayLine[nSlot * (B + 1)]);
+		for (k = 0; k <= B; k++)
+		{
+			y[2 * k] += h[2 * k] * x[2 * k] - h[2 * k + 1] * x[2 * k + 1];
+			y[2 * k + 1] += h[2 * k] * x[2 * k + 1] + h[2 * k + 1] * x[2 * k];
+		}
+	}
+
+	m_Inverse.Execute(&m_arSum[0], &m_arBlockOut[0]);
+	memcpy(&m_arOutput[0], &m_arBlockOut[B], B * sizeof(T));
+}
+
+template class CFFTConvolverT<double>;
+template class CFFTConvolverT<float>;
+
+// Smallest even 2^a*3^b*5^c >= n (fast sizes of CFFTPlanT)
+static size_t do_fast_size(size_t n)
+{
+	size_t m, r;
+	for (m = (n < 2) ? 2 : n + (n & 1); ; m += 2)
+	{
+		for (r = m; (r % 2) == 0; r /= 2);
+		for (; (r % 3) == 0; r /= 3);
+		for (; (r % 5) == 0; r /= 5);
+		if (r == 1)
+			return m;
+	}
+}
+
+// Number and first lag of the correlation values of signals of N and M samples
+static size_t do_corr_size(int eMode, size_t N, size_t M)
+{
+	switch (eMode)
+	{
+	case CFFTCorrelatorT<double>::SAME:
+		return N;
+	case CFFTCorrelatorT<double>::VALID:
+		return (N > M) ? N - M + 1 : M - N + 1;
+	}
+	return N + M - 1;
+}
+
+static long long do_corr_first_lag(int eMode, size_t N, size_t M)
+{
+	switch (eMode)
+	{
+	case CFFTCorrelatorT<double>::SAME:
+		return -(long long) (M / 2);
+	case CFFTCorrelatorT<double>::VALID:
+		return (N > M) ? 0 : (long long) N - (long long) M;
+	}
+	return 1 - (long long) M;
+}
+
+template <class T>
+CFFTCorrelatorT<T>::CFFTCorrelatorT()
+	: m_nLen1(0)
+	, m_nLen2(0)
+	, m_nFFT(0)
+{
+}
+
+template <class T>
+void CFFTCorrelatorT<T>::Reset()
+{
+	m_nLen1 = 0;
+	m_nLen2 = 0;
+	m_nFFT = 0;
+	m_Complex.Reset();
+	m_Forward.Reset();
+	m_Inverse.Reset();
+	m_arWork.clear();
+	m_arCorr.clear();
+}
+
+template <class T>
+int CFFTCorrelatorT<T>::Create(size_t nLen1, size_t nLen2/* = 0*/)
+{
+	Reset();
+
+	if (nLen1 < 1) return -1;
+	if (nLen2 == 0)
+		nLen2 = nLen1;
+
+	size_t L = do_fast_size(nLen1 + nLen2 - 1);
+	int nRes = m_Complex.Create(CFFTPlanBase::COMPLEX, L, false, false);
+	if (nRes == 0)
+		nRes = m_Forward.Create(CFFTPlanBase::REAL, L, false, false);
+	if (nRes == 0)
+		nRes = m_Inverse.Create(CFFTPlanBase::REAL, L, true, false);
+	if (nRes != 0)
+	{
+		Reset();
+		return nRes;
+	}
+
+	m_nLen1 = nLen1;
+	m_nLen2 = nLen2;
+	m_nFFT = L;
+	m_arWork.resize(L);
+	m_arCorr.resize(L);
+	return 0;
+}
+
+template <class T>
+size_t CFFTCorrelatorT<T>::GetOutputSize(TMode eMode) const
+{
+	return do_corr_size(eMode, m_nLen1, m_nLen2);
+}
+
+template <class T>
+long long CFFTCorrelatorT<T>::GetFirstLag(TMode eMode) const
+{
+	return do_corr_first_lag(eMode, m_nLen1, m_nLen2);
+}
+
+// X * conj(Y) * fScale to m_arWork[0..L/2]. Z is the transform of z = x + i*y (divided by L),
+// X = (Z[k] + conj(Z[L-k])) / 2, Y = (Z[k] - conj(Z[L-k])) / 2i, so
+// X * conj(Y) = Im(Z[k] * Z[L-k]) / 2 + i * (|Z[k]|^2 - |Z[L-k]|^2) / 4.
+// In place: bin k only needs Z[k] and Z[L-k], L-k >= L/2.
+template <class T>
+void CFFTCorrelatorT<T>::Spectrum(const T *pX, const T *pY, T fScale)
+{
+	const size_t L = m_nFFT;
+	size_t k, j;
+	T *z = reinterpret_cast<T *>(&m_arWork[0]);
+
+	for (k = 0; k < L; k++)
+	{
+		z[2 * k] = (k < m_nLen1) ? pX[k] : 0.;
+		z[2 * k + 1] = (k < m_nLen2) ? pY[k] : 0.;
+	}
+	m_Complex.Execute(&m_arWork[0]);
+
+	const T fHalf = T(0.5) * fScale;
+	const T fQuarter = T(0.25) * fScale;
+	for (k = 0; 2 * k <= L; k++)
+	{
+		j = (k == 0) ? 0 : L - k;
+		T ar = z[2 * k], ai = z[2 * k + 1];
+		T br = z[2 * j], bi = z[2 * j + 1];
+		z[2 * k] = (ar * bi + ai * br) * fHalf;
+		z[2 * k + 1] = (ar * ar + ai * ai - br * br - bi * bi) * fQuarter;
+	}
+}
+
+// Lags nFirst .. nFirst+nCnt-1 of the circular correlation in m_arCorr
+template <class T>
+void CFFTCorrelatorT<T>::Lags(long long nFirst, size_t nCnt, T *pOut)
+{
+	size_t i;
+	long long k;
+	for (i = 0, k = nFirst; i < nCnt; i++, k++)
+		pOut[i] = m_arCorr[size_t(k < 0 ? k + (long long) m_nFFT : k)];
+}
+
+template <class T>
+int CFFTCorrelatorT<T>::Correlate(const T *pX, const T *pY, T *pOut, TMode eMode/* = FULL*/)
+{
+	if (m_nFFT == 0) return -1;
+
+	// Both spectra are divided by L, the inverse transform is not normalized
+	Spectrum(pX, pY, T(m_nFFT));
+	m_Inverse.Execute(&m_arWork[0], &m_arCorr[0]);
+	Lags(GetFirstLag(eMode), GetOutputSize(eMode), pOut);
+	return 0;
+}
+
+template <class T>
+int CFFTCorrelatorT<T>::AutoCorrelate(const T *pX, T *pOut, TMode eMode/* = FULL*/)
+{
+	if (m_nFFT == 0) return -1;
+	if (m_nLen2 < m_nLen1) return -3;
+
+	const size_t L = m_nFFT;
+	size_t k;
+	memcpy(&m_arCorr[0], pX, m_nLen1 * sizeof(T));
+	std::fill(m_arCorr.begin() + m_nLen1, m_arCorr.end(), T(0));
+	m_Forward.Execute(&m_arCorr[0], &m_arWork[0]);
+
+	T *z = reinterpret_cast<T *>(&m_arWork[0]);
+	const T fScale = T(L);
+	for (k = 0; 2 * k <= L; k++)
+	{
+		z[2 * k] = (z[2 * k] * z[2 * k] + z[2 * k + 1] * z[2 * k + 1]) * fScale;
+		z[2 * k + 1] = 0.;
+	}
+	m_Inverse.Execute(&m_arWork[0], &m_arCorr[0]);
+	Lags(do_corr_first_lag(eMode, m_nLen1, m_nLen1), do_corr_size(eMode, m_nLen1, m_nLen1), pOut);
+	return 0;
+}
+
+template <class T>
+int CFFTCorrelatorT<T>::CrossPowerSpectrum(const T *pX, const T *pY, std::complex<T> *pOut)
+{
+	if (m_nFFT == 0) return -1;
+
+	Spectrum(pX, pY, T(double(m_nFFT) * double(m_nFFT)));
+	memcpy(pOut, &m_arWork[0], GetBins() * sizeof(std::complex<T>));
+	return 0;
+}
+
+template class CFFTCorrelatorT<double>;
+template class CFFTCorrelatorT<float>;
+
+template <class T>
+CSTFTT<T>::CSTFTT()
+	: m_nFrame(0)
+	, m_nHop(0)
+	, m_nFill(0)
+	, m_nSkip(0)
+{
+}
+
+template <class T>
+void CSTFTT<T>::Reset()
+{
+	m_nFrame = 0;
+	m_nHop = 0;
+	m_nFill = 0;
+	m_nSkip = 0;
+	m_Forward.Reset();
+	m_Inverse.Reset();
+	m_arWindow.clear();
+	m_arFrame.clear();
+	m_arBuffer.clear();
+}
+
+template <class T>
+int CSTFTT<T>::Create(size_t nFrameSize, size_t nHop, const T *pWindow/* = NULL*/, bool bOrthNorm/* = true*/)
+{
+	Reset();
+
+	if (nHop < 1) return -1;
+
+	int nRes = m_Forward.Create(CFFTPlanBase::REAL, nFrameSize, false, bOrthNorm);
+	if (nRes == 0)
+		nRes = m_Inverse.Create(CFFTPlanBase::REAL, nFrameSize, true, bOrthNorm);
+	if (nRes != 0)
+	{
+		Reset();
+		return nRes;
+	}
+
+	m_nFrame = nFrameSize;
+	m_nHop = nHop;
+	m_arFrame.resize(nFrameSize);
+	m_arBuffer.resize(nFrameSize);
+	if (pWindow != NULL)
+		m_arWindow.assign(pWindow, pWindow + nFrameSize);
+	else
+	{
+		size_t n;
+		m_arWindow.resize(nFrameSize);
+		for (n = 0; n < nFrameSize; n++)
+			m_arWindow[n] = T(0.5 - 0.5 * cos(2. * const_PI * double(n) / double(nFrameSize)));
+	}
+	return 0;
+}
+
+template <class T>
+void CSTFTT<T>::Clear()
+{
+	m_nFill = 0;
+	m_nSkip = 0;
+}
+
+template <class T>
+size_t CSTFTT<T>::GetFrameCount(size_t nCnt) const
+{
+	if (m_nFrame == 0 || nCnt < m_nFrame) return 0;
+	return 1 + (nCnt - m_nFrame) / m_nHop;
+}
+
+template <class T>
+size_t CSTFTT<T>::GetSignalSize(size_t nFrames) const
+{
+	if (m_nFrame == 0 || nFrames == 0) return 0;
+	return (nFrames - 1) * m_nHop + m_nFrame;
+}
+
+template <class T>
+void CSTFTT<T>::Frame(const T *pIn, std::complex<T> *pOut)
+{
+	size_t n;
+	const T *w = &m_arWindow[0];
+	T *x = &m_arFrame[0];
+	for (n = 0; n < m_nFrame; n++)
+		x[n] = pIn[n] * w[n];
+	m_Forward.Execute(x, pOut);
+}
+
+template <class T>
+int CSTFTT<T>::Forward(size_t nCnt, const T *pIn, std::complex<T> *pOut)
+{
+	if (m_nFrame == 0) return -1;
+
+	size_t f, nFrames = GetFrameCount(nCnt);
+	size_t nBins = GetBins();
+	for (f = 0; f < nFrames; f++)
+		Frame(pIn + f * m_nHop, pOut + f * nBins);
+	return 0;
+}
+
+// Samples are collected in m_arBuffer. After a frame the last nFrameSize-nHop of them
+// are kept, or nHop-nFrameSize next ones are dropped.
+template <class T>
+int CSTFTT<T>::Push(size_t nCnt, const T *pIn, std::complex<T> *pOut, size_t &nFrames)
+{
+	nFrames = 0;
+	if (m_nFrame == 0) return -1;
+
+	const size_t N = m_nFrame;
+	size_t nBins = GetBins();
+	size_t n;
+	T *pBuffer = &m_arBuffer[0];
+	while (nCnt > 0)
+	{
+		if (m_nSkip > 0)
+		{
+			n = (m_nSkip < nCnt) ? m_nSkip : nCnt;
+			m_nSkip -= n;
+		}
+		else
+		{
+			n = (N - m_nFill < nCnt) ? N - m_nFill : nCnt;
+			memcpy(pBuffer + m_nFill, pIn, n * sizeof(T));
+			m_nFill += n;
+			if (m_nFill == N)
+			{
+				Frame(pBuffer, pOut + nFrames * nBins);
+				nFrames++;
+				if (m_nHop < N)
+				{
+					memmove(pBuffer, pBuffer + m_nHop, (N - m_nHop) * sizeof(T));
+					m_nFill = N - m_nHop;
+				}
+				else
+				{
+					m_nFill = 0;
+					m_nSkip = m_nHop - N;
+				}
+			}
+		}
+		pIn += n;
+		nCnt -= n;
+	}
+	return 0;
+}
+
+// Weighted overlap-add: y[n] = sum w[n - f*nHop] * x_f[n - f*nHop] / sum w[n - f*nHop]^2
+// over frames f covering n, which restores the signal for any window and hop
+// (where the sum of squares is not zero).
+template <class T>
+int CSTFTT<T>::Inverse(size_t nFrames, const std::complex<T> *pIn, T *pOut)
+{
+	if (m_nFrame == 0) return -1;
+
+	const size_t N = m_nFrame;
+	size_t nBins = GetBins();
+	size_t nLen = GetSignalSize(nFrames);
+	size_t f, n;
+	const T *w = &m_arWindow[0];
+	T *x = &m_arFrame[0];
+
+	for (n = 0; n < nLen; n++)
+		pOut[n] = 0.;
+	for (f = 0; f < nFrames; f++)
+	{
+		m_Inverse.Execute(pIn + f * nBins, x);
+		T *y = pOut + f * m_nHop;
+		for (n = 0; n < N; n++)
+			y[n] += x[n] * w[n];
+	}
+
+	for (n = 0; n < nLen; n++)
+	{
+		// Frames f0..f1 cover sample n
+		size_t f0 = (n + 1 > N) ? (n + 1 - N + m_nHop - 1) / m_nHop : 0;
+		size_t f1 = n / m_nHop;
+		if (f1 >= nFrames)
+			f1 = nFrames - 1;
+		T fSum = 0.;
+		for (f = f0; f <= f1; f++)
+			fSum += w[n - f * m_nHop] * w[n - f * m_nHop];
+		pOut[n] = (fSum > T(1e-6)) ? pOut[n] / fSum : T(0.);
+	}
+	return 0;
+}
+
+template class CSTFTT<double>;
+template class CSTFTT<float>;
+
+// Fixed-point FFT (CFFTFixedT)
+
+// Wide type of fixed-point products and the number of fraction bits
+template <class T> struct CFixedTraits;
+template <> struct CFixedTraits<short> { typedef int TWide; typedef unsigned int TPair; enum { nBits = 15 }; };
+template <> struct CFixedTraits<int> { typedef long long TWide; typedef unsigned long long TPair; enum { nBits = 31 }; };
+
+// Fixed-point product rounded to nearest, (x*y + 2^(B-1)) >> B (pmulhrsw for Q15)
+template <class W>
+static inline W do_fixed_mul(W x, W y, int nBits)
+{
+	return (x * y + (W(1) << (nBits - 1))) >> nBits;
+}
+
+// Rounding shift right of the block exponent, (x + 2^(s-1)) >> s
+template <class W>
+static inline W do_fixed_shift(W x, int nShift)
+{
+	return (nShift > 0) ? (x + (W(1) << (nShift - 1))) >> nShift : x;
+}
+
+// Radix-2 decimation in time stage: transforms of L points -> 2L points, n points in all.
+// Inputs are shifted right by nShift first. w[k] = W_2L^k, k < L (interleaved).
+// Returns the largest |value| of the output.
+template <class T>
+static long long do_fixed_stage(size_t n, size_t L, const T *w, T *a, int nShift)
+{
+	typedef typename CFixedTraits<T>::TWide W;
+	const int B = CFixedTraits<T>::nBits;
+	size_t j, k;
+	W nMax = 0;
+
+	for (j = 0; j < 2 * n; j += 4 * L)
+	{
+		T *p0 = a + j;
+		T *p1 = p0 + 2 * L;
+		for (k = 0; k < 2 * L; k += 2)
+		{
+			W ar = do_fixed_shift(W(p0[k]), nShift);
+			W ai = do_fixed_shift(W(p0[k + 1]), nShift);
+			W br = do_fixed_shift(W(p1[k]), nShift);
+			W bi = do_fixed_shift(W(p1[k + 1]), nShift);
+			W wr = w[k], wi = w[k + 1];
+			W tr = do_fixed_mul(br, wr, B) + do_fixed_mul(bi, -wi, B);
+			W ti = do_fixed_mul(br, wi, B) + do_fixed_mul(bi, wr, B);
+			W v[4] = {ar + tr, ai + ti, ar - tr, ai - ti};
+			p0[k] = T(v[0]);
+			p0[k + 1] = T(v[1]);
+			p1[k] = T(v[2]);
+			p1[k + 1] = T(v[3]);
+			for (int i = 0; i < 4; i++)
+				nMax = std::max(nMax, (v[i] < 0) ? -v[i] : v[i]);
+		}
+	}
+	return nMax;
+}
+
+// The first two stages at once (L = 1, 2). Twiddles are 1 and -+i, so there are no
+// products and no rounding, |values| grow 4 times at most.
+template <class T>
+static long long do_fixed_first_stages(size_t n, T *a, int nShift, bool bInverse)
+{
+	typedef typename CFixedTraits<T>::TWide W;
+	size_t j;
+	W nMax = 0;
+
+	for (j = 0; j < 2 * n; j += 8)
+	{
+		T *p = a + j;
+		W x0r = do_fixed_shift(W(p[0]), nShift), x0i = do_fixed_shift(W(p[1]), nShift);
+		W x1r = do_fixed_shift(W(p[2]), nShift), x1i = do_fixed_shift(W(p[3]), nShift);
+		W x2r = do_fixed_shift(W(p[4]), nShift), x2i = do_fixed_shift(W(p[5]), nShift);
+		W x3r = do_fixed_shift(W(p[6]), nShift), x3i = do_fixed_shift(W(p[7]), nShift);
+		W sr = x0r + x1r, si = x0i + x1i, dr = x0r - x1r, di = x0i - x1i;
+		W tr = x2r + x3r, ti = x2i + x3i;
+		// -+i * (x2 - x3)
+		W ur = bInverse ? x3i - x2i : x2i - x3i;
+		W ui = bInverse ? x2r - x3r : x3r - x2r;
+		W v[8] = {sr + tr, si + ti, dr + ur, di + ui, sr - tr, si - ti, dr - ur, di - ui};
+		for (int i = 0; i < 8; i++)
+		{
+			p[i] = T(v[i]);
+			nMax = std::max(nMax, (v[i] < 0) ? -v[i] : v[i]);
+		}
+	}
+	return nMax;
+}
+
+// Largest |a[i]| of n values
+template <class T>
+static long long do_fixed_max_abs(size_t n, const T *a)
+{
+	size_t i;
+	long long nMax = 0;
+	for (i = 0; i < n; i++)
+		nMax = std::max(nMax, std::abs((long long) a[i]));
+	return nMax;
+}
+
+// In place bit reversal permutation of n complex values, a value (re, im) is moved as one word
+template <class T>
+static void do_fixed_bit_reverse(size_t n, const unsigned int *rev, size_t nRevStep, T *a)
+{
+	typedef typename CFixedTraits<T>::TPair P;
+	size_t i, j;
+	for (i = 0; i < n; i++)
+	{
+		j = rev[nRevStep * i];
+		if (i < j)
+		{
+			P x, y;
+			memcpy(&x, a + 2 * i, sizeof(P));
+			memcpy(&y, a + 2 * j, sizeof(P));
+			memcpy(a + 2 * i, &y, sizeof(P));
+			memcpy(a + 2 * j, &x, sizeof(P));
+		}
+	}
+}
+
+#ifdef FFT_X86
+
+// Same as do_fixed_max_abs() for Q15, 16 values per AVX2 register
+FFT_TARGET("avx2") static long long do_fixed_max_abs_avx2(size_t n, const short *a)
+{
+	size_t i;
+	__m256i vmax = _mm256_setzero_si256();
+	for (i = 0; i + 16 <= n; i += 16)
+		vmax = _mm256_max_epu16(vmax, _mm256_abs_epi16(_mm256_loadu_si256((const __m256i *) (a + i))));
+
+	unsigned short arMax[16];
+	_mm256_storeu_si256((__m256i *) arMax, vmax);
+	long long nMax = do_fixed_max_abs(n - i, a + i);
+	for (i = 0; i < 16; i++)
+		nMax = std::max(nMax, (long long) arMax[i]);
+	return nMax;
+}
+
+// Same as do_fixed_first_stages() for Q15, two 4-point transforms per AVX2 register. Complex
+// values are 32-bit lanes: x0 x1 x2 x3 -> x0+x1, x0-x1, x2+x3, x2-x3 -> the last one times -+i
+// -> (s+t, d+u, s-t, d-u). Sums don't overflow, so the results are the same bit for bit.
+FFT_TARGET("avx2") static long long do_fixed_first_stages_avx2(size_t n, short *a, int nShift, bool bInverse)
+{
+	size_t j;
+	const __m256i sgn1 = _mm256_setr_epi16(1, 1, -1, -1, 1, 1, -1, -1, 1, 1, -1, -1, 1, 1, -1, -1);
+	const __m256i sgn2 = _mm256_setr_epi16(1, 1, 1, 1, -1, -1, -1, -1, 1, 1, 1, 1, -1, -1, -1, -1);
+	// Swap re, im of x3 and negate: -i * (re, im) = (im, -re), i * (re, im) = (-im, re)
+	const __m256i swap3 = _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 14, 15, 12, 13,
+		0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 14, 15, 12, 13);
+	const short r = bInverse ? -1 : 1;
+	const __m256i sgn3 = _mm256_setr_epi16(1, 1, 1, 1, 1, 1, r, short(-r), 1, 1, 1, 1, 1, 1, r, short(-r));
+	const __m256i scale = _mm256_set1_epi16(short(nShift > 0 ? 1 << (15 - nShift) : 0));
+	__m256i vmax = _mm256_setzero_si256();
+
+	for (j = 0; j < 2 * n; j += 16)
+	{
+		__m256i x = _mm256_loadu_si256((const __m256i *) (a + j));
+		if (nShift > 0)
+			x = _mm256_mulhrs_epi16(x, scale);
+		// x0 x0 x2 x2 +- x1 x1 x3 x3
+		__m256i y = _mm256_add_epi16(_mm256_shuffle_epi32(x, 0xA0), _mm256_sign_epi16(_mm256_shuffle_epi32(x, 0xF5), sgn1));
+		y = _mm256_sign_epi16(_mm256_shuffle_epi8(y, swap3), sgn3);
+		// s d s d +- t u t u
+		y = _mm256_add_epi16(_mm256_shuffle_epi32(y, 0x44), _mm256_sign_epi16(_mm256_shuffle_epi32(y, 0xEE), sgn2));
+		_mm256_storeu_si256((__m256i *) (a + j), y);
+		vmax = _mm256_max_epu16(vmax, _mm256_abs_epi16(y));
+	}
+
+	unsigned short arMax[16];
+	_mm256_storeu_si256((__m256i *) arMax, vmax);
+	long long nMax = 0;
+	for (j = 0; j < 16; j++)
+		nMax = std::max(nMax, (long long) arMax[j]);
+	return nMax;
+}
+
+// Same as do_fixed_stage() for Q15, 4 complex numbers per register, L = 4
+FFT_TARGET("avx2") static long long do_fixed_stage4_avx2(size_t n, const short *w, short *a, int nShift)
+{
+	size_t j;
+	const __m128i swap = _mm_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+	const __m128i dupr = _mm_setr_epi8(0, 1, 0, 1, 4, 5, 4, 5, 8, 9, 8, 9, 12, 13, 12, 13);
+	const __m128i dupi = _mm_setr_epi8(2, 3, 2, 3, 6, 7, 6, 7, 10, 11, 10, 11, 14, 15, 14, 15);
+	const __m128i sgn = _mm_setr_epi16(-1, 1, -1, 1, -1, 1, -1, 1);
+	const __m128i scale = _mm_set1_epi16(short(nShift > 0 ? 1 << (15 - nShift) : 0));
+	__m128i vw = _mm_loadu_si128((const __m128i *) w);
+	__m128i wr = _mm_shuffle_epi8(vw, dupr);
+	__m128i wi = _mm_sign_epi16(_mm_shuffle_epi8(vw, dupi), sgn);
+	__m128i vmax = _mm_setzero_si128();
+
+	for (j = 0; j < 2 * n; j += 16)
+	{
+		__m128i x0 = _mm_loadu_si128((const __m128i *) (a + j));
+		__m128i x1 = _mm_loadu_si128((const __m128i *) (a + j + 8));
+		if (nShift > 0)
+		{
+			x0 = _mm_mulhrs_epi16(x0, scale);
+			x1 = _mm_mulhrs_epi16(x1, scale);
+		}
+		__m128i t = _mm_add_epi16(_mm_mulhrs_epi16(x1, wr), _mm_mulhrs_epi16(_mm_shuffle_epi8(x1, swap), wi));
+		__m128i y0 = _mm_add_epi16(x0, t);
+		__m128i y1 = _mm_sub_epi16(x0, t);
+		_mm_storeu_si128((__m128i *) (a + j), y0);
+		_mm_storeu_si128((__m128i *) (a + j + 8), y1);
+		vmax = _mm_max_epu16(vmax, _mm_abs_epi16(y0));
+		vmax = _mm_max_epu16(vmax, _mm_abs_epi16(y1));
+	}
+
+	unsigned short arMax[8];
+	_mm_storeu_si128((__m128i *) arMax, vmax);
+	long long nMax = 0;
+	for (j = 0; j < 8; j++)
+		nMax = std::max(nMax, (long long) arMax[j]);
+	return nMax;
+}
+
+// Same as do_fixed_stage() for Q15, 8 complex numbers per AVX2 register, L >= 8.
+// pmulhrsw rounds as do_fixed_mul(), so the results are the same bit for bit.
+FFT_TARGET("avx2") static long long do_fixed_stage_avx2(size_t n, size_t L, const short *w, short *a, int nShift)
+{
+	size_t j, k;
+	const __m256i swap = _mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+		2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+	const __m256i dupr = _mm256_setr_epi8(0, 1, 0, 1, 4, 5, 4, 5, 8, 9, 8, 9, 12, 13, 12, 13,
+		0, 1, 0, 1, 4, 5, 4, 5, 8, 9, 8, 9, 12, 13, 12, 13);
+	const __m256i dupi = _mm256_setr_epi8(2, 3, 2, 3, 6, 7, 6, 7, 10, 11, 10, 11, 14, 15, 14, 15,
+		2, 3, 2, 3, 6, 7, 6, 7, 10, 11, 10, 11, 14, 15, 14, 15);
+	const __m256i sgn = _mm256_setr_epi16(-1, 1, -1, 1, -1, 1, -1, 1, -1, 1, -1, 1, -1, 1, -1, 1);
+	// x * 2^(15-s) rounded is the rounding shift of x by s
+	const __m256i scale = _mm256_set1_epi16(short(nShift > 0 ? 1 << (15 - nShift) : 0));
+	__m256i vmax = _mm256_setzero_si256();
+
+	for (j = 0; j < 2 * n; j += 4 * L)
+	{
+		short *p0 = a + j;
+		short *p1 = p0 + 2 * L;
+		for (k = 0; k < 2 * L; k += 16)
+		{
+			__m256i x0 = _mm256_loadu_si256((const __m256i *) (p0 + k));
+			__m256i x1 = _mm256_loadu_si256((const __m256i *) (p1 + k));
+			if (nShift > 0)
+			{
+				x0 = _mm256_mulhrs_epi16(x0, scale);
+				x1 = _mm256_mulhrs_epi16(x1, scale);
+			}
+			__m256i vw = _mm256_loadu_si256((const __m256i *) (w + k));
+			__m256i wr = _mm256_shuffle_epi8(vw, dupr);
+			__m256i wi = _mm256_sign_epi16(_mm256_shuffle_epi8(vw, dupi), sgn);
+			__m256i t = _mm256_add_epi16(_mm256_mulhrs_epi16(x1, wr),
+				_mm256_mulhrs_epi16(_mm256_shuffle_epi8(x1, swap), wi));
+			__m256i y0 = _mm256_add_epi16(x0, t);
+			__m256i y1 = _mm256_sub_epi16(x0, t);
+			_mm256_storeu_si256((__m256i *) (p0 + k), y0);
+			_mm256_storeu_si256((__m256i *) (p1 + k), y1);
+			vmax = _mm256_max_epu16(vmax, _mm256_abs_epi16(y0));
+			vmax = _mm256_max_epu16(vmax, _mm256_abs_epi16(y1));
+		}
+	}
+
+	unsigned short arMax[16];
+	_mm256_storeu_si256((__m256i *) arMax, vmax);
+	long long nMax = 0;
+	for (k = 0; k < 16; k++)
+		nMax = std::max(nMax, (long long) arMax[k]);
+	return nMax;
+}
+
+#endif // FFT_X86
+
+// Dispatch to the instruction set nSimd. Q31 and non-x86 builds run the scalar code.
+template <class T>
+static long long do_fixed_stage(size_t n, size_t L, const T *w, T *a, int nShift, int /*nSimd*/)
+{
+	return do_fixed_stage(n, L, w, a, nShift);
+}
+
+template <class T>
+static long long do_fixed_first_stages(size_t n, T *a, int nShift, bool bInverse, int /*nSimd*/)
+{
+	return do_fixed_first_stages(n, a, nShift, bInverse);
+}
+
+template <class T>
+static long long do_fixed_max_abs(size_t n, const T *a, int /*nSimd*/)
+{
+	return do_fixed_max_abs(n, a);
+}
+
+#ifdef FFT_X86
+static long long do_fixed_stage(size_t n, size_t L, const short *w, short *a, int nShift, int nSimd)
+{
+	if (nSimd >= CFFTPlanBase::SIMD_AVX2 && L >= 8)
+		return do_fixed_stage_avx2(n, L, w, a, nShift);
+	if (nSimd >= CFFTPlanBase::SIMD_AVX2 && L == 4)
+		return do_fixed_stage4_avx2(n, w, a, nShift);
+	return do_fixed_stage(n, L, w, a, nShift);
+}
+
+static long long do_fixed_first_stages(size_t n, short *a, int nShift, bool bInverse, int nSimd)
+{
+	if (nSimd >= CFFTPlanBase::SIMD_AVX2 && n >= 8)
+		return do_fixed_first_stages_avx2(n, a, nShift, bInverse);
+	return do_fixed_first_stages(n, a, nShift, bInverse);
+}
+
+static long long do_fixed_max_abs(size_t n, const short *a, int nSimd)
+{
+	if (nSimd >= CFFTPlanBase::SIMD_AVX2)
+		return do_fixed_max_abs_avx2(n, a);
+	return do_fixed_max_abs(n, a);
+}
+#endif
+
+template <class T>
+CFFTFixedT<T>::CFFTFixedT()
+	: m_nSize(0)
+	, m_bInverse(false)
+	, m_eSimd(GetSupportedSimd())
+	, m_nMax(0)
+	, m_nGuard(0)
+{
+}
+
+template <class T>
+void CFFTFixedT<T>::Reset()
+{
+	m_nSize = 0;
+	m_bInverse = false;
+	m_nMax = 0;
+	m_nGuard = 0;
+	m_arTwiddle.clear();
+	m_arBitRev.clear();
+}
+
+template <class T>
+int CFFTFixedT<T>::Create(size_t nSize, bool bInverse)
+{
+	Reset();
+	if (nSize < 2 || (nSize & (nSize - 1)) != 0) return -1;
+	if (nSize > (size_t(1) << 24)) return -2;
+
+	const size_t N = nSize;
+	const double fOne = double((1ULL << CFixedTraits<T>::nBits) - 1);
+	double sgn = bInverse ? 1. : -1.;
+	size_t i, j, k, L;
+
+	m_nSize = N;
+	m_bInverse = bInverse;
+	// |a + w*b| <= (1 + sqrt(2)) * max(|a|, |b|) plus 1 of the rounding
+	m_nMax = T(fOne);
+	m_nGuard = T((fOne - 1.) / (1. + ::sqrt(2.)));
+
+	m_arTwiddle.resize(2 * (N - 1));
+	for (L = 1; L < N; L *= 2)
+	{
+		T *w = &m_arTwiddle[2 * (L - 1)];
+		for (k = 0; k < L; k++)
+		{
+			double c, s;
+			do_twiddle(k, 2 * L, c, s);
+			w[2 * k] = T(floor(c * fOne + 0.5));
+			w[2 * k + 1] = T(floor(sgn * s * fOne + 0.5));
+		}
+	}
+
+	m_arBitRev.resize(N);
+	for (i = 0, j = 0; i < N; i++)
+	{
+		m_arBitRev[i] = (unsigned int) j;
+		k = N >> 1;
+		while (k >= 1 && (j & k) != 0)
+		{
+			j ^= k;
+			k >>= 1;
+		}
+		j |= k;
+	}
+	return 0;
+}
+
+template <class T>
+int CFFTFixedT<T>::SetSimd(TSimd eSimd)
+{
+	if (eSimd > GetSupportedSimd()) return -1;
+	m_eSimd = eSimd;
+	return 0;
+}
+
+// Stages of an N-point transform of bit reversed a[], nMax is the largest |a[i]| on entry
+// and on exit. Returns the block exponent. The first two stages have no products, their
+// growth of 4 needs less headroom than two stages of 1 + sqrt(2).
+template <class T>
+int CFFTFixedT<T>::Transform(size_t N, T *a, long long &nMax)
+{
+	int nExponent = 0;
+	size_t L = 1;
+	if (N >= 4)
+	{
+		int nShift = 0;
+		while (4 * do_fixed_shift(nMax, nShift) > (long long) m_nMax)
+			nShift++;
+		nExponent += nShift;
+		nMax = do_fixed_first_stages(N, a, nShift, m_bInverse, m_eSimd);
+		L = 4;
+	}
+	for (; L < N; L *= 2)
+	{
+		int nShift = 0;
+		while (do_fixed_shift(nMax, nShift) > m_nGuard)
+			nShift++;
+		nExponent += nShift;
+		nMax = do_fixed_stage(N, L, &m_arTwiddle[2 * (L - 1)], a, nShift, m_eSimd);
+	}
+	return nExponent;
+}
+
+template <class T>
+int CFFTFixedT<T>::Execute(T *pData, int &nExponent)
+{
+	if (m_nSize == 0) return -1;
+
+	const size_t N = m_nSize;
+	long long nMax = do_fixed_max_abs(2 * N, pData, m_eSimd);
+	do_fixed_bit_reverse(N, &m_arBitRev[0], 1, pData);
+	nExponent = Transform(N, pData, nMax);
+	return 0;
+}
+
+// Split of the packed spectrum as CFFTPlanT::PackedSpectrum(), without the halving:
+// 2X[k] = Z[k] + conj(Z[H-k]) - i * w[k] * (Z[k] - conj(Z[H-k])), which grows by at most
+// 2 * (1 + sqrt(2)), so the block is shifted below (m_nGuard - 1) / 2 first.
+template <class T>
+int CFFTFixedT<T>::ExecuteReal(const T *pIn, T *pOut, int &nExponent)
+{
+	typedef typename CFixedTraits<T>::TWide W;
+	typedef typename CFixedTraits<T>::TPair P;
+	const int B = CFixedTraits<T>::nBits;
+	if (m_nSize == 0) return -1;
+	if (m_nSize < 4) return -2;
+	if (m_bInverse) return InverseReal(pIn, pOut, nExponent);
+
+	const size_t H = m_nSize / 2;
+	const unsigned int *rev = &m_arBitRev[0];
+	size_t k, j;
+	long long nMax = do_fixed_max_abs(m_nSize, pIn, m_eSimd);
+
+	for (k = 0; k < H; k++)
+		memcpy(pOut + 2 * rev[2 * k], pIn + 2 * k, sizeof(P));
+	nExponent = Transform(H, pOut, nMax);
+
+	int nShift = 0;
+	while (do_fixed_shift(nMax, nShift) > (m_nGuard - 1) / 2)
+		nShift++;
+	nExponent += nShift - 1;
+
+	// W_N^k, k < H, are the twiddles of the last stage of an N-point transform
+	const T *w = &m_arTwiddle[2 * (H - 1)];
+	T *z = pOut;
+	W zr = do_fixed_shift(W(z[0]), nShift);
+	W zi = do_fixed_shift(W(z[1]), nShift);
+	z[0] = T(2 * (zr + zi));
+	z[1] = 0;
+	z[2 * H] = T(2 * (zr - zi));
+	z[2 * H + 1] = 0;
+
+	for (k = 1; 2 * k <= H; k++)
+	{
+		j = H - k;
+		W kr = do_fixed_shift(W(z[2 * k]), nShift), ki = do_fixed_shift(W(z[2 * k + 1]), nShift);
+		W jr = do_fixed_shift(W(z[2 * j]), nShift), ji = do_fixed_shift(W(z[2 * j + 1]), nShift);
+		W er = kr + jr, ei = ki - ji, dr = kr - jr, di = ki + ji;
+		W tr = do_fixed_mul(W(w[2 * k]), di, B) + do_fixed_mul(W(w[2 * k + 1]), dr, B);
+		W ti = do_fixed_mul(W(w[2 * k + 1]), di, B) - do_fixed_mul(W(w[2 * k]), dr, B);
+		z[2 * k] = T(er + tr);
+		z[2 * k + 1] = T(ei + ti);
+		z[2 * j] = T(er - tr);
+		z[2 * j + 1] = T(ti - ei);
+	}
+	return 0;
+}
+
+// Inverse of ExecuteReal() as CFFTPlanT::PackedInverse(): Z[k] = E + i * w[k] * D,
+// E = X[k] + conj(X[H-k]), D = X[k] - conj(X[H-k]), |Z| <= |E| + |D| <= 2 * sqrt(2) * max|X|,
+// then the H-point inverse transform of Z holds even samples in real parts and odd samples
+// in imaginary parts. In place when pIn == pOut.
+template <class T>
+int CFFTFixedT<T>::InverseReal(const T *pIn, T *pOut, int &nExponent)
+{
+	typedef typename CFixedTraits<T>::TWide W;
+	const int B = CFixedTraits<T>::nBits;
+	const size_t H = m_nSize / 2;
+	size_t k, j;
+	long long nMax = do_fixed_max_abs(m_nSize + 2, pIn, m_eSimd);
+
+	int nShift = 0;
+	while (do_fixed_shift(nMax, nShift) > (m_nGuard - 1) / 2)
+		nShift++;
+
+	const T *w = &m_arTwiddle[2 * (H - 1)];
+	T *z = pOut;
+	W x0 = do_fixed_shift(W(pIn[0]), nShift);
+	W xH = do_fixed_shift(W(pIn[2 * H]), nShift);
+	W v[4] = {x0 + xH, x0 - xH, 0, 0};
+	z[0] = T(v[0]);
+	z[1] = T(v[1]);
+	nMax = std::max((v[0] < 0) ? -v[0] : v[0], (v[1] < 0) ? -v[1] : v[1]);
+
+	for (k = 1; 2 * k <= H; k++)
+	{
+		j = H - k;
+		W kr = do_fixed_shift(W(pIn[2 * k]), nShift), ki = do_fixed_shift(W(pIn[2 * k + 1]), nShift);
+		W jr = do_fixed_shift(W(pIn[2 * j]), nShift), ji = do_fixed_shift(W(pIn[2 * j + 1]), nShift);
+		W er = kr + jr, ei = ki - ji, dr = kr - jr, di = ki + ji;
+		W tr = -(do_fixed_mul(W(w[2 * k]), di, B) + do_fixed_mul(W(w[2 * k + 1]), dr, B));
+		W ti = do_fixed_mul(W(w[2 * k]), dr, B) - do_fixed_mul(W(w[2 * k + 1]), di, B);
+		v[0] = er + tr;
+		v[1] = ei + ti;
+		v[2] = er - tr;
+		v[3] = ti - ei;
+		z[2 * k] = T(v[0]);
+		z[2 * k + 1] = T(v[1]);
+		z[2 * j] = T(v[2]);
+		z[2 * j + 1] = T(v[3]);
+		for (int i = 0; i < 4; i++)
+			nMax = std::max(nMax, (long long) ((v[i] < 0) ? -v[i] : v[i]));
+	}
+
+	do_fixed_bit_reverse(H, &m_arBitRev[0], 2, z);
+	nExponent = nShift + Transform(H, z, nMax);
+	return 0;
+}
+
+template class CFFTFixedT<short>;
+template class CFFTFixedT<int>;
+
+// Convolutions of limbs of 16 bits are at most min(nLen1, nLen2) * 2^32. Up to 2^13 values
+// the distance of the inverse transforms from integers stays below 0.06 (0.2 at 2^15).
+static const size_t const_MultiplierMax16 = 1 << 13;
+
+CFFTMultiplier::CFFTMultiplier()
+	: m_nLen1(0)
+	, m_nLen2(0)
+	, m_nFFT(0)
+	, m_nBits(0)
+{
+}
+
+void CFFTMultiplier::Reset()
+{
+	m_nLen1 = 0;
+	m_nLen2 = 0;
+	m_nFFT = 0;
+	m_nBits = 0;
+	m_Forward.Reset();
+	m_Inverse.Reset();
+	m_arLimbs.clear();
+	m_arSpectra.clear();
+	m_arSum.clear();
+	m_arProducts.clear();
+}
+
+int CFFTMultiplier::Create(size_t nLen1, size_t nLen2/* = 0*/)
+{
+	Reset();
+
+	if (nLen1 < 1) return -1;
+	if (nLen2 == 0)
+		nLen2 = nLen1;
+
+	size_t L = do_fast_size(nLen1 + nLen2 - 1);
+	int nRes = m_Forward.Create(CFFTPlanBase::REAL, L, false, false);
+	if (nRes == 0)
+		nRes = m_Inverse.Create(CFFTPlanBase::REAL, L, true, false);
+	if (nRes != 0)
+	{
+		Reset();
+		return nRes;
+	}
+
+	m_nLen1 = nLen1;
+	m_nLen2 = nLen2;
+	m_nFFT = L;
+	m_arLimbs.resize(L);
+	m_arSum.resize(L / 2 + 1);
+	SetBits((std::min(nLen1, nLen2) <= const_MultiplierMax16) ? 16 : 8);
+	return 0;
+}
+
+// Buffers for limbs of nBits: up to 64/nBits limbs of each factor, 64/nBits limb sums
+void CFFTMultiplier::SetBits(int nBits)
+{
+	m_nBits = nBits;
+	m_arSpectra.resize(2 * (64 / nBits) * (m_nFFT / 2 + 1));
+	m_arProducts.resize((64 / nBits) * m_nFFT);
+}
+
+// Spectra of nLimbs limb sequences of p[0..nCnt-1] (reduced modulo nMod, 0 - none)
+template <class E>
+void CFFTMultiplier::Spectra(const E *p, size_t nCnt, int nLimbs, unsigned int nMod, std::complex<double> *pSpectra)
+{
+	const size_t L = m_nFFT;
+	const unsigned long long nMask = (1ULL << m_nBits) - 1;
+	size_t k;
+	for (int i = 0; i < nLimbs; i++)
+	{
+		const int nShift = i * m_nBits;
+		for (k = 0; k < nCnt; k++)
+		{
+			unsigned long long x = (unsigned long long) p[k];
+			if (nMod != 0)
+				x %= nMod;
+			m_arLimbs[k] = double((x >> nShift) & nMask);
+		}
+		std::fill(m_arLimbs.begin() + nCnt, m_arLimbs.end(), 0.);
+		m_Forward.Execute(&m_arLimbs[0], pSpectra + i * (L / 2 + 1));
+	}
+}
+
+// Convolutions of the limb sums s = i + j < nSums to m_arProducts. Spectra of the first
+// factor are in front of m_arSpectra. Returns the largest distance from an integer.
+double CFFTMultiplier::Products(int nLimbs, int nSums, const std::complex<double> *pSpectraB)
+{
+	const size_t L = m_nFFT, B = L / 2 + 1, nOut = m_nLen1 + m_nLen2 - 1;
+	const std::complex<double> *pSpectraA = &m_arSpectra[0];
+	// Both spectra are divided by L, the inverse transform is not normalized
+	const double fScale = double(L);
+	double fErr = 0.;
+	size_t k;
+
+	for (int s = 0; s < nSums; s++)
+	{
+		std::fill(m_arSum.begin(), m_arSum.end(), std::complex<double>(0., 0.));
+		for (int i = std::max(0, s - nLimbs + 1); i < nLimbs && i <= s; i++)
+		{
+			const std::complex<double> *a = pSpectraA + i * B, *b = pSpectraB + (s - i) * B;
+			for (k = 0; k < B; k++)
+				m_arSum[k] += a[k] * b[k];
+		}
+		for (k = 0; k < B; k++)
+			m_arSum[k] *= fScale;
+
+		double *pOut = &m_arProducts[s * L];
+		m_Inverse.Execute(&m_arSum[0], pOut);
+		for (k = 0; k < nOut; k++)
+			fErr = std::max(fErr, ::fabs(pOut[k] - ::floor(pOut[k] + 0.5)));
+	}
+	return fErr;
+}
+
+// Limb sums of pA * pB (nWidth bits per value) to m_arProducts, halves the limb size
+// while the result isn't exact. All 2*nLimbs-1 sums or (bAllSums = false) the sums
+// below 64 bits. Returns the number of limbs.
+template <class E>
+int CFFTMultiplier::Convolve(const E *pA, const E *pB, int nWidth, unsigned int nMod, bool bAllSums)
+{
+	for (;;)
+	{
+		const int nLimbs = (nWidth + m_nBits - 1) / m_nBits;
+		const int nSums = bAllSums ? 2 * nLimbs - 1 : std::min(2 * nLimbs - 1, 64 / m_nBits);
+		std::complex<double> *pSpectraB = &m_arSpectra[0];
+		Spectra(pA, m_nLen1, nLimbs, nMod, pSpectraB);
+		if ((const void *) pB != (const void *) pA || m_nLen2 != m_nLen1)
+		{
+			pSpectraB += nLimbs * (m_nFFT / 2 + 1);
+			Spectra(pB, m_nLen2, nLimbs, nMod, pSpectraB);
+		}
+		if (Products(nLimbs, nSums, pSpectraB) <= 0.25 || m_nBits == 1)
+			return nLimbs;
+		SetBits(m_nBits / 2);
+	}
+}
+
+int CFFTMultiplier::MultiplyPoly(const long long *pA, const long long *pB, long long *pOut)
+{
+	if (m_nFFT == 0) return -1;
+
+	// Two's complement: the product modulo 2^64 of the unsigned values is the same
+	const int nLimbs = Convolve(pA, pB, 64, 0, false);
+	const size_t L = m_nFFT, nOut = m_nLen1 + m_nLen2 - 1;
+	size_t k;
+	for (k = 0; k < nOut; k++)
+	{
+		unsigned long long x = 0;
+		for (int s = 0; s < nLimbs; s++)
+			x += (unsigned long long) (m_arProducts[s * L + k] + 0.5) << (s * m_nBits);
+		pOut[k] = (long long) x;
+	}
+	return 0;
+}
+
+int CFFTMultiplier::MultiplyMod(const unsigned int *pA, const unsigned int *pB, unsigned int nMod, unsigned int *pOut)
+{
+	if (m_nFFT == 0) return -1;
+	if (nMod == 0) return -2;
+
+	int nWidth = 1;
+	while (nWidth < 32 && ((nMod - 1) >> nWidth) != 0)
+		nWidth++;
+	const int nLimbs = Convolve(pA, pB, nWidth, nMod, true);
+	const size_t L = m_nFFT, nOut = m_nLen1 + m_nLen2 - 1;
+	size_t k;
+	unsigned long long arScale[64];             // 2^(s*bits) modulo nMod
+	arScale[0] = 1 % nMod;
+	for (int s = 1; s < 2 * nLimbs - 1; s++)
+		arScale[s] = (arScale[s - 1] << m_nBits) % nMod;
+	for (k = 0; k < nOut; k++)
+	{
+		unsigned long long x = 0;
+		for (int s = 0; s < 2 * nLimbs - 1; s++)
+			x = (x + (unsigned long long) (m_arProducts[s * L + k] + 0.5) % nMod * arScale[s]) % nMod;
+		pOut[k] = (unsigned int) x;
+	}
+	return 0;
+}
+
+int CFFTMultiplier::MultiplyBig(const unsigned int *pA, const unsigned int *pB, unsigned int *pOut)
+{
+	if (m_nFFT == 0) return -1;
+
+	// Digit p of base 2^bits collects the sums s of limb position k with p = k*nLimbs + s
+	const int nLimbs = Convolve(pA, pB, 32, 0, true);
+	const size_t L = m_nFFT, nOut = m_nLen1 + m_nLen2 - 1;
+	const unsigned long long nMask = (1ULL << m_nBits) - 1;
+	unsigned long long nCarry = 0;
+	size_t w, p;
+	for (w = 0; w <= nOut; w++)
+	{
+		unsigned int nWord = 0;
+		for (int d = 0; d < nLimbs; d++)
+		{
+			p = w * nLimbs + d;
+			for (int s = d; s < 2 * nLimbs - 1; s += nLimbs)
+			{
+				size_t k = (p - s) / nLimbs;
+				if (p >= size_t(s) && k < nOut)
+					nCarry += (unsigned long long) (m_arProducts[s * L + k] + 0.5);
+			}
+			nWord |= (unsigned int) (nCarry & nMask) << (d * m_nBits);
+			nCarry >>= m_nBits;
+		}
+		pOut[w] = nWord;
+	}
+	return 0;
+}
+
+template <class T>
+static int do_make_window(CFFTWindow::TWindow eWindow, size_t nSize, T *pOut, bool bPeriodic)
+{
+	if (nSize < 1) return -1;
+
+	// Cosine sums a0 - a1*cos(2*pi*n/M) + a2*cos(4*pi*n/M) - a3*cos(6*pi*n/M)
+	double a[4] = {1., 0., 0., 0.};
+	switch (eWindow)
+	{
+	case CFFTWindow::RECTANGULAR:
+	case CFFTWindow::SINE:
+		break;
+	case CFFTWindow::HANN:
+		a[0] = 0.5; a[1] = 0.5;
+		break;
+	case CFFTWindow::HAMMING:
+		a[0] = 0.54; a[1] = 0.46;
+		break;
+	case CFFTWindow::BLACKMAN:
+		a[0] = 0.42; a[1] = 0.5; a[2] = 0.08;
+		break;
+	case CFFTWindow::BLACKMAN_HARRIS:
+		a[0] = 0.35875; a[1] = 0.48829; a[2] = 0.14128; a[3] = 0.01168;
+		break;
+	default:
+		return -2;
+	}
+
+	const size_t M = bPeriodic ? nSize : nSize - 1;
+	size_t n;
+	for (n = 0; n < nSize; n++)
+	{
+		double v;
+		if (eWindow == CFFTWindow::SINE)
+			v = sin(const_PI * (double(n) + 0.5) / double(M + 1));
+		else if (M == 0)
+			v = 1.;
+		else
+		{
+			double x = 2. * const_PI * double(n) / double(M);
+			v = a[0] - a[1] * cos(x) + a[2] * cos(2. * x) - a[3] * cos(3. * x);
+		}
+		pOut[n] = T(v);
+	}
+	return 0;
+}
+
+int CFFTWindow::Make(TWindow eWindow, size_t nSize, double *pOut, bool bPeriodic/* = true*/)
+{
+	return do_make_window(eWindow, nSize, pOut, bPeriodic);
+}
+
+int CFFTWindow::Make(TWindow eWindow, size_t nSize, float *pOut, bool bPeriodic/* = true*/)
+{
+	return do_make_window(eWindow, nSize, pOut, bPeriodic);
+}
+
+// Frequency scales of CFilterbankT and their inverses
+static double do_hz_to_scale(int eScale, double f)
+{
+	switch (eScale)
+	{
+	case CFilterbankT<double>::MEL:
+		return 2595. * log10(1. + f / 700.);
+	case CFilterbankT<double>::BARK:
+		return 26.81 * f / (1960. + f) - 0.53;
+	}
+	return 21.4 * log10(1. + 0.00437 * f);
+}
+
+static double do_scale_to_hz(int eScale, double z)
+{
+	switch (eScale)
+	{
+	case CFilterbankT<double>::MEL:
+		return 700. * (pow(10., z / 2595.) - 1.);
+	case CFilterbankT<double>::BARK:
+		return 1960. * (z + 0.53) / (26.28 - z);
+	}
+	return (pow(10., z / 21.4) - 1.) / 0.00437;
+}
+
+template <class T>
+CFilterbankT<T>::CFilterbankT()
+	: m_nFFT(0)
+{
+}
+
+template <class T>
+void CFilterbankT<T>::Reset()
+{
+	m_nFFT = 0;
+	m_Forward.Reset();
+	m_arWindow.clear();
+	m_arFrame.clear();
+	m_arSpectrum.clear();
+	m_arRowStart.clear();
+	m_arBin.clear();
+	m_arWeight.clear();
+	m_arCenter.clear();
+}
+
+// Plan, buffers and the Hann window of Process()
+template <class T>
+int CFilterbankT<T>::Prepare(size_t nFFTSize, bool bOrthNorm)
+{
+	Reset();
+
+	int nRes = m_Forward.Create(CFFTPlanBase::REAL, nFFTSize, false, bOrthNorm);
+	if (nRes != 0)
+	{
+		Reset();
+		return nRes;
+	}
+
+	m_nFFT = nFFTSize;
+	m_arFrame.resize(nFFTSize);
+	m_arSpectrum.resize(nFFTSize / 2 + 1);
+	m_arWindow.resize(nFFTSize);
+	CFFTWindow::Make(CFFTWindow::HANN, nFFTSize, &m_arWindow[0]);
+	m_arRowStart.push_back(0);
+	return 0;
+}
+
+template <class T>
+int CFilterbankT<T>::Create(TScale eScale, size_t nFFTSize, double fSampleRate, size_t nBands,
+	double fLowHz/* = 0.*/, double fHighHz/* = 0.*/, bool bOrthNorm/* = true*/)
+{
+	Reset();
+
+	if (nBands < 1 || !(fSampleRate > 0.)) return -1;
+	if (fHighHz == 0.)
+		fHighHz = 0.5 * fSampleRate;
+	if (fLowHz < 0. || fLowHz >= fHighHz || fHighHz > 0.5 * fSampleRate) return -2;
+	if (eScale != MEL && eScale != BARK && eScale != GAMMATONE) return -2;
+
+	int nRes = Prepare(nFFTSize, bOrthNorm);
+	if (nRes != 0) return nRes;
+
+	// Centers: nBands + 2 points of the triangles, nBands points of GAMMATONE
+	const size_t nPoints = (eScale == GAMMATONE) ? nBands : nBands + 2;
+	const double z0 = do_hz_to_scale(eScale, fLowHz), z1 = do_hz_to_scale(eScale, fHighHz);
+	std::vector<double> arPoint(nPoints);
+	size_t b, k;
+	for (b = 0; b < nPoints; b++)
+		arPoint[b] = (nPoints == 1) ? do_scale_to_hz(eScale, 0.5 * (z0 + z1)) :
+			do_scale_to_hz(eScale, z0 + (z1 - z0) * double(b) / double(nPoints - 1));
+
+	const double fBinHz = fSampleRate / double(nFFTSize);
+	for (b = 0; b < nBands; b++)
+	{
+		for (k = 0; k < GetBins(); k++)
+		{
+			const double f = double(k) * fBinHz;
+			double w = 0.;
+			if (eScale == GAMMATONE)
+			{
+				const double fc = arPoint[b];
+				const double fB = 1.019 * 24.7 * (0.00437 * fc + 1.);
+				const double x = (f - fc) / fB;
+				w = 1. / ((1. + x * x) * (1. + x * x) * (1. + x * x) * (1. + x * x));
+				if (w < 1e-4)
+					w = 0.;
+			}
+			else if (f > arPoint[b] && f < arPoint[b + 2])
+			{
+				if (f <= arPoint[b + 1])
+					w = (f - arPoint[b]) / (arPoint[b + 1] - arPoint[b]);
+				else
+					w = (arPoint[b + 2] - f) / (arPoint[b + 2] - arPoint[b + 1]);
+			}
+			if (w > 0.)
+			{
+				m_arBin.push_back((unsigned int) k);
+				m_arWeight.push_back(T(w));
+			}
+		}
+		m_arRowStart.push_back((unsigned int) m_arWeight.size());
+		m_arCenter.push_back(arPoint[(eScale == GAMMATONE) ? b : b + 1]);
+	}
+	return 0;
+}
+
+template <class T>
+int CFilterbankT<T>::Create(size_t nFFTSize, size_t nBands, const size_t *pRowStart, const size_t *pBins,
+	const T *pWeights, bool bOrthNorm/* = true*/)
+{
+	Reset();
+
+	if (nBands < 1) return -1;
+	size_t b, j;
+	if (pRowStart[0] != 0) return -2;
+	for (b = 0; b < nBands; b++)
+	{
+		if (pRowStart[b + 1] < pRowStart[b]) return -2;
+		for (j = pRowStart[b]; j < pRowStart[b + 1]; j++)
+			if (pBins[j] > nFFTSize / 2) return -2;
+	}
+
+	int nRes = Prepare(nFFTSize, bOrthNorm);
+	if (nRes != 0) return nRes;
+
+	for (b = 0; b < nBands; b++)
+		m_arRowStart.push_back((unsigned int) pRowStart[b + 1]);
+	m_arBin.assign(pBins, pBins + pRowStart[nBands]);
+	m_arWeight.assign(pWeights, pWeights + pRowStart[nBands]);
+	return 0;
+}
+
+template <class T>
+int CFilterbankT<T>::SetWindow(const T *pWindow)
+{
+	if (m_nFFT == 0) return -1;
+
+	if (pWindow != NULL)
+		m_arWindow.assign(pWindow, pWindow + m_nFFT);
+	else
+		m_arWindow.clear();
+	return 0;
+}
+
+template <class T>
+double CFilterbankT<T>::GetCenterFrequency(size_t nBand) const
+{
+	return (nBand < m_arCenter.size()) ? m_arCenter[nBand] : 0.;
+}
+
+template <class T>
+size_t CFilterbankT<T>::GetWeights(size_t nBand, const unsigned int *&pBins, const T *&pWeights) const
+{
+	if (nBand >= GetBands())
+	{
+		pBins = NULL;
+		pWeights = NULL;
+		return 0;
+	}
+	const size_t j = m_arRowStart[nBand];
+	pBins = m_arBin.empty() ? NULL : &m_arBin[0] + j;
+	pWeights = m_arWeight.empty() ? NULL : &m_arWeight[0] + j;
+	return m_arRowStart[nBand + 1] - j;
+}
+
+template <class T>
+int CFilterbankT<T>::Apply(const std::complex<T> *pSpectrum, T *pBands) const
+{
+	if (m_nFFT == 0) return -1;
+
+	const T *x = reinterpret_cast<const T *>(pSpectrum);
+	const unsigned int *pBin = m_arBin.empty() ? NULL : &m_arBin[0];
+	const T *pWeight = m_arWeight.empty() ? NULL : &m_arWeight[0];
+	size_t b, j;
+	for (b = 0; b + 1 < m_arRowStart.size(); b++)
+	{
+		T s = 0.;
+		for (j = m_arRowStart[b]; j < m_arRowStart[b + 1]; j++)
+		{
+			const T *v = x + 2 * pBin[j];
+			s += pWeight[j] * (v[0] * v[0] + v[1] * v[1]);
+		}
+		pBands[b] = s;
+	}
+	return 0;
+}
+
+template <class T>
+int CFilterbankT<T>::Process(const T *pFrame, T *pBands)
+{
+	if (m_nFFT == 0) return -1;
+
+	const T *pIn = pFrame;
+	if (!m_arWindow.empty())
+	{
+		size_t n;
+		for (n = 0; n < m_nFFT; n++)
+			m_arFrame[n] = pFrame[n] * m_arWindow[n];
+		pIn = &m_arFrame[0];
+	}
+	m_Forward.Execute(pIn, &m_arSpectrum[0]);
+	return Apply(&m_arSpectrum[0], pBands);
+}
+
+template class CFilterbankT<double>;
+template class CFilterbankT<float>;
+
+template <class T>
+CHilbertT<T>::CHilbertT()
+	: m_nSize(0)
+{
+}
+
+template <class T>
+void CHilbertT<T>::Reset()
+{
+	m_nSize = 0;
+	m_Forward.Reset();
+	m_Inverse.Reset();
+	m_arSpectrum.clear();
+}
+
+// The forward transform is scaled by 1/N, the inverse one is not
+template <class T>
+int CHilbertT<T>::Create(size_t nSize)
+{
+	Reset();
+
+	int nRes = m_Forward.Create(CFFTPlanBase::REAL, nSize, false, false);
+	if (nRes == 0)
+		nRes = m_Inverse.Create(CFFTPlanBase::REAL, nSize, true, false);
+	if (nRes != 0)
+	{
+		Reset();
+		return nRes;
+	}
+
+	m_nSize = nSize;
+	m_arSpectrum.resize(nSize / 2 + 1);
+	return 0;
+}
+
+template <class T>
+void CHilbertT<T>::Rotate(const T *pIn)
+{
+	const size_t H = m_nSize / 2;
+	T *x = reinterpret_cast<T *>(&m_arSpectrum[0]);
+	size_t k;
+
+	m_Forward.Execute(pIn, &m_arSpectrum[0]);
+
+	// -i * (re + i*im) = im - i*re
+	for (k = 1; k <= H; k++)
+	{
+		T re = x[2 * k];
+		x[2 * k] = x[2 * k + 1];
+		x[2 * k + 1] = -re;
+	}
+	x[0] = x[1] = 0.;
+	if ((m_nSize & 1) == 0)
+		x[2 * H] = x[2 * H + 1] = 0.;
+}
+
+template <class T>
+int CHilbertT<T>::Hilbert(const T *pIn, T *pOut)
+{
+	if (m_nSize == 0) return -1;
+
+	Rotate(pIn);
+	m_Inverse.Execute(&m_arSpectrum[0], pOut);
+	return 0;
+}
+
+template <class T>
+int CHilbertT<T>::Envelope(const T *pIn, T *pOut)
+{
+	if (m_nSize == 0) return -1;
+
+	Rotate(pIn);
+	T *h = reinterpret_cast<T *>(&m_arSpectrum[0]);
+	m_Inverse.Execute(&m_arSpectrum[0], h);
+	size_t n;
+	for (n = 0; n < m_nSize; n++)
+		pOut[n] = ::sqrt(pIn[n] * pIn[n] + h[n] * h[n]);
+	return 0;
+}
+
+template <class T>
+int CHilbertT<T>::Analytic(const T *pIn, std::complex<T> *pOut)
+{
+	if (m_nSize == 0) return -1;
+
+	Rotate(pIn);
+	T *h = reinterpret_cast<T *>(&m_arSpectrum[0]);
+	m_Inverse.Execute(&m_arSpectrum[0], h);
+	size_t n;
+	for (n = 0; n < m_nSize; n++)
+		pOut[n] = std::complex<T>(pIn[n], h[n]);
+	return 0;
+}
+
+template class CHilbertT<double>;
+template class CHilbertT<float>;
+
+// Applies the 1-D transform fn(n, in, out) along every dimension of a row-major array (slow)
+template <class E, class F>
+static void do_separable_slow(size_t nDims, const size_t *pSize, E *a, F fn)
+{
+	size_t nTotal = 1, nInner = 1, d, o, i, j;
+	for (d = 0; d < nDims; d++)
+		nTotal *= pSize[d];
+	for (d = nDims; d-- > 0; )
+	{
+		size_t n = pSize[d];
+		std::vector<E> x(n), y(n);
+		for (o = 0; o < nTotal / (n * nInner); o++)
+		{
+			for (j = 0; j < nInner; j++)
+			{
+				E *p = a + o * n * nInner + j;
+				for (i = 0; i < n; i++)
+					x[i] = p[i * nInner];
+				fn(n, &x[0], &y[0]);
+				for (i = 0; i < n; i++)
+					p[i * nInner] = y[i];
+			}
+		}
+		nInner *= n;
+	}
+}
+
+static int nTestNum = 0;
+static int nTestErrNum = 0;
+
+#define TEST(a) { nTestNum ++; \
+	if (!(a)) {printf("Test %d FAILED! (%s)\n", nTestNum, #a); nTestErrNum++; } }
+#define EXPECT(a,b) { nTestNum ++; \
+	if (!(fabs(double(a)-double(b))<0.0001)) {printf("Test %d FAILED! (%s==%g, expexted %g)\n", nTestNum, #a, double(a), double(b)); nTestErrNum++; } }
+#define FAIL(a) { nTestNum ++; \
+	if (!(a)) {printf("Test %d FAILED! (%s)\n", nTestNum, #a); return nTestNum; } }
+#define EXPECT_FAIL(a,b) { nTestNum ++; \
+	if (!(fabs(double(a)-double(b))<0.0001)) {printf("Test %d FAILED! (%s==%g, expexted %g)\n", nTestNum, #a, double(a), double(b)); return nTestNum; } }
+
+#define USE_N 8
+
+// Deterministic test signal
+static void make_test_signal(size_t n, double *x, unsigned int seed)
+{
+	size_t i;
+	for (i = 0; i < n; i++)
+	{
+		seed = seed * 1103515245u + 12345u;
+		x[i] = double((seed >> 8) & 0xFFFF) / 32768. - 1.;
+	}
+}
+
+// Works for any mix of float, double and their complex types
+template <class T, class U>
+static double max_abs_diff(size_t n, const T *a, const U *b)
+{
+	double d = 0.;
+	size_t i;
+	for (i = 0; i < n; i++)
+	{
+		double e = std::abs(std::complex<double>(a[i]) - std::complex<double>(b[i]));
+		if (e > d)
+			d = e;
+	}
+	return d;
+}
+
+// Deterministic 32-bit test values, every bit random
+static void make_test_words(size_t n, unsigned int *x, unsigned int seed)
+{
+	unsigned long long s = seed;
+	size_t i;
+	for (i = 0; i < n; i++)
+	{
+		s = s * 6364136223846793005ULL + 1442695040888963407ULL;
+		x[i] = (unsigned int) (s >> 32);
+	}
+}
+
+int run_FFT_selftest()
+{
+	int i;
+	double x[USE_N], sx[USE_N], xx[USE_N], dct_slow[USE_N], idct_slow[USE_N];// , s[USE_N], y[USE_N];
+	std::vector<double> s, y, t2, t3, f;
+
+	x[0] = 4.;
+	x[1] = 3.;
+	x[2] = 5.;
+	x[3] = 10.;
+	TEST(FDCT2(false, 4, x, sx) == 0);
+	TEST(FDCT2(true, 4, sx, xx) == 0);
+	TEST(FDCT2(false, 1, x, sx) == -1);
+	FDCT(4, x, t2, false, true);
+	FDCT(4, &t2[0], t3, true, true);
+	do_real_dct_slow(false, 4, x, dct_slow);
+	do_real_dct_slow(true, 4, dct_slow, idct_slow);
+
+	// Check DCT (slow version)
+	//TEST(fabs(dct_slow[0] - 11) < 0.0001);
+	EXPECT(dct_slow[0], 11.);
+	EXPECT(dct_slow[1], -3.15432);
+	EXPECT(dct_slow[2], 2.12132);
+	EXPECT(dct_slow[3], -0.224171);
+	EXPECT(idct_slow[0], 4);
+	EXPECT(idct_slow[1], 3);
+	EXPECT(idct_slow[2], 5);
+	EXPECT(idct_slow[3], 10);
+
+	// Check Fast DCT
+	for (i = 0; i < 4; i++) EXPECT(dct_slow[i], sx[i]);
+	for (i = 0; i < 4; i++) EXPECT(idct_slow[i], xx[i]);
+	for (i = 0; i < 4; i++) EXPECT(dct_slow[i], t2[i]);
+	for (i = 0; i < 4; i++) EXPECT(idct_slow[i], t3[i]);
+
+	printf("Cosine transform1\n");
+	for (i = 0; i < 4; i++)
+	{
+		printf("%d. %7.3g \t=> %7.3g\t=> %7.3g\t=>%7.3g\t=>%g\n", i, x[i], sx[i], t2[i], t3[i], t3[i] / x[i]);
+	}
+
+	printf("Cosine transform2\n");
+	for (i = 0; i < 4; i++)
+	{
+		if (fabs(xx[i]) < 1e-13) xx[i] = 0.;
+		printf("%d. %5g \t=> %7.3g\t=> %g\n", i, x[i], sx[i], xx[i]);
+	}
+
+
+	memset(x, 0, USE_N * sizeof(double));
+	for (i = 0; i < USE_N; i++)
+		x[i] = 1.;
+	x[1] = 4.;
+
+	printf("Cosine transform\n");
+	FDCT(USE_N, x, s, false, true);
+	FDCT(s.size(), &s[0], y, true, true);
+	for (i = 0; i < USE_N; i++)
+	{
+		if (fabs(y[i]) < 1e-13) y[i] = 0.;
+		printf("%d. %g \t=> %g \t=> %g\n", i, x[i], s[i], y[i]);
+	}
+
+	printf("Sine transform\n");
+	FDST(USE_N, x, s, false, false);
+	FDST(s.size(), &s[0], y, true, false);
+	for (i = 0; i < USE_N; i++)
+	{
+		if (fabs(y[i]) < 1e-13) y[i] = 0.;
+		printf("%d. %g \t=> %g \t=> %g\n", i, x[i], s[i], y[i]);
+	}
+
+	printf("\nFFT\n");
+
+	std::vector<std::complex<double> > cX(USE_N), cF, cIF;
+	for (i = 0; i < USE_N; i++)
+	{
+		cX[i] = 1.;
+		x[i] = 1.;
+	}
+	x[1] = 4.;
+	cX[1] = 4.;
+	
+	FFT(USE_N, x, cF, false, true);
+	FFT(USE_N, &cF[0], cIF, true, true);
+
+	for (i = 0; i < USE_N; i++)
+	{
+		//if (fabs(cIF[i]) < 1e-13) cIF[i] = 0.;
+		printf("%d. %g \t=> (%g + j%g) \t\t=> %g\n", i, cX[i].real(), cF[i].real(), cF[i].imag(), cIF[i].real());
+	}
+
+	printf("\nRFFT\n");
+	f.resize(USE_N);
+	for (i = 0; i < USE_N; i++)
+	{
+		cX[i] = 1.;
+		f[i] = 1.;
+	}
+	f[1] = 4.;
+	cX[1] = 4.;
+	RFFT2(f, cF);
+
+	/*for (i=1; i<(int)cF.size(); i++)
+	{
+		double mod = abs ( cF[i] );
+		double ph = arg ( cF[i] ) + 3.14159265/4.;
+		cF[i] = std::polar(mod, ph);
+	}*/
+	IRFFT2(cF, y);
+
+	printf("SRC vs TRG\n");
+	for (i = 0; i < USE_N; i++)
+	{
+		printf("%d. %g \t=> %g\n", i, f[i], y[i]);
+	}
+	printf("Spectrum\n");
+	for (i = 0; i < (int) cF.size(); i++)
+	{
+		printf("%d. (%5g ; j%-5g)\n", i, cF[i].real(), cF[i].imag());
+	}
+
+	printf("\nFFT plans\n");
+	{
+		size_t arSizes[] = {4, 8, 16, 64, 1024};
+		size_t k, j;
+		for (k = 0; k < sizeof(arSizes) / sizeof(arSizes[0]); k++)
+		{
+			size_t N = arSizes[k];
+			std::vector<double> arX(N), arRef, arRes;
+			std::vector<std::complex<double> > arCX(N), arCRef, arCRes;
+			make_test_signal(N, &arX[0], (unsigned int) N);
+			for (j = 0; j < N; j++)
+				arCX[j] = std::complex<double>(arX[j], arX[N - 1 - j]);
+
+			for (int nMode = 0; nMode < 4; nMode++)
+			{
+				bool bInverse = (nMode & 1) != 0;
+				bool bOrthNorm = (nMode & 2) != 0;
+				CFFTPlan plan;
+
+				TEST(plan.Create(CFFTPlan::COMPLEX, N, bInverse, bOrthNorm) == 0);
+				FFT(N, &arCX[0], arCRef, bInverse, bOrthNorm);
+				TEST(plan.Execute(N, &arCX[0], arCRes) == 0);
+				TEST(max_abs_diff(N, &arCRef[0], &arCRes[0]) < 1e-12);
+				FFT(N - 1, &arX[0], arCRef, bInverse, bOrthNorm);
+				TEST(plan.Execute(N - 1, &arX[0], arCRes) == 0);
+				TEST(max_abs_diff(N, &arCRef[0], &arCRes[0]) < 1e-12);
+
+				TEST(plan.Create(CFFTPlan::DCT, N, bInverse, bOrthNorm) == 0);
+				FDCT(N, &arX[0], arRef, bInverse, bOrthNorm);
+				TEST(plan.Execute(N, &arX[0], arRes) == 0);
+				TEST(max_abs_diff(N, &arRef[0], &arRes[0]) < 1e-12);
+
+				TEST(plan.Create(CFFTPlan::DST, N, bInverse, bOrthNorm) == 0);
+				FDST(N, &arX[0], arRef, bInverse, bOrthNorm);
+				TEST(plan.Execute(N, &arX[0], arRes) == 0);
+				TEST(max_abs_diff(N, &arRef[0], &arRes[0]) < 1e-12);
+
+				if (!bInverse)
+				{
+					TEST(plan.Create(CFFTPlan::REAL, N, false, bOrthNorm) == 0);
+					FFT(N, &arX[0], arCRef, false, bOrthNorm);
+					TEST(plan.Execute(N, &arX[0], arCRes) == 0);
+					TEST(arCRes.size() == N / 2 + 1);
+					TEST(max_abs_diff(N / 2 + 1, &arCRef[0], &arCRes[0]) < 1e-12);
+
+					CFFTPlan iplan;
+					TEST(iplan.Create(CFFTPlan::REAL, N, true, bOrthNorm) == 0);
+					IRFFT(arCRes, arRef, bOrthNorm);
+					TEST(iplan.Execute(arCRes, arRes) == 0);
+					TEST(max_abs_diff(N, &arRef[0], &arRes[0]) < 1e-12);
+					if (bOrthNorm)
+						TEST(max_abs_diff(N, &arX[0], &arRes[0]) < 1e-12);
+				}
+			}
+		}
+
+		// Caller provided buffers
+		size_t N = 64;
+		std::vector<double> arX(N), arRes(N);
+		std::vector<std::complex<double> > arCX(N), arCRef, arCRes(N), arCBuf(N);
+		make_test_signal(N, &arX[0], 77);
+		for (j = 0; j < N; j++)
+			arCX[j] = std::complex<double>(arX[j], -arX[(j * 5) % N]);
+
+		CFFTPlan plan;
+		TEST(plan.Create(CFFTPlan::COMPLEX, N, false) == 0);
+		FFT(N, &arCX[0], arCRef, false);
+		TEST(plan.Execute(&arCX[0], &arCRes[0]) == 0);
+		TEST(max_abs_diff(N, &arCRef[0], &arCRes[0]) < 1e-12);
+		arCBuf = arCX;
+		TEST(plan.Execute(&arCBuf[0]) == 0);
+		TEST(max_abs_diff(N, &arCRef[0], &arCBuf[0]) < 1e-12);
+		arCBuf = arCX;
+		TEST(FFT(N, &arCBuf[0], &arCBuf[0], false) == 0);
+		TEST(max_abs_diff(N, &arCRef[0], &arCBuf[0]) < 1e-12);
+		TEST(FFT(N, &arCX[0], &arCRes[0], false) == 0);
+		TEST(max_abs_diff(N, &arCRef[0], &arCRes[0]) < 1e-12);
+		TEST(FFT(N, &arCRes[0], &arCRes[0], true) == 0);
+		TEST(max_abs_diff(N, &arCX[0], &arCRes[0]) < 1e-12);
+		// Any frame length: mixed radix and Bluestein sizes
+		for (k = 12; k <= 13; k++)
+		{
+			arCBuf.assign(arCX.begin(), arCX.begin() + k);
+			do_complex_dft_slow(false, k, &arCBuf[0], &arCRef[0]);
+			for (j = 0; j < k; j++)
+				arCRef[j] *= ::sqrt(1. / double(k));
+			TEST(FFT(k, &arCBuf[0], &arCBuf[0], false) == 0);
+			TEST(max_abs_diff(k, &arCRef[0], &arCBuf[0]) < 1e-13);
+		}
+		TEST(FFT(1, &arCX[0], &arCRes[0], false) == -1);
+		TEST(plan.Execute(&arX[0], &arRes[0]) == -3);
+
+		TEST(plan.Create(CFFTPlan::REAL, N, false) == 0);
+		FFT(N, &arX[0], arCRef, false);
+		TEST(plan.Execute(&arX[0], &arCRes[0]) == 0);
+		TEST(max_abs_diff(N / 2 + 1, &arCRef[0], &arCRes[0]) < 1e-12);
+		TEST(plan.Create(CFFTPlan::REAL, N, true) == 0);
+		TEST(plan.Execute(&arCRes[0], &arRes[0]) == 0);
+		TEST(max_abs_diff(N, &arX[0], &arRes[0]) < 1e-12);
+
+		TEST(plan.Create(CFFTPlan::DCT, N, false) == 0);
+		TEST(plan.Execute(&arX[0], &arRes[0]) == 0);
+		TEST(plan.Create(CFFTPlan::DCT, N, true) == 0);
+		TEST(plan.Execute(&arRes[0]) == 0);
+		TEST(max_abs_diff(N, &arX[0], &arRes[0]) < 1e-12);
+
+		TEST(plan.Create(CFFTPlan::COMPLEX, 1, false) == -1);
+		TEST(plan.Execute(1, &x[0], cF) == -1);
+		printf("%d tests, %d failed\n", nTestNum, nTestErrNum);
+	}
+
+	printf("\nFFT plans (SIMD)\n");
+	{
+		const char *arSimdName[] = {"scalar", "SSE2", "AVX2", "AVX-512"};
+		size_t arSizes[] = {2, 4, 8, 16, 32, 64, 128, 256, 2048, 4096, 11, 1025};
+		size_t k, j;
+		int nSimd;
+		printf("Supported: %s\n", arSimdName[CFFTPlan::GetSupportedSimd()]);
+		for (k = 0; k < sizeof(arSizes) / sizeof(arSizes[0]); k++)
+		{
+			size_t N = arSizes[k];
+			std::vector<double> arX(N);
+			std::vector<std::complex<double> > arCX(N), arCRef(N), arCRes(N);
+			make_test_signal(N, &arX[0], (unsigned int) N + 5);
+			for (j = 0; j < N; j++)
+				arCX[j] = std::complex<double>(arX[j], arX[(j * 3) % N]);
+
+			for (int nMode = 0; nMode < 2; nMode++)
+			{
+				CFFTPlan plan;
+				TEST(plan.Create(CFFTPlan::COMPLEX, N, nMode != 0) == 0);
+				TEST(plan.SetSimd(CFFTPlanBase::SIMD_SCALAR) == 0);
+				TEST(plan.Execute(&arCX[0], &arCRef[0]) == 0);
+				for (nSimd = CFFTPlanBase::SIMD_SSE2; nSimd <= CFFTPlan::GetSupportedSimd(); nSimd++)
+				{
+					TEST(plan.SetSimd(CFFTPlan::TSimd(nSimd)) == 0);
+					TEST(plan.Execute(&arCX[0], &arCRes[0]) == 0);
+					TEST(max_abs_diff(N, &arCRef[0], &arCRes[0]) < 1e-14);
+				}
+			}
+		}
+		if (CFFTPlan::GetSupportedSimd() < CFFTPlanBase::SIMD_AVX512)
+		{
+			CFFTPlan plan;
+			TEST(plan.SetSimd(CFFTPlanBase::SIMD_AVX512) == -1);
+		}
+		printf("%d tests, %d failed\n", nTestNum, nTestErrNum);
+	}
+
+	printf("\nFFT plans (any size)\n");
+	{
+		size_t arSizes[] = {2, 3, 5, 6, 7, 9, 10, 12, 15, 30, 49, 60, 105, 210, 1000, 3072,
+			11, 13, 17, 97, 1025, 2047};
+		size_t k, j;
+		for (k = 0; k < sizeof(arSizes) / sizeof(arSizes[0]); k++)
+		{
+			size_t N = arSizes[k];
+			std::vector<double> arX(N), arRef(N), arRes(N);
+			std::vector<std::complex<double> > arCX(N), arCRef(N), arCRes(N);
+			make_test_signal(N, &arX[0], (unsigned int) N + 3);
+			for (j = 0; j < N; j++)
+				arCX[j] = std::complex<double>(arX[j], arX[N - 1 - j] * 0.5);
+
+			CFFTPlan plan;
+			double fMaxErr = 0.;
+			for (int nMode = 0; nMode < 2; nMode++)
+			{
+				bool bInverse = nMode != 0;
+				TEST(plan.Create(CFFTPlan::COMPLEX, N, bInverse, false) == 0);
+				TEST(plan.GetSize() == N);
+				do_complex_dft_slow(bInverse, N, &arCX[0], &arCRef[0]);
+				if (!bInverse)
+				{
+					for (j = 0; j < N; j++)
+						arCRef[j] /= double(N);
+				}
+				TEST(plan.Execute(&arCX[0], &arCRes[0]) == 0);
+				double fErr = max_abs_diff(N, &arCRef[0], &arCRes[0]);
+				TEST(fErr < 1e-12 * (1. + ::sqrt(double(N))));
+				if (fErr > fMaxErr) fMaxErr = fErr;
+			}
+
+			TEST(plan.Create(CFFTPlan::REAL, N, false) == 0);
+			TEST(plan.Execute(&arX[0], &arCRes[0]) == 0);
+			CFFTPlan cplan;
+			cplan.Create(CFFTPlan::COMPLEX, N, false);
+			cplan.Execute(N, &arX[0], arCRef);
+			TEST(max_abs_diff(N / 2 + 1, &arCRef[0], &arCRes[0]) < 1e-12);
+			TEST(plan.Create(CFFTPlan::REAL, N, true) == 0);
+			TEST(plan.Execute(&arCRes[0], &arRes[0]) == 0);
+			TEST(max_abs_diff(N, &arX[0], &arRes[0]) < 1e-12);
+			// Zero padded input
+			TEST(plan.Create(CFFTPlan::REAL, N, false) == 0);
+			cplan.Execute(N / 2 + 1, &arX[0], arCRef);
+			TEST(plan.Execute(N / 2 + 1, &arX[0], arCRes) == 0);
+			TEST(max_abs_diff(N / 2 + 1, &arCRef[0], &arCRes[0]) < 1e-12);
+
+			if (N > 1)
+			{
+				TEST(plan.Create(CFFTPlan::DCT, N, false) == 0);
+				TEST(plan.Execute(&arX[0], &arRes[0]) == 0);
+				do_real_dct_slow(false, int(N), &arX[0], &arRef[0]);
+				TEST(max_abs_diff(N, &arRef[0], &arRes[0]) < 1e-11);
+				TEST(plan.Create(CFFTPlan::DCT, N, true) == 0);
+				TEST(plan.Execute(&arRes[0]) == 0);
+				TEST(max_abs_diff(N, &arX[0], &arRes[0]) < 1e-12);
+
+				TEST(plan.Create(CFFTPlan::DST, N, false) == 0);
+				TEST(plan.Execute(&arX[0], &arRes[0]) == 0);
+				TEST(plan.Create(CFFTPlan::DST, N, true) == 0);
+				TEST(plan.Execute(&arRes[0]) == 0);
+				TEST(max_abs_diff(N, &arX[0], &arRes[0]) < 1e-12);
+			}
+
+			const char *arAlgName[] = {"radix-2", "mixed radix", "Bluestein", "four-step"};
+			printf("N=%5d %-12s max.err=%g\n", int(N), arAlgName[cplan.GetAlgorithm()], fMaxErr);
+		}
+		printf("%d tests, %d failed\n", nTestNum, nTestErrNum);
+	}
+
+	printf("\nFFT codelets\n");
+	{
+		size_t N, j;
+		for (N = 1; N <= const_CodeletMaxSize; N *= 2)
+		{
+			std::vector<double> arX(2 * N), arLoop(2 * N);
+			std::vector<std::complex<double> > arCX(N), arCRef(N), arCRes(N), arCIn(N);
+			std::vector<std::complex<float> > arFX(N), arFRes(N);
+			make_test_signal(2 * N, &arX[0], (unsigned int) N + 7);
+			for (j = 0; j < N; j++)
+			{
+				arCX[j] = std::complex<double>(arX[2 * j], arX[2 * j + 1]);
+				arFX[j] = std::complex<float>(arCX[j]);
+			}
+
+			double fErr = 0., fErrLoop = 0.;
+			for (int nMode = 0; nMode < 2; nMode++)
+			{
+				bool bInverse = nMode != 0;
+				do_complex_dft_slow(bInverse, N, &arCX[0], &arCRef[0]);
+				do_fft_codelet(N, reinterpret_cast<const double *>(&arCX[0]), reinterpret_cast<double *>(&arCRes[0]), bInverse);
+				double e = max_abs_diff(N, &arCRef[0], &arCRes[0]);
+				TEST(e < 1e-14 * double(N));
+				if (e > fErr) fErr = e;
+				// In place
+				arCIn = arCX;
+				do_fft_codelet(N, reinterpret_cast<double *>(&arCIn[0]), reinterpret_cast<double *>(&arCIn[0]), bInverse);
+				TEST(max_abs_diff(N, &arCRes[0], &arCIn[0]) == 0.);
+				// Loops and recurrences of do_complex_dft()
+				if (N > 1)
+				{
+					double w = const_PI / double(N);
+					memcpy(&arLoop[0], &arCX[0], 2 * N * sizeof(double));
+					do_complex_dft_loop(int(2 * N), cos(w), bInverse ? sin(w) : -sin(w), &arLoop[0]);
+					e = max_abs_diff(N, &arCRef[0], reinterpret_cast<std::complex<double> *>(&arLoop[0]));
+					if (e > fErrLoop) fErrLoop = e;
+				}
+				do_fft_codelet(N, reinterpret_cast<const float *>(&arFX[0]), reinterpret_cast<float *>(&arFRes[0]), bInverse);
+				TEST(max_abs_diff(N, &arCRef[0], &arFRes[0]) < 1e-6 * double(N));
+			}
+
+			// FFT() runs the codelet
+			if (N > 1)
+			{
+				TEST(FFT(N, &arCX[0], arCRes, true, false) == 0);
+				do_complex_dft_slow(true, N, &arCX[0], &arCRef[0]);
+				TEST(max_abs_diff(N, &arCRef[0], &arCRes[0]) < 1e-14 * double(N));
+			}
+			printf("N=%2d max.err=%g (loops %g)\n", int(N), fErr, fErrLoop);
+		}
+		printf("%d tests, %d failed\n", nTestNum, nTestErrNum);
+	}
+
+	printf("\nAccurate twiddles\n");
+	{
+		size_t arSizes[] = {8, 64, 1024, 4096};
+		size_t k, j;
+
+		// Symmetric twiddles are equal to the last bit
+		double c1, s1, c2, s2;
+		for (j = 1; j < 1000; j += 37)
+		{
+			do_twiddle(j, 1000, c1, s1);
+			do_twiddle(1000 - j, 1000, c2, s2);
+			TEST(c1 == c2 && s1 == -s2);
+			do_twiddle(j, 4000, c1, s1);
+			do_twiddle(1000 - j, 4000, c2, s2);
+			TEST(c1 == s2 && s1 == c2);
+			TEST(fabs(c1 - cos(2. * const_PI * double(j) / 4000.)) < 4e-16);
+		}
+		do_twiddle(3, 12, c1, s1);
+		TEST(c1 == 0. && s1 == 1.);
+
+		// The table of plans gives the same factors for every size dividing its own
+		size_t arTable[] = {4096, 1000, 6, 15};
+		for (k = 0; k < sizeof(arTable) / sizeof(arTable[0]); k++)
+		{
+			size_t N = arTable[k], n;
+			CTwiddleTable table(N);
+			int nDiff = 0;
+			for (n = 1; n <= N; n++)
+			{
+				for (j = 0; N % n == 0 && j < 3 * n; j++)
+				{
+					do_twiddle(j, n, c1, s1);
+					table.Get(j, n, c2, s2);
+					nDiff += (c1 != c2 || s1 != s2);
+				}
+			}
+			TEST(nDiff == 0);
+		}
+
+		for (k = 0; k < sizeof(arSizes) / sizeof(arSizes[0]); k++)
+		{
+			size_t N = arSizes[k];
+			std::vector<double> arX(2 * N), arR1, arR2, arD1, arD2, arS1, arS2;
+			std::vector<std::complex<double> > arCX(N), arCRef(N), arC1, arC2;
+			make_test_signal(2 * N, &arX[0], (unsigned int) N + 11);
+			for (j = 0; j < N; j++)
+				arCX[j] = std::complex<double>(arX[2 * j], arX[2 * j + 1]);
+			arX.resize(N);
+
+			double fErr[2];
+			for (int nMode = 0; nMode < 2; nMode++)
+			{
+				SetAccurateTwiddles(nMode != 0);
+				TEST(GetAccurateTwiddles() == (nMode != 0));
+				std::vector<std::complex<double> > &arC = nMode ? arC2 : arC1;
+				std::vector<double> &arR = nMode ? arR2 : arR1;
+				std::vector<double> &arD = nMode ? arD2 : arD1;
+				std::vector<double> &arS = nMode ? arS2 : arS1;
+				TEST(FFT(N, &arCX[0], arC, false, false) == 0);
+				do_complex_dft_slow(false, N, &arCX[0], &arCRef[0]);
+				for (j = 0; j < N; j++)
+					arCRef[j] /= double(N);
+				fErr[nMode] = max_abs_diff(N, &arCRef[0], &arC[0]);
+				TEST(FFT(N, &arC[0], &arC[0], true, false) == 0);
+				TEST(max_abs_diff(N, &arCX[0], &arC[0]) < 1e-13);
+
+				// Both modes give the same transforms
+				TEST(RFFT(arX, arC) == 0);
+				TEST(IRFFT(arC, arR) == 0);
+				TEST(max_abs_diff(N, &arX[0], &arR[0]) < 1e-13);
+				TEST(FDCT(N, &arX[0], arD, false) == 0);
+				TEST(FDST(N, &arX[0], arS, true) == 0);
+			}
+			SetAccurateTwiddles(false);
+			TEST(max_abs_diff(N / 2 + 1, &arC1[0], &arC2[0]) < 1e-13);
+			TEST(max_abs_diff(N, &arR1[0], &arR2[0]) < 1e-13);
+			TEST(max_abs_diff(N, &arD1[0], &arD2[0]) < 1e-13);
+			TEST(max_abs_diff(N, &arS1[0], &arS2[0]) < 1e-13);
+			TEST(fErr[0] < 1e-15 * (1. + ::sqrt(double(N))));
+			TEST(fErr[1] < 1e-15 * (1. + ::sqrt(double(N))));
+			printf("N=%4d FFT() max.err=%g, accurate twiddles %g\n", int(N), fErr[0], fErr[1]);
+		}
+		printf("%d tests, %d failed\n", nTestNum, nTestErrNum);
+	}
+
+	printf("\nFFT plans (Stockham)\n");
+	{
+		size_t arSizes[] = {64, 128, 256, 512, 2048, 8192, 65536, 1025};
+		size_t k, j;
+		for (k = 0; k < sizeof(arSizes) / sizeof(arSizes[0]); k++)
+		{
+			size_t N = arSizes[k];
+			std::vector<double> arX(2 * N), arR(N), arRes(N);
+			std::vector<std::complex<double> > arCX(N), arCRef(N), arCRes(N);
+			make_test_signal(2 * N, &arX[0], (unsigned int) N + 13);
+			for (j = 0; j < N; j++)
+				arCX[j] = std::complex<double>(arX[2 * j], arX[2 * j + 1]);
+			arX.resize(N);
+
+			double fErr = 0.;
+			for (int nMode = 0; nMode < 2; nMode++)
+			{
+				bool bInverse = nMode != 0;
+				CFFTPlan plan, splan;
+				TEST(plan.Create(CFFTPlan::COMPLEX, N, bInverse) == 0);
+				TEST(splan.SetAlgorithm(CFFTPlan::STOCKHAM) == 0);
+				TEST(splan.Create(CFFTPlan::COMPLEX, N, bInverse) == 0);
+				CFFTPlan::TAlgorithm eAlg = ((N & (N - 1)) != 0) ? CFFTPlan::BLUESTEIN :
+					(N > 64) ? CFFTPlan::STOCKHAM : CFFTPlan::RADIX2;
+				TEST(splan.GetAlgorithm() == eAlg);
+				TEST(plan.Execute(&arCX[0], &arCRef[0]) == 0);
+				TEST(splan.Execute(&arCX[0], &arCRes[0]) == 0);
+				double e = max_abs_diff(N, &arCRef[0], &arCRes[0]);
+				TEST(e < 1e-14 * ::sqrt(double(N)));
+				if (e > fErr) fErr = e;
+				// In place
+				arCRes = arCX;
+				TEST(splan.Execute(&arCRes[0]) == 0);
+				TEST(max_abs_diff(N, &arCRef[0], &arCRes[0]) == e);
+			}
+
+			// Real transforms run an N/2-point Stockham transform
+			CFFTPlan rplan, splan;
+			TEST(rplan.Create(CFFTPlan::REAL, N, false) == 0);
+			TEST(splan.Create(CFFTPlan::REAL, N, false) == 0);
+			TEST(splan.SetAlgorithm(CFFTPlan::STOCKHAM) == 0);
+			TEST(rplan.Execute(&arX[0], &arCRef[0]) == 0);
+			TEST(splan.Execute(&arX[0], &arCRes[0]) == 0);
+			TEST(max_abs_diff(N / 2 + 1, &arCRef[0], &arCRes[0]) < 1e-14 * ::sqrt(double(N)));
+			TEST(splan.Create(CFFTPlan::REAL, N, true) == 0);
+			TEST(splan.Execute(&arCRes[0], &arRes[0]) == 0);
+			TEST(max_abs_diff(N, &arX[0], &arRes[0]) < 1e-14 * ::sqrt(double(N)));
+			printf("N=%5d max.diff=%g\n", int(N), fErr);
+		}
+
+		// Single precision, batch
+		const size_t N = 1024;
+		std::vector<std::complex<float> > arFX(4 * N), arFRef(4 * N), arFRes(4 * N);
+		for (j = 0; j < 4 * N; j++)
+			arFX[j] = std::complex<float>(float(sin(0.01 * double(j))), float(j % 7) * 0.1f);
+		CFFTPlanF fplan, fsplan;
+		TEST(fplan.Create(CFFTPlanF::COMPLEX, N, false) == 0);
+		TEST(fsplan.SetAlgorithm(CFFTPlanF::STOCKHAM) == 0);
+		TEST(fsplan.Create(CFFTPlanF::COMPLEX, N, false) == 0);
+		TEST(fplan.ExecuteMany(4, &arFX[0], 1, N, &arFRef[0], 1, N) == 0);
+		TEST(fsplan.ExecuteMany(4, &arFX[0], 1, N, &arFRes[0], 1, N) == 0);
+		TEST(max_abs_diff(4 * N, &arFRef[0], &arFRes[0]) < 1e-5);
+		// Every instruction set against the scalar passes
+		for (int nSimd = CFFTPlanF::SIMD_SCALAR; nSimd <= CFFTPlanF::SIMD_AVX512; nSimd++)
+		{
+			if (fsplan.SetSimd(CFFTPlanF::TSimd(nSimd)) != 0)
+				continue;
+			TEST(fsplan.Create(CFFTPlanF::COMPLEX, N, true) == 0);
+			TEST(fsplan.ExecuteMany(4, &arFX[0], 1, N, &arFRes[0], 1, N) == 0);
+			TEST(fplan.Create(CFFTPlanF::COMPLEX, N, true) == 0);
+			TEST(fplan.ExecuteMany(4, &arFX[0], 1, N, &arFRef[0], 1, N) == 0);
+			TEST(max_abs_diff(4 * N, &arFRef[0], &arFRes[0]) < 1e-5);
+			CFFTPlan plan, splan;
+			std::vector<std::complex<double> > arCX(N), arCRef(N), arCRes(N);
+			for (j = 0; j < N; j++)
+				arCX[j] = std::complex<double>(arFX[j].real(), arFX[j].imag());
+			TEST(splan.SetSimd(CFFTPlan::TSimd(nSimd)) == 0);
+			TEST(splan.SetAlgorithm(CFFTPlan::STOCKHAM) == 0);
+			TEST(splan.Create(CFFTPlan::COMPLEX, 2 * N, false) == 0);
+			TEST(plan.Create(CFFTPlan::COMPLEX, 2 * N, false) == 0);
+			arCX.resize(2 * N);
+			arCRef.resize(2 * N);
+			arCRes.resize(2 * N);
+			TEST(plan.Execute(&arCX[0], &arCRef[0]) == 0);
+			TEST(splan.Execute(&arCX[0], &arCRes[0]) == 0);
+			TEST(max_abs_diff(2 * N, &arCRef[0], &arCRes[0]) < 1e-12);
+		}
+		TEST(fsplan.SetAlgorithm(CFFTPlanF::MIXED_RADIX) == -1);
+		printf("%d tests, %d failed\n", nTestNum, nTestErrNum);
+	}
+
+	printf("\nFFT plans (split complex)\n");
+	{
+		size_t arSizes[] = {16, 64, 128, 256, 2048, 8192, 12, 1000, 1025};
+		size_t k, j;
+		for (k = 0; k < sizeof(arSizes) / sizeof(arSizes[0]); k++)
+		{
+			size_t N = arSizes[k];
+			std::vector<double> arX(2 * N), arRe(N + 1), arIm(N + 1), arRes(N);
+			std::vector<std::complex<double> > arCX(N), arCRef(N);
+			make_test_signal(2 * N, &arX[0], (unsigned int) N + 29);
+			for (j = 0; j < N; j++)
+				arCX[j] = std::complex<double>(arX[2 * j], arX[2 * j + 1]);
+			arX.resize(N);
+
+			double fErr = 0.;
+			for (int nMode = 0; nMode < 2; nMode++)
+			{
+				bool bInverse = nMode != 0;
+				CFFTPlan plan;
+				TEST(plan.Create(CFFTPlan::COMPLEX, N, bInverse) == 0);
+				TEST(plan.Execute(&arCX[0], &arCRef[0]) == 0);
+				for (j = 0; j < N; j++)
+				{
+					arRe[j] = arCX[j].real();
+					arIm[j] = arCX[j].imag();
+				}
+				// In place
+				TEST(plan.ExecuteSplit(&arRe[0], &arIm[0], &arRe[0], &arIm[0]) == 0);
+				double e = 0.;
+				for (j = 0; j < N; j++)
+					e = std::max(e, std::abs(std::complex<double>(arRe[j], arIm[j]) - arCRef[j]));
+				TEST(e < 1e-14 * ::sqrt(double(N)));
+				if (e > fErr) fErr = e;
+				// Out of place, real input
+				std::vector<double> arORe(N), arOIm(N);
+				TEST(plan.Execute(&arX[0], &arCRef[0]) == 0);
+				TEST(plan.ExecuteSplit(&arX[0], &arORe[0], &arOIm[0]) == 0);
+				e = 0.;
+				for (j = 0; j < N; j++)
+					e = std::max(e, std::abs(std::complex<double>(arORe[j], arOIm[j]) - arCRef[j]));
+				TEST(e < 1e-14 * ::sqrt(double(N)));
+			}
+
+			CFFTPlan rplan, iplan;
+			TEST(rplan.Create(CFFTPlan::REAL, N, false) == 0);
+			TEST(iplan.Create(CFFTPlan::REAL, N, true) == 0);
+			TEST(rplan.Execute(&arX[0], &arCRef[0]) == 0);
+			TEST(rplan.ExecuteSplit(&arX[0], &arRe[0], &arIm[0]) == 0);
+			double e = 0.;
+			for (j = 0; j <= N / 2; j++)
+				e = std::max(e, std::abs(std::complex<double>(arRe[j], arIm[j]) - arCRef[j]));
+			TEST(e < 1e-14 * ::sqrt(double(N)));
+			TEST(iplan.ExecuteSplitToReal(&arRe[0], &arIm[0], &arRes[0]) == 0);
+			TEST(max_abs_diff(N, &arX[0], &arRes[0]) < 1e-14 * ::sqrt(double(N)));
+			TEST(rplan.ExecuteSplitToReal(&arRe[0], &arIm[0], &arRes[0]) == -3);
+			TEST(iplan.ExecuteSplit(&arRe[0], &arIm[0], &arRe[0], &arIm[0]) == -3);
+			printf("N=%5d max.diff=%g\n", int(N), fErr);
+		}
+
+		// Single precision, every instruction set
+		const size_t N = 4096;
+		std::vector<std::complex<float> > arFX(N), arFRef(N);
+		std::vector<float> arFRe(N), arFIm(N);
+		for (j = 0; j < N; j++)
+			arFX[j] = std::complex<float>(float(sin(0.01 * double(j))), float(j % 7) * 0.1f);
+		CFFTPlanF fplan;
+		TEST(fplan.ExecuteSplit(&arFRe[0], &arFIm[0], &arFRe[0], &arFIm[0]) == -1);
+		for (int nSimd = CFFTPlanF::SIMD_SCALAR; nSimd <= CFFTPlanF::GetSupportedSimd(); nSimd++)
+		{
+			TEST(fplan.SetSimd(CFFTPlanF::TSimd(nSimd)) == 0);
+			TEST(fplan.Create(CFFTPlanF::COMPLEX, N, nSimd == CFFTPlanF::SIMD_AVX2) == 0);
+			TEST(fplan.Execute(&arFX[0], &arFRef[0]) == 0);
+			for (j = 0; j < N; j++)
+			{
+				arFRe[j] = arFX[j].real();
+				arFIm[j] = arFX[j].imag();
+			}
+			TEST(fplan.ExecuteSplit(&arFRe[0], &arFIm[0], &arFRe[0], &arFIm[0]) == 0);
+			float e = 0.f;
+			for (j = 0; j < N; j++)
+				e = std::max(e, std::abs(std::complex<float>(arFRe[j], arFIm[j]) - arFRef[j]));
+			TEST(e < 1e-5f);
+		}
+		printf("%d tests, %d failed\n", nTestNum, nTestErrNum);
+	}
+
+	printf("\nFFT plans (float)\n");
+	{
+		size_t arSizes[] = {2, 4, 8, 64, 1024, 12, 105, 3072, 11, 1025};
+		size_t k, j;
+		for (k = 0; k < sizeof(arSizes) / sizeof(arSizes[0]); k++)
+		{
+			size_t N = arSizes[k];
+			std::vector<double> arX(N), arRef(N);
+			std::vector<float> arXF(N), arResF(N);
+			std::vector<std::complex<double> > arCX(N), arCRef(N);
+			std::vector<std::complex<float> > arCXF(N), arCResF(N);
+			make_test_signal(N, &arX[0], (unsigned int) N + 7);
+			for (j = 0; j < N; j++)
+			{
+				arXF[j] = float(arX[j]);
+				arX[j] = arXF[j];
+				arCXF[j] = std::complex<float>(arXF[j], arXF[N - 1 - j]);
+				arCX[j] = arCXF[j];
+			}
+
+			double fMaxErr = 0.;
+			for (int nMode = 0; nMode < 2; nMode++)
+			{
+				bool bInverse = nMode != 0;
+				CFFTPlan plan;
+				CFFTPlanF planf;
+				double fErr;
+
+				TEST(plan.Create(CFFTPlan::COMPLEX, N, bInverse) == 0);
+				TEST(planf.Create(CFFTPlanF::COMPLEX, N, bInverse) == 0);
+				TEST(planf.GetAlgorithm() == plan.GetAlgorithm());
+				plan.Execute(&arCX[0], &arCRef[0]);
+				TEST(planf.Execute(&arCXF[0], &arCResF[0]) == 0);
+				fErr = max_abs_diff(N, &arCRef[0], &arCResF[0]);
+				TEST(fErr < 1e-5);
+				if (fErr > fMaxErr) fMaxErr = fErr;
+
+				TEST(plan.Create(CFFTPlan::DCT, N, bInverse) == 0);
+				TEST(planf.Create(CFFTPlanF::DCT, N, bInverse) == 0);
+				plan.Execute(&arX[0], &arRef[0]);
+				TEST(planf.Execute(&arXF[0], &arResF[0]) == 0);
+				TEST(max_abs_diff(N, &arRef[0], &arResF[0]) < 1e-5);
+
+				TEST(plan.Create(CFFTPlan::DST, N, bInverse) == 0);
+				TEST(planf.Create(CFFTPlanF::DST, N, bInverse) == 0);
+				plan.Execute(&arX[0], &arRef[0]);
+				TEST(planf.Execute(&arXF[0], &arResF[0]) == 0);
+				TEST(max_abs_diff(N, &arRef[0], &arResF[0]) < 1e-5);
+			}
+
+			CFFTPlanF planf;
+			TEST(planf.Create(CFFTPlanF::REAL, N, false) == 0);
+			TEST(planf.Execute(&arXF[0], &arCResF[0]) == 0);
+			CFFTPlan cplan;
+			cplan.Create(CFFTPlan::COMPLEX, N, false);
+			cplan.Execute(N, &arX[0], arCRef);
+			TEST(max_abs_diff(N / 2 + 1, &arCRef[0], &arCResF[0]) < 1e-5);
+			TEST(planf.Create(CFFTPlanF::REAL, N, true) == 0);
+			TEST(planf.Execute(&arCResF[0], &arResF[0]) == 0);
+			TEST(max_abs_diff(N, &arXF[0], &arResF[0]) < 1e-5);
+
+			printf("N=%5d max.err=%g\n", int(N), fMaxErr);
+		}
+
+		// Free functions against the double precision ones
+		size_t N = 1000;
+		std::vector<double> arX(N), arRef;
+		std::vector<float> arXF(N), arResF;
+		std::vector<std::complex<double> > arCRef;
+		std::vector<std::complex<float> > arCResF;
+		make_test_signal(N, &arX[0], 17);
+		for (j = 0; j < N; j++)
+			arXF[j] = float(arX[j]);
+		for (int nMode = 0; nMode < 4; nMode++)
+		{
+			bool bInverse = (nMode & 1) != 0;
+			bool bOrthNorm = (nMode & 2) == 0;
+			// Non-normalized results grow with the size
+			double fTol = bOrthNorm ? 1e-5 : 1e-5 * 1024.;
+			TEST(FFT(N, &arX[0], arCRef, bInverse, bOrthNorm) == 0);
+			TEST(FFT(N, &arXF[0], arCResF, bInverse, bOrthNorm) == 0);
+			TEST(arCResF.size() == arCRef.size());
+			TEST(max_abs_diff(arCRef.size(), &arCRef[0], &arCResF[0]) < fTol);
+			std::vector<std::complex<double> > arCX(arCRef);
+			std::vector<std::complex<float> > arCXF(arCResF);
+			TEST(FFT(arCX.size(), &arCX[0], arCRef, bInverse, bOrthNorm) == 0);
+			TEST(FFT(arCXF.size(), &arCXF[0], arCResF, bInverse, bOrthNorm) == 0);
+			TEST(max_abs_diff(arCRef.size(), &arCRef[0], &arCResF[0]) < fTol * 1024.);
+			TEST(FFT(arCXF.size(), &arCXF[0], &arCXF[0], bInverse, bOrthNorm) == 0);
+			TEST(max_abs_diff(arCRef.size(), &arCRef[0], &arCXF[0]) < fTol * 1024.);
+			TEST(FDCT(N, &arX[0], arRef, bInverse, bOrthNorm) == 0);
+			TEST(FDCT(N, &arXF[0], arResF, bInverse, bOrthNorm) == 0);
+			TEST(arResF.size() == arRef.size());
+			TEST(max_abs_diff(arRef.size(), &arRef[0], &arResF[0]) < fTol);
+			TEST(FDST(N, &arX[0], arRef, bInverse, bOrthNorm) == 0);
+			TEST(FDST(N, &arXF[0], arResF, bInverse, bOrthNorm) == 0);
+			TEST(max_abs_diff(arRef.size(), &arRef[0], &arResF[0]) < fTol);
+		}
+		std::vector<double> arX2(arX.begin(), arX.begin() + 512);
+		std::vector<float> arXF2(arXF.begin(), arXF.begin() + 512);
+		TEST(RFFT(arX2, arCRef) == 0);
+		TEST(RFFT(arXF2, arCResF) == 0);
+		TEST(arCResF.size() == 257);
+		TEST(max_abs_diff(arCRef.size(), &arCRef[0], &arCResF[0]) < 1e-5);
+		TEST(IRFFT(arCResF, arResF) == 0);
+		TEST(arResF.size() == 512);
+		TEST(max_abs_diff(arXF2.size(), &arXF2[0], &arResF[0]) < 1e-5);
+
+		// Vectorized passes against the scalar ones
+		size_t arSimdSizes[] = {4, 8, 16, 32, 64, 128, 256, 2048, 11};
+		for (k = 0; k < sizeof(arSimdSizes) / sizeof(arSimdSizes[0]); k++)
+		{
+			N = arSimdSizes[k];
+			std::vector<std::complex<float> > arCXF(N), arCRefF(N);
+			arX.resize(N);
+			arCResF.resize(N);
+			make_test_signal(N, &arX[0], (unsigned int) N + 9);
+			for (j = 0; j < N; j++)
+				arCXF[j] = std::complex<float>(float(arX[j]), float(arX[(j * 5) % N]));
+			for (int nMode = 0; nMode < 2; nMode++)
+			{
+				CFFTPlanF plan;
+				TEST(plan.Create(CFFTPlanF::COMPLEX, N, nMode != 0) == 0);
+				TEST(plan.SetSimd(CFFTPlanBase::SIMD_SCALAR) == 0);
+				TEST(plan.Execute(&arCXF[0], &arCRefF[0]) == 0);
+				for (int nSimd = CFFTPlanBase::SIMD_SSE2; nSimd <= CFFTPlanBase::GetSupportedSimd(); nSimd++)
+				{
+					TEST(plan.SetSimd(CFFTPlanBase::TSimd(nSimd)) == 0);
+					TEST(plan.Execute(&arCXF[0], &arCResF[0]) == 0);
+					TEST(max_abs_diff(N, &arCRefF[0], &arCResF[0]) < 1e-5);
+				}
+			}
+		}
+		printf("%d tests, %d failed\n", nTestNum, nTestErrNum);
+	}
+
+	printf("\nFFT plans (batch)\n");
+	{
+		size_t arSizes[] = {2, 4, 8, 16, 64, 512, 12, 11};
+		const size_t nHowMany = 7;  // not a multiple of the lane count
+		size_t k, j, m;
+		for (k = 0; k < sizeof(arSizes) / sizeof(arSizes[0]); k++)
+		{
+			size_t N = arSizes[k];
+			std::vector<double> arX(24 * N), arY(24 * N), arSig(N), arRef(N);
+			std::vector<std::complex<double> > arCX(24 * N), arCOut(24 * N), arCSig(N), arCRef(N);
+			make_test_signal(arX.size(), &arX[0], (unsigned int) N + 11);
+			for (j = 0; j < arX.size(); j++)
+				arCX[j] = std::complex<double>(arX[j], arX[arX.size() - 1 - j]);
+
+			// Input stride, input distance, output stride, output distance
+			size_t arLayout[3][4] = {{1, N, 1, N}, {nHowMany, 1, 1, N + 3}, {3, 3 * N, nHowMany, 1}};
+			for (int nLayout = 0; nLayout < 3; nLayout++)
+			{
+				size_t is = arLayout[nLayout][0], id = arLayout[nLayout][1];
+				size_t os = arLayout[nLayout][2], od = arLayout[nLayout][3];
+				double fErr = 0.;
+
+				for (int nMode = 0; nMode < 2; nMode++)
+				{
+					CFFTPlan plan;
+					TEST(plan.Create(CFFTPlan::COMPLEX, N, nMode != 0) == 0);
+					for (int nSimd = CFFTPlanBase::SIMD_SCALAR; nSimd <= CFFTPlanBase::GetSupportedSimd(); nSimd++)
+					{
+						TEST(plan.SetSimd(CFFTPlanBase::TSimd(nSimd)) == 0);
+						TEST(plan.ExecuteMany(nHowMany, &arCX[0], is, id, &arCOut[0], os, od) == 0);
+						for (m = 0; m < nHowMany; m++)
+						{
+							for (j = 0; j < N; j++)
+								arCSig[j] = arCX[m * id + j * is];
+							plan.Execute(&arCSig[0], &arCRef[0]);
+							for (j = 0; j < N; j++)
+								arCSig[j] = arCOut[m * od + j * os];
+							double e = max_abs_diff(N, &arCRef[0], &arCSig[0]);
+							if (e > fErr) fErr = e;
+						}
+					}
+				}
+				TEST(fErr < 1e-13);
+
+				double e;
+				fErr = 0.;
+				CFFTPlan plan, iplan;
+				TEST(plan.Create(CFFTPlan::REAL, N, false) == 0);
+				TEST(iplan.Create(CFFTPlan::REAL, N, true) == 0);
+				TEST(plan.ExecuteMany(nHowMany, &arX[0], is, id, &arCOut[0], os, od) == 0);
+				TEST(iplan.ExecuteMany(nHowMany, &arCOut[0], os, od, &arY[0], is, id) == 0);
+				for (m = 0; m < nHowMany; m++)
+				{
+					for (j = 0; j < N; j++)
+						arSig[j] = arX[m * id + j * is];
+					plan.Execute(&arSig[0], &arCRef[0]);
+					for (j = 0; j <= N / 2; j++)
+						arCSig[j] = arCOut[m * od + j * os];
+					e = max_abs_diff(N / 2 + 1, &arCRef[0], &arCSig[0]);
+					if (e > fErr) fErr = e;
+					for (j = 0; j < N; j++)
+						arRef[j] = arY[m * id + j * is];
+					e = max_abs_diff(N, &arSig[0], &arRef[0]);
+					if (e > fErr) fErr = e;
+				}
+				TEST(fErr < 1e-13);
+
+				fErr = 0.;
+				TEST(plan.Create(CFFTPlan::DCT, N, false) == 0);
+				TEST(plan.ExecuteMany(nHowMany, &arX[0], is, id, &arY[0], os, od) == 0);
+				for (m = 0; m < nHowMany; m++)
+				{
+					for (j = 0; j < N; j++)
+						arSig[j] = arX[m * id + j * is];
+					plan.Execute(&arSig[0]);
+					for (j = 0; j < N; j++)
+						arRef[j] = arY[m * od + j * os];
+					e = max_abs_diff(N, &arSig[0], &arRef[0]);
+					if (e > fErr) fErr = e;
+				}
+				TEST(fErr < 1e-13);
+			}
+		}
+
+		// Single precision, up to 8 signals per register
+		for (k = 0; k < 5; k++)
+		{
+			size_t N = size_t(2) << (2 * k);
+			size_t nCnt = 11;
+			std::vector<std::complex<float> > arCX(N * nCnt), arCOut(N * nCnt), arCRef(N);
+			for (j = 0; j < N * nCnt; j++)
+				arCX[j] = std::complex<float>(float(j % 7) - 3.f, float(j % 5));
+			CFFTPlanF plan;
+			TEST(plan.Create(CFFTPlanF::COMPLEX, N, false) == 0);
+			TEST(plan.ExecuteMany(nCnt, &arCX[0], 1, N, &arCOut[0], 1, N) == 0);
+			double fErr = 0.;
+			for (m = 0; m < nCnt; m++)
+			{
+				plan.Execute(&arCX[m * N], &arCRef[0]);
+				double e = max_abs_diff(N, &arCRef[0], &arCOut[m * N]);
+				if (e > fErr) fErr = e;
+			}
+			TEST(fErr < 1e-5);
+		}
+
+		CFFTPlan plan;
+		double arX[8], arY[8];
+		make_test_signal(8, arX, 1);
+		TEST(plan.ExecuteMany(1, arX, 1, 0, arY, 1, 0) == -1);
+		TEST(plan.Create(CFFTPlan::COMPLEX, 8, false) == 0);
+		TEST(plan.ExecuteMany(1, arX, 1, 0, arY, 1, 0) == -3);
+		printf("%d tests, %d failed\n", nTestNum, nTestErrNum);
+	}
+
+	printf("\nFFT plans (threads)\n");
+	{
+		size_t arSizes[] = {65536, 98304, 65537, 262144};
+		size_t k, j;
+		for (k = 0; k < sizeof(arSizes) / sizeof(arSizes[0]); k++)
+		{
+			size_t N = arSizes[k];
+			std::vector<std::complex<double> > arX(N), arRef(N), arRes(N);
+			for (j = 0; j < N; j++)
+				arX[j] = std::complex<double>(double(j % 13) - 6., double(j % 7) - 3.);
+
+			CFFTPlan plan, tplan;
+			TEST(plan.Create(CFFTPlan::COMPLEX, N, false) == 0);
+			TEST(tplan.SetThreads(4) == 0);
+			TEST(tplan.Create(CFFTPlan::COMPLEX, N, false) == 0);
+			TEST(tplan.GetThreads() == 4);
+			TEST(tplan.GetAlgorithm() == (N == 65537 ? CFFTPlan::BLUESTEIN : CFFTPlan::FOUR_STEP));
+			plan.Execute(&arX[0], &arRef[0]);
+			TEST(tplan.Execute(&arX[0], &arRes[0]) == 0);
+			double fErr = max_abs_diff(N, &arRef[0], &arRes[0]) / sqrt(double(N));
+			TEST(fErr < 1e-13);
+
+			TEST(tplan.Create(CFFTPlan::COMPLEX, N, true) == 0);
+			TEST(tplan.Execute(&arRes[0]) == 0);
+			double e = max_abs_diff(N, &arX[0], &arRes[0]);
+			TEST(e < 1e-12);
+			if (e > fErr) fErr = e;
+
+			// Other number of threads, the workers are reused by every Execute()
+			TEST(tplan.SetThreads(2) == 0);
+			for (j = 0; j < 3; j++)
+			{
+				TEST(tplan.Execute(&arRef[0], &arRes[0]) == 0);
+				TEST(max_abs_diff(N, &arX[0], &arRes[0]) < 1e-12);
+			}
+
+			TEST(tplan.SetThreads(1) == 0);
+			TEST(tplan.GetAlgorithm() != CFFTPlan::FOUR_STEP);
+			printf("N=%6d max.err=%g\n", int(N), fErr);
+		}
+
+		// Single precision, real transform of 2^17 points
+		size_t N = 131072;
+		std::vector<float> arX(N), arY(N);
+		std::vector<std::complex<float> > arRef(N / 2 + 1), arRes(N / 2 + 1);
+		for (j = 0; j < N; j++)
+			arX[j] = float(j % 11) - 5.f;
+		CFFTPlanF plan, tplan, iplan;
+		TEST(plan.Create(CFFTPlanF::REAL, N, false) == 0);
+		TEST(tplan.Create(CFFTPlanF::REAL, N, false) == 0);
+		TEST(tplan.SetThreads(3) == 0);
+		TEST(tplan.GetAlgorithm() == CFFTPlanF::FOUR_STEP);
+		TEST(iplan.SetThreads(3) == 0);
+		TEST(iplan.Create(CFFTPlanF::REAL, N, true) == 0);
+		plan.Execute(&arX[0], &arRef[0]);
+		TEST(tplan.Execute(&arX[0], &arRes[0]) == 0);
+		TEST(max_abs_diff(N / 2 + 1, &arRef[0], &arRes[0]) / sqrt(double(N)) < 1e-4);
+		TEST(iplan.Execute(&arRes[0], &arY[0]) == 0);
+		TEST(max_abs_diff(N, &arX[0], &arY[0]) < 1e-4);
+		TEST(tplan.SetThreads(0) == -1);
+		printf("%d tests, %d failed\n", nTestNum, nTestErrNum);
+	}
+
+	printf("\nFFT plans (2-D, 3-D)\n");
+	{
+		size_t arSizes[][3] = {{8, 8, 0}, {12, 20, 0}, {7, 16, 0}, {4, 6, 5}, {2, 9, 8}};
+		size_t k, j;
+		for (k = 0; k < sizeof(arSizes) / sizeof(arSizes[0]); k++)
+		{
+			size_t nDims = arSizes[k][2] ? 3 : 2;
+			size_t N = arSizes[k][0] * arSizes[k][1] * (nDims == 3 ? arSizes[k][2] : 1);
+			std::vector<double> arX(N), arRef(N), arRes(N);
+			std::vector<std::complex<double> > arCX(N), arCRef(N), arCRes(N);
+			make_test_signal(N, &arX[0], (unsigned int) N + 5);
+			for (j = 0; j < N; j++)
+				arCX[j] = std::complex<double>(arX[j], arX[N - 1 - j]);
+
+			CFFTPlanND plan;
+			double fErr = 0., e;
+			for (int nType = 0; nType < 2; nType++)
+			{
+				CFFTPlanBase::TTransform eType = nType ? CFFTPlanBase::DCT : CFFTPlanBase::COMPLEX;
+				int nRes;
+				if (nDims == 2)
+					nRes = plan.Create2D(eType, arSizes[k][0], arSizes[k][1], false);
+				else
+					nRes = plan.Create3D(eType, arSizes[k][0], arSizes[k][1], arSizes[k][2], false);
+				TEST(nRes == 0);
+				TEST(plan.GetDims() == nDims);
+				TEST(plan.GetSize(1) == arSizes[k][1]);
+
+				if (eType == CFFTPlanBase::COMPLEX)
+				{
+					arCRef = arCX;
+					do_separable_slow(nDims, arSizes[k], &arCRef[0],
+						[](size_t n, std::complex<double> *x, std::complex<double> *y) { do_complex_dft_slow(false, n, x, y); });
+					for (j = 0; j < N; j++)
+						arCRef[j] /= ::sqrt(double(N));
+					TEST(plan.Execute(&arCX[0], &arCRes[0]) == 0);
+					e = max_abs_diff(N, &arCRef[0], &arCRes[0]);
+					TEST(e < 1e-13);
+					if (e > fErr) fErr = e;
+					TEST(plan.Execute(&arX[0]) == -3);
+				}
+				else
+				{
+					arRef = arX;
+					do_separable_slow(nDims, arSizes[k], &arRef[0],
+						[](size_t n, double *x, double *y) { do_real_dct_slow(false, int(n), x, y); });
+					TEST(plan.Execute(&arX[0], &arRes[0]) == 0);
+					e = max_abs_diff(N, &arRef[0], &arRes[0]);
+					TEST(e < 1e-13);
+					if (e > fErr) fErr = e;
+					TEST(plan.Execute(&arCX[0]) == -3);
+				}
+
+				// In place inverse
+				if (nDims == 2)
+					nRes = plan.Create2D(eType, arSizes[k][0], arSizes[k][1], true);
+				else
+					nRes = plan.Create3D(eType, arSizes[k][0], arSizes[k][1], arSizes[k][2], true);
+				TEST(nRes == 0);
+				if (eType == CFFTPlanBase::COMPLEX)
+				{
+					TEST(plan.Execute(&arCRes[0]) == 0);
+					e = max_abs_diff(N, &arCX[0], &arCRes[0]);
+				}
+				else
+				{
+					TEST(plan.Execute(&arRes[0]) == 0);
+					e = max_abs_diff(N, &arX[0], &arRes[0]);
+				}
+				TEST(e < 1e-13);
+				if (e > fErr) fErr = e;
+			}
+			printf("%dx%dx%d max.err=%g\n", int(arSizes[k][0]), int(arSizes[k][1]), int(nDims == 3 ? arSizes[k][2] : 1), fErr);
+		}
+
+		// Large arrays on several threads, single precision
+		size_t arLarge[][3] = {{256, 256, 1}, {32, 48, 64}};
+		for (k = 0; k < 2; k++)
+		{
+			size_t N = arLarge[k][0] * arLarge[k][1] * arLarge[k][2];
+			std::vector<std::complex<float> > arCX(N), arCRef(N), arCRes(N);
+			std::vector<float> arX(N), arRef(N), arRes(N);
+			for (j = 0; j < N; j++)
+			{
+				arX[j] = float(j % 17) - 8.f;
+				arCX[j] = std::complex<float>(arX[j], float(j % 5));
+			}
+			CFFTPlanNDF plan, tplan;
+			TEST(tplan.SetThreads(4) == 0);
+			TEST(tplan.GetThreads() == 4);
+			if (k == 0)
+			{
+				TEST(plan.Create2D(CFFTPlanBase::COMPLEX, 256, 256, false) == 0);
+				TEST(tplan.Create2D(CFFTPlanBase::COMPLEX, 256, 256, false) == 0);
+			}
+			else
+			{
+				TEST(plan.Create3D(CFFTPlanBase::COMPLEX, 32, 48, 64, false) == 0);
+				TEST(tplan.Create3D(CFFTPlanBase::COMPLEX, 32, 48, 64, false) == 0);
+			}
+			TEST(plan.Execute(&arCX[0], &arCRef[0]) == 0);
+			TEST(tplan.Execute(&arCX[0], &arCRes[0]) == 0);
+			TEST(max_abs_diff(N, &arCRef[0], &arCRes[0]) < 1e-6);
+
+			if (k == 0)
+			{
+				TEST(plan.Create2D(CFFTPlanBase::DCT, 256, 256, true) == 0);
+				TEST(tplan.Create2D(CFFTPlanBase::DCT, 256, 256, true) == 0);
+			}
+			else
+			{
+				TEST(plan.Create3D(CFFTPlanBase::DCT, 32, 48, 64, true) == 0);
+				TEST(tplan.Create3D(CFFTPlanBase::DCT, 32, 48, 64, true) == 0);
+			}
+			TEST(plan.Execute(&arX[0], &arRef[0]) == 0);
+			TEST(tplan.Execute(&arX[0], &arRes[0]) == 0);
+			TEST(max_abs_diff(N, &arRef[0], &arRes[0]) < 1e-6);
+			TEST(tplan.SetThreads(1) == 0);
+			TEST(tplan.Execute(&arX[0], &arRes[0]) == 0);
+			TEST(max_abs_diff(N, &arRef[0], &arRes[0]) == 0.);
+		}
+
+		CFFTPlanND plan;
+		double x[4];
+		TEST(plan.Execute(x) == -1);
+		TEST(plan.Create2D(CFFTPlanBase::DCT, 1, 8, false) == -1);
+		TEST(plan.Create2D(CFFTPlanBase::REAL, 8, 8, false) == -3);
+		printf("%d tests, %d failed\n", nTestNum, nTestErrNum);
+	}
+
+	printf("\nFFT plans (DCT-I, DCT-IV, DST-I, DST-II, DST-IV, MDCT)\n");
+	{
+		size_t arSizes[] = {2, 3, 4, 5, 6, 8, 15, 16, 64, 100, 127, 256};
+		CFFTPlanBase::TTransform arTypes[] = {CFFTPlanBase::DCT1, CFFTPlanBase::DCT4,
+			CFFTPlanBase::DST1, CFFTPlanBase::DST2, CFFTPlanBase::DST4};
+		const char *arTypeName[] = {"DCT-I", "DCT-IV", "DST-I", "DST-II", "DST-IV"};
+		size_t k, t, j;
+		for (t = 0; t < 5; t++)
+		{
+			double fMaxErr = 0.;
+			for (k = 0; k < sizeof(arSizes) / sizeof(arSizes[0]); k++)
+			{
+				size_t N = arSizes[k];
+				std::vector<double> arX(N), arRef(N), arRes(N), arY(N);
+				make_test_signal(N, &arX[0], (unsigned int) N + 7);
+				CFFTPlan plan, iplan;
+
+				// Not normalized: FFTW definitions, the inverse undoes them
+				TEST(plan.Create(arTypes[t], N, false, false) == 0);
+				TEST(iplan.Create(arTypes[t], N, true, false) == 0);
+				do_real_r2r_slow(arTypes[t], N, &arX[0], &arRef[0]);
+				TEST(plan.Execute(&arX[0], &arRes[0]) == 0);
+				double e = max_abs_diff(N, &arRef[0], &arRes[0]) / double(N);
+				if (e > fMaxErr) fMaxErr = e;
+				TEST(iplan.Execute(&arRes[0], &arY[0]) == 0);
+				e = max_abs_diff(N, &arX[0], &arY[0]);
+				if (e > fMaxErr) fMaxErr = e;
+
+				// Orthonormal: the norm is kept, the inverse undoes it in place
+				TEST(plan.Create(arTypes[t], N, false) == 0);
+				TEST(iplan.Create(arTypes[t], N, true) == 0);
+				TEST(plan.Execute(&arX[0], &arRes[0]) == 0);
+				double fNormX = 0., fNormY = 0.;
+				for (j = 0; j < N; j++)
+				{
+					fNormX += arX[j] * arX[j];
+					fNormY += arRes[j] * arRes[j];
+				}
+				e = fabs(fNormX - fNormY) / fNormX;
+				if (e > fMaxErr) fMaxErr = e;
+				TEST(iplan.Execute(&arRes[0]) == 0);
+				e = max_abs_diff(N, &arX[0], &arRes[0]);
+				if (e > fMaxErr) fMaxErr = e;
+			}
+			TEST(fMaxErr < 1e-13);
+			printf("%-7s max.err=%g\n", arTypeName[t], fMaxErr);
+		}
+
+		// MDCT with sine window, overlap-added IMDCT frames restore the signal
+		size_t arMdct[] = {2, 4, 6, 16, 64, 250};
+		for (k = 0; k < sizeof(arMdct) / sizeof(arMdct[0]); k++)
+		{
+			size_t N = arMdct[k];
+			size_t nLen = 6 * N;
+			std::vector<double> arX(nLen), arWin(2 * N), arFrame(2 * N), arRef(N), arRes(N), arY(nLen, 0.);
+			make_test_signal(nLen, &arX[0], (unsigned int) N + 9);
+			for (j = 0; j < 2 * N; j++)
+				arWin[j] = sin(const_PI * (double(j) + 0.5) / double(2 * N));
+			double fMaxErr = 0., e;
+
+			for (int nNorm = 0; nNorm < 2; nNorm++)
+			{
+				CFFTPlan plan, iplan;
+				TEST(plan.Create(CFFTPlanBase::MDCT, N, false, nNorm != 0) == 0);
+				TEST(iplan.Create(CFFTPlanBase::MDCT, N, true, nNorm != 0) == 0);
+				TEST(plan.SetWindow(&arWin[0]) == 0);
+				TEST(iplan.SetWindow(&arWin[0]) == 0);
+
+				// Forward against the definition
+				for (j = 0; j < 2 * N; j++)
+					arFrame[j] = arX[j] * arWin[j];
+				do_real_r2r_slow(CFFTPlanBase::MDCT, N, &arFrame[0], &arRef[0]);
+				TEST(plan.Execute(&arX[0], &arRes[0]) == 0);
+				double fScale = nNorm ? ::sqrt(2. / double(N)) : 1.;
+				for (j = 0; j < N; j++)
+					arRef[j] *= fScale;
+				e = max_abs_diff(N, &arRef[0], &arRes[0]) / ::sqrt(double(N));
+				if (e > fMaxErr) fMaxErr = e;
+
+				std::fill(arY.begin(), arY.end(), 0.);
+				size_t m;
+				for (m = 0; m + 2 * N <= nLen; m += N)
+				{
+					TEST(plan.Execute(&arX[m], &arRes[0]) == 0);
+					TEST(iplan.Execute(&arRes[0], &arFrame[0]) == 0);
+					for (j = 0; j < 2 * N; j++)
+						arY[m + j] += arFrame[j];
+				}
+				e = max_abs_diff(nLen - 2 * N, &arX[N], &arY[N]);
+				if (e > fMaxErr) fMaxErr = e;
+			}
+
+			// Batch of MDCT frames with hop N
+			CFFTPlan plan;
+			TEST(plan.Create(CFFTPlanBase::MDCT, N, false) == 0);
+			std::vector<double> arMany(5 * N);
+			TEST(plan.ExecuteMany(5, &arX[0], 1, N, &arMany[0], 1, N) == 0);
+			TEST(plan.Execute(&arX[2 * N], &arRes[0]) == 0);
+			TEST(max_abs_diff(N, &arRes[0], &arMany[2 * N]) == 0.);
+
+			// SetThreads() and SetAlgorithm() create the plan again, the window stays
+			std::vector<double> arWinRes(N);
+			TEST(plan.SetWindow(&arWin[0]) == 0);
+			TEST(plan.Execute(&arX[0], &arRes[0]) == 0);
+			TEST(plan.SetThreads(2) == 0);
+			TEST(plan.Execute(&arX[0], &arWinRes[0]) == 0);
+			TEST(max_abs_diff(N, &arRes[0], &arWinRes[0]) == 0.);
+			TEST(plan.SetAlgorithm(CFFTPlanBase::STOCKHAM) == 0);
+			TEST(plan.Execute(&arX[0], &arWinRes[0]) == 0);
+			TEST(max_abs_diff(N, &arRes[0], &arWinRes[0]) < 1e-13);
+
+			TEST(fMaxErr < 1e-13);
+			printf("MDCT N=%3d max.err=%g\n", int(N), fMaxErr);
+		}
+
+		// Single precision DCT-IV against double
+		std::vector<double> arX(64), arRef(64);
+		std::vector<float> arXF(64), arResF(64);
+		make_test_signal(64, &arX[0], 3);
+		for (j = 0; j < 64; j++)
+			arXF[j] = float(arX[j]);
+		CFFTPlan plan;
+		CFFTPlanF planf;
+		TEST(plan.Create(CFFTPlanBase::DCT4, 64, false) == 0);
+		TEST(planf.Create(CFFTPlanBase::DCT4, 64, false) == 0);
+		TEST(plan.Execute(&arX[0]) == 0);
+		TEST(planf.Execute(&arXF[0], &arResF[0]) == 0);
+		TEST(max_abs_diff(64, &arX[0], &arResF[0]) < 1e-5);
+
+		// 2-D DST-II
+		size_t arSize2D[2] = {6, 8};
+		std::vector<double> arX2(48), arRef2(48), arRes2(48);
+		make_test_signal(48, &arX2[0], 4);
+		arRef2 = arX2;
+		do_separable_slow(2, arSize2D, &arRef2[0],
+			[](size_t n, double *x, double *y) { do_real_r2r_slow(CFFTPlanBase::DST2, n, x, y); });
+		CFFTPlanND plan2;
+		TEST(plan2.Create2D(CFFTPlanBase::DST2, 6, 8, false, false) == 0);
+		TEST(plan2.Execute(&arX2[0], &arRes2[0]) == 0);
+		TEST(max_abs_diff(48, &arRef2[0], &arRes2[0]) < 1e-12);
+		TEST(plan2.Create2D(CFFTPlanBase::MDCT, 6, 8, false) == -3);
+
+		TEST(plan.Create(CFFTPlanBase::MDCT, 5, false) == -1);
+		TEST(plan.SetWindow(NULL) == -1);
+		TEST(plan.Create(CFFTPlanBase::DCT4, 8, false) == 0);
+		TEST(plan.SetWindow(NULL) == -3);
+		printf("%d tests, %d failed\n", nTestNum, nTestErrNum);
+	}
+
+	printf("\nSTFT\n");
+	{
+		const size_t nLen = 1000;
+		const size_t N = 64;
+		size_t arHop[] = {16, 32, 48, 64, 80};
+		std::vector<double> arX(nLen), arY(nLen), arFrame(N);
+		make_test_signal(nLen, &arX[0], 31);
+		size_t h, f, n;
+		for (h = 0; h < sizeof(arHop) / sizeof(arHop[0]); h++)
+		{
+			size_t nHop = arHop[h];
+			CSTFT stft;
+			TEST(stft.Create(N, nHop) == 0);
+			size_t nFrames = stft.GetFrameCount(nLen);
+			TEST(nFrames == 1 + (nLen - N) / nHop);
+			TEST(stft.GetBins() == N / 2 + 1);
+			std::vector<std::complex<double> > arSpec(nFrames * (N / 2 + 1)), arPush(arSpec.size() + N), arRef(N / 2 + 1);
+			TEST(stft.Forward(nLen, &arX[0], &arSpec[0]) == 0);
+
+			// Against windowed frames through a plan
+			CFFTPlan plan;
+			plan.Create(CFFTPlan::REAL, N, false);
+			double fErr = 0., e;
+			for (f = 0; f < nFrames; f++)
+			{
+				for (n = 0; n < N; n++)
+					arFrame[n] = arX[f * nHop + n] * (0.5 - 0.5 * cos(2. * const_PI * double(n) / double(N)));
+				plan.Execute(&arFrame[0], &arRef[0]);
+				e = max_abs_diff(N / 2 + 1, &arRef[0], &arSpec[f * (N / 2 + 1)]);
+				if (e > fErr) fErr = e;
+			}
+
+			// Streaming in chunks of varying size gives the same frames
+			size_t i, nChunk, nCnt, nPushed = 0;
+			int nRes = 0;
+			for (i = 0, nChunk = 0; i < nLen; i += nCnt, nChunk++)
+			{
+				nCnt = (nChunk * 7) % 40 + 1;
+				if (nCnt > nLen - i)
+					nCnt = nLen - i;
+				size_t nDone;
+				nRes |= stft.Push(nCnt, &arX[i], &arPush[nPushed * (N / 2 + 1)], nDone);
+				nPushed += nDone;
+			}
+			TEST(nRes == 0);
+			TEST(nPushed == nFrames);
+			TEST(max_abs_diff(arSpec.size(), &arSpec[0], &arPush[0]) == 0.);
+
+			// ISTFT restores samples covered by windows
+			TEST(stft.GetSignalSize(nFrames) == (nFrames - 1) * nHop + N);
+			TEST(stft.Inverse(nFrames, &arSpec[0], &arY[0]) == 0);
+			for (n = 1; n < stft.GetSignalSize(nFrames); n++)
+			{
+				if (nHop < N || (n % nHop) != 0)
+				{
+					if (nHop > N && (n % nHop) >= N)
+						continue;
+					e = fabs(arX[n] - arY[n]);
+					if (e > fErr) fErr = e;
+				}
+			}
+			TEST(arY[0] == 0.);
+			TEST(fErr < 1e-12);
+			printf("N=%d hop=%2d frames=%d max.err=%g\n", int(N), int(nHop), int(nFrames), fErr);
+		}
+
+		// Single precision, sine window
+		std::vector<float> arXF(nLen), arYF(nLen), arWinF(N);
+		for (n = 0; n < nLen; n++)
+			arXF[n] = float(arX[n]);
+		for (n = 0; n < N; n++)
+			arWinF[n] = float(sin(const_PI * (double(n) + 0.5) / double(N)));
+		CSTFTF stft;
+		TEST(stft.Create(N, N / 2, &arWinF[0], false) == 0);
+		size_t nFrames = stft.GetFrameCount(nLen);
+		std::vector<std::complex<float> > arSpec(nFrames * stft.GetBins());
+		TEST(stft.Forward(nLen, &arXF[0], &arSpec[0]) == 0);
+		TEST(stft.Inverse(nFrames, &arSpec[0], &arYF[0]) == 0);
+		TEST(max_abs_diff(stft.GetSignalSize(nFrames), &arXF[0], &arYF[0]) < 1e-5);
+
+		CSTFT stft2;
+		size_t nDone;
+		TEST(stft2.Forward(10, &arX[0], NULL) == -1);
+		TEST(stft2.Push(10, &arX[0], NULL, nDone) == -1);
+		TEST(stft2.Create(64, 0) == -1);
+		TEST(stft2.Create(1, 1) == -1);
+		printf("%d tests, %d failed\n", nTestNum, nTestErrNum);
+	}
+
+	printf("\nFFT convolver\n");
+	{
+		size_t arKernel[] = {1, 5, 64, 300, 1000};
+		size_t arBlock[] = {1, 7, 16, 64};
+		size_t arChunk[] = {1, 3, 100, 17, 256, 2};
+		const size_t nLen = 3000;
+		std::vector<double> arX(nLen), arH(1000), arRef(nLen), arY(nLen), arY2(nLen);
+		make_test_signal(nLen, &arX[0], 21);
+		make_test_signal(1000, &arH[0], 22);
+		size_t k, b, i, j;
+		for (k = 0; k < sizeof(arKernel) / sizeof(arKernel[0]); k++)
+		{
+			size_t L = arKernel[k];
+			for (i = 0; i < nLen; i++)
+			{
+				arRef[i] = 0.;
+				for (j = 0; j < L && j <= i; j++)
+					arRef[i] += arH[j] * arX[i - j];
+			}
+
+			double fErr = 0.;
+			for (b = 0; b < sizeof(arBlock) / sizeof(arBlock[0]); b++)
+			{
+				size_t B = arBlock[b];
+				if (B == 1 && L > 64)
+					continue;
+				CFFTConvolver conv;
+				TEST(conv.Create(L, &arH[0], B) == 0);
+				TEST(conv.GetLatency() == B);
+				for (int nPass = 0; nPass < 2; nPass++)
+				{
+					// Chunks of varying size, the second pass in place after Clear()
+					std::vector<double> &arOut = nPass ? arY2 : arY;
+					if (nPass)
+					{
+						conv.Clear();
+						arY2 = arX;
+					}
+					size_t n, nChunk;
+					int nRes = 0;
+					for (i = 0, nChunk = 0; i < nLen; i += n, nChunk++)
+					{
+						n = arChunk[nChunk % 6];
+						if (n > nLen - i)
+							n = nLen - i;
+						nRes |= conv.Process(n, nPass ? &arOut[i] : &arX[i], &arOut[i]);
+					}
+					TEST(nRes == 0);
+				}
+				for (i = 0; i < B; i++)
+				{
+					double e = fabs(arY[i]);
+					if (e > fErr) fErr = e;
+				}
+				double e = max_abs_diff(nLen - B, &arRef[0], &arY[B]);
+				if (e > fErr) fErr = e;
+				TEST(max_abs_diff(nLen, &arY[0], &arY2[0]) == 0.);
+			}
+			TEST(fErr < 1e-12 * ::sqrt(double(L)));
+			printf("kernel=%4d max.err=%g\n", int(L), fErr);
+		}
+
+		// Single precision
+		std::vector<float> arXF(nLen), arHF(100), arYF(nLen);
+		for (i = 0; i < nLen; i++)
+			arXF[i] = float(arX[i]);
+		for (i = 0; i < 100; i++)
+			arHF[i] = float(arH[i]);
+		CFFTConvolverF conv;
+		TEST(conv.Create(100, &arHF[0], 32) == 0);
+		TEST(conv.Process(nLen, &arXF[0], &arYF[0]) == 0);
+		double fErr = 0.;
+		for (i = 32; i < nLen; i++)
+		{
+			double v = 0.;
+			for (j = 0; j < 100 && j <= i - 32; j++)
+				v += double(arHF[j]) * double(arXF[i - 32 - j]);
+			double e = fabs(v - double(arYF[i]));
+			if (e > fErr) fErr = e;
+		}
+		TEST(fErr < 1e-4);
+		TEST(conv.Create(0, &arHF[0], 32) == -1);
+		TEST(conv.Process(1, &arXF[0], &arYF[0]) == -1);
+		printf("%d tests, %d failed\n", nTestNum, nTestErrNum);
+	}
+
+	printf("\nFFT correlation\n");
+	{
+		size_t arLen[][2] = {{1, 1}, {7, 3}, {3, 7}, {50, 50}, {100, 17}, {64, 129}, {1000, 300}};
+		size_t t, i, n;
+		for (t = 0; t < sizeof(arLen) / sizeof(arLen[0]); t++)
+		{
+			size_t N = arLen[t][0], M = arLen[t][1];
+			std::vector<double> arX(N), arY(M), arRef(N + M - 1), arRes(N + M - 1);
+			make_test_signal(N, &arX[0], (unsigned int) N + 1);
+			make_test_signal(M, &arY[0], (unsigned int) M + 2);
+
+			CFFTCorrelator corr;
+			TEST(corr.Create(N, M) == 0);
+			TEST(corr.GetFFTSize() >= N + M - 1 && (corr.GetFFTSize() % 2) == 0);
+
+			double fErr = 0.;
+			for (int eMode = CFFTCorrelator::FULL; eMode <= CFFTCorrelator::VALID; eMode++)
+			{
+				CFFTCorrelator::TMode eM = CFFTCorrelator::TMode(eMode);
+				size_t nCnt = corr.GetOutputSize(eM);
+				long long nFirst = corr.GetFirstLag(eM);
+				TEST(corr.Correlate(&arX[0], &arY[0], &arRes[0], eM) == 0);
+				for (i = 0; i < nCnt; i++)
+				{
+					// z[k] = sum x[n + k] * y[n]
+					long long k = nFirst + (long long) i;
+					double v = 0.;
+					for (n = 0; n < M; n++)
+					{
+						long long m = (long long) n + k;
+						if (m >= 0 && m < (long long) N)
+							v += arX[size_t(m)] * arY[n];
+					}
+					arRef[i] = v;
+				}
+				double e = max_abs_diff(nCnt, &arRef[0], &arRes[0]);
+				TEST(e < 1e-12 * double(N + M));
+				if (e > fErr) fErr = e;
+			}
+			TEST(corr.GetOutputSize(CFFTCorrelator::FULL) == N + M - 1);
+			TEST(corr.GetOutputSize(CFFTCorrelator::SAME) == N);
+			TEST(corr.GetOutputSize(CFFTCorrelator::VALID) == (N > M ? N - M : M - N) + 1);
+			printf("N=%4d M=%4d L=%4d max.err=%g\n", int(N), int(M), int(corr.GetFFTSize()), fErr);
+
+			// Autocorrelation is correlation with itself
+			if (M >= N)
+			{
+				for (int eMode = CFFTCorrelator::FULL; eMode <= CFFTCorrelator::VALID; eMode++)
+				{
+					CFFTCorrelator::TMode eM = CFFTCorrelator::TMode(eMode);
+					CFFTCorrelator self;
+					TEST(self.Create(N) == 0);
+					TEST(self.Correlate(&arX[0], &arX[0], &arRef[0], eM) == 0);
+					TEST(corr.AutoCorrelate(&arX[0], &arRes[0], eM) == 0);
+					TEST(max_abs_diff(self.GetOutputSize(eM), &arRef[0], &arRes[0]) < 1e-12 * double(N));
+				}
+			}
+			else
+				TEST(corr.AutoCorrelate(&arX[0], &arRes[0]) == -3);
+
+			// X * conj(Y) of the zero padded signals
+			size_t L = corr.GetFFTSize();
+			std::vector<std::complex<double> > arCX(L, 0.), arCY(L, 0.), arFX(L), arFY(L), arP(L / 2 + 1);
+			for (i = 0; i < N; i++)
+				arCX[i] = arX[i];
+			for (i = 0; i < M; i++)
+				arCY[i] = arY[i];
+			do_complex_dft_slow(false, L, &arCX[0], &arFX[0]);
+			do_complex_dft_slow(false, L, &arCY[0], &arFY[0]);
+			TEST(corr.CrossPowerSpectrum(&arX[0], &arY[0], &arP[0]) == 0);
+			for (i = 0; i <= L / 2; i++)
+				arFX[i] *= std::conj(arFY[i]);
+			TEST(max_abs_diff(L / 2 + 1, &arFX[0], &arP[0]) < 1e-11 * double(L));
+		}
+
+		// Single precision
+		std::vector<float> arXF(300), arYF(40), arZF(339);
+		for (i = 0; i < 300; i++)
+			arXF[i] = float(sin(0.1 * double(i)));
+		for (i = 0; i < 40; i++)
+			arYF[i] = float(cos(0.3 * double(i)));
+		CFFTCorrelatorF corrf;
+		TEST(corrf.Create(300, 40) == 0);
+		TEST(corrf.Correlate(&arXF[0], &arYF[0], &arZF[0], CFFTCorrelatorF::VALID) == 0);
+		double fErr = 0.;
+		for (i = 0; i < 261; i++)
+		{
+			double v = 0.;
+			for (n = 0; n < 40; n++)
+				v += double(arXF[i + n]) * double(arYF[n]);
+			if (fabs(v - arZF[i]) > fErr) fErr = fabs(v - arZF[i]);
+		}
+		TEST(fErr < 1e-4);
+		TEST(corrf.Create(0) == -1);
+		TEST(corrf.Correlate(&arXF[0], &arYF[0], &arZF[0]) == -1);
+		printf("%d tests, %d failed\n", nTestNum, nTestErrNum);
+	}
+
+	printf("\nFixed-point FFT (Q15, Q31)\n");
+	{
+		size_t arSizes[] = {8, 64, 1024, 4096, 65536};
+		size_t k, j;
+		for (k = 0; k < sizeof(arSizes) / sizeof(arSizes[0]); k++)
+		{
+			size_t N = arSizes[k];
+			std::vector<double> arX(2 * N);
+			make_test_signal(2 * N, &arX[0], (unsigned int) N + 7);
+			std::vector<std::complex<double> > arCX(N), arCRef(N);
+			std::vector<short> arQ15(2 * N), arQ15Simd(2 * N), arQ15Real(N + 2);
+			std::vector<int> arQ31(2 * N), arQ31Real(N + 2);
+			for (j = 0; j < N; j++)
+			{
+				arCX[j] = std::complex<double>(floor(arX[2 * j] * 32767. + 0.5), floor(arX[2 * j + 1] * 32767. + 0.5));
+				arQ15[2 * j] = short(arCX[j].real());
+				arQ15[2 * j + 1] = short(arCX[j].imag());
+				arQ31[2 * j] = int(arCX[j].real()) * 65536;
+				arQ31[2 * j + 1] = int(arCX[j].imag()) * 65536;
+			}
+			arQ15Simd = arQ15;
+			std::vector<short> arQ15In(arQ15);
+			std::vector<int> arQ31In(arQ31);
+
+			for (int nMode = 0; nMode < 2; nMode++)
+			{
+				bool bInverse = nMode != 0;
+				CFFTPlan plan;
+				TEST(plan.Create(CFFTPlan::COMPLEX, N, bInverse, false) == 0);
+				TEST(plan.Execute(&arCX[0], &arCRef[0]) == 0);
+				if (!bInverse)
+				{
+					for (j = 0; j < N; j++)
+						arCRef[j] *= double(N);
+				}
+
+				CFFTFixedQ15 q15, q15s;
+				CFFTFixedQ31 q31;
+				int nExp15 = 0, nExp15s = 0, nExp31 = 0;
+				arQ15 = arQ15In;
+				arQ15Simd = arQ15In;
+				arQ31 = arQ31In;
+				TEST(q15.Create(N, bInverse) == 0);
+				TEST(q15s.Create(N, bInverse) == 0);
+				TEST(q15s.SetSimd(CFFTFixedQ15::SIMD_SCALAR) == 0);
+				TEST(q31.Create(N, bInverse) == 0);
+				TEST(q15.Execute(&arQ15Simd[0], nExp15) == 0);
+				TEST(q15s.Execute(&arQ15[0], nExp15s) == 0);
+				TEST(q31.Execute(&arQ31[0], nExp31) == 0);
+				// Instruction sets give the same bits
+				TEST(nExp15 == nExp15s && arQ15 == arQ15Simd);
+
+				double fSignal = 0., fNoise15 = 0., fNoise31 = 0.;
+				double f15 = ldexp(1., nExp15), f31 = ldexp(1., nExp31 - 16);
+				for (j = 0; j < N; j++)
+				{
+					fSignal += std::norm(arCRef[j]);
+					fNoise15 += std::norm(arCRef[j] - std::complex<double>(arQ15[2 * j], arQ15[2 * j + 1]) * f15);
+					fNoise31 += std::norm(arCRef[j] - std::complex<double>(arQ31[2 * j], arQ31[2 * j + 1]) * f31);
+				}
+				double fSNR15 = 10. * log10(fSignal / fNoise15);
+				double fSNR31 = 10. * log10(fSignal / fNoise31);
+				// Rounding of the stages and of the block shifts, up to 2^16 points
+				TEST(fSNR15 > 50.);
+				TEST(fSNR31 > 140.);
+				if (!bInverse)
+					printf("N=%5d Q15 SNR=%.1f dB, Q31 SNR=%.1f dB, exponents %d, %d\n", int(N), fSNR15, fSNR31, nExp15, nExp31);
+			}
+
+			// Real input
+			CFFTPlan rplan;
+			std::vector<double> arR(N);
+			for (j = 0; j < N; j++)
+				arR[j] = arCX[j].real();
+			TEST(rplan.Create(CFFTPlan::REAL, N, false, false) == 0);
+			TEST(rplan.Execute(&arR[0], &arCRef[0]) == 0);
+			CFFTFixedQ15 q15;
+			CFFTFixedQ31 q31;
+			int nExp15 = 0, nExp31 = 0;
+			for (j = 0; j < N; j++)
+			{
+				arQ15[j] = short(arR[j]);
+				arQ31[j] = int(arR[j]) * 65536;
+			}
+			TEST(q15.Create(N, false) == 0);
+			TEST(q31.Create(N, false) == 0);
+			TEST(q15.ExecuteReal(&arQ15[0], &arQ15Real[0], nExp15) == 0);
+			TEST(q31.ExecuteReal(&arQ31[0], &arQ31Real[0], nExp31) == 0);
+			double fSignal = 0., fNoise15 = 0., fNoise31 = 0.;
+			double f15 = ldexp(1., nExp15), f31 = ldexp(1., nExp31 - 16);
+			for (j = 0; j <= N / 2; j++)
+			{
+				std::complex<double> c = arCRef[j] * double(N);
+				fSignal += std::norm(c);
+				fNoise15 += std::norm(c - std::complex<double>(arQ15Real[2 * j], arQ15Real[2 * j + 1]) * f15);
+				fNoise31 += std::norm(c - std::complex<double>(arQ31Real[2 * j], arQ31Real[2 * j + 1]) * f31);
+			}
+			TEST(10. * log10(fSignal / fNoise15) > 50.);
+			TEST(10. * log10(fSignal / fNoise31) > 140.);
+			printf("N=%5d real Q15 SNR=%.1f dB, Q31 SNR=%.1f dB\n", int(N), 10. * log10(fSignal / fNoise15),
+				10. * log10(fSignal / fNoise31));
+
+			// Inverse real transform of the Q15 spectrum against the double one, in place
+			std::vector<std::complex<double> > arSpec(N / 2 + 1);
+			std::vector<int> arQ31Inv(N + 2);
+			for (j = 0; j <= N / 2; j++)
+			{
+				arSpec[j] = std::complex<double>(arQ15Real[2 * j], arQ15Real[2 * j + 1]) * f15;
+				arQ31Inv[2 * j] = int(arQ15Real[2 * j]) * 65536;
+				arQ31Inv[2 * j + 1] = int(arQ15Real[2 * j + 1]) * 65536;
+			}
+			arSpec[0] = arSpec[0].real();
+			arSpec[N / 2] = arSpec[N / 2].real();
+			TEST(rplan.Create(CFFTPlan::REAL, N, true, false) == 0);
+			TEST(rplan.Execute(&arSpec[0], &arR[0]) == 0);
+			CFFTFixedQ15 iq15, iq15s;
+			CFFTFixedQ31 iq31;
+			std::vector<short> arQ15Inv(arQ15Real);
+			int nExpInv15 = 0, nExpInv15s = 0, nExpInv31 = 0;
+			TEST(iq15.Create(N, true) == 0);
+			TEST(iq15s.Create(N, true) == 0);
+			TEST(iq15s.SetSimd(CFFTFixedQ15::SIMD_SCALAR) == 0);
+			TEST(iq31.Create(N, true) == 0);
+			TEST(iq15.ExecuteReal(&arQ15Inv[0], &arQ15Inv[0], nExpInv15) == 0);
+			TEST(iq15s.ExecuteReal(&arQ15Real[0], &arQ15[0], nExpInv15s) == 0);
+			TEST(iq31.ExecuteReal(&arQ31Inv[0], &arQ31Inv[0], nExpInv31) == 0);
+			TEST(nExpInv15 == nExpInv15s && std::equal(arQ15.begin(), arQ15.begin() + N, arQ15Inv.begin()));
+			fSignal = fNoise15 = fNoise31 = 0.;
+			f15 = ldexp(1., nExpInv15 + nExp15);
+			f31 = ldexp(1., nExpInv31 + nExp15 - 16);
+			for (j = 0; j < N; j++)
+			{
+				fSignal += arR[j] * arR[j];
+				fNoise15 += (arR[j] - arQ15Inv[j] * f15) * (arR[j] - arQ15Inv[j] * f15);
+				fNoise31 += (arR[j] - arQ31Inv[j] * f31) * (arR[j] - arQ31Inv[j] * f31);
+			}
+			TEST(10. * log10(fSignal / fNoise15) > 50.);
+			TEST(10. * log10(fSignal / fNoise31) > 140.);
+			printf("N=%5d inverse real Q15 SNR=%.1f dB, Q31 SNR=%.1f dB\n", int(N), 10. * log10(fSignal / fNoise15),
+				10. * log10(fSignal / fNoise31));
+		}
+
+		// Quiet input keeps its bits: no shifts before the stages need them
+		CFFTFixedQ15 q15;
+		std::vector<short> arQ(2 * 1024, 0);
+		int nExp = -1;
+		arQ[2] = 3;
+		TEST(q15.Create(1024, false) == 0);
+		TEST(q15.Execute(&arQ[0], nExp) == 0);
+		TEST(nExp == 0 && arQ[0] == 3 && arQ[1] == 0);
+
+		TEST(q15.Create(1000, false) == -1);
+		TEST(q15.Create(2, true) == 0);
+		TEST(q15.ExecuteReal(&arQ[0], &arQ[0], nExp) == -2);
+		q15.Reset();
+		TEST(q15.Execute(&arQ[0], nExp) == -1);
+		printf("%d tests, %d failed\n", nTestNum, nTestErrNum);
+	}
+
+	printf("\nFFT multiplier (exact products)\n");
+	{
+		size_t arLen[][2] = {{1, 1}, {1, 7}, {5, 3}, {64, 64}, {100, 37}, {1000, 1000}, {3000, 700}, {10000, 9000}};
+		unsigned int arMod[] = {1, 2, 65537, 998244353, 4294967291u};
+		size_t t, i, j;
+		for (t = 0; t < sizeof(arLen) / sizeof(arLen[0]); t++)
+		{
+			size_t N = arLen[t][0], M = arLen[t][1];
+			std::vector<unsigned int> arA(N), arB(M), arRes(N + M), arRef(N + M);
+			std::vector<long long> arPA(N), arPB(M), arPRes(N + M - 1), arPRef(N + M - 1);
+			make_test_words(N, &arA[0], (unsigned int) N + 1);
+			make_test_words(M, &arB[0], (unsigned int) M + 2);
+			for (i = 0; i < N; i++)
+				arPA[i] = (long long) ((unsigned long long) arA[i] << 32 | arA[(i + 1) % N]);
+			for (i = 0; i < M; i++)
+				arPB[i] = (long long) ((unsigned long long) arB[(i + 1) % M] << 32 | arB[i]);
+
+			CFFTMultiplier mul;
+			TEST(mul.Create(N, M) == 0);
+			TEST(mul.GetFFTSize() >= N + M - 1 && mul.GetLimbBits() == ((std::min(N, M) <= 8192) ? 16 : 8));
+			printf("N=%5d M=%5d FFT size %5d, limbs of %2d bits\n", int(N), int(M), int(mul.GetFFTSize()), mul.GetLimbBits());
+
+			// Polynomials, long long wraps around as the product does
+			std::fill(arPRef.begin(), arPRef.end(), 0LL);
+			for (i = 0; i < N; i++)
+				for (j = 0; j < M; j++)
+					arPRef[i + j] = (long long) ((unsigned long long) arPRef[i + j] +
+						(unsigned long long) arPA[i] * (unsigned long long) arPB[j]);
+			TEST(mul.MultiplyPoly(&arPA[0], &arPB[0], &arPRes[0]) == 0);
+			TEST(arPRes == arPRef);
+			// Small signed coefficients give the exact product
+			for (i = 0; i < N; i++)
+				arPA[i] = (long long) (arA[i] % 2001) - 1000;
+			for (i = 0; i < M; i++)
+				arPB[i] = -(long long) (arB[i] >> 1);
+			std::fill(arPRef.begin(), arPRef.end(), 0LL);
+			for (i = 0; i < N; i++)
+				for (j = 0; j < M; j++)
+					arPRef[i + j] += arPA[i] * arPB[j];
+			TEST(mul.MultiplyPoly(&arPA[0], &arPB[0], &arPRes[0]) == 0);
+			TEST(arPRes == arPRef);
+
+			// Modular, the factors aren't reduced
+			for (size_t m = 0; m < sizeof(arMod) / sizeof(arMod[0]); m++)
+			{
+				unsigned long long nMod = arMod[m];
+				std::fill(arRef.begin(), arRef.end(), 0u);
+				for (i = 0; i < N; i++)
+					for (j = 0; j < M; j++)
+						arRef[i + j] = (unsigned int) ((arRef[i + j] + arA[i] % nMod * (arB[j] % nMod)) % nMod);
+				arRes[N + M - 1] = arRef[N + M - 1] = 0;
+				TEST(mul.MultiplyMod(&arA[0], &arB[0], arMod[m], &arRes[0]) == 0);
+				TEST(arRes == arRef);
+			}
+
+			// Big integers: random limbs, then all limbs 0xFFFFFFFF (every convolution at its maximum)
+			for (int nFill = 0; nFill < 2; nFill++)
+			{
+				if (nFill != 0)
+				{
+					std::fill(arA.begin(), arA.end(), 0xFFFFFFFFu);
+					std::fill(arB.begin(), arB.end(), 0xFFFFFFFFu);
+				}
+				std::fill(arRef.begin(), arRef.end(), 0u);
+				for (i = 0; i < N; i++)
+				{
+					unsigned long long nCarry = 0;
+					for (j = 0; j < M; j++)
+					{
+						nCarry += (unsigned long long) arA[i] * arB[j] + arRef[i + j];
+						arRef[i + j] = (unsigned int) nCarry;
+						nCarry >>= 32;
+					}
+					arRef[i + M] = (unsigned int) nCarry;
+				}
+				TEST(mul.MultiplyBig(&arA[0], &arB[0], &arRes[0]) == 0);
+				TEST(arRes == arRef);
+			}
+		}
+
+		// Squares run half of the forward transforms
+		{
+			const size_t N = 2500;
+			std::vector<unsigned int> arA(N), arRes(2 * N), arRef(2 * N, 0u);
+			make_test_words(N, &arA[0], 77);
+			for (i = 0; i < N; i++)
+			{
+				unsigned long long nCarry = 0;
+				for (j = 0; j < N; j++)
+				{
+					nCarry += (unsigned long long) arA[i] * arA[j] + arRef[i + j];
+					arRef[i + j] = (unsigned int) nCarry;
+					nCarry >>= 32;
+				}
+				arRef[i + N] = (unsigned int) nCarry;
+			}
+			CFFTMultiplier mul;
+			TEST(mul.Create(N) == 0);
+			TEST(mul.GetSize2() == N);
+			TEST(mul.MultiplyBig(&arA[0], &arA[0], &arRes[0]) == 0);
+			TEST(arRes == arRef);
+		}
+
+		CFFTMultiplier mul;
+		long long nA = 3;
+		unsigned int nU = 3;
+		TEST(mul.MultiplyPoly(&nA, &nA, &nA) == -1);
+		TEST(mul.Create(0) == -1);
+		TEST(mul.Create(1) == 0);
+		TEST(mul.MultiplyMod(&nU, &nU, 0, &nU) == -2);
+		TEST(mul.MultiplyMod(&nU, &nU, 7, &nU) == 0);
+		TEST(nU == 2);
+	}
+
+	printf("\nPruned FFT (input length, output bins)\n");
+	{
+		// nInCnt, nSize, nFirstBin, nOutCnt: direct sums, inputs pruned, outputs pruned, all bins
+		size_t arCase[][4] = {{10, 1024, 3, 5}, {1, 8, 0, 8}, {1000, 65536, 0, 512}, {300, 16384, 16000, 384},
+			{65536, 65536, 100, 64}, {5000, 8192, 8000, 192}, {1024, 1024, 0, 1024}, {3, 0, 0, 4}, {700, 0, 17, 1000}};
+		size_t t, i;
+		for (t = 0; t < sizeof(arCase) / sizeof(arCase[0]); t++)
+		{
+			size_t nIn = arCase[t][0], k0 = arCase[t][2], M = arCase[t][3];
+			size_t N = arCase[t][1];
+			if (N == 0)
+				for (N = 2; N < nIn; N <<= 1);
+			std::vector<double> arX(2 * nIn);
+			std::vector<std::complex<double> > arCX(nIn), arRes(M), arRef;
+			std::vector<std::complex<float> > arFX(nIn), arFRes(M);
+			std::vector<float> arFReal(nIn);
+			make_test_signal(2 * nIn, &arX[0], (unsigned int) (nIn + t));
+			for (i = 0; i < nIn; i++)
+			{
+				arCX[i] = std::complex<double>(arX[2 * i], arX[2 * i + 1]);
+				arFX[i] = std::complex<float>(arCX[i]);
+				arFReal[i] = float(arX[2 * i]);
+			}
+
+			double fErr = 0., fErrReal = 0., fErrFloat = 0.;
+			for (int nMode = 0; nMode < 4; nMode++)
+			{
+				bool bInverse = (nMode & 1) != 0, bOrthNorm = nMode < 2;
+				CFFTPlan plan;
+				TEST(plan.Create(CFFTPlan::COMPLEX, N, bInverse, bOrthNorm) == 0);
+				TEST(plan.Execute(nIn, &arCX[0], arRef) == 0);
+				// Unnormalized values are up to nIn
+				double fTol = bOrthNorm || bInverse ? 1. : double(N);
+				TEST(FFT(nIn, &arCX[0], arCase[t][1], k0, M, &arRes[0], bInverse, bOrthNorm) == 0);
+				fErr = std::max(fErr, max_abs_diff(M, &arRef[k0], &arRes[0]) * fTol);
+				TEST(FFT(nIn, &arFX[0], arCase[t][1], k0, M, &arFRes[0], bInverse, bOrthNorm) == 0);
+				fErrFloat = std::max(fErrFloat, max_abs_diff(M, &arRef[k0], &arFRes[0]) * fTol);
+
+				std::vector<double> arReal(arX.begin(), arX.begin() + nIn);
+				for (i = 0; i < nIn; i++)
+					arReal[i] = arX[2 * i];
+				TEST(plan.Execute(nIn, &arReal[0], arRef) == 0);
+				TEST(FFT(nIn, &arReal[0], arCase[t][1], k0, M, &arRes[0], bInverse, bOrthNorm) == 0);
+				fErrReal = std::max(fErrReal, max_abs_diff(M, &arRef[k0], &arRes[0]) * fTol);
+				TEST(FFT(nIn, &arFReal[0], arCase[t][1], k0, M, &arFRes[0], bInverse, bOrthNorm) == 0);
+				fErrFloat = std::max(fErrFloat, max_abs_diff(M, &arRef[k0], &arFRes[0]) * fTol);
+			}
+			printf("in=%5d N=%5d bins %5d..%5d max.err=%g, real %g, float %g\n", int(nIn), int(N), int(k0),
+				int(k0 + M - 1), fErr, fErrReal, fErrFloat);
+			TEST(fErr < 1e-12 * ::sqrt(double(nIn)));
+			TEST(fErrReal < 1e-12 * ::sqrt(double(nIn)));
+			TEST(fErrFloat < 1e-5 * ::sqrt(double(nIn)));
+		}
+
+		std::complex<double> arC[8];
+		TEST(FFT(0, arC, 8, 0, 8, arC, false) == -1);
+		TEST(FFT(4, arC, 6, 0, 4, arC, false) == -2);
+		TEST(FFT(8, arC, 4, 0, 4, arC, false) == -2);
+		TEST(FFT(4, arC, 8, 4, 5, arC, false) == -3);
+		TEST(FFT(4, arC, 8, 8, 0, arC, false) == 0);
+	}
+
+	printf("\nFilterbank (mel, bark, gammatone) and windows\n");
+	{
+		// Windows against their formulas, periodic (length N) and symmetric (length N-1)
+		const size_t N = 16;
+		double arW[N];
+		float arFW[N];
+		size_t n, i;
+		TEST(CFFTWindow::Make(CFFTWindow::HANN, N, arW) == 0);
+		double fErr = 0.;
+		for (n = 0; n < N; n++)
+			fErr = std::max(fErr, ::fabs(arW[n] - 0.5 * (1. - cos(2. * const_PI * double(n) / double(N)))));
+		TEST(CFFTWindow::Make(CFFTWindow::HAMMING, N, arW, false) == 0);
+		for (n = 0; n < N; n++)
+			fErr = std::max(fErr, ::fabs(arW[n] - (0.54 - 0.46 * cos(2. * const_PI * double(n) / double(N - 1)))));
+		TEST(::fabs(arW[0] - arW[N - 1]) < 1e-15);
+		TEST(CFFTWindow::Make(CFFTWindow::BLACKMAN_HARRIS, N, arW, false) == 0);
+		fErr = std::max(fErr, ::fabs(arW[0] - 6e-5));
+		TEST(CFFTWindow::Make(CFFTWindow::SINE, N, arW) == 0);
+		for (n = 0; n < N; n++)
+			fErr = std::max(fErr, ::fabs(arW[n] - sin(const_PI * (double(n) + 0.5) / double(N + 1))));
+		TEST(CFFTWindow::Make(CFFTWindow::BLACKMAN, N, arFW) == 0);
+		for (n = 0; n < N; n++)
+		{
+			double x = 2. * const_PI * double(n) / double(N);
+			fErr = std::max(fErr, ::fabs(arFW[n] - (0.42 - 0.5 * cos(x) + 0.08 * cos(2. * x))) * 1e-8);
+		}
+		TEST(CFFTWindow::Make(CFFTWindow::RECTANGULAR, N, arW) == 0);
+		for (n = 0; n < N; n++)
+			fErr = std::max(fErr, ::fabs(arW[n] - 1.));
+		printf("windows max.err=%g\n", fErr);
+		TEST(fErr < 1e-12);
+		TEST(CFFTWindow::Make(CFFTWindow::HANN, 0, arW) == -1);
+		TEST(CFFTWindow::Make(CFFTWindow::TWindow(17), N, arW) == -2);
+
+		// Scales: Apply() against the dense product with the weights, Process() against window + plan + Apply()
+		const double fRate = 16000.;
+		size_t arCase[][3] = {{512, 40, CFilterbank::MEL}, {1024, 24, CFilterbank::BARK}, {2048, 64, CFilterbank::GAMMATONE},
+			{256, 1, CFilterbank::GAMMATONE}, {4096, 128, CFilterbank::MEL}};
+		size_t t;
+		for (t = 0; t < sizeof(arCase) / sizeof(arCase[0]); t++)
+		{
+			const size_t nFFT = arCase[t][0], nBands = arCase[t][1];
+			const CFilterbank::TScale eScale = CFilterbank::TScale(arCase[t][2]);
+			CFilterbank bank;
+			CFilterbankF bankF;
+			TEST(bank.Create(eScale, nFFT, fRate, nBands) == 0);
+			TEST(bankF.Create(CFilterbankF::TScale(eScale), nFFT, fRate, nBands) == 0);
+			TEST(bank.GetBands() == nBands && bank.GetBins() == nFFT / 2 + 1 && bank.GetFFTSize() == nFFT);
+
+			// Dense matrix of the weights
+			std::vector<double> arDense(nBands * bank.GetBins(), 0.);
+			size_t nWeights = 0;
+			double fMax = 0., fMin = 1.;
+			for (i = 0; i < nBands; i++)
+			{
+				const unsigned int *pBins;
+				const double *pWeights;
+				size_t nCnt = bank.GetWeights(i, pBins, pWeights);
+				for (n = 0; n < nCnt; n++)
+				{
+					arDense[i * bank.GetBins() + pBins[n]] = pWeights[n];
+					fMax = std::max(fMax, pWeights[n]);
+					fMin = std::min(fMin, pWeights[n]);
+				}
+				nWeights += nCnt;
+				TEST(i == 0 || bank.GetCenterFrequency(i) > bank.GetCenterFrequency(i - 1));
+			}
+			TEST(fMax <= 1. && fMin > 0.);
+			if (eScale == CFilterbank::GAMMATONE)
+				TEST(fMin >= 1e-4);
+
+			// Triangles sum to 1 between the first and the last center
+			double fSumErr = 0.;
+			if (eScale != CFilterbank::GAMMATONE)
+				for (n = 0; n < bank.GetBins(); n++)
+				{
+					double f = double(n) * fRate / double(nFFT);
+					if (f < bank.GetCenterFrequency(0) || f > bank.GetCenterFrequency(nBands - 1)) continue;
+					double s = 0.;
+					for (i = 0; i < nBands; i++)
+						s += arDense[i * bank.GetBins() + n];
+					fSumErr = std::max(fSumErr, ::fabs(s - 1.));
+				}
+			TEST(fSumErr < 1e-12);
+
+			std::vector<double> arFrame(nFFT), arBands(nBands), arRef(nBands);
+			std::vector<float> arFFrame(nFFT), arFBands(nBands);
+			std::vector<std::complex<double> > arSpec(nFFT / 2 + 1);
+			make_test_signal(nFFT, &arFrame[0], (unsigned int) (t + 5));
+			for (n = 0; n < nFFT; n++)
+				arFFrame[n] = float(arFrame[n]);
+
+			std::vector<double> arWin(nFFT), arX(nFFT);
+			CFFTWindow::Make(CFFTWindow::HANN, nFFT, &arWin[0]);
+			for (n = 0; n < nFFT; n++)
+				arX[n] = arFrame[n] * arWin[n];
+			CFFTPlan plan;
+			TEST(plan.Create(CFFTPlan::REAL, nFFT, false, true) == 0);
+			TEST(plan.Execute(&arX[0], &arSpec[0]) == 0);
+			double fScale = 0.;
+			for (i = 0; i < nBands; i++)
+			{
+				double s = 0.;
+				for (n = 0; n < bank.GetBins(); n++)
+					s += arDense[i * bank.GetBins() + n] * std::norm(arSpec[n]);
+				arRef[i] = s;
+				fScale = std::max(fScale, s);
+			}
+
+			TEST(bank.Apply(&arSpec[0], &arBands[0]) == 0);
+			double fErrApply = max_abs_diff(nBands, &arBands[0], &arRef[0]) / fScale;
+			TEST(bank.Process(&arFrame[0], &arBands[0]) == 0);
+			double fErrProcess = max_abs_diff(nBands, &arBands[0], &arRef[0]) / fScale;
+			TEST(bankF.Process(&arFFrame[0], &arFBands[0]) == 0);
+			double fErrFloat = max_abs_diff(nBands, &arFBands[0], &arRef[0]) / fScale;
+			printf("%-9s N=%5d bands=%4d weights=%6d max.err=%g, process %g, float %g\n",
+				eScale == CFilterbank::MEL ? "mel" : eScale == CFilterbank::BARK ? "bark" : "gammatone",
+				int(nFFT), int(nBands), int(nWeights), fErrApply, fErrProcess, fErrFloat);
+			TEST(fErrApply < 1e-14);
+			TEST(fErrProcess < 1e-12);
+			TEST(fErrFloat < 1e-5);
+
+			// No window: the spectrum of the frame itself
+			TEST(bank.SetWindow(NULL) == 0);
+			TEST(plan.Execute(&arFrame[0], &arSpec[0]) == 0);
+			TEST(bank.Apply(&arSpec[0], &arRef[0]) == 0);
+			TEST(bank.Process(&arFrame[0], &arBands[0]) == 0);
+			TEST(max_abs_diff(nBands, &arBands[0], &arRef[0]) < 1e-12 * (1. + arRef[0]));
+		}
+
+		// Given weights: two bands over bins {1, 2} and {0, 4}
+		{
+			size_t arRow[] = {0, 2, 4}, arBin[] = {1, 2, 0, 4}, arBad[] = {1, 2, 0, 5};
+			double arWeight[] = {0.5, 2., 1., 3.};
+			std::complex<double> arSpec[5] = {std::complex<double>(1., 0.), std::complex<double>(0., 2.),
+				std::complex<double>(1., 1.), std::complex<double>(5., 5.), std::complex<double>(-1., 0.)};
+			double arBands[2];
+			CFilterbank bank;
+			TEST(bank.Apply(arSpec, arBands) == -1);
+			TEST(bank.Process(arBands, arBands) == -1);
+			TEST(bank.SetWindow(NULL) == -1);
+			TEST(bank.Create(8, 2, arRow, arBad, arWeight) == -2);
+			TEST(bank.Create(8, 2, arRow, arBin, arWeight) == 0);
+			TEST(bank.GetBands() == 2 && bank.GetCenterFrequency(0) == 0.);
+			TEST(bank.Apply(arSpec, arBands) == 0);
+			TEST(arBands[0] == 0.5 * 4. + 2. * 2. && arBands[1] == 1. + 3.);
+			TEST(bank.Create(CFilterbank::MEL, 512, 16000., 0) == -1);
+			TEST(bank.Create(CFilterbank::MEL, 512, 0., 10) == -1);
+			TEST(bank.Create(CFilterbank::MEL, 512, 16000., 10, 100., 9000.) == -2);
+			TEST(bank.Create(CFilterbank::BARK, 512, 16000., 10, 3000., 2000.) == -2);
+			TEST(bank.GetBands() == 0);
+			TEST(bank.Create(CFilterbank::MEL, 0, 16000., 2) != 0);
+		}
+	}
+
+	printf("\nHilbert transform, analytic signal and envelope\n");
+	{
+		// Reference: complex transform, negative frequencies zeroed, positive ones doubled, inverse
+		size_t arSize[] = {2, 3, 7, 16, 100, 1000, 1024, 4095, 4096, 1 << 16};
+		size_t t, n;
+		for (t = 0; t < sizeof(arSize) / sizeof(arSize[0]); t++)
+		{
+			const size_t N = arSize[t];
+			std::vector<double> arX(N), arH(N), arEnv(N), arRefH(N), arRefEnv(N);
+			std::vector<float> arFX(N), arFH(N);
+			std::vector<std::complex<double> > arZ(N), arRef(N);
+			make_test_signal(N, &arX[0], (unsigned int) (N + 11));
+			for (n = 0; n < N; n++)
+				arFX[n] = float(arX[n]);
+
+			CFFTPlan fwd, inv;
+			TEST(fwd.Create(CFFTPlan::COMPLEX, N, false, false) == 0);
+			TEST(inv.Create(CFFTPlan::COMPLEX, N, true, false) == 0);
+			TEST(fwd.Execute(&arX[0], &arRef[0]) == 0);
+			for (n = 1; n < N; n++)
+				if (2 * n < N)
+					arRef[n] *= 2.;
+				else if (2 * n > N)
+					arRef[n] = 0.;
+			TEST(inv.Execute(&arRef[0]) == 0);
+			for (n = 0; n < N; n++)
+			{
+				arRefH[n] = arRef[n].imag();
+				arRefEnv[n] = std::abs(arRef[n]);
+			}
+
+			CHilbert hilbert;
+			CHilbertF hilbertF;
+			TEST(hilbert.Create(N) == 0);
+			TEST(hilbertF.Create(N) == 0);
+			TEST(hilbert.GetSize() == N);
+			TEST(hilbert.Hilbert(&arX[0], &arH[0]) == 0);
+			double fErr = max_abs_diff(N, &arH[0], &arRefH[0]);
+			TEST(hilbert.Analytic(&arX[0], &arZ[0]) == 0);
+			double fErrZ = max_abs_diff(N, &arZ[0], &arRef[0]);
+			TEST(hilbert.Envelope(&arX[0], &arEnv[0]) == 0);
+			double fErrEnv = max_abs_diff(N, &arEnv[0], &arRefEnv[0]);
+			TEST(hilbertF.Hilbert(&arFX[0], &arFH[0]) == 0);
+			double fErrFloat = max_abs_diff(N, &arFH[0], &arRefH[0]);
+
+			// In place
+			arH = arX;
+			TEST(hilbert.Hilbert(&arH[0], &arH[0]) == 0);
+			fErr = std::max(fErr, max_abs_diff(N, &arH[0], &arRefH[0]));
+			arEnv = arX;
+			TEST(hilbert.Envelope(&arEnv[0], &arEnv[0]) == 0);
+			fErrEnv = std::max(fErrEnv, max_abs_diff(N, &arEnv[0], &arRefEnv[0]));
+			printf("N=%6d max.err=%g, analytic %g, envelope %g, float %g\n", int(N), fErr, fErrZ, fErrEnv, fErrFloat);
+			TEST(fErr < 1e-14 * ::sqrt(double(N) + 1.));
+			TEST(fErrZ < 1e-14 * ::sqrt(double(N) + 1.));
+			TEST(fErrEnv < 1e-14 * ::sqrt(double(N) + 1.));
+			TEST(fErrFloat < 1e-6 * ::sqrt(double(N) + 1.));
+		}
+
+		// cos -> sin, the envelope of an AM tone is its modulation
+		{
+			const size_t N = 1000;
+			std::vector<double> arX(N), arH(N), arEnv(N);
+			double fErr = 0., fErrEnv = 0.;
+			for (n = 0; n < N; n++)
+				arX[n] = (1. + 0.5 * cos(2. * const_PI * 3. * double(n) / double(N))) *
+					cos(2. * const_PI * 50. * double(n) / double(N));
+			CHilbert hilbert;
+			TEST(hilbert.Create(N) == 0);
+			TEST(hilbert.Envelope(&arX[0], &arEnv[0]) == 0);
+			for (n = 0; n < N; n++)
+				fErrEnv = std::max(fErrEnv, ::fabs(arEnv[n] - (1. + 0.5 * cos(2. * const_PI * 3. * double(n) / double(N)))));
+			for (n = 0; n < N; n++)
+				arX[n] = cos(2. * const_PI * 17. * double(n) / double(N));
+			TEST(hilbert.Hilbert(&arX[0], &arH[0]) == 0);
+			for (n = 0; n < N; n++)
+				fErr = std::max(fErr, ::fabs(arH[n] - sin(2. * const_PI * 17. * double(n) / double(N))));
+			printf("cos -> sin max.err=%g, AM envelope %g\n", fErr, fErrEnv);
+			TEST(fErr < 1e-13);
+			TEST(fErrEnv < 1e-13);
+		}
+
+		CHilbert hilbert;
+		double x = 1.;
+		std::complex<double> z;
+		TEST(hilbert.Hilbert(&x, &x) == -1);
+		TEST(hilbert.Envelope(&x, &x) == -1);
+		TEST(hilbert.Analytic(&x, &z) == -1);
+		TEST(hilbert.Create(1) == -1);
+		TEST(hilbert.GetSize() == 0);
+	}
+
+	printf("\nFFT planner\n");
+	{
+		const char *pFileName = "fft_wisdom_test.txt";
+		size_t arSizes[] = {1024, 960, 1000, 4096};
+		CFFTPlanBase::TAlgorithm arAlg[4];
+		size_t k, j;
+		CFFTPlanBase::ForgetWisdom();
+		TEST(CFFTPlanBase::GetPlanner() == CFFTPlanBase::ESTIMATE);
+		CFFTPlanBase::SetPlanner(CFFTPlanBase::MEASURE);
+		TEST(CFFTPlanBase::GetPlanner() == CFFTPlanBase::MEASURE);
+		for (k = 0; k < sizeof(arSizes) / sizeof(arSizes[0]); k++)
+		{
+			size_t N = arSizes[k];
+			std::vector<std::complex<double> > arCX(N), arCRef(N), arCRes(N);
+			for (j = 0; j < N; j++)
+				arCX[j] = std::complex<double>(sin(0.1 * double(j)), double(j % 5));
+			CFFTPlan plan, tplan;
+			TEST(tplan.Create(CFFTPlan::COMPLEX, N, false) == 0);
+			arAlg[k] = tplan.GetAlgorithm();
+			TEST(arAlg[k] != CFFTPlan::FOUR_STEP);
+			if (N == 1000)
+				TEST(arAlg[k] == CFFTPlan::MIXED_RADIX || arAlg[k] == CFFTPlan::BLUESTEIN);
+			CFFTPlanBase::SetPlanner(CFFTPlanBase::ESTIMATE);
+			TEST(plan.Create(CFFTPlan::COMPLEX, N, false) == 0);
+			CFFTPlanBase::SetPlanner(CFFTPlanBase::MEASURE);
+			// Wisdom is used by later plans with either planner
+			TEST(plan.GetAlgorithm() == arAlg[k]);
+			TEST(tplan.Execute(&arCX[0], &arCRes[0]) == 0);
+			do_complex_dft_slow(false, N, &arCX[0], &arCRef[0]);
+			for (j = 0; j < N; j++)
+				arCRef[j] *= ::sqrt(1. / double(N));
+			TEST(max_abs_diff(N, &arCRef[0], &arCRes[0]) < 1e-12);
+			printf("N=%4d %s\n", int(N), arAlgorithmNames[arAlg[k]]);
+		}
+		// Real transform of 4096 points runs a tuned 2048-point one, float has its own wisdom
+		std::vector<double> arX(4096), arRes(4096);
+		std::vector<std::complex<double> > arCRef, arCRes(2049);
+		make_test_signal(4096, &arX[0], 17);
+		CFFTPlan rplan;
+		TEST(rplan.Create(CFFTPlan::REAL, 4096, false) == 0);
+		TEST(rplan.Execute(&arX[0], &arCRes[0]) == 0);
+		TEST(RFFT(arX, arCRef) == 0);
+		TEST(max_abs_diff(2049, &arCRef[0], &arCRes[0]) < 1e-10);
+		CFFTPlanF fplan;
+		TEST(fplan.Create(CFFTPlanF::COMPLEX, 960, false) == 0);
+		CFFTPlanBase::SetPlanner(CFFTPlanBase::ESTIMATE);
+
+		// SetAlgorithm() takes precedence over wisdom
+		CFFTPlan plan;
+		TEST(plan.SetAlgorithm(arAlg[0] == CFFTPlan::STOCKHAM ? CFFTPlan::RADIX2 : CFFTPlan::STOCKHAM) == 0);
+		TEST(plan.Create(CFFTPlan::COMPLEX, 1024, false) == 0);
+		TEST(plan.GetAlgorithm() == (arAlg[0] == CFFTPlan::STOCKHAM ? CFFTPlan::RADIX2 : CFFTPlan::STOCKHAM));
+
+		// Save, forget, load
+		TEST(CFFTPlanBase::SaveWisdom(pFileName) == 0);
+		CFFTPlanBase::ForgetWisdom();
+		TEST(plan.Create(CFFTPlan::COMPLEX, 960, false) == 0);
+		TEST(plan.GetAlgorithm() == CFFTPlan::MIXED_RADIX);
+		TEST(CFFTPlanBase::LoadWisdom(pFileName) == 0);
+		for (k = 0; k < sizeof(arSizes) / sizeof(arSizes[0]); k++)
+		{
+			CFFTPlan lplan;
+			TEST(lplan.Create(CFFTPlan::COMPLEX, arSizes[k], false) == 0);
+			TEST(lplan.GetAlgorithm() == arAlg[k]);
+		}
+		TEST(CFFTPlanBase::LoadWisdom("no_such_dir/fft_wisdom.txt") == -1);
+		TEST(CFFTPlanBase::SaveWisdom("no_such_dir/fft_wisdom.txt") == -1);
+		FILE *f = fopen(pFileName, "w");
+		TEST(f != NULL);
+		if (f != NULL)
+		{
+			fprintf(f, "fft_wisdom 1 %s\n8 1024 RADIX3\n", arSimdNames[CFFTPlanBase::GetSupportedSimd()]);
+			fclose(f);
+		}
+		TEST(CFFTPlanBase::LoadWisdom(pFileName) == -2);
+		f = fopen(pFileName, "w");
+		TEST(f != NULL);
+		if (f != NULL)
+		{
+			fprintf(f, "fft_wisdom 1 none\n8 1024 STOCKHAM\n");
+			fclose(f);
+		}
+		TEST(CFFTPlanBase::LoadWisdom(pFileName) == -3);
+
+		// Plans restricted by SetSimd() or SetThreads() leave no wisdom
+		CFFTPlanBase::ForgetWisdom();
+		CFFTPlanBase::SetPlanner(CFFTPlanBase::MEASURE);
+		CFFTPlan splan, mplan;
+		TEST(splan.SetSimd(CFFTPlanBase::SIMD_SCALAR) == 0);
+		TEST(splan.Create(CFFTPlan::COMPLEX, 960, false) == 0);
+		TEST(mplan.SetThreads(2) == 0);
+		TEST(mplan.Create(CFFTPlan::COMPLEX, 1000, false) == 0);
+		CFFTPlanBase::SetPlanner(CFFTPlanBase::ESTIMATE);
+		TEST(CFFTPlanBase::SaveWisdom(pFileName) == 0);
+		f = fopen(pFileName, "r");
+		TEST(f != NULL);
+		if (f != NULL)
+		{
+			int nLines = 0, c;
+			while ((c = fgetc(f)) != EOF)
+				nLines += (c == '\n');
+			fclose(f);
+			TEST(nLines == (CFFTPlanBase::GetSupportedSimd() == CFFTPlanBase::SIMD_SCALAR ? 2 : 1));
+		}
+		remove(pFileName);
+		CFFTPlanBase::ForgetWisdom();
+		printf("%d tests, %d failed\n", nTestNum, nTestErrNum);
+	}
+
+	return 0;
+}
+
+// Reference transform in long double (radix-2, directly computed twiddles). Not normalized
+static void do_fft_long_double(size_t n, std::complex<long double> *a)
+{
+	size_t i, j, k, L;
+	for (i = 0, j = 0; i < n; i++)
+	{
+		if (i < j)
+			std::swap(a[i], a[j]);
+		for (k = n >> 1; k >= 1 && (j & k) != 0; k >>= 1)
+			j ^= k;
+		j |= k;
+	}
+
+	std::vector<std::complex<long double> > w(n / 2);
+	for (k = 0; k < n / 2; k++)
+	{
+		long double c, s;
+		do_twiddle(k, n, c, s);
+		w[k] = std::complex<long double>(c, -s);
+	}
+	for (L = 1; L < n; L *= 2)
+	{
+		for (i = 0; i < n; i += 2 * L)
+		{
+			for (k = 0; k < L; k++)
+			{
+				std::complex<long double> t = w[k * (n / (2 * L))] * a[i + k + L];
+				a[i + k + L] = a[i + k] - t;
+				a[i + k] += t;
+			}
+		}
+	}
+}
+
+// Plan and buffer of the benchmark kernels
+static CFFTPlan *pBenchPlan = NULL;
+static std::complex<double> *pBenchData = NULL;
+
+static void bench_execute()
+{
+	pBenchPlan->Execute(pBenchData);
+}
+
+// Split arrays of the same data, the interleaved layout converts them both ways
+static double *pBenchRe = NULL;
+static double *pBenchIm = NULL;
+
+static void bench_split()
+{
+	pBenchPlan->ExecuteSplit(pBenchRe, pBenchIm, pBenchRe, pBenchIm);
+}
+
+// 16-bit samples: Q15 transform against conversion to double and a plan
+static CFFTFixedQ15 *pBenchQ15 = NULL;
+static short *pBenchSamples = NULL;
+static short *pBenchQ15Data = NULL;
+
+static void bench_q15()
+{
+	int nExponent;
+	memcpy(pBenchQ15Data, pBenchSamples, 2 * pBenchQ15->GetSize() * sizeof(short));
+	pBenchQ15->Execute(pBenchQ15Data, nExponent);
+}
+
+static void bench_q15_as_double()
+{
+	size_t i, N = pBenchPlan->GetSize();
+	for (i = 0; i < N; i++)
+		pBenchData[i] = std::complex<double>(pBenchSamples[2 * i], pBenchSamples[2 * i + 1]);
+	pBenchPlan->Execute(pBenchData);
+}
+
+static void bench_interleaved()
+{
+	size_t i, N = pBenchPlan->GetSize();
+	for (i = 0; i < N; i++)
+		pBenchData[i] = std::complex<double>(pBenchRe[i], pBenchIm[i]);
+	pBenchPlan->Execute(pBenchData);
+	for (i = 0; i < N; i++)
+	{
+		pBenchRe[i] = pBenchData[i].real();
+		pBenchIm[i] = pBenchData[i].imag();
+	}
+}
+
+
+// Small transforms: nBenchReps in place transforms of nBenchSmall points per kernel call
+static const int nBenchReps = 10000;
+static size_t nBenchSmall = 0;
+static CFFTMultiplier *pBenchMul = NULL;
+static size_t nBenchLimbs = 0;
+static unsigned int *pBenchA = NULL;
+static unsigned int *pBenchB = NULL;
+static unsigned int *pBenchProduct = NULL;
+
+static void bench_multiply_fft()
+{
+	pBenchMul->MultiplyBig(pBenchA, pBenchB, pBenchProduct);
+}
+
+static void bench_multiply_loop()
+{
+	const size_t N = nBenchLimbs;
+	size_t i, j;
+	memset(pBenchProduct, 0, 2 * N * sizeof(unsigned int));
+	for (i = 0; i < N; i++)
+	{
+		unsigned long long nCarry = 0;
+		for (j = 0; j < N; j++)
+		{
+			nCarry += (unsigned long long) pBenchA[i] * pBenchB[j] + pBenchProduct[i + j];
+			pBenchProduct[i + j] = (unsigned int) nCarry;
+			nCarry >>= 32;
+		}
+		pBenchProduct[i + N] = (unsigned int) nCarry;
+	}
+}
+
+static size_t arBenchPruned[4] = {0, 0, 0, 0};    // nInCnt, nSize, nFirstBin, nOutCnt
+static std::vector<std::complex<double> > *pBenchOutput = NULL;
+
+static void bench_pruned()
+{
+	FFT(arBenchPruned[0], pBenchData, arBenchPruned[1], arBenchPruned[2], arBenchPruned[3], &(*pBenchOutput)[0], false);
+}
+
+static void bench_padded()
+{
+	FFT(arBenchPruned[1], pBenchData, *pBenchOutput, false);
+}
+
+static CFilterbank *pBenchBank = NULL;
+static const std::vector<double> *pBenchDense = NULL;    // bands x bins
+static std::vector<std::complex<double> > *pBenchSpectrum = NULL;
+static std::vector<double> *pBenchBands = NULL;
+static const double *pBenchFrame = NULL;
+
+static void bench_filterbank_dense()
+{
+	const size_t nBins = pBenchSpectrum->size(), nBands = pBenchBands->size();
+	std::vector<double> arPower(nBins);
+	size_t b, k;
+	for (k = 0; k < nBins; k++)
+		arPower[k] = std::norm((*pBenchSpectrum)[k]);
+	for (b = 0; b < nBands; b++)
+	{
+		const double *pRow = &(*pBenchDense)[b * nBins];
+		double s = 0.;
+		for (k = 0; k < nBins; k++)
+			s += pRow[k] * arPower[k];
+		(*pBenchBands)[b] = s;
+	}
+}
+
+static void bench_filterbank_apply()
+{
+	pBenchBank->Apply(&(*pBenchSpectrum)[0], &(*pBenchBands)[0]);
+}
+
+static void bench_filterbank_process()
+{
+	pBenchBank->Process(pBenchFrame, &(*pBenchBands)[0]);
+}
+
+static double *pBenchSignal = NULL;
+static std::vector<double> *pBenchEnvelope = NULL;
+static CHilbert *pBenchHilbert = NULL;
+static CFFTPlan *pBenchInverse = NULL;
+static std::vector<std::complex<double> > *pBenchAnalytic = NULL;
+
+static void do_bench_one_sided(std::vector<std::complex<double> > &arZ)
+{
+	const size_t N = arZ.size();
+	size_t k;
+	for (k = 1; k < N; k++)
+		if (2 * k < N)
+			arZ[k] *= 2.;
+		else if (2 * k > N)
+			arZ[k] = 0.;
+}
+
+// FFT() of the signal, a copy with the negative frequencies zeroed, FFT() back
+static void bench_envelope_fft()
+{
+	const size_t N = pBenchEnvelope->size();
+	std::vector<std::complex<double> > arSpec, arZ;
+	FFT(N, pBenchSignal, arSpec, false, false);
+	arZ = arSpec;
+	do_bench_one_sided(arZ);
+	FFT(N, &arZ[0], arSpec, true, false);
+	size_t n;
+	for (n = 0; n < N; n++)
+		(*pBenchEnvelope)[n] = std::abs(arSpec[n]);
+}
+
+// The same with COMPLEX plans and preallocated buffers
+static void bench_envelope_plan()
+{
+	const size_t N = pBenchEnvelope->size();
+	std::vector<std::complex<double> > &arZ = *pBenchAnalytic;
+	pBenchPlan->Execute(pBenchSignal, &arZ[0]);
+	do_bench_one_sided(arZ);
+	pBenchInverse->Execute(&arZ[0]);
+	size_t n;
+	for (n = 0; n < N; n++)
+		(*pBenchEnvelope)[n] = std::abs(arZ[n]);
+}
+
+static void bench_envelope_hilbert()
+{
+	pBenchHilbert->Envelope(pBenchSignal, &(*pBenchEnvelope)[0]);
+}
+
+static double *pBenchSmall = NULL;
+
+static void bench_codelet()
 {
 	int i;
-	double x[USE_N], sx[USE_N], xx[USE_N], dct_slow[USE_N], idct_slow[USE_N];// , s[USE_N], y[USE_N];
-	std::vector<double> s, y, t2, t3, f;
+	for (i = 0; i < nBenchReps; i++)
+		do_fft_codelet(nBenchSmall, pBenchSmall, pBenchSmall, false);
+}
 
-	x[0] = 4.;
-	x[1] = 3.;
-	x[2] = 5.;
-	x[3] = 10.;
-	FDCT2(false, 4, x, sx);
-	FDCT2(true, 4, sx, xx);
-	FDCT(4, x, t2, false, true);
-	FDCT(4, &t2[0], t3, true, true);
-	do_real_dct_slow(false, 4, x, dct_slow);
-	do_real_dct_slow(true, 4, dct_slow, idct_slow);
+static void bench_dft_loop()
+{
+	int i;
+	double w = const_PI / double(nBenchSmall);
+	for (i = 0; i < nBenchReps; i++)
+		do_complex_dft_loop(int(2 * nBenchSmall), cos(w), -sin(w), pBenchSmall);
+}
+int run_FFT_benchmark()
+{
+	printf("\nFour-step FFT scaling\n");
+	{
+		const size_t N = size_t(1) << 22;
+		int nMaxThreads = int(std::thread::hardware_concurrency());
+		if (nMaxThreads < 2)
+			nMaxThreads = 2;
+		printf("%d hardware threads\n", int(std::thread::hardware_concurrency()));
 
-	// Check DCT (slow version)
-	//TEST(fabs(dct_slow[0] - 11) < 0.0001);
-	EXPECT(dct_slow[0], 11.);
-	EXPECT(dct_slow[1], -3.15432);
-	EXPECT(dct_slow[2], 2.12132);
-	EXPECT(dct_slow[3], -0.224171);
-	EXPECT(idct_slow[0], 4);
-	EXPECT(idct_slow[1], 3);
-	EXPECT(idct_slow[2], 5);
-	EXPECT(idct_slow[3], 10);
+		std::vector<std::complex<double> > arX(N, std::complex<double>(1., 0.));
+		CFFTPlan plan;
+		CStatistics stat;
+		plan.Create(CFFTPlan::COMPLEX, N, false);
+		pBenchPlan = &plan;
+		pBenchData = &arX[0];
+		stat.RunMicrobenchmark(bench_execute, 10, 0.5);
+		double fTime1 = stat.GetMedian();
+		printf("N=%d threads=1 %-9s %8.2f ms\n", int(N), "radix-2", fTime1 * 1e3);
 
-	// Check Fast DCT
-	for (i = 0; i < 4; i++) EXPECT(dct_slow[i], sx[i]);
-	for (i = 0; i < 4; i++) EXPECT(idct_slow[i], xx[i]);
-	for (i = 0; i < 4; i++) EXPECT(dct_slow[i], t2[i]);
-	for (i = 0; i < 4; i++) EXPECT(idct_slow[i], t3[i]);
+		int nThreads;
+		for (nThreads = 2; nThreads <= nMaxThreads; nThreads++)
+		{
+			plan.SetThreads(nThreads);
+			stat.RunMicrobenchmark(bench_execute, 10, 0.5);
+			printf("N=%d threads=%d %-9s %8.2f ms, speedup %.2f\n", int(N), nThreads, "four-step",
+				stat.GetMedian() * 1e3, fTime1 / stat.GetMedian());
+		}
+		pBenchPlan = NULL;
+		pBenchData = NULL;
+	}
 
-	printf("Cosine transform1\n");
-	for (i = 0; i < 4; i++)
+	printf("\nSmall FFT codelets against loops and recurrences\n");
 	{
-		printf("%d. %7.3g \t=> %7.3g\t=> %7.3g\t=>%7.3g\t=>%g\n", i, x[i], sx[i], t2[i], t3[i], t3[i] / x[i]);
+		std::vector<double> arX(2 * const_CodeletMaxSize, 0.);
+		size_t N;
+		for (N = 4; N <= const_CodeletMaxSize; N *= 2)
+		{
+			CStatistics stat;
+			nBenchSmall = N;
+			pBenchSmall = &arX[0];
+			stat.RunMicrobenchmark(bench_dft_loop, 10, 0.2);
+			double fTimeLoop = stat.GetMedian() / nBenchReps;
+			stat.RunMicrobenchmark(bench_codelet, 10, 0.2);
+			double fTimeCodelet = stat.GetMedian() / nBenchReps;
+			printf("N=%2d loops %8.1f ns, codelet %8.1f ns, speedup %.2f\n", int(N),
+				fTimeLoop * 1e9, fTimeCodelet * 1e9, fTimeLoop / fTimeCodelet);
+		}
+		pBenchSmall = NULL;
 	}
 
-	printf("Cosine transform2\n");
-	for (i = 0; i < 4; i++)
+	printf("\nFFT accuracy against a long double FFT (orthonormal, random input in [-1, 1])\n");
 	{
-		if (fabs(xx[i]) < 1e-13) xx[i] = 0.;
-		printf("%d. %5g \t=> %7.3g\t=> %g\n", i, x[i], sx[i], xx[i]);
+		const char *arName[] = {"recurrence", "FFT()", "CFFTPlan"};
+		size_t N, i;
+		for (N = 16; N <= (size_t(1) << 24); N *= 4)
+		{
+			std::vector<double> arX(2 * N);
+			std::vector<std::complex<double> > arCX(N), arRes;
+			std::vector<std::complex<long double> > arRef(N);
+			make_test_signal(2 * N, &arX[0], (unsigned int) N);
+			for (i = 0; i < N; i++)
+			{
+				arCX[i] = std::complex<double>(arX[2 * i], arX[2 * i + 1]);
+				arRef[i] = std::complex<long double>(arX[2 * i], arX[2 * i + 1]);
+			}
+			std::vector<double>().swap(arX);
+			do_fft_long_double(N, &arRef[0]);
+			long double fNorm = 1.L / sqrtl((long double) N);
+			for (i = 0; i < N; i++)
+				arRef[i] *= fNorm;
+
+			for (int nMode = 0; nMode < 3; nMode++)
+			{
+				if (nMode == 0)
+				{
+					// Twiddles of do_complex_dft() (FDCT(), FDST() without accurate twiddles)
+					arRes = arCX;
+					do_complex_dft(int(2 * N), cos(const_PI / double(N)), -sin(const_PI / double(N)),
+						reinterpret_cast<double *>(&arRes[0]));
+					for (i = 0; i < N; i++)
+						arRes[i] *= double(fNorm);
+				}
+				else if (nMode == 1)
+					FFT(N, &arCX[0], arRes, false);
+				else
+				{
+					CFFTPlan plan;
+					plan.Create(CFFTPlan::COMPLEX, N, false);
+					plan.Execute(N, &arCX[0], arRes);
+				}
+				long double fMax = 0., fSum = 0.;
+				for (i = 0; i < N; i++)
+				{
+					long double e = std::abs(std::complex<long double>(arRes[i]) - arRef[i]);
+					fSum += e * e;
+					if (e > fMax) fMax = e;
+				}
+				printf("N=2^%-2d %-17s max.err=%9.3g rms.err=%9.3g\n", int(log2(double(N)) + 0.5), arName[nMode],
+					double(fMax), double(sqrtl(fSum / (long double) N)));
+			}
+		}
 	}
 
+	printf("\nRadix-2 (bit reversal) against Stockham autosort, in place complex FFT\n");
+	{
+		size_t N;
+		size_t nFirst = 0, nLast = 0, nRun = 0, nBestRun = 0;
+		for (N = 256; N <= (size_t(1) << 22); N *= 2)
+		{
+			std::vector<std::complex<double> > arX(N, std::complex<double>(1., 0.));
+			CFFTPlan plan;
+			CStatistics stat;
+			plan.Create(CFFTPlan::COMPLEX, N, false);
+			pBenchPlan = &plan;
+			pBenchData = &arX[0];
+			stat.RunMicrobenchmark(bench_execute, 10, 0.2);
+			double fTimeRadix2 = stat.GetMedian();
+			plan.SetAlgorithm(CFFTPlan::STOCKHAM);
+			stat.RunMicrobenchmark(bench_execute, 10, 0.2);
+			double fTimeStockham = stat.GetMedian();
+			// Longest run of sizes where Stockham wins
+			nRun = (fTimeStockham < fTimeRadix2) ? nRun + 1 : 0;
+			if (nRun > nBestRun)
+			{
+				nBestRun = nRun;
+				nLast = N;
+				nFirst = N >> (nRun - 1);
+			}
+			printf("N=2^%-2d radix-2 %10.1f us, Stockham %10.1f us, ratio %.2f\n", int(log2(double(N)) + 0.5),
+				fTimeRadix2 * 1e6, fTimeStockham * 1e6, fTimeRadix2 / fTimeStockham);
+		}
+		if (nBestRun != 0)
+			printf("Stockham is faster from N=%d to N=%d\n", int(nFirst), int(nLast));
+		else
+			printf("Stockham is not faster at any size\n");
+		pBenchPlan = NULL;
+		pBenchData = NULL;
+	}
 
-	memset(x, 0, USE_N * sizeof(double));
-	for (i = 0; i < USE_N; i++)
-		x[i] = 1.;
-	x[1] = 4.;
+	printf("\nPlanner: ESTIMATE against MEASURE, complex FFT\n");
+	{
+		size_t arSizes[] = {1024, 4096, 16384, 65536, 262144, 1000, 3000, 30000, 240000};
+		size_t k;
+		CFFTPlanBase::ForgetWisdom();
+		for (k = 0; k < sizeof(arSizes) / sizeof(arSizes[0]); k++)
+		{
+			size_t N = arSizes[k];
+			std::vector<std::complex<double> > arX(N, std::complex<double>(1., 0.));
+			CFFTPlan plan;
+			CStatistics stat;
+			plan.Create(CFFTPlan::COMPLEX, N, false);
+			CFFTPlan::TAlgorithm eEstimate = plan.GetAlgorithm();
+			pBenchPlan = &plan;
+			pBenchData = &arX[0];
+			stat.RunMicrobenchmark(bench_execute, 10, 0.2);
+			double fTimeEstimate = stat.GetMedian();
+			CFFTPlanBase::SetPlanner(CFFTPlanBase::MEASURE);
+			plan.Create(CFFTPlan::COMPLEX, N, false);
+			CFFTPlanBase::SetPlanner(CFFTPlanBase::ESTIMATE);
+			stat.RunMicrobenchmark(bench_execute, 10, 0.2);
+			double fTimeMeasure = stat.GetMedian();
+			printf("N=%-6d %-11s %10.1f us, %-11s %10.1f us, ratio %.2f\n", int(N),
+				arAlgorithmNames[eEstimate], fTimeEstimate * 1e6, arAlgorithmNames[plan.GetAlgorithm()],
+				fTimeMeasure * 1e6, fTimeEstimate / fTimeMeasure);
+		}
+		CFFTPlanBase::ForgetWisdom();
+		pBenchPlan = NULL;
+		pBenchData = NULL;
+	}
 
-	printf("Cosine transform\n");
-	FDCT(USE_N, x, s, false, true);
-	FDCT(s.size(), &s[0], y, true, true);
-	for (i = 0; i < USE_N; i++)
+	printf("\nSplit complex: ExecuteSplit() against interleave + Execute() + deinterleave\n");
 	{
-		if (fabs(y[i]) < 1e-13) y[i] = 0.;
-		printf("%d. %g \t=> %g \t=> %g\n", i, x[i], s[i], y[i]);
+		size_t N;
+		for (N = 256; N <= (size_t(1) << 20); N *= 4)
+		{
+			std::vector<std::complex<double> > arX(N, std::complex<double>(1., 0.));
+			std::vector<double> arRe(N, 1.), arIm(N, 0.);
+			CFFTPlan plan;
+			CStatistics stat;
+			plan.Create(CFFTPlan::COMPLEX, N, false);
+			pBenchPlan = &plan;
+			pBenchData = &arX[0];
+			pBenchRe = &arRe[0];
+			pBenchIm = &arIm[0];
+			stat.RunMicrobenchmark(bench_interleaved, 10, 0.2);
+			double fTimeInterleaved = stat.GetMedian();
+			stat.RunMicrobenchmark(bench_split, 10, 0.2);
+			double fTimeSplit = stat.GetMedian();
+			printf("N=2^%-2d interleaved %10.1f us, split %10.1f us, ratio %.2f\n", int(log2(double(N)) + 0.5),
+				fTimeInterleaved * 1e6, fTimeSplit * 1e6, fTimeInterleaved / fTimeSplit);
+		}
+		pBenchPlan = NULL;
+		pBenchData = NULL;
+		pBenchRe = NULL;
+		pBenchIm = NULL;
 	}
 
-	printf("Sine transform\n");
-	FDST(USE_N, x, s, false, false);
-	FDST(s.size(), &s[0], y, true, false);
-	for (i = 0; i < USE_N; i++)
+	printf("\nFixed-point Q15 FFT against conversion to double + FFT plan\n");
 	{
-		if (fabs(y[i]) < 1e-13) y[i] = 0.;
-		printf("%d. %g \t=> %g \t=> %g\n", i, x[i], s[i], y[i]);
+		size_t N;
+		for (N = 256; N <= 65536; N *= 4)
+		{
+			std::vector<std::complex<double> > arX(N);
+			std::vector<short> arSamples(2 * N), arQ15(2 * N);
+			size_t i;
+			for (i = 0; i < 2 * N; i++)
+				arSamples[i] = short((i * 7919) % 65536 - 32768);
+			CFFTPlan plan;
+			CFFTFixedQ15 q15;
+			CStatistics stat;
+			plan.Create(CFFTPlan::COMPLEX, N, false);
+			q15.Create(N, false);
+			pBenchPlan = &plan;
+			pBenchData = &arX[0];
+			pBenchQ15 = &q15;
+			pBenchSamples = &arSamples[0];
+			pBenchQ15Data = &arQ15[0];
+			stat.RunMicrobenchmark(bench_q15_as_double, 10, 0.2);
+			double fTimeDouble = stat.GetMedian();
+			stat.RunMicrobenchmark(bench_q15, 10, 0.2);
+			double fTimeQ15 = stat.GetMedian();
+			printf("N=2^%-2d double %10.1f us, Q15 %10.1f us, ratio %.2f\n", int(log2(double(N)) + 0.5),
+				fTimeDouble * 1e6, fTimeQ15 * 1e6, fTimeDouble / fTimeQ15);
+		}
+		pBenchPlan = NULL;
+		pBenchData = NULL;
+		pBenchQ15 = NULL;
+		pBenchSamples = NULL;
+		pBenchQ15Data = NULL;
 	}
 
-	printf("\nFFT\n");
+	printf("\nBig integer product: CFFTMultiplier against the schoolbook loop, N x N 32-bit limbs\n");
+	{
+		size_t N;
+		for (N = 64; N <= 16384; N *= 4)
+		{
+			std::vector<unsigned int> arA(N), arB(N), arProduct(2 * N);
+			make_test_words(N, &arA[0], 1);
+			make_test_words(N, &arB[0], 2);
+			CFFTMultiplier mul;
+			CStatistics stat;
+			mul.Create(N, N);
+			pBenchMul = &mul;
+			nBenchLimbs = N;
+			pBenchA = &arA[0];
+			pBenchB = &arB[0];
+			pBenchProduct = &arProduct[0];
+			stat.RunMicrobenchmark(bench_multiply_loop, 10, 0.2);
+			double fTimeLoop = stat.GetMedian();
+			stat.RunMicrobenchmark(bench_multiply_fft, 10, 0.2);
+			double fTimeFFT = stat.GetMedian();
+			printf("N=%-5d loop %10.1f us, FFT %10.1f us (%2d-bit limbs), speedup %.2f\n", int(N),
+				fTimeLoop * 1e6, fTimeFFT * 1e6, mul.GetLimbBits(), fTimeLoop / fTimeFFT);
+		}
+		pBenchMul = NULL;
+		pBenchA = NULL;
+		pBenchB = NULL;
+		pBenchProduct = NULL;
+	}
 
-	std::vector<std::complex<double> > cX(USE_N), cF, cIF;
-	for (i = 0; i < USE_N; i++)
+	printf("\nPruned FFT against FFT() of the zero padded input\n");
 	{
-		cX[i] = 1.;
-		x[i] = 1.;
+		// nInCnt, nSize, nFirstBin, nOutCnt
+		size_t arCase[][4] = {{32, 4096, 0, 32}, {1000, 65536, 0, 512}, {300, 16384, 0, 384}, {65536, 65536, 100, 64},
+			{4096, 1 << 20, 0, 4096}, {1 << 20, 1 << 20, 0, 1024}, {16384, 16384, 0, 16384}};
+		size_t t;
+		for (t = 0; t < sizeof(arCase) / sizeof(arCase[0]); t++)
+		{
+			std::vector<std::complex<double> > arX(arCase[t][1], std::complex<double>(0., 0.)), arOut(arCase[t][1]);
+			std::fill(arX.begin(), arX.begin() + arCase[t][0], std::complex<double>(1., 0.));
+			CStatistics stat;
+			memcpy(arBenchPruned, arCase[t], sizeof(arBenchPruned));
+			pBenchData = &arX[0];
+			pBenchOutput = &arOut;
+			stat.RunMicrobenchmark(bench_padded, 10, 0.2);
+			double fTimeFull = stat.GetMedian();
+			stat.RunMicrobenchmark(bench_pruned, 10, 0.2);
+			double fTimePruned = stat.GetMedian();
+			printf("in=%-7d N=2^%-2d bins %5d..%-5d FFT() %10.1f us, pruned %10.1f us, speedup %.2f\n",
+				int(arCase[t][0]), int(log2(double(arCase[t][1])) + 0.5), int(arCase[t][2]),
+				int(arCase[t][2] + arCase[t][3] - 1), fTimeFull * 1e6, fTimePruned * 1e6, fTimeFull / fTimePruned);
+		}
+		pBenchData = NULL;
+		pBenchOutput = NULL;
 	}
-	x[1] = 4.;
-	cX[1] = 4.;
-	
-	FFT(USE_N, x, cF, false, true);
-	FFT(USE_N, &cF[0], cIF, true, true);
 
-	for (i = 0; i < USE_N; i++)
+	printf("\nFilterbank: power vector and dense weights against the fused sparse Apply()\n");
 	{
-		//if (fabs(cIF[i]) < 1e-13) cIF[i] = 0.;
-		printf("%d. %g \t=> (%g + j%g) \t\t=> %g\n", i, cX[i].real(), cF[i].real(), cF[i].imag(), cIF[i].real());
+		// nFFTSize, nBands, scale
+		size_t arCase[][3] = {{512, 40, CFilterbank::MEL}, {2048, 128, CFilterbank::MEL}, {4096, 64, CFilterbank::GAMMATONE}};
+		size_t t, b, j;
+		for (t = 0; t < sizeof(arCase) / sizeof(arCase[0]); t++)
+		{
+			const size_t nFFT = arCase[t][0], nBands = arCase[t][1];
+			CFilterbank bank;
+			bank.Create(CFilterbank::TScale(arCase[t][2]), nFFT, 16000., nBands);
+			std::vector<double> arDense(nBands * bank.GetBins(), 0.), arFrame(nFFT), arBands(nBands);
+			size_t nWeights = 0;
+			for (b = 0; b < nBands; b++)
+			{
+				const unsigned int *pBins;
+				const double *pWeights;
+				size_t nCnt = bank.GetWeights(b, pBins, pWeights);
+				for (j = 0; j < nCnt; j++)
+					arDense[b * bank.GetBins() + pBins[j]] = pWeights[j];
+				nWeights += nCnt;
+			}
+			std::vector<std::complex<double> > arSpec(bank.GetBins());
+			make_test_signal(2 * arSpec.size(), reinterpret_cast<double *>(&arSpec[0]), 3);
+			make_test_signal(nFFT, &arFrame[0], 4);
+			pBenchBank = &bank;
+			pBenchDense = &arDense;
+			pBenchSpectrum = &arSpec;
+			pBenchBands = &arBands;
+			pBenchFrame = &arFrame[0];
+
+			CStatistics stat;
+			stat.RunMicrobenchmark(bench_filterbank_dense, 10, 0.2);
+			double fTimeDense = stat.GetMedian();
+			stat.RunMicrobenchmark(bench_filterbank_apply, 10, 0.2);
+			double fTimeApply = stat.GetMedian();
+			stat.RunMicrobenchmark(bench_filterbank_process, 10, 0.2);
+			double fTimeProcess = stat.GetMedian();
+			printf("%-9s N=%-5d bands=%-4d weights=%-6d dense %8.2f us, Apply() %8.2f us, speedup %5.2f, Process() %8.2f us\n",
+				arCase[t][2] == CFilterbank::MEL ? "mel" : "gammatone", int(nFFT), int(nBands), int(nWeights),
+				fTimeDense * 1e6, fTimeApply * 1e6, fTimeDense / fTimeApply, fTimeProcess * 1e6);
+		}
+		pBenchBank = NULL;
+		pBenchDense = NULL;
+		pBenchSpectrum = NULL;
+		pBenchBands = NULL;
+		pBenchFrame = NULL;
 	}
 
-	printf("\nRFFT\n");
-	f.resize(USE_N);
-	for (i = 0; i < USE_N; i++)
+	printf("\nEnvelope: FFT(), zeroed negative frequencies, inverse FFT() against CHilbert\n");
 	{
-		cX[i] = 1.;
-		f[i] = 1.;
+		size_t arSize[] = {1024, 4096, 10000, 65536, 1 << 20};
+		size_t t;
+		for (t = 0; t < sizeof(arSize) / sizeof(arSize[0]); t++)
+		{
+			const size_t N = arSize[t];
+			std::vector<double> arX(N), arEnv(N);
+			std::vector<std::complex<double> > arZ(N);
+			make_test_signal(N, &arX[0], 9);
+			CFFTPlan fwd, inv;
+			fwd.Create(CFFTPlan::COMPLEX, N, false, false);
+			inv.Create(CFFTPlan::COMPLEX, N, true, false);
+			CHilbert hilbert;
+			hilbert.Create(N);
+			pBenchSignal = &arX[0];
+			pBenchEnvelope = &arEnv;
+			pBenchAnalytic = &arZ;
+			pBenchPlan = &fwd;
+			pBenchInverse = &inv;
+			pBenchHilbert = &hilbert;
+
+			CStatistics stat;
+			stat.RunMicrobenchmark(bench_envelope_fft, 10, 0.2);
+			double fTimeFFT = stat.GetMedian();
+			stat.RunMicrobenchmark(bench_envelope_plan, 10, 0.2);
+			double fTimePlan = stat.GetMedian();
+			stat.RunMicrobenchmark(bench_envelope_hilbert, 10, 0.2);
+			double fTimeHilbert = stat.GetMedian();
+			printf("N=%-8d FFT() %10.1f us, COMPLEX plans %10.1f us, CHilbert %10.1f us, speedup %5.2f / %5.2f\n",
+				int(N), fTimeFFT * 1e6, fTimePlan * 1e6, fTimeHilbert * 1e6, fTimeFFT / fTimeHilbert,
+				fTimePlan / fTimeHilbert);
+		}
+		pBenchSignal = NULL;
+		pBenchEnvelope = NULL;
+		pBenchAnalytic = NULL;
+		pBenchPlan = NULL;
+		pBenchInverse = NULL;
+		pBenchHilbert = NULL;
 	}
-	f[1] = 4.;
-	cX[1] = 4.;
-	RFFT2(f, cF);
 
-	/*for (i=1; i<(int)cF.size(); i++)
+	return 0;
+}
+
+// Benchmark suite: buffers of the current size, every kernel runs nSuiteRepeat transforms
+static size_t nSuiteSize = 0;
+static int nSuiteRepeat = 1;
+static std::vector<std::complex<double> > arSuiteCplx, arSuiteCplxOut;
+static std::vector<std::complex<float> > arSuiteCplxF, arSuiteCplxOutF;
+static std::vector<double> arSuiteReal, arSuiteRealOut;
+static std::vector<float> arSuiteRealF, arSuiteRealOutF;
+static CFFTPlan *pSuitePlan = NULL;
+
+static void suite_fft()
+{
+	for (int i = 0; i < nSuiteRepeat; i++)
+		FFT(nSuiteSize, &arSuiteCplx[0], arSuiteCplxOut, false);
+}
+
+static void suite_fft_f()
+{
+	for (int i = 0; i < nSuiteRepeat; i++)
+		FFT(nSuiteSize, &arSuiteCplxF[0], arSuiteCplxOutF, false);
+}
+
+static void suite_rfft()
+{
+	for (int i = 0; i < nSuiteRepeat; i++)
+		RFFT(arSuiteReal, arSuiteCplxOut);
+}
+
+static void suite_rfft_f()
+{
+	for (int i = 0; i < nSuiteRepeat; i++)
+		RFFT(arSuiteRealF, arSuiteCplxOutF);
+}
+
+// RFFT2() takes the input size from the output vector
+static void suite_rfft2()
+{
+	for (int i = 0; i < nSuiteRepeat; i++)
 	{
-		double mod = abs ( cF[i] );
-		double ph = arg ( cF[i] ) + 3.14159265/4.;
-		cF[i] = std::polar(mod, ph);
-	}*/
-	IRFFT2(cF, y);
+		arSuiteCplxOut.resize(nSuiteSize);
+		RFFT2(arSuiteReal, arSuiteCplxOut);
+	}
+}
 
-	printf("SRC vs TRG\n");
-	for (i = 0; i < USE_N; i++)
+static void suite_fdct()
+{
+	for (int i = 0; i < nSuiteRepeat; i++)
+		FDCT(nSuiteSize, &arSuiteReal[0], arSuiteRealOut, false);
+}
+
+static void suite_fdct_f()
+{
+	for (int i = 0; i < nSuiteRepeat; i++)
+		FDCT(nSuiteSize, &arSuiteRealF[0], arSuiteRealOutF, false);
+}
+
+static void suite_fdst()
+{
+	for (int i = 0; i < nSuiteRepeat; i++)
+		FDST(nSuiteSize, &arSuiteReal[0], arSuiteRealOut, false);
+}
+
+static void suite_fdst_f()
+{
+	for (int i = 0; i < nSuiteRepeat; i++)
+		FDST(nSuiteSize, &arSuiteRealF[0], arSuiteRealOutF, false);
+}
+
+static void suite_plan()
+{
+	for (int i = 0; i < nSuiteRepeat; i++)
+		pSuitePlan->Execute(&arSuiteCplx[0], &arSuiteCplxOut[0]);
+}
+
+static void suite_plan_real()
+{
+	for (int i = 0; i < nSuiteRepeat; i++)
+		pSuitePlan->Execute(&arSuiteReal[0], &arSuiteCplxOut[0]);
+}
+
+struct TSuiteEntry
+{
+	const char *pName;
+	const char *pPrecision;
+	bool bComplex;                        // complex data: 5 N log2 N flops, real: 2.5 N log2 N
+	int nPlan;                            // -1 - no plan, CFFTPlanBase::COMPLEX or REAL
+	FnBenchKernel fnKernel;
+};
+
+static const TSuiteEntry arSuiteEntries[] = {
+	{"FFT", "double", true, -1, suite_fft},
+	{"FFT", "float", true, -1, suite_fft_f},
+	{"RFFT", "double", false, -1, suite_rfft},
+	{"RFFT", "float", false, -1, suite_rfft_f},
+	{"RFFT2", "double", false, -1, suite_rfft2},
+	{"FDCT", "double", false, -1, suite_fdct},
+	{"FDCT", "float", false, -1, suite_fdct_f},
+	{"FDST", "double", false, -1, suite_fdst},
+	{"FDST", "float", false, -1, suite_fdst_f},
+	{"CFFTPlan COMPLEX", "double", true, CFFTPlanBase::COMPLEX, suite_plan},
+	{"CFFTPlan REAL", "double", false, CFFTPlanBase::REAL, suite_plan_real}};
+
+// Resize the buffers of the suite to N points (empty for N = 0)
+static void do_suite_buffers(size_t N)
+{
+	std::vector<double> arX(2 * N);
+	make_test_signal(2 * N, arX.empty() ? NULL : &arX[0], (unsigned int) N);
+	nSuiteSize = N;
+	arSuiteCplx.assign(N, std::complex<double>(0., 0.));
+	arSuiteCplxF.assign(N, std::complex<float>(0.f, 0.f));
+	arSuiteReal.assign(arX.begin(), arX.begin() + N);
+	arSuiteRealF.assign(arX.begin(), arX.begin() + N);
+	size_t i;
+	for (i = 0; i < N; i++)
 	{
-		printf("%d. %g \t=> %g\n", i, f[i], y[i]);
+		arSuiteCplx[i] = std::complex<double>(arX[2 * i], arX[2 * i + 1]);
+		arSuiteCplxF[i] = std::complex<float>(arSuiteCplx[i]);
 	}
-	printf("Spectrum\n");
-	for (i = 0; i < (int) cF.size(); i++)
+	// Outputs at full capacity, so the transforms don't allocate them
+	arSuiteCplxOut.assign(N, std::complex<double>(0., 0.));
+	arSuiteCplxOutF.assign(N, std::complex<float>(0.f, 0.f));
+	arSuiteRealOut.assign(N, 0.);
+	arSuiteRealOutF.assign(N, 0.f);
+	if (N == 0)
 	{
-		printf("%d. (%5g ; j%-5g)\n", i, cF[i].real(), cF[i].imag());
+		std::vector<std::complex<double> >().swap(arSuiteCplx);
+		std::vector<std::complex<double> >().swap(arSuiteCplxOut);
+		std::vector<std::complex<float> >().swap(arSuiteCplxF);
+		std::vector<std::complex<float> >().swap(arSuiteCplxOutF);
+		std::vector<double>().swap(arSuiteReal);
+		std::vector<double>().swap(arSuiteRealOut);
+		std::vector<float>().swap(arSuiteRealF);
+		std::vector<float>().swap(arSuiteRealOutF);
+	}
+}
+
+int run_FFT_benchmark_suite(int nMinLog2/* = 2*/, int nMaxLog2/* = 24*/, const char *pFileName/* = NULL*/)
+{
+	if (nMinLog2 < 2 || nMaxLog2 > 26 || nMinLog2 > nMaxLog2) return -2;
+
+	const size_t nLen = (pFileName != NULL) ? strlen(pFileName) : 0;
+	const bool bJson = nLen >= 5 && strcmp(pFileName + nLen - 5, ".json") == 0;
+	FILE *f = NULL;
+	if (pFileName != NULL)
+	{
+		f = fopen(pFileName, "w");
+		if (f == NULL) return -1;
+		if (bJson)
+			fprintf(f, "{\n  \"simd\": \"%s\",\n  \"results\": [", arSimdNames[CFFTPlanBase::GetSupportedSimd()]);
+		else
+			fprintf(f, "transform,precision,size,ns,ns_low,ns_high,mflops,mflops_low,mflops_high,samples,repeats\n");
 	}
 
+	printf("\nFFT benchmark suite: median ns per transform, \"5 N log2 N\" MFLOPS (2.5 N log2 N for real data),\n");
+	printf("95%% confidence intervals of the median (bootstrap), instruction set %s\n",
+		arSimdNames[CFFTPlanBase::GetSupportedSimd()]);
+	printf("%-16s %-6s %5s %14s %24s %10s %22s\n", "transform", "type", "N", "ns", "95% CI", "MFLOPS", "95% CI");
+
+	bool bFirst = true;
+	for (int nLog2 = nMinLog2; nLog2 <= nMaxLog2; nLog2++)
+	{
+		const size_t N = size_t(1) << nLog2;
+		do_suite_buffers(N);
+		for (size_t e = 0; e < sizeof(arSuiteEntries) / sizeof(arSuiteEntries[0]); e++)
+		{
+			const TSuiteEntry &entry = arSuiteEntries[e];
+			CFFTPlan plan;
+			if (entry.nPlan >= 0)
+				plan.Create(CFFTPlanBase::TTransform(entry.nPlan), N, false);
+			pSuitePlan = &plan;
+
+			// Samples of at least 2 ms: the timer of CStatistics counts microseconds
+			CStatistics stat;
+			for (nSuiteRepeat = 1; ; nSuiteRepeat *= 2)
+			{
+				stat.RunMicrobenchmark(entry.fnKernel, 2, 0.);
+				if (stat.GetMinValue() >= 2e-3 || nSuiteRepeat >= (1 << 20))
+					break;
+			}
+			// The calibration has warmed up the caches and the plan
+			const int nSamples = (stat.GetMinValue() > 0.1) ? 5 : 15;
+			stat.RunMicrobenchmark(entry.fnKernel, nSamples, 0.);
+			CStatistics boot;
+			boot.MakeBootstrapStatistic(CStatistics::MEDIAN, stat, 1000);
+
+			const double fScale = 1e9 / double(nSuiteRepeat);
+			const double fNs = stat.GetMedian() * fScale;
+			const double fNsLow = boot.GetPercentile(2.5f) * fScale;
+			const double fNsHigh = boot.GetPercentile(97.5f) * fScale;
+			const double fFlops = (entry.bComplex ? 5. : 2.5) * double(N) * double(nLog2);
+			const double fMflops = fFlops / fNs * 1e3;
+			const double fMflopsLow = fFlops / fNsHigh * 1e3;
+			const double fMflopsHigh = fFlops / fNsLow * 1e3;
+			printf("%-16s %-6s 2^%-3d %14.1f [%10.1f, %10.1f] %10.1f [%9.1f, %9.1f]\n", entry.pName, entry.pPrecision,
+				nLog2, fNs, fNsLow, fNsHigh, fMflops, fMflopsLow, fMflopsHigh);
+			if (f != NULL && bJson)
+				fprintf(f, "%s\n    {\"transform\": \"%s\", \"precision\": \"%s\", \"size\": %lu, \"ns\": %.1f, "
+					"\"ns_ci\": [%.1f, %.1f], \"mflops\": %.1f, \"mflops_ci\": [%.1f, %.1f], \"samples\": %d, \"repeats\": %d}",
+					bFirst ? "" : ",", entry.pName, entry.pPrecision, (unsigned long) N, fNs, fNsLow, fNsHigh,
+					fMflops, fMflopsLow, fMflopsHigh, nSamples, nSuiteRepeat);
+			else if (f != NULL)
+				fprintf(f, "%s,%s,%lu,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%d,%d\n", entry.pName, entry.pPrecision,
+					(unsigned long) N, fNs, fNsLow, fNsHigh, fMflops, fMflopsLow, fMflopsHigh, nSamples, nSuiteRepeat);
+			bFirst = false;
+		}
+		pSuitePlan = NULL;
+		fflush(stdout);
+	}
+	do_suite_buffers(0);
 
+	if (f != NULL)
+	{
+		if (bJson)
+			fprintf(f, "\n  ]\n}\n");
+		fclose(f);
+	}
 	return 0;
 }
@@ -5,16 +5,45 @@
 
 typedef std::vector<std::complex<double> > v_complex;
 typedef std::vector<double> v_double;
+typedef std::vector<std::complex<float> > v_complex_f;
+typedef std::vector<float> v_float;
+
+// Single precision (float) overloads are computed the same way, with float
+// data and double precision twiddles.
+
+// FFT(), RFFT() and IRFFT() run CFFTPlanT plans (vectorized radix-4 passes, tables computed
+// directly), cached per thread, one per type, size, direction and normalization. Only the
+// first call of a kind computes tables and allocates them (see ForgetFFTPlans()). Plans of
+// more than 65536 points aren't cached, every call creates and frees its own.
 
 // Fast Fourier Transform. Output is always multiple of 2
 int FFT(size_t nInCnt, double *pInVal, std::vector<std::complex<double> > &arOutput, bool bInverse, bool bOrthNorm = true);
 int FFT(size_t nInCnt, const std::complex<double> *pInVal, std::vector<std::complex<double> > &arOutput, bool bInverse, bool bOrthNorm = true);
+int FFT(size_t nInCnt, const float *pInVal, std::vector<std::complex<float> > &arOutput, bool bInverse, bool bOrthNorm = true);
+int FFT(size_t nInCnt, const std::complex<float> *pInVal, std::vector<std::complex<float> > &arOutput, bool bInverse, bool bOrthNorm = true);
+// Fast Fourier Transform of any size nCnt >= 2 on caller provided buffers, no allocations
+// (but by the first call of a size and direction). In place when pIn == pOut
+int FFT(size_t nCnt, const std::complex<double> *pIn, std::complex<double> *pOut, bool bInverse, bool bOrthNorm = true);
+int FFT(size_t nCnt, const std::complex<float> *pIn, std::complex<float> *pOut, bool bInverse, bool bOrthNorm = true);
+// Pruned Fast Fourier Transform: bins nFirstBin .. nFirstBin+nOutCnt-1 of the nSize-point
+// transform of nInCnt values zero padded to nSize points (nSize is a power of 2, 0 - the
+// smallest one >= nInCnt), the same as those bins of FFT(). nOutCnt values to pOut.
+// Butterflies of padding zeros and of bins not asked for are skipped: the cheapest of
+// direct sums, nSize/P transforms of P >= nInCnt points (inputs pruned) and transforms of
+// S >= nOutCnt points combined for the bins asked for (outputs pruned) is run. The
+// transforms run cached plans as FFT() does, the twiddles of the pruning are computed directly.
+int FFT(size_t nInCnt, const double *pIn, size_t nSize, size_t nFirstBin, size_t nOutCnt, std::complex<double> *pOut, bool bInverse, bool bOrthNorm = true);
+int FFT(size_t nInCnt, const std::complex<double> *pIn, size_t nSize, size_t nFirstBin, size_t nOutCnt, std::complex<double> *pOut, bool bInverse, bool bOrthNorm = true);
+int FFT(size_t nInCnt, const float *pIn, size_t nSize, size_t nFirstBin, size_t nOutCnt, std::complex<float> *pOut, bool bInverse, bool bOrthNorm = true);
+int FFT(size_t nInCnt, const std::complex<float> *pIn, size_t nSize, size_t nFirstBin, size_t nOutCnt, std::complex<float> *pOut, bool bInverse, bool bOrthNorm = true);
 
 // Fast Fourier Transform for real input data.
 // Forward Transform: 2 * n -> n + 1 elements (i.e. complex conjurgate half is ignored)
 int RFFT(const v_double &f, v_complex &F, bool bOrthNorm = true);
+int RFFT(const v_float &f, v_complex_f &F, bool bOrthNorm = true);
 // Inverse Transform: n + 1 -> 2 * n elements
 int IRFFT(const v_complex &F, v_double &f, bool bOrthNorm = true);
+int IRFFT(const v_complex_f &F, v_float &f, bool bOrthNorm = true);
 // Forward Transform: 2 * n -> n + 1 elements (i.e. complex conjurgate half is ignored)
 int RFFT2(const v_double &f, v_complex &F);
 // Inverse Transform: n + 1 -> 2 * n elements
@@ -22,9 +51,725 @@ int IRFFT2(const v_complex &F, v_double &f);
 
 // Fast cosine transform. Type DCT-II, inverse is DCT-III. Output is always multiple of 2
 int FDCT(size_t nInCnt, const double *pInVal, std::vector<double> &arOutput, bool bInverse, bool bOrthNorm = true);
+int FDCT(size_t nInCnt, const float *pInVal, std::vector<float> &arOutput, bool bInverse, bool bOrthNorm = true);
 
 // Fast sine transform. Output is always multiple of 2
 int FDST(size_t nInCnt, const double *pInVal, std::vector<double> &arOutput, bool bInverse, bool bOrthNorm = true);
+int FDST(size_t nInCnt, const float *pInVal, std::vector<float> &arOutput, bool bInverse, bool bOrthNorm = true);
+
+// Twiddle factors of FDCT() and FDST() come from recurrences by default, which is fast,
+// but the error grows with the size. With SetAccurateTwiddles(true) they run cached CFFTPlanT
+// plans as FFT() does. A global setting, change it while no transform runs.
+void SetAccurateTwiddles(bool bAccurate);
+bool GetAccurateTwiddles();
+// Frees the plans cached by the free functions of the calling thread. Only plans of up to
+// 65536 points are cached, each one holds a few MB at most.
+void ForgetFFTPlans();
 
 // Run self-tests
 int run_FFT_selftest();
+
+// Run benchmarks
+int run_FFT_benchmark();
+
+// Benchmark suite: FFT(), RFFT(), RFFT2(), FDCT(), FDST() (double and float) and CFFTPlan
+// COMPLEX and REAL of 2^nMinLog2 .. 2^nMaxLog2 points (2..26). Prints the median time of a
+// transform in ns and FFTW's "5 N log2 N" MFLOPS (2.5 N log2 N for real data) with 95%
+// confidence intervals of the median (bootstrap of CStatistics). pFileName - the results
+// are written as JSON (the name ends with .json) or CSV, to be compared between versions.
+// Returns -1 if the file can't be written, -2 for wrong sizes.
+int run_FFT_benchmark_suite(int nMinLog2 = 2, int nMaxLog2 = 24, const char *pFileName = NULL);
+
+// Precision independent part of CFFTPlanT
+class CFFTThreadPool;
+
+class CFFTPlanBase
+{
+public:
+	enum TTransform { COMPLEX=0, REAL, DCT, DST, DCT1, DCT4, DST1, DST2, DST4, MDCT };
+	enum TAlgorithm { RADIX2=0, MIXED_RADIX, BLUESTEIN, FOUR_STEP, STOCKHAM };
+	enum TSimd { SIMD_SCALAR=0, SIMD_SSE2, SIMD_AVX2, SIMD_AVX512 };
+	enum TPlanner { ESTIMATE=0, MEASURE };
+
+	// Best instruction set of the CPU
+	static TSimd GetSupportedSimd();
+
+	// Planner of all plans, both precisions. ESTIMATE (default) - the algorithm follows
+	// from the size. MEASURE - Create() times every algorithm able to run the size
+	// (RADIX2, STOCKHAM and MIXED_RADIX for powers of 2 above 64 points, MIXED_RADIX and
+	// BLUESTEIN for products of 2, 3, 5 and 7) and keeps the fastest one as wisdom.
+	// Sub-transforms (REAL, DCT, Bluestein, ...) are tuned the same way. Wisdom is used
+	// by later plans of the same size and precision with either planner, SetAlgorithm()
+	// takes precedence over it. Plans restricted by SetSimd() or running several threads
+	// (SetThreads()) don't use or change wisdom, MEASURE times their candidates every
+	// time. Measuring takes tens of milliseconds per size.
+	static void SetPlanner(TPlanner ePlanner);
+	static TPlanner GetPlanner();
+
+	// Wisdom is a text file, one size per line. SaveWisdom() returns -1 if the file can't
+	// be written. LoadWisdom() merges the file with the current wisdom, it returns -1 if
+	// the file can't be read, -2 if the format is wrong, -3 if the file was measured with
+	// another instruction set (nothing is loaded then).
+	static int SaveWisdom(const char *pFileName);
+	static int LoadWisdom(const char *pFileName);
+	static void ForgetWisdom();
+};
+
+// Reusable transform plan. Twiddle factors, bit reversal table and scratch buffers
+// are computed once in Create(), so Execute() does no trigonometry and no heap
+// allocations (as long as output vectors already have enough capacity).
+// A plan is not reentrant. Use one plan per thread.
+// T is double (CFFTPlan) or float (CFFTPlanF). Tables are computed in double
+// precision and rounded to T.
+template <class T>
+class CFFTPlanT : public CFFTPlanBase
+{
+public:
+	CFFTPlanT();
+	~CFFTPlanT();
+
+	// Prepare a transform of nSize points. Any size is supported: powers of 2 run
+	// radix-2, products of 2, 3, 5 and 7 run mixed radix, other sizes use Bluestein's
+	// algorithm. No zero padding is done, the output always has nSize points.
+	// Radix-2 transforms up to 64 points (and FFT(), FDCT(), ... of such sizes) run
+	// fully unrolled codelets with constant twiddles.
+	// COMPLEX - same as FFT(),  nSize complex -> nSize complex
+	// REAL    - same as RFFT(), nSize real -> nSize/2+1 complex (IRFFT() when bInverse)
+	//           Even sizes run an nSize/2-point complex transform (GetAlgorithm() is its one)
+	// DCT     - same as FDCT(), nSize real -> nSize real
+	// DST     - same as FDST(), nSize real -> nSize real
+	// DCT1    - DCT-I, nSize real -> nSize real (inverse is DCT-I as well)
+	// DCT4    - DCT-IV (inverse is DCT-IV as well)
+	// DST1    - DST-I (inverse is DST-I as well)
+	// DST2    - DST-II, inverse is DST-III
+	// DST4    - DST-IV (inverse is DST-IV as well)
+	//           Without bOrthNorm DCT1..DST4 are FFTW's REDFT00, REDFT11, RODFT00, RODFT10
+	//           and RODFT11 (sums times 2), inverse plans undo them exactly. With bOrthNorm
+	//           they are orthonormal (as norm="ortho" of scipy.fft).
+	//           All of them run on an N-point (N/2 for DCT4, DST4 of even size) transform.
+	// MDCT    - 2*nSize real -> nSize real, IMDCT when bInverse, nSize is even.
+	//           X[k] = sum x[n] * w[n] * cos(pi/N * (n + 1/2 + N/2) * (k + 1/2)),
+	//           IMDCT is the transpose times 2/N (both times sqrt(2/N) with bOrthNorm).
+	//           Halves of IMDCT outputs overlap-added restore the signal, if the window
+	//           satisfies w[n]^2 + w[n+N]^2 = 1 (see SetWindow()).
+	int Create(TTransform eType, size_t nSize, bool bInverse, bool bOrthNorm = true);
+	void Reset();
+
+	TTransform GetType() const { return m_eType; };
+	TAlgorithm GetAlgorithm() const { return m_eAlgorithm; };
+	size_t GetSize() const { return m_nSize; };
+	bool IsInverse() const { return m_bInverse; };
+
+	// MDCT window of 2*GetSize() samples (e.g. sin(pi*(n+0.5)/2N)), applied to the input
+	// of MDCT and to the output of IMDCT. NULL - no window (the default). Call after Create().
+	int SetWindow(const T *pWindow);
+
+	// Radix-2 butterflies are vectorized for the best instruction set of the CPU.
+	// SetSimd() can restrict it (e.g. to cross check the results).
+	int SetSimd(TSimd eSimd);
+	TSimd GetSimd() const { return m_eSimd; };
+
+	// Transforms of 65536 points and more are split between nThreads threads by the
+	// four-step algorithm (GetAlgorithm() is FOUR_STEP). 1 (default) - no threads.
+	// Can be called before or after Create(). Execute() is still not reentrant.
+	int SetThreads(int nThreads);
+	int GetThreads() const { return m_nThreads; };
+
+	// Algorithm of power of 2 transforms above 64 points (sub-transforms of Bluestein and
+	// four-step included). RADIX2 - bit reversal permutation, then radix-4 passes in place.
+	// STOCKHAM - autosort radix-4 passes between two buffers, no permutation and only
+	// sequential access, faster while both buffers fit the cache. Without a call the
+	// planner decides (RADIX2 unless wisdom says otherwise, see SetPlanner()).
+	// Can be called before or after Create().
+	int SetAlgorithm(TAlgorithm eAlgorithm);
+
+	// Caller provided buffers of GetSize() elements (GetSize()/2+1 for the complex side
+	// of REAL). No copies, no allocations. In place when pIn == pOut.
+	// COMPLEX
+	int Execute(std::complex<T> *pData);
+	int Execute(const std::complex<T> *pIn, std::complex<T> *pOut);
+	// COMPLEX (real input), REAL forward
+	int Execute(const T *pIn, std::complex<T> *pOut);
+	// REAL inverse
+	int Execute(const std::complex<T> *pIn, T *pOut);
+	// DCT, DST, DCT1, DCT4, DST1, DST2, DST4
+	int Execute(T *pData);
+	// Same and MDCT (2*GetSize() -> GetSize(), GetSize() -> 2*GetSize() when inverse)
+	int Execute(const T *pIn, T *pOut);
+
+	// Input shorter than the plan size is zero padded (as FFT() does)
+	int Execute(size_t nInCnt, const T *pInVal, std::vector<std::complex<T> > &arOutput);
+	int Execute(size_t nInCnt, const std::complex<T> *pInVal, std::vector<std::complex<T> > &arOutput);
+	int Execute(size_t nInCnt, const T *pInVal, std::vector<T> &arOutput);
+	// Inverse real transform: nSize/2+1 complex -> nSize real
+	int Execute(const std::vector<std::complex<T> > &arInput, std::vector<T> &arOutput);
+
+	// Batch of nHowMany transforms of GetSize() points, same as FFTW's advanced interface.
+	// Element k of signal m is p[m * nDist + k * nStride] (in elements of the array).
+	// Radix-2 COMPLEX plans up to 4096 points interleave signals across SIMD lanes.
+	// The first call allocates the batch buffers, later calls of the same kind don't.
+	// COMPLEX
+	int ExecuteMany(size_t nHowMany, const std::complex<T> *pIn, size_t nInStride, size_t nInDist,
+		std::complex<T> *pOut, size_t nOutStride, size_t nOutDist);
+	// COMPLEX (real input), REAL forward
+	int ExecuteMany(size_t nHowMany, const T *pIn, size_t nInStride, size_t nInDist,
+		std::complex<T> *pOut, size_t nOutStride, size_t nOutDist);
+	// REAL inverse
+	int ExecuteMany(size_t nHowMany, const std::complex<T> *pIn, size_t nInStride, size_t nInDist,
+		T *pOut, size_t nOutStride, size_t nOutDist);
+	// DCT, DST, ..., MDCT
+	int ExecuteMany(size_t nHowMany, const T *pIn, size_t nInStride, size_t nInDist,
+		T *pOut, size_t nOutStride, size_t nOutDist);
+
+	// Split complex (SoA) data: real and imaginary parts in separate arrays of GetSize()
+	// elements (GetSize()/2+1 for the complex side of REAL). Power of 2 COMPLEX plans
+	// above 64 points and REAL plans of twice that run the SIMD radix-4 passes on the
+	// split arrays, other plans go through an interleaved buffer. COMPLEX works in place
+	// when the input and output arrays are equal, REAL doesn't. The first call allocates
+	// the split twiddles and buffers, later calls don't. ExecuteSplitToReal() has its own
+	// name: its arguments would be ambiguous with the real input overload.
+	// COMPLEX
+	int ExecuteSplit(const T *pInRe, const T *pInIm, T *pOutRe, T *pOutIm);
+	// COMPLEX (real input), REAL forward
+	int ExecuteSplit(const T *pIn, T *pOutRe, T *pOutIm);
+	// REAL inverse
+	int ExecuteSplitToReal(const T *pInRe, const T *pInIm, T *pOut);
+
+private:
+	CFFTPlanT(const CFFTPlanT &);
+	CFFTPlanT &operator=(const CFFTPlanT &);
+
+	void CreateTransform(size_t N, bool bBackward);
+	int Recreate();
+	void Transform(T *a);
+	void Transform(const T *in, T *out);
+	void Bluestein(const T *in, T *out);
+	void FourStep(const T *in, T *out);
+	void Stockham(const T *in, T *out);
+	TAlgorithm SelectAlgorithm(size_t N, bool bSmooth);
+	void ForwardReal(size_t nInCnt, const T *pIn, std::complex<T> *pOut);
+	void PackedForward(size_t nInCnt, const T *pIn, std::complex<T> *pOut);
+	void PackedSpectrum(T *z, T fNorm);
+	void PackedInverse(const std::complex<T> *pIn, T *pOut);
+	bool IsSplitNative() const;
+	void PrepareSplit();
+	void PackedSpectrumSplit(T *zr, T *zi, T fNorm);
+	void DCT2(T *a);
+	void DCT3(T *a);
+	void DCTIV(T *a);
+	void ExecuteDCT(T *a);
+	void ExecuteDST(T *a);
+	void ExecuteDCT1(T *a);
+	void ExecuteDST1(T *a);
+	void ExecuteDST2(T *a);
+	void ExecuteDCT4(T *a);
+	void ExecuteMDCT(const T *pIn, T *pOut);
+	template <class TIn, class TOut>
+	int ExecuteEach(size_t nHowMany, const TIn *pIn, size_t nInStride, size_t nInDist, size_t nInCnt,
+		TOut *pOut, size_t nOutStride, size_t nOutDist, size_t nOutCnt);
+	void ExecuteLanes(size_t nLanes, size_t nCnt, const std::complex<T> *pIn, size_t nInStride, size_t nInDist,
+		std::complex<T> *pOut, size_t nOutStride, size_t nOutDist);
+
+	TTransform m_eType;
+	TAlgorithm m_eAlgorithm;
+	int m_nPow2Algorithm;                 // RADIX2 or STOCKHAM (SetAlgorithm()), -1 - planner
+	int m_nTuneAlgorithm;                 // algorithm timed by the planner, -1 - none
+	TSimd m_eSimd;
+	size_t m_nSize;
+	size_t m_nCplxSize;                   // points of the underlying complex transform
+	size_t m_nLanes;                      // signals interleaved by ExecuteMany()
+	int m_nThreads;
+	bool m_bInverse;
+	bool m_bBackward;                     // direction of the underlying complex transform
+	bool m_bOrthNorm;
+	T m_fNorm;
+
+	std::vector<T> m_arTwiddle;           // exp(-+2*pi*i*k/N), k = 0..N-1 (interleaved),
+	                                      // twiddles of every radix-4 pass for RADIX2, STOCKHAM
+	std::vector<unsigned int> m_arBitRev; // bit reversal permutation (RADIX2)
+	std::vector<size_t> m_arFactors;      // (radix, remaining length) pairs (MIXED_RADIX),
+	                                      // N1, N2 (FOUR_STEP)
+	std::vector<T> m_arChirp;             // exp(-+i*pi*n^2/N) (BLUESTEIN)
+	std::vector<T> m_arChirpSpectrum;     // transform of conj(chirp) divided by M (BLUESTEIN)
+	std::vector<T> m_arShift;             // exp(i*pi*k/2N), k = 0..N-1 (DCT, DST, DST2, odd DCT4)
+	std::vector<T> m_arRealTwiddle;       // exp(-+2*pi*i*k/N), k = 0..N/2-1 (REAL of even size,
+	                                      // DCT1 and DST1 of 2(N-+1) points)
+	std::vector<T> m_arDctTwiddle;        // pre and post-twiddles of DCT4, DST4, MDCT
+	std::vector<T> m_arWindow;            // MDCT window, empty - none
+	std::vector<T> m_arWork;              // 2*N values of scratch space
+	std::vector<T> m_arAlgWork;           // scratch space of the complex transform
+	std::vector<T> m_arLaneTwiddle;       // m_arTwiddle, each entry repeated m_nLanes times
+	std::vector<T> m_arBatch;             // gather/scatter buffer of ExecuteMany()
+	std::vector<T> m_arSplitTwiddle;      // m_arTwiddle of RADIX2, real parts of every block
+	                                      // of L twiddles, then imaginary parts (ExecuteSplit())
+	std::vector<T> m_arSplit;             // buffer of ExecuteSplit()
+	CFFTPlanT *m_pSubPlan;                // 2^m-point transform (BLUESTEIN)
+	std::vector<CFFTPlanT *> m_arStepPlans; // N1 and N2-point transforms of every thread (FOUR_STEP)
+	CFFTThreadPool *m_pPool;              // worker threads (FOUR_STEP), NULL - none
+};
+
+typedef CFFTPlanT<double> CFFTPlan;
+typedef CFFTPlanT<float> CFFTPlanF;
+
+// Multidimensional transform plan of a row-major nSize0 x nSize1 (x nSize2) array,
+// the last dimension is contiguous. Separable: 1-D transforms of CFFTPlanT run along
+// every dimension. Dimensions other than the last one are brought in rows by blocked
+// transposes through a scratch buffer of the array size, so no strided access is done.
+// COMPLEX    - 2-D/3-D FFT, complex -> complex
+// DCT, ...   - every real to real type of CFFTPlanT but MDCT, e.g. DCT-II (DCT-III when bInverse)
+// With bOrthNorm the transform is orthonormal (e.g. the 8x8 DCT of JPEG).
+template <class T>
+class CFFTPlanNDT : public CFFTPlanBase
+{
+public:
+	CFFTPlanNDT();
+	~CFFTPlanNDT();
+
+	int Create2D(TTransform eType, size_t nSize0, size_t nSize1, bool bInverse, bool bOrthNorm = true);
+	int Create3D(TTransform eType, size_t nSize0, size_t nSize1, size_t nSize2, bool bInverse, bool bOrthNorm = true);
+	void Reset();
+
+	TTransform GetType() const { return m_eType; };
+	size_t GetDims() const { return m_nDims; };
+	size_t GetSize(size_t nDim) const { return nDim < m_nDims ? m_arSize[nDim] : 1; };
+	bool IsInverse() const { return m_bInverse; };
+
+	// Arrays of 65536 elements and more are split between nThreads threads by rows.
+	// 1 (default) - no threads. Can be called before or after Create2D()/Create3D().
+	int SetThreads(int nThreads);
+	int GetThreads() const { return m_nThreads; };
+
+	// Caller provided arrays of nSize0 * nSize1 (* nSize2) elements. In place when pIn == pOut.
+	// COMPLEX
+	int Execute(std::complex<T> *pData);
+	int Execute(const std::complex<T> *pIn, std::complex<T> *pOut);
+	// DCT, DST, DCT1, DCT4, DST1, DST2, DST4
+	int Execute(T *pData);
+	int Execute(const T *pIn, T *pOut);
+
+private:
+	CFFTPlanNDT(const CFFTPlanNDT &);
+	CFFTPlanNDT &operator=(const CFFTPlanNDT &);
+
+	int Create(TTransform eType, size_t nDims, const size_t *pSize, bool bInverse, bool bOrthNorm);
+	template <class E>
+	void ExecuteAxes(const E *pIn, E *pOut, E *pWork);
+
+	TTransform m_eType;
+	size_t m_nDims;
+	size_t m_arSize[3];
+	size_t m_nTotal;                      // number of elements
+	bool m_bInverse;
+	bool m_bOrthNorm;
+	int m_nThreads;
+
+	std::vector<CFFTPlanT<T> *> m_arPlans; // plan of every dimension and thread, [nDim * m_nThreads + nThread]
+	std::vector<T> m_arWork;              // transposed array
+	CFFTThreadPool *m_pPool;              // worker threads (65536 elements and more), NULL - none
+};
+
+typedef CFFTPlanNDT<double> CFFTPlanND;
+typedef CFFTPlanNDT<float> CFFTPlanNDF;
+
+// Streaming FIR filter: convolution of a real signal with a real kernel.
+// Uniformly partitioned overlap-save: the kernel is split into partitions of nBlockSize
+// samples and their spectra (2*nBlockSize-point real FFT) are computed once in Create().
+// Every nBlockSize input samples one forward and one inverse transform are done and the
+// spectra of the last blocks are multiplied by the partition spectra.
+// The output is delayed by GetLatency() = nBlockSize samples. Smaller blocks mean less
+// latency and more work per sample. Powers of 2 are the fastest block sizes.
+template <class T>
+class CFFTConvolverT
+{
+public:
+	CFFTConvolverT();
+
+	int Create(size_t nKernelLen, const T *pKernel, size_t nBlockSize);
+	void Reset();
+	// Forget the input history (as if only zeros were processed), keep the kernel
+	void Clear();
+
+	size_t GetKernelSize() const { return m_nKernel; };
+	size_t GetBlockSize() const { return m_nBlock; };
+	size_t GetLatency() const { return m_nBlock; };
+
+	// Filters nCnt samples of any number. pOut[i] is the filtered signal GetLatency()
+	// samples earlier. In place when pIn == pOut. No allocations.
+	int Process(size_t nCnt, const T *pIn, T *pOut);
+
+private:
+	CFFTConvolverT(const CFFTConvolverT &);
+	CFFTConvolverT &operator=(const CFFTConvolverT &);
+
+	void ProcessBlock();
+
+	size_t m_nKernel;
+	size_t m_nBlock;
+	size_t m_nParts;                      // number of kernel partitions
+	size_t m_nPos;                        // input samples of the current block
+	size_t m_nSlot;                       // delay line slot of the last block
+	CFFTPlanT<T> m_Forward;               // 2*nBlockSize real -> nBlockSize+1 complex
+	CFFTPlanT<T> m_Inverse;
+	std::vector<std::complex<T> > m_arKernelSpectra; // m_nParts spectra of nBlockSize+1 bins
+	std::vector<std::complex<T> > m_arDelayLine;     // spectra of the last m_nParts input blocks
+	std::vector<std::complex<T> > m_arSum;
+	std::vector<T> m_arInput;             // previous and current input block
+	std::vector<T> m_arBlockOut;          // 2*nBlockSize samples, the last half is valid
+	std::vector<T> m_arOutput;            // output of the previous block
+};
+
+typedef CFFTConvolverT<double> CFFTConvolver;
+typedef CFFTConvolverT<float> CFFTConvolverF;
+
+// Cross-correlation of real signals of nLen1 and nLen2 samples by FFT:
+// z[k] = sum x[n + k] * y[n], lags k = -(nLen2-1) .. nLen1-1 (numpy/scipy correlate()).
+// Both signals are zero padded to GetFFTSize() >= nLen1 + nLen2 - 1 points (the smallest
+// even 2^a*3^b*5^c) and packed into one complex sequence x + i*y, so a single complex
+// transform gives both spectra. X * conj(Y) is formed in the same pass that splits them,
+// one inverse real transform gives the correlation. Plans and scratch space are made in
+// Create(), so the calls do no allocations.
+template <class T>
+class CFFTCorrelatorT
+{
+public:
+	// FULL  - every lag with overlap, nLen1 + nLen2 - 1 values
+	// SAME  - nLen1 values centered on FULL, lags -(nLen2/2) .. (as scipy.signal.correlate())
+	// VALID - lags where the shorter signal overlaps completely, |nLen1 - nLen2| + 1 values
+	enum TMode { FULL=0, SAME, VALID };
+
+	CFFTCorrelatorT();
+
+	// nLen2 = 0 - same as nLen1 (e.g. autocorrelation only)
+	int Create(size_t nLen1, size_t nLen2 = 0);
+	void Reset();
+
+	size_t GetSize1() const { return m_nLen1; };
+	size_t GetSize2() const { return m_nLen2; };
+	size_t GetFFTSize() const { return m_nFFT; };
+	size_t GetBins() const { return m_nFFT / 2 + 1; };
+	// Values of Correlate() and AutoCorrelate() (with nLen2 = nLen1) in eMode
+	size_t GetOutputSize(TMode eMode) const;
+	// Lag of the first value in eMode
+	long long GetFirstLag(TMode eMode) const;
+
+	// pX - nLen1 samples, pY - nLen2 samples, pOut - GetOutputSize(eMode) values
+	int Correlate(const T *pX, const T *pY, T *pOut, TMode eMode = FULL);
+	// z[k] = sum x[n + k] * x[n], pX - nLen1 samples. Needs nLen2 >= nLen1.
+	// Runs a real transform, half of the work of Correlate().
+	int AutoCorrelate(const T *pX, T *pOut, TMode eMode = FULL);
+	// X[k] * conj(Y[k]), k = 0 .. GetBins()-1, DFTs (not normalized) of the signals
+	// zero padded to GetFFTSize() points
+	int CrossPowerSpectrum(const T *pX, const T *pY, std::complex<T> *pOut);
+
+private:
+	CFFTCorrelatorT(const CFFTCorrelatorT &);
+	CFFTCorrelatorT &operator=(const CFFTCorrelatorT &);
+
+	void Spectrum(const T *pX, const T *pY, T fScale);
+	void Lags(long long nFirst, size_t nCnt, T *pOut);
+
+	size_t m_nLen1;
+	size_t m_nLen2;
+	size_t m_nFFT;
+	CFFTPlanT<T> m_Complex;               // forward transform of x + i*y
+	CFFTPlanT<T> m_Forward;               // forward real transform of AutoCorrelate()
+	CFFTPlanT<T> m_Inverse;               // product spectrum -> circular correlation
+	std::vector<std::complex<T> > m_arWork; // GetFFTSize() values, the product spectrum in front
+	std::vector<T> m_arCorr;              // circular correlation, lag k at k mod GetFFTSize()
+};
+
+typedef CFFTCorrelatorT<double> CFFTCorrelator;
+typedef CFFTCorrelatorT<float> CFFTCorrelatorF;
+
+// Short-time Fourier transform of a real signal. Frame f holds samples f*nHop ..
+// f*nHop+nFrameSize-1 multiplied by the window, its nFrameSize-point real transform
+// is row f of a time x frequency matrix of GetBins() = nFrameSize/2+1 columns.
+// Frames start at the first sample, pad the signal with nFrameSize/2 zeros on both
+// sides for centered frames. No allocations after Create().
+template <class T>
+class CSTFTT
+{
+public:
+	CSTFTT();
+
+	// pWindow - nFrameSize samples, NULL - periodic Hann window 0.5 - 0.5*cos(2*pi*n/nFrameSize).
+	// bOrthNorm is the normalization of the real transforms (see CFFTPlanT).
+	int Create(size_t nFrameSize, size_t nHop, const T *pWindow = NULL, bool bOrthNorm = true);
+	void Reset();
+	// Forget the samples of Push() not yet in a frame
+	void Clear();
+
+	size_t GetFrameSize() const { return m_nFrame; };
+	size_t GetHop() const { return m_nHop; };
+	size_t GetBins() const { return m_nFrame / 2 + 1; };
+	// Frames of a signal of nCnt samples (0 when shorter than a frame)
+	size_t GetFrameCount(size_t nCnt) const;
+	// Samples restored from nFrames frames
+	size_t GetSignalSize(size_t nFrames) const;
+
+	// Whole signal: GetFrameCount(nCnt) rows to pOut
+	int Forward(size_t nCnt, const T *pIn, std::complex<T> *pOut);
+	// Streaming: chunks of any size, frames completed by the chunk are written to pOut
+	// (room for nCnt/nHop+1 rows), nFrames is their number. Same frames as Forward()
+	// of the whole stream.
+	int Push(size_t nCnt, const T *pIn, std::complex<T> *pOut, size_t &nFrames);
+	// ISTFT: inverse transforms of nFrames rows, windowed and overlap-added, divided by the
+	// sum of squared windows. GetSignalSize(nFrames) samples to pOut. Samples no window
+	// covers (zeros of the window) are set to 0.
+	int Inverse(size_t nFrames, const std::complex<T> *pIn, T *pOut);
+
+private:
+	CSTFTT(const CSTFTT &);
+	CSTFTT &operator=(const CSTFTT &);
+
+	void Frame(const T *pIn, std::complex<T> *pOut);
+
+	size_t m_nFrame;
+	size_t m_nHop;
+	size_t m_nFill;                       // samples of Push() in m_arBuffer
+	size_t m_nSkip;                       // samples of Push() to drop (nHop > nFrameSize)
+	CFFTPlanT<T> m_Forward;
+	CFFTPlanT<T> m_Inverse;
+	std::vector<T> m_arWindow;
+	std::vector<T> m_arFrame;             // windowed frame
+	std::vector<T> m_arBuffer;            // next frame of Push()
+};
+
+typedef CSTFTT<double> CSTFT;
+typedef CSTFTT<float> CSTFTF;
+
+// Fixed-point complex FFT of 2^m points for integer pipelines. T is short (Q15,
+// CFFTFixedQ15) or int (Q31, CFFTFixedQ31), data are interleaved (re, im) pairs.
+// Block floating point: before every radix-2 stage the whole block is shifted right
+// by 1 or 2 bits if the stage could overflow, the total shift is returned as the
+// block exponent. out * 2^nExponent is the unnormalized transform (FFT() with
+// bOrthNorm = false, the same before the 1/N of an inverse). Products are rounded
+// to nearest (as pmulhrsw), Q15 stages run 16 values per AVX2 register.
+// Twiddles are cos, sin * (2^15-1) or (2^31-1). No allocations after Create().
+template <class T>
+class CFFTFixedT : public CFFTPlanBase
+{
+public:
+	CFFTFixedT();
+
+	// nSize is a power of 2, 2..2^24. REAL transforms (ExecuteReal()) need nSize >= 4.
+	int Create(size_t nSize, bool bInverse);
+	void Reset();
+
+	size_t GetSize() const { return m_nSize; };
+	bool IsInverse() const { return m_bInverse; };
+
+	// Restricts the instruction set (e.g. to cross check the results), see CFFTPlanT
+	int SetSimd(TSimd eSimd);
+	TSimd GetSimd() const { return m_eSimd; };
+
+	// Complex transform in place, 2*GetSize() values
+	int Execute(T *pData, int &nExponent);
+	// Forward real transform, GetSize() real -> GetSize()/2+1 complex (GetSize()+2 values).
+	// Even and odd samples form a GetSize()/2-point complex sequence (see CFFTPlanT).
+	// Inverse plans: GetSize()/2+1 complex -> GetSize() real, in place when pIn == pOut
+	// (imaginary parts of bins 0 and GetSize()/2 are ignored).
+	int ExecuteReal(const T *pIn, T *pOut, int &nExponent);
+
+private:
+	int Transform(size_t N, T *a, long long &nMax);
+	int InverseReal(const T *pIn, T *pOut, int &nExponent);
+
+	size_t m_nSize;
+	bool m_bInverse;
+	TSimd m_eSimd;
+	T m_nMax;                             // 2^15-1 or 2^31-1
+	T m_nGuard;                           // largest |value| a radix-2 stage can't overflow
+	std::vector<T> m_arTwiddle;           // (cos, -+sin) of 2*pi*k/2L, k < L, of every stage
+	                                      // L = 1, 2, 4, .., N/2 (interleaved)
+	std::vector<unsigned int> m_arBitRev; // bit reversal of N points (of N/2: m_arBitRev[2*i])
+};
+
+typedef CFFTFixedT<short> CFFTFixedQ15;
+typedef CFFTFixedT<int> CFFTFixedQ31;
+
+// Exact products of integer sequences by FFT, O(n log n) instead of the O(n^2) loop:
+// polynomial products (with wrap-around or modular coefficients) and products of
+// big integers. Values are split into limbs of GetLimbBits() bits (16 or 8), every
+// pair of limb sequences is convolved by REAL transforms in double precision and the
+// rounded sums are recombined. Create() chooses the limb size from the sizes, so the
+// convolutions stay well below 2^53. A call checks how far the inverse transforms are
+// from integers, and redoes the product with 8-bit limbs if that is more than 1/4
+// (this allocates once). Forward transforms of the second factor are skipped when
+// both pointers are equal (squares). No allocations after Create().
+class CFFTMultiplier
+{
+public:
+	CFFTMultiplier();
+
+	// nLen1, nLen2 - values (coefficients, limbs) of the factors, nLen2 = 0 - same as nLen1
+	int Create(size_t nLen1, size_t nLen2 = 0);
+	void Reset();
+
+	size_t GetSize1() const { return m_nLen1; };
+	size_t GetSize2() const { return m_nLen2; };
+	size_t GetFFTSize() const { return m_nFFT; };
+	int GetLimbBits() const { return m_nBits; };
+
+	// Polynomial product, nLen1 + nLen2 - 1 coefficients to pOut. Exact as long as the
+	// coefficients fit long long, modulo 2^64 otherwise (as the loop with long long).
+	int MultiplyPoly(const long long *pA, const long long *pB, long long *pOut);
+	// Polynomial product modulo nMod (1 .. 2^32-1), nLen1 + nLen2 - 1 coefficients.
+	// Coefficients of the factors may be >= nMod.
+	int MultiplyMod(const unsigned int *pA, const unsigned int *pB, unsigned int nMod, unsigned int *pOut);
+	// Product of unsigned big integers, 32-bit limbs, least significant first.
+	// nLen1 + nLen2 limbs to pOut.
+	int MultiplyBig(const unsigned int *pA, const unsigned int *pB, unsigned int *pOut);
+
+private:
+	CFFTMultiplier(const CFFTMultiplier &);
+	CFFTMultiplier &operator=(const CFFTMultiplier &);
+
+	void SetBits(int nBits);
+	template <class E>
+	void Spectra(const E *p, size_t nCnt, int nLimbs, unsigned int nMod, std::complex<double> *pSpectra);
+	double Products(int nLimbs, int nSums, const std::complex<double> *pSpectraB);
+	template <class E>
+	int Convolve(const E *pA, const E *pB, int nWidth, unsigned int nMod, bool bAllSums);
+
+	size_t m_nLen1;
+	size_t m_nLen2;
+	size_t m_nFFT;
+	int m_nBits;                          // limb size
+	CFFTPlan m_Forward;
+	CFFTPlan m_Inverse;
+	std::vector<double> m_arLimbs;        // GetFFTSize() values, a limb sequence zero padded
+	std::vector<std::complex<double> > m_arSpectra; // spectra of the limb sequences of both
+	                                      // factors, GetFFTSize()/2+1 bins each
+	std::vector<std::complex<double> > m_arSum; // sum of the products of spectra of a limb sum
+	std::vector<double> m_arProducts;     // convolution of every limb sum, GetFFTSize() values each
+};
+
+// Window functions of nSize samples for frames of real transforms (CSTFTT, CFilterbankT).
+// Periodic windows (bPeriodic) are the DFT-even ones of spectral analysis: period M = nSize,
+// as scipy.signal.get_window(). Symmetric windows have M = nSize - 1.
+// RECTANGULAR     - 1
+// HANN            - 0.5 - 0.5*cos(2*pi*n/M)
+// HAMMING         - 0.54 - 0.46*cos(2*pi*n/M)
+// BLACKMAN        - 0.42 - 0.5*cos(2*pi*n/M) + 0.08*cos(4*pi*n/M)
+// BLACKMAN_HARRIS - 0.35875 - 0.48829*cos(2*pi*n/M) + 0.14128*cos(4*pi*n/M) - 0.01168*cos(6*pi*n/M)
+// SINE            - sin(pi*(n + 0.5)/(M + 1)), the MDCT window for even nSize
+class CFFTWindow
+{
+public:
+	enum TWindow { RECTANGULAR=0, HANN, HAMMING, BLACKMAN, BLACKMAN_HARRIS, SINE };
+
+	// Returns -1 if nSize is 0, -2 for an unknown window
+	static int Make(TWindow eWindow, size_t nSize, double *pOut, bool bPeriodic = true);
+	static int Make(TWindow eWindow, size_t nSize, float *pOut, bool bPeriodic = true);
+};
+
+// Filterbank on the power spectrum of a real transform: band b is
+// sum w[b][k] * |X[k]|^2 over the bins k = 0 .. nFFTSize/2 with w[b][k] != 0.
+// The weights are kept in CSR form (bins and weights of every band one after another,
+// a start index per band), Apply() squares the bins it reads, so there is no pass over
+// the whole spectrum and no power vector. Process() windows a frame and runs the real
+// transform into a buffer of the filterbank before. No allocations after Create().
+// MEL       - triangles on the HTK mel scale 2595*log10(1 + f/700): the centers of
+//             nBands + 2 points equally spaced in mels from fLowHz to fHighHz, band b
+//             rises from point b to 1 at point b+1 and falls to 0 at point b+2 (linear in Hz)
+// BARK      - the same on Traunmueller's bark scale 26.81*f/(1960 + f) - 0.53
+// GAMMATONE - power response (1 + ((f - fc)/B)^2)^-4 of 4th order gammatone filters, nBands
+//             centers fc equally spaced on the ERB-number scale 21.4*log10(1 + 0.00437*f) from
+//             fLowHz to fHighHz, B = 1.019*24.7*(0.00437*fc + 1) (Glasberg and Moore). Weights
+//             below 1e-4 (-40 dB) are left out.
+template <class T>
+class CFilterbankT
+{
+public:
+	enum TScale { MEL=0, BARK, GAMMATONE };
+
+	CFilterbankT();
+
+	// Bands of an nFFTSize-point real transform of a signal sampled at fSampleRate Hz.
+	// fHighHz = 0 - fSampleRate/2. bOrthNorm is the normalization of the transform of
+	// Process() (see CFFTPlanT). The window of Process() is the periodic Hann window.
+	int Create(TScale eScale, size_t nFFTSize, double fSampleRate, size_t nBands,
+		double fLowHz = 0., double fHighHz = 0., bool bOrthNorm = true);
+	// Given weights: band b has pWeights[j] of bins pBins[j], j = pRowStart[b] .. pRowStart[b+1]-1.
+	// Returns -2 if the rows or bins are out of range.
+	int Create(size_t nFFTSize, size_t nBands, const size_t *pRowStart, const size_t *pBins,
+		const T *pWeights, bool bOrthNorm = true);
+	void Reset();
+
+	// Window of the frames of Process(), GetFFTSize() samples. NULL - no window.
+	int SetWindow(const T *pWindow);
+
+	size_t GetFFTSize() const { return m_nFFT; };
+	size_t GetBins() const { return m_nFFT / 2 + 1; };
+	size_t GetBands() const { return m_arRowStart.empty() ? 0 : m_arRowStart.size() - 1; };
+	// Center of band b in Hz (0 for given weights)
+	double GetCenterFrequency(size_t nBand) const;
+	// Bins and weights of band b, returns their number
+	size_t GetWeights(size_t nBand, const unsigned int *&pBins, const T *&pWeights) const;
+
+	// pSpectrum - GetBins() bins (REAL plan, RFFT(), a row of CSTFTT), pBands - GetBands() values
+	int Apply(const std::complex<T> *pSpectrum, T *pBands) const;
+	// pFrame - GetFFTSize() samples
+	int Process(const T *pFrame, T *pBands);
+
+private:
+	CFilterbankT(const CFilterbankT &);
+	CFilterbankT &operator=(const CFilterbankT &);
+
+	int Prepare(size_t nFFTSize, bool bOrthNorm);
+
+	size_t m_nFFT;
+	CFFTPlanT<T> m_Forward;
+	std::vector<T> m_arWindow;            // empty - none
+	std::vector<T> m_arFrame;             // windowed frame
+	std::vector<std::complex<T> > m_arSpectrum;
+	std::vector<unsigned int> m_arRowStart; // first weight of every band, GetBands()+1 values
+	std::vector<unsigned int> m_arBin;    // bin of every weight
+	std::vector<T> m_arWeight;
+	std::vector<double> m_arCenter;       // Hz, empty for given weights
+};
+
+typedef CFilterbankT<double> CFilterbank;
+typedef CFilterbankT<float> CFilterbankF;
+
+// Hilbert transform and analytic signal of nSize real samples (periodic, as
+// scipy.signal.hilbert()). The Hilbert transform h has the spectrum -i*sign(k)*X[k], so it
+// is real and takes one forward REAL transform and one inverse REAL transform of the
+// half spectrum: bins 1 .. nSize/2 are rotated by -i, the DC bin and the Nyquist bin of
+// even sizes become 0. The analytic signal is x + i*h, the envelope is |x + i*h|.
+// The half spectrum is kept in a buffer of the object and transformed back in place
+// there, no allocations after Create(). Not reentrant, use one object per thread.
+template <class T>
+class CHilbertT
+{
+public:
+	CHilbertT();
+
+	// Returns -1 if nSize < 2 (see CFFTPlanT::Create())
+	int Create(size_t nSize);
+	void Reset();
+
+	size_t GetSize() const { return m_nSize; };
+
+	// GetSize() samples in and out. In place when pIn == pOut.
+	int Hilbert(const T *pIn, T *pOut);
+	int Envelope(const T *pIn, T *pOut);
+	// x[n] + i*h[n], GetSize() values
+	int Analytic(const T *pIn, std::complex<T> *pOut);
+
+private:
+	CHilbertT(const CHilbertT &);
+	CHilbertT &operator=(const CHilbertT &);
+
+	// Half spectrum of pIn, rotated (-i*sign(k)) in m_arSpectrum
+	void Rotate(const T *pIn);
+
+	size_t m_nSize;
+	CFFTPlanT<T> m_Forward;
+	CFFTPlanT<T> m_Inverse;
+	std::vector<std::complex<T> > m_arSpectrum; // GetSize()/2+1 bins, then h in place
+};
+
+typedef CHilbertT<double> CHilbert;
+typedef CHilbertT<float> CHilbertF;
@@ -2,6 +2,9 @@
 #define _RNG_H_INCLUDED_2014_04_01
 
 #include <time.h>
+#include <assert.h>
+
+class CRngEngineArc4Ex;
 
 template <typename RngEngine = CRngEngineArc4Ex>
 class CRandom
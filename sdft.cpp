@@ -0,0 +1,422 @@
+#include <stdio.h>
+#include <math.h>
+#include <memory.h>
+#include <vector>
+#include <complex>
+#include "sdft.h"
+#include "fft.h"
+#include "stat.h"
+
+const double const_SDFT_PI = (double) 3.141592653589793238462643383279502884;
+
+template <class T>
+CGoertzelT<T>::CGoertzelT()
+	: m_nSize(0)
+{
+}
+
+template <class T>
+void CGoertzelT<T>::Reset()
+{
+	m_nSize = 0;
+	m_arBins.clear();
+	m_arCoef.clear();
+	m_arPhase.clear();
+	m_arState.clear();
+}
+
+template <class T>
+int CGoertzelT<T>::Create(size_t nSize, size_t nBins, const double *pBins)
+{
+	Reset();
+
+	if (nSize < 1 || nBins < 1 || pBins == NULL) return -1;
+
+	size_t b;
+	m_nSize = nSize;
+	m_arBins.assign(pBins, pBins + nBins);
+	m_arCoef.resize(nBins);
+	m_arPhase.resize(4 * nBins);
+	m_arState.resize(2 * nBins);
+	for (b = 0; b < nBins; b++)
+	{
+		double w = 2. * const_SDFT_PI * pBins[b] / double(nSize);
+		m_arCoef[b] = T(2. * cos(w));
+		m_arPhase[4 * b] = T(cos(w * double(nSize - 1)));
+		m_arPhase[4 * b + 1] = T(-sin(w * double(nSize - 1)));
+		m_arPhase[4 * b + 2] = T(cos(w));
+		m_arPhase[4 * b + 3] = T(-sin(w));
+	}
+	return 0;
+}
+
+// s[n] = x[n] + 2*cos(w) * s[n-1] - s[n-2],
+// X = exp(-i*w*(N-1)) * (s[N-1] - exp(-i*w) * s[N-2])
+template <class T>
+int CGoertzelT<T>::Execute(const T *pIn, std::complex<T> *pOut)
+{
+	if (m_nSize == 0) return -1;
+
+	const size_t nBins = m_arBins.size();
+	size_t n, b;
+	const T *c = &m_arCoef[0];
+	T *s1 = &m_arState[0];
+	T *s2 = s1 + nBins;
+
+	for (b = 0; b < nBins; b++)
+		s1[b] = s2[b] = 0.;
+	for (n = 0; n < m_nSize; n++)
+	{
+		T x = pIn[n];
+		for (b = 0; b < nBins; b++)
+		{
+			T s0 = x + c[b] * s1[b] - s2[b];
+			s2[b] = s1[b];
+			s1[b] = s0;
+		}
+	}
+
+	const T *p = &m_arPhase[0];
+	for (b = 0; b < nBins; b++, p += 4)
+	{
+		T yr = s1[b] - p[2] * s2[b];
+		T yi = -p[3] * s2[b];
+		pOut[b] = std::complex<T>(p[0] * yr - p[1] * yi, p[0] * yi + p[1] * yr);
+	}
+	return 0;
+}
+
+template class CGoertzelT<double>;
+template class CGoertzelT<float>;
+
+template <class T>
+CSlidingDFTT<T>::CSlidingDFTT()
+	: m_nSize(0)
+	, m_nPos(0)
+	, m_nCount(0)
+{
+}
+
+template <class T>
+void CSlidingDFTT<T>::Reset()
+{
+	m_nSize = 0;
+	m_nPos = 0;
+	m_nCount = 0;
+	m_Goertzel.Reset();
+	m_arX.clear();
+	m_arRotate.clear();
+	m_arNew.clear();
+	m_arRing.clear();
+}
+
+template <class T>
+int CSlidingDFTT<T>::Create(size_t nSize, size_t nBins, const double *pBins)
+{
+	Reset();
+
+	int nRes = m_Goertzel.Create(nSize, nBins, pBins);
+	if (nRes != 0) return nRes;
+
+	size_t b;
+	m_nSize = nSize;
+	m_arX.resize(nBins);
+	m_arRotate.resize(nBins);
+	m_arNew.resize(nBins);
+	m_arRing.resize(2 * nSize);
+	for (b = 0; b < nBins; b++)
+	{
+		double w = 2. * const_SDFT_PI * pBins[b] / double(nSize);
+		m_arRotate[b] = std::complex<T>(T(cos(w)), T(sin(w)));
+		m_arNew[b] = std::complex<T>(T(cos(w * double(nSize - 1))), T(-sin(w * double(nSize - 1))));
+	}
+	Clear();
+	return 0;
+}
+
+template <class T>
+void CSlidingDFTT<T>::Clear()
+{
+	size_t i;
+	for (i = 0; i < m_arX.size(); i++)
+		m_arX[i] = 0.;
+	for (i = 0; i < m_arRing.size(); i++)
+		m_arRing[i] = 0.;
+	m_nPos = 0;
+	m_nCount = 0;
+}
+
+template <class T>
+int CSlidingDFTT<T>::Push(size_t nCnt, const T *pIn, std::complex<T> *pOut/* = NULL*/)
+{
+	if (m_nSize == 0) return -1;
+
+	const size_t N = m_nSize;
+	const size_t nBins = m_arX.size();
+	size_t i, b;
+	T *x = reinterpret_cast<T *>(&m_arX[0]);
+	const T *r = reinterpret_cast<const T *>(&m_arRotate[0]);
+	const T *w = reinterpret_cast<const T *>(&m_arNew[0]);
+	T *ring = &m_arRing[0];
+
+	for (i = 0; i < nCnt; i++)
+	{
+		T xNew = pIn[i];
+		T xOld = ring[m_nPos];
+		ring[m_nPos] = xNew;
+		ring[m_nPos + N] = xNew;
+		m_nPos = (m_nPos + 1 == N) ? 0 : m_nPos + 1;
+
+		if (++m_nCount == N)
+		{
+			m_Goertzel.Execute(ring + m_nPos, &m_arX[0]);
+			m_nCount = 0;
+		}
+		else
+		{
+			for (b = 0; b < nBins; b++)
+			{
+				T dr = x[2 * b] - xOld;
+				T di = x[2 * b + 1];
+				x[2 * b] = r[2 * b] * dr - r[2 * b + 1] * di + w[2 * b] * xNew;
+				x[2 * b + 1] = r[2 * b] * di + r[2 * b + 1] * dr + w[2 * b + 1] * xNew;
+			}
+		}
+
+		if (pOut != NULL)
+			memcpy(pOut + i * nBins, &m_arX[0], nBins * sizeof(std::complex<T>));
+	}
+	return 0;
+}
+
+template class CSlidingDFTT<double>;
+template class CSlidingDFTT<float>;
+
+static int nTestNum = 0;
+static int nTestErrNum = 0;
+
+#define TEST(a) { nTestNum ++; \
+	if (!(a)) {printf("Test %d FAILED! (%s)\n", nTestNum, #a); nTestErrNum++; } }
+
+// Bins of the window x[0..n-1] (slow)
+static void do_bins_slow(size_t n, const double *x, size_t nBins, const double *pBins, std::complex<double> *out)
+{
+	size_t b, i;
+	for (b = 0; b < nBins; b++)
+	{
+		std::complex<double> v = 0.;
+		for (i = 0; i < n; i++)
+		{
+			double phi = 2. * const_SDFT_PI * pBins[b] * double(i) / double(n);
+			v += x[i] * std::complex<double>(cos(phi), -sin(phi));
+		}
+		out[b] = v;
+	}
+}
+
+int run_SDFT_selftest()
+{
+	printf("\nGoertzel bank\n");
+	{
+		const size_t N = 64;
+		double arBins[] = {0., 1., 5.5, 31., 32., 63.};
+		const size_t nBins = sizeof(arBins) / sizeof(arBins[0]);
+		std::vector<double> arX(N);
+		std::vector<std::complex<double> > arRef(nBins), arRes(nBins), arFFT(N);
+		size_t i, b;
+		for (i = 0; i < N; i++)
+			arX[i] = sin(0.3 * double(i)) + double(i % 5) * 0.1;
+
+		CGoertzel bank;
+		TEST(bank.Create(N, nBins, arBins) == 0);
+		TEST(bank.GetBinCount() == nBins);
+		TEST(bank.Execute(&arX[0], &arRes[0]) == 0);
+		do_bins_slow(N, &arX[0], nBins, arBins, &arRef[0]);
+		double fErr = 0.;
+		for (b = 0; b < nBins; b++)
+		{
+			double e = std::abs(arRef[b] - arRes[b]);
+			if (e > fErr) fErr = e;
+		}
+		TEST(fErr < 1e-12);
+
+		// Integer bins are bins of the FFT
+		CFFTPlan plan;
+		plan.Create(CFFTPlan::COMPLEX, N, false);
+		plan.Execute(&arX[0], &arFFT[0]);
+		for (b = 0; b < nBins; b++)
+		{
+			if (arBins[b] != floor(arBins[b]))
+				continue;
+			TEST(std::abs(arFFT[size_t(arBins[b])] * ::sqrt(double(N)) - arRes[b]) < 1e-12);
+		}
+		printf("N=%d max.err=%g\n", int(N), fErr);
+
+		CGoertzelF bankf;
+		std::vector<float> arXF(N);
+		std::vector<std::complex<float> > arResF(nBins);
+		for (i = 0; i < N; i++)
+			arXF[i] = float(arX[i]);
+		TEST(bankf.Create(N, nBins, arBins) == 0);
+		TEST(bankf.Execute(&arXF[0], &arResF[0]) == 0);
+		for (b = 0; b < nBins; b++)
+			TEST(std::abs(std::complex<double>(arResF[b]) - arRef[b]) < 1e-4);
+
+		TEST(bank.Create(0, nBins, arBins) == -1);
+		TEST(bank.Execute(&arX[0], &arRes[0]) == -1);
+		printf("%d tests, %d failed\n", nTestNum, nTestErrNum);
+	}
+
+	printf("\nSliding DFT\n");
+	{
+		const size_t N = 100;
+		const size_t nLen = 2000;
+		double arBins[] = {0., 3., 10.25, 50.};
+		const size_t nBins = sizeof(arBins) / sizeof(arBins[0]);
+		std::vector<double> arX(nLen + N, 0.);
+		std::vector<std::complex<double> > arRows(nLen * nBins), arRef(nBins);
+		size_t i, b;
+		for (i = 0; i < nLen; i++)
+			arX[N + i] = cos(0.05 * double(i)) + double((i * 7) % 11) * 0.05;
+
+		CSlidingDFT sdft;
+		TEST(sdft.Create(N, nBins, arBins) == 0);
+		TEST(sdft.GetBinCount() == nBins);
+
+		// Chunks of varying size, bins after every sample
+		size_t nCnt, nChunk;
+		int nRes = 0;
+		for (i = 0, nChunk = 0; i < nLen; i += nCnt, nChunk++)
+		{
+			nCnt = (nChunk * 13) % 37 + 1;
+			if (nCnt > nLen - i)
+				nCnt = nLen - i;
+			nRes |= sdft.Push(nCnt, &arX[N + i], &arRows[i * nBins]);
+		}
+		TEST(nRes == 0);
+
+		// Window after sample t is arX[t+1 .. t+N] (zeros before the signal)
+		double fErr = 0.;
+		for (i = 0; i < nLen; i += 7)
+		{
+			do_bins_slow(N, &arX[i + 1], nBins, arBins, &arRef[0]);
+			for (b = 0; b < nBins; b++)
+			{
+				double e = std::abs(arRef[b] - arRows[i * nBins + b]);
+				if (e > fErr) fErr = e;
+			}
+		}
+		TEST(fErr < 1e-11);
+		do_bins_slow(N, &arX[nLen], nBins, arBins, &arRef[0]);
+		for (b = 0; b < nBins; b++)
+			TEST(std::abs(arRef[b] - sdft.GetBins()[b]) < 1e-11);
+		printf("N=%d samples=%d max.err=%g\n", int(N), int(nLen), fErr);
+
+		// Clear() starts from zeros
+		sdft.Clear();
+		TEST(sdft.Push(N, &arX[N]) == 0);
+		do_bins_slow(N, &arX[N], nBins, arBins, &arRef[0]);
+		for (b = 0; b < nBins; b++)
+			TEST(std::abs(arRef[b] - sdft.GetBins()[b]) < 1e-11);
+
+		// Single precision
+		std::vector<float> arXF(nLen);
+		for (i = 0; i < nLen; i++)
+			arXF[i] = float(arX[N + i]);
+		CSlidingDFTF sdftf;
+		TEST(sdftf.Create(N, nBins, arBins) == 0);
+		TEST(sdftf.Push(nLen, &arXF[0]) == 0);
+		do_bins_slow(N, &arX[nLen], nBins, arBins, &arRef[0]);
+		for (b = 0; b < nBins; b++)
+			TEST(std::abs(arRef[b] - std::complex<double>(sdftf.GetBins()[b])) < 1e-3);
+
+		CSlidingDFT sdft2;
+		TEST(sdft2.Push(1, &arX[0]) == -1);
+		TEST(sdft2.GetBins() == NULL);
+		printf("%d tests, %d failed\n", nTestNum, nTestErrNum);
+	}
+
+	return 0;
+}
+
+// Benchmark: nBenchHops samples, bins of the last nBenchSize samples after every one
+static const size_t nBenchSize = 1024;
+static const size_t nBenchHops = 1024;
+static std::vector<double> arBenchSignal;
+static std::vector<std::complex<double> > arBenchOut;
+static CSlidingDFT *pBenchSDFT = NULL;
+static CGoertzel *pBenchBank = NULL;
+static CFFTPlan *pBenchPlan = NULL;
+
+static void bench_sdft()
+{
+	pBenchSDFT->Push(nBenchHops, &arBenchSignal[nBenchSize], &arBenchOut[0]);
+}
+
+static void bench_goertzel()
+{
+	size_t i;
+	for (i = 0; i < nBenchHops; i++)
+		pBenchBank->Execute(&arBenchSignal[i + 1], &arBenchOut[0]);
+}
+
+static void bench_plan()
+{
+	size_t i;
+	for (i = 0; i < nBenchHops; i++)
+		pBenchPlan->Execute(&arBenchSignal[i + 1], &arBenchOut[0]);
+}
+
+static void bench_fft()
+{
+	size_t i;
+	std::vector<std::complex<double> > arSpectrum;
+	for (i = 0; i < nBenchHops; i++)
+		FFT(nBenchSize, &arBenchSignal[i + 1], arSpectrum, false);
+}
+
+int run_SDFT_benchmark()
+{
+	printf("\nSliding DFT against FFT per hop\n");
+	{
+		double arBins[] = {10., 100., 200., 300.};
+		const size_t nBins = sizeof(arBins) / sizeof(arBins[0]);
+		size_t i;
+		arBenchSignal.resize(nBenchSize + nBenchHops);
+		arBenchOut.resize(nBenchSize * nBins);
+		for (i = 0; i < arBenchSignal.size(); i++)
+			arBenchSignal[i] = sin(0.01 * double(i));
+
+		CSlidingDFT sdft;
+		CGoertzel bank;
+		CFFTPlan plan;
+		sdft.Create(nBenchSize, nBins, arBins);
+		bank.Create(nBenchSize, nBins, arBins);
+		plan.Create(CFFTPlan::COMPLEX, nBenchSize, false);
+		pBenchSDFT = &sdft;
+		pBenchBank = &bank;
+		pBenchPlan = &plan;
+
+		const char *arName[] = {"sliding DFT", "Goertzel bank", "CFFTPlan", "FFT()"};
+		FnBenchKernel arKernel[] = {bench_sdft, bench_goertzel, bench_plan, bench_fft};
+		double fTimeFFT = 0.;
+		double arTime[4];
+		int k;
+		for (k = 0; k < 4; k++)
+		{
+			CStatistics stat;
+			stat.RunMicrobenchmark(arKernel[k], 10, 0.2);
+			arTime[k] = stat.GetMedian() / double(nBenchHops);
+		}
+		fTimeFFT = arTime[3];
+		printf("N=%d, %d bins, hop of 1 sample\n", int(nBenchSize), int(nBins));
+		for (k = 0; k < 4; k++)
+			printf("%-14s %10.1f ns/hop, %7.1fx faster than FFT()\n", arName[k], arTime[k] * 1e9, fTimeFFT / arTime[k]);
+
+		pBenchSDFT = NULL;
+		pBenchBank = NULL;
+		pBenchPlan = NULL;
+	}
+
+	return 0;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vector>
+#include <complex>
+
+// Selected bins of a DFT over the last nSize samples, for a few frequencies
+// where a full FFT per hop would be wasted. Bin k (any real number, integer k is
+// bin k of the FFT) of the window x[0..nSize-1], oldest sample first:
+// X[k] = sum x[n] * exp(-2*pi*i*k*n/nSize). Not normalized (FFT() with bOrthNorm
+// multiplies by 1/sqrt(nSize)).
+
+// Goertzel bank: the bins of a block of nSize samples, O(nSize) per bin.
+// Second order recurrence per bin, samples in the outer loop and bins in the
+// inner one, so the bank is vectorized across bins.
+template <class T>
+class CGoertzelT
+{
+public:
+	CGoertzelT();
+
+	int Create(size_t nSize, size_t nBins, const double *pBins);
+	void Reset();
+
+	size_t GetSize() const { return m_nSize; };
+	size_t GetBinCount() const { return m_arBins.size(); };
+
+	// pIn - nSize samples, pOut - GetBinCount() bins
+	int Execute(const T *pIn, std::complex<T> *pOut);
+
+private:
+	size_t m_nSize;
+	std::vector<double> m_arBins;
+	std::vector<T> m_arCoef;              // 2*cos(w) of every bin
+	std::vector<T> m_arPhase;             // exp(-i*w*(nSize-1)), exp(-i*w) of every bin
+	std::vector<T> m_arState;             // s[n-1], s[n-2] of every bin
+};
+
+typedef CGoertzelT<double> CGoertzel;
+typedef CGoertzelT<float> CGoertzelF;
+
+// Sliding DFT: the bins are updated by every new sample in O(1) per bin,
+// X' = exp(i*w) * (X - x[0]) + exp(-i*w*(nSize-1)) * x[nSize], w = 2*pi*k/nSize.
+// The recurrence accumulates rounding errors, so every nSize samples the bins are
+// computed again from the window by the Goertzel bank (O(1) per sample per bin
+// on average). Before nSize samples are pushed the window is padded with zeros.
+template <class T>
+class CSlidingDFTT
+{
+public:
+	CSlidingDFTT();
+
+	int Create(size_t nSize, size_t nBins, const double *pBins);
+	void Reset();
+	// Zero window
+	void Clear();
+
+	size_t GetSize() const { return m_nSize; };
+	size_t GetBinCount() const { return m_arX.size(); };
+
+	// Adds nCnt samples. pOut (optional) gets the bins after every sample,
+	// nCnt rows of GetBinCount() bins.
+	int Push(size_t nCnt, const T *pIn, std::complex<T> *pOut = NULL);
+	// Bins of the current window
+	const std::complex<T> *GetBins() const { return m_arX.empty() ? NULL : &m_arX[0]; };
+
+private:
+	CSlidingDFTT(const CSlidingDFTT &);
+	CSlidingDFTT &operator=(const CSlidingDFTT &);
+
+	size_t m_nSize;
+	size_t m_nPos;                        // oldest sample of the window in m_arRing
+	size_t m_nCount;                      // samples since the last Goertzel pass
+	CGoertzelT<T> m_Goertzel;
+	std::vector<std::complex<T> > m_arX;
+	std::vector<std::complex<T> > m_arRotate; // exp(i*w)
+	std::vector<std::complex<T> > m_arNew;    // exp(-i*w*(nSize-1))
+	std::vector<T> m_arRing;              // window twice, so that it is contiguous
+};
+
+typedef CSlidingDFTT<double> CSlidingDFT;
+typedef CSlidingDFTT<float> CSlidingDFTF;
+
+// Run self-tests
+int run_SDFT_selftest();
+
+// Run benchmarks
+int run_SDFT_benchmark();
@@ -114,6 +114,9 @@ double CStatistics::GetStatistic(TStatistic eStat)
 	case MEAN:
 		fRet = GetMean();
 		break;
+	case MEDIAN:
+		fRet = GetMedian();
+		break;
 	case STDEV:
 		fRet = GetStDev();
 		break;